@@ -0,0 +1,65 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench.h
+#
+# Microbenchmark harness of the host build: time and heap allocations per operation
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_BENCH_H_
+#define HOST_BENCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* State of a running benchmark, whose body performs iterations operations */
+typedef struct {
+	size_t iterations;
+	size_t bytes;		// bytes produced per operation, such as the payload length, reported when set
+	size_t in_bytes;	// bytes consumed per operation, reported as a rate with the in/out ratio when set
+	uint64_t start_ns;	// start of the timed part of the body
+	uint64_t start_alloc;
+} gw_bench_t;
+
+typedef void (*gw_bench_fn)(gw_bench_t& b);
+
+/**
+ * Registers a benchmark at startup. max_ns is the time per operation above which --check fails, loose
+ * enough for slow CI machines; with max_alloc=0, --check also fails if the body allocates from the heap.
+ */
+struct gw_bench_register {
+	gw_bench_register(const char* name, gw_bench_fn fn, uint32_t max_ns, int32_t max_alloc=0);
+};
+
+#define GW_BENCH(name, max_ns) \
+	static void bench_##name(gw_bench_t& b); \
+	static gw_bench_register bench_reg_##name(#name,&bench_##name,max_ns); \
+	static void bench_##name(gw_bench_t& b)
+
+/* Benchmark allowed to allocate, max_alloc being the bytes per operation above which --check fails */
+#define GW_BENCH_ALLOC(name, max_ns, max_alloc) \
+	static void bench_##name(gw_bench_t& b); \
+	static gw_bench_register bench_reg_##name(#name,&bench_##name,max_ns,max_alloc); \
+	static void bench_##name(gw_bench_t& b)
+
+/* Keep the compiler from optimizing away a result */
+static inline void gw_bench_keep(const void* p) {
+	__asm__ __volatile__("" : : "r"(p) : "memory");
+}
+
+/* Leave the setup done so far by the body out of the time and allocations of the benchmark */
+void gw_bench_reset_timer(gw_bench_t& b);
+
+/* Bytes allocated from the heap since the start of the process, counted by the wrapped allocator */
+uint64_t gw_bench_allocated(void);
+
+#endif /* HOST_BENCH_H_ */
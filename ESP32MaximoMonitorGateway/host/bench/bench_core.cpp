@@ -0,0 +1,168 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench_core.cpp
+#
+# Microbenchmarks of the gateway core: payloads, topics, configuration and policies
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "bench.h"
+#include "WIoTPEncoder.h"
+#include "WIoTPBinary.h"
+#include "WIoTPTopic.h"
+#include "WIoTPConfigArena.h"
+#include "WIoTPTokenBucket.h"
+#include "ESP32WifiPolicy.h"
+#include "SPSCRing.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+}
+
+WIOTP_INT_FIELD(BenchTemp,"temp");
+WIOTP_FLOAT_FIELD(BenchHum,"hum",1);
+
+/* The payload of one reading as formatted by the gateway before WIoTP_Encoder, the baseline of publish_encode_temp */
+GW_BENCH(publish_snprintf_temp, 5000) {
+	char payload[512];
+	int len=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		len=snprintf(payload,sizeof(payload),"{\"d\":{\"temp\":%d}}",(int)(i&1023)-512);
+		gw_bench_keep(payload);
+	}
+	b.bytes=len;
+}
+
+GW_BENCH(publish_encode_temp, 200) {
+	char payload[WIoTP_Encoder<BenchTemp>::max_len+1];
+	size_t len=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		len=WIoTP_Encoder<BenchTemp>::encode(payload,(int32_t)(i&1023)-512);
+		gw_bench_keep(payload);
+	}
+	b.bytes=len;
+}
+
+/* A reading with a float field, the baseline of publish_encode_json */
+GW_BENCH(publish_snprintf_json, 5000) {
+	char payload[512];
+	int len=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		len=snprintf(payload,sizeof(payload),"{\"d\":{\"temp\":%d,\"hum\":%.1f}}",(int)(i&1023)-512,48.5f+(i&7));
+		gw_bench_keep(payload);
+	}
+	b.bytes=len;
+}
+
+/* One reading payload, as published by the gateway before batching */
+GW_BENCH(publish_encode_json, 200) {
+	char payload[WIoTP_Encoder<BenchTemp,BenchHum>::max_len+1];
+	size_t len=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		len=WIoTP_Encoder<BenchTemp,BenchHum>::encode(payload,(int32_t)(i&1023)-512,48.5f+(i&7));
+		gw_bench_keep(payload);
+	}
+	b.bytes=len;
+}
+
+/* A batch of 32 slowly varying readings as a delta packed CBOR series */
+GW_BENCH(publish_encode_cbor_batch32, 2000) {
+	int32_t values[32];
+	for(size_t i=0;i<32;i++) values[i]=2000+(int32_t)(i%5);
+	uint8_t payload[256];
+	size_t len=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		uint8_t* p=cbor_head(payload,CBOR_MAP,1);
+		p=cbor_text(p,"d",1);
+		p=cbor_head(p,CBOR_MAP,1);
+		p=cbor_text(p,"temp",4);
+		values[0]=(int32_t)i;
+		p=wiotp_delta_pack(p,values,32);
+		len=p-payload;
+		gw_bench_keep(payload);
+	}
+	b.bytes=len;
+}
+
+GW_BENCH(topic_event, 2000) {
+	char topic[256];
+	int len=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		len=wiotp_event_topic(topic,sizeof(topic),"ESP32","gw-0042","data","json");
+		gw_bench_keep(topic);
+	}
+	b.bytes=len;
+}
+
+static const char BENCH_CONFIG[]=
+		"# gateway\nwifi_ssid=plant-floor\nwifi_pass=secret\nwiotp_orgid=abc123\nwiotp_gw_type=ESP32GW\n"
+		"wiotp_gw_id=gw-0042\nwiotp_gw_token=0123456789abcdef\nwiotp_dev_type=ESP32\nwiotp_dev_id=dev-0042\n"
+		"wiotp_host=abc123.messaging.internetofthings.ibmcloud.com\n";
+
+/* Parsing the configuration, done once at boot when the NVS cache is stale */
+GW_BENCH(config_build, 20000) {
+	static uint8_t arena[1024];
+	size_t size=wiotp_config_size(BENCH_CONFIG,sizeof(BENCH_CONFIG)-1);
+	for(size_t i=0;i<b.iterations;i++) {
+		memset(arena,0,size);
+		wiotp_config_build(BENCH_CONFIG,sizeof(BENCH_CONFIG)-1,arena,size);
+		gw_bench_keep(arena);
+	}
+	b.bytes=size;
+}
+
+GW_BENCH(config_get, 500) {
+	static uint8_t arena[1024];
+	size_t size=wiotp_config_size(BENCH_CONFIG,sizeof(BENCH_CONFIG)-1);
+	wiotp_config_build(BENCH_CONFIG,sizeof(BENCH_CONFIG)-1,arena,size);
+	static const char* keys[]={ "wiotp_host", "wifi_ssid", "wiotp_gw_token", "missing" };
+	for(size_t i=0;i<b.iterations;i++) {
+		gw_bench_keep(wiotp_config_get(arena,keys[i&3]));
+	}
+}
+
+GW_BENCH(token_bucket, 100) {
+	WIoTP_TokenBucket bucket(50,10);
+	uint32_t taken=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		bucket.refill((int64_t)i*1000);
+		taken+=bucket.take();
+	}
+	gw_bench_keep(&taken);
+}
+
+/* A disconnect and reconnection decided by the Wifi policy */
+GW_BENCH(wifi_policy_cycle, 500) {
+	ESP32_Wifi_Policy policy(42,500,60000,3,5,50);
+	policy.set_ap_count(2);
+	policy.on_start(0);
+	int64_t now=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		wifi_attempt_t attempt=policy.on_disconnected(now);
+		now+=attempt.delay_ms;
+		policy.on_connected(now);
+	}
+	gw_bench_keep(&now);
+}
+
+/* Sample ring, pushed and popped as by the sampling and publishing tasks */
+GW_BENCH(spsc_ring_push_pop, 200) {
+	static SPSC_Ring<int32_t,256> ring;
+	int32_t v;
+	for(size_t i=0;i<b.iterations;i++) {
+		ring.push((int32_t)i);
+		ring.pop(v);
+	}
+	gw_bench_keep(&v);
+}
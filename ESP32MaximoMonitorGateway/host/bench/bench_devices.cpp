@@ -0,0 +1,124 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench_devices.cpp
+#
+# Benchmarks of the registry and batches of downstream devices, at 500 devices
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "bench.h"
+#include "WIoTPDevices.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+}
+
+#define BENCH_DEVICES 500
+#define BENCH_DEVICE_TYPE "Sensor"
+#define BENCH_DEVICE_SAMPLES 16
+
+/* The registry must hold BENCH_DEVICES, which the default budget does not: build with bench/sdkconfig.fanin500 */
+#if CONFIG_GW_FANIN_ENABLE && CONFIG_GW_FANIN_MAX_DEVICES>=BENCH_DEVICES
+
+/* Registry whose batches are only rendered */
+class Bench_Devices : public WIoTP_Devices {
+protected:
+	int publish(const char* topic, const char* payload, size_t len) override {
+		gw_bench_keep(payload);
+		published_bytes+=len;
+		return ++msg_id;
+	}
+
+public:
+	int msg_id=0;
+	size_t published_bytes=0;
+
+	Bench_Devices(wiotp_format_t format)
+	: WIoTP_Devices(NULL,format,"data","temp",BENCH_DEVICES,BENCH_DEVICE_SAMPLES) {}
+};
+
+static char bench_ids[BENCH_DEVICES][16];
+static size_t bench_id_lens[BENCH_DEVICES];
+
+/* Register the devices, as their first readings would */
+static void bench_register(Bench_Devices& devices) {
+	for(size_t i=0;i<BENCH_DEVICES;i++) {
+		bench_id_lens[i]=snprintf(bench_ids[i],sizeof(bench_ids[i]),"floor1-m%03u",(unsigned)i);
+		if(devices.lookup(BENCH_DEVICE_TYPE,strlen(BENCH_DEVICE_TYPE),bench_ids[i],bench_id_lens[i])!=(int)i) {
+			fprintf(stderr,"Device %s not registered\n",bench_ids[i]);
+			abort();
+		}
+	}
+}
+
+/* Lookup of a reading of a known device, as done by the fan-in task for each reading */
+GW_BENCH(devices_lookup_500, 500) {
+	Bench_Devices devices(WIOTP_FMT_JSON);
+	bench_register(devices);
+	gw_bench_reset_timer(b);
+	int sum=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		size_t d=(i*7)%BENCH_DEVICES;
+		sum+=devices.lookup(BENCH_DEVICE_TYPE,strlen(BENCH_DEVICE_TYPE),bench_ids[d],bench_id_lens[d]);
+	}
+	gw_bench_keep(&sum);
+}
+
+/* Lookup of an unknown device in a full registry, as for the readings of a device beyond the registry */
+GW_BENCH(devices_lookup_500_miss, 500) {
+	Bench_Devices devices(WIOTP_FMT_JSON);
+	bench_register(devices);
+	char id[16];
+	size_t id_len=snprintf(id,sizeof(id),"floor2-m%03u",0u);
+	gw_bench_reset_timer(b);
+	int sum=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		id[10]='0'+i%10;
+		sum+=devices.lookup(BENCH_DEVICE_TYPE,strlen(BENCH_DEVICE_TYPE),id,id_len,false);
+	}
+	gw_bench_keep(&sum);
+}
+
+/* One operation batches BENCH_DEVICE_SAMPLES readings of the next device and publishes its batch; out B/op is per batch */
+static void bench_publish(gw_bench_t& b, wiotp_format_t format) {
+	Bench_Devices devices(format);
+	bench_register(devices);
+	gw_bench_reset_timer(b);
+	int64_t ts_us=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		uint32_t d=i%BENCH_DEVICES;
+		if(d==0) {
+			ts_us+=1000000;
+		}
+		for(int32_t n=0;n<BENCH_DEVICE_SAMPLES;n++) {
+			devices.add(d,ts_us+n*100000,2150+(int32_t)((d+n+i/BENCH_DEVICES)%7)-3);
+		}
+		devices.flush(d);
+	}
+	b.bytes=b.iterations>0?devices.published_bytes/b.iterations:0;
+}
+
+GW_BENCH(devices_publish_500_json, 20000) {
+	bench_publish(b,WIOTP_FMT_JSON);
+}
+
+GW_BENCH(devices_publish_500_cbor, 20000) {
+	bench_publish(b,WIOTP_FMT_CBOR);
+}
+
+GW_BENCH(devices_publish_500_gorilla, 20000) {
+	bench_publish(b,WIOTP_FMT_GORILLA);
+}
+
+#endif
@@ -0,0 +1,132 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench_features.cpp
+#
+# Benchmarks of the edge analytics: spectrum kernels of WIoTPDsp.h and features of a block
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "bench.h"
+#include "WIoTPDsp.h"
+#include "WIoTPFeatures.h"
+
+extern "C" {
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+}
+
+#define BENCH_FEAT_MAX_POINTS 1024
+#define BENCH_FEAT_BLOCK 256
+
+static float bench_signal[BENCH_FEAT_MAX_POINTS];
+static float bench_window[BENCH_FEAT_MAX_POINTS];
+static float bench_twiddles[BENCH_FEAT_MAX_POINTS];
+static float bench_work[BENCH_FEAT_MAX_POINTS];
+static float bench_power[BENCH_FEAT_MAX_POINTS/2+1];
+
+/* Vibration of a 50 Hz motor sampled at 1 kHz: fundamental, a harmonic and noise */
+static void bench_fill_signal(size_t n) {
+	uint32_t seed=12345;
+	for(size_t i=0;i<n;i++) {
+		seed=seed*1103515245+12345;
+		float noise=(((seed>>16)&0x7fff)/32768.0f-0.5f)*0.2f;
+		bench_signal[i]=1.5f*sinf(2*(float)M_PI*50*i/1000)+0.3f*sinf(2*(float)M_PI*150*i/1000)+noise;
+	}
+}
+
+/* One operation is the spectrum of a block of n readings, as WIoTP_Features computes it: window,
+ * FFT of the n/2 complex values and power of the n/2+1 bins. in B/op is the block of floats */
+static void bench_spectrum(gw_bench_t& b, size_t n) {
+	bench_fill_signal(n);
+	wiotp_dsp_hann(bench_window,n);
+	wiotp_dsp_rfft_init(bench_twiddles,n);
+	gw_bench_reset_timer(b);
+	for(size_t i=0;i<b.iterations;i++) {
+		wiotp_dsp_mul(bench_signal,bench_window,bench_work,n);
+		wiotp_dsp_bit_rev(bench_work,n/2);
+		wiotp_dsp_fft(bench_work,n/2,bench_twiddles);
+		wiotp_dsp_rfft_power(bench_work,n,bench_twiddles,bench_power);
+		gw_bench_keep(bench_power);
+	}
+	b.in_bytes=n*sizeof(float);
+}
+
+GW_BENCH(dsp_spectrum_256, 50000) {
+	bench_spectrum(b,256);
+}
+
+GW_BENCH(dsp_spectrum_1024, 200000) {
+	bench_spectrum(b,1024);
+}
+
+/* The same spectrum by a direct DFT of the windowed block, in O(n^2), which the FFT replaces */
+GW_BENCH(dsp_spectrum_256_dft, 5000000) {
+	const size_t n=256;
+	bench_fill_signal(n);
+	wiotp_dsp_hann(bench_window,n);
+	wiotp_dsp_mul(bench_signal,bench_window,bench_work,n);
+	gw_bench_reset_timer(b);
+	for(size_t i=0;i<b.iterations;i++) {
+		for(size_t k=0;k<=n/2;k++) {
+			float re=0, im=0;
+			for(size_t t=0;t<n;t++) {
+				float phase=2*(float)M_PI*(float)((k*t)%n)/n;
+				re+=bench_work[t]*cosf(phase);
+				im-=bench_work[t]*sinf(phase);
+			}
+			bench_power[k]=re*re+im*im;
+		}
+		gw_bench_keep(bench_power);
+	}
+	b.in_bytes=n*sizeof(float);
+}
+
+/* The blocks, window and twiddles come from the features region of the memory budget */
+#if CONFIG_GW_FEAT_ENABLE && CONFIG_GW_MEM_FEATURES_SIZE>=4*BENCH_FEAT_BLOCK*4
+
+/* Features whose events are only rendered */
+class Bench_Features : public WIoTP_Features {
+protected:
+	int publish(const char* payload, size_t len) override {
+		gw_bench_keep(payload);
+		published_bytes=len;
+		return ++msg_id;
+	}
+
+public:
+	int msg_id=0;
+	size_t published_bytes=0;
+
+	Bench_Features()
+	: WIoTP_Features(NULL,"features","temp",BENCH_FEAT_BLOCK,8,50,5,3) {}
+};
+
+/* One operation adds a block of readings, whose features are computed, scored and rendered; out B/op is the event */
+GW_BENCH(features_block_256, 100000) {
+	// Tables and blocks are allocated once from the budget, for all the runs
+	static Bench_Features features;
+	bench_fill_signal(BENCH_FEAT_BLOCK);
+	gw_bench_reset_timer(b);
+	int64_t ts_us=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		for(size_t k=0;k<BENCH_FEAT_BLOCK;k++) {
+			features.add(ts_us,bench_signal[k]);
+			ts_us+=1000;
+		}
+	}
+	b.bytes=features.published_bytes;
+	b.in_bytes=BENCH_FEAT_BLOCK*sizeof(float);
+}
+
+#endif
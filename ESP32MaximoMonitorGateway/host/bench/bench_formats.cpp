@@ -0,0 +1,153 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench_formats.cpp
+#
+# Size and encode time of batches of readings as JSON and as CBOR, over representative sample sets
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "bench.h"
+#include "WIoTPBatcher.h"
+#include "WIoTPEncoder.h"
+
+extern "C" {
+#include <math.h>
+#include <stdlib.h>
+}
+
+#define BENCH_BATCH_SAMPLES 50
+#define BENCH_BATCHES 64
+
+typedef enum {
+	BENCH_TEMP_DRIFT,		// slowly drifting temperature, in hundredths of a degree
+	BENCH_NOISY_CURRENT,	// 50 Hz current sampled at 1 kHz with noise, in mA
+	BENCH_RANDOM_BYTE,		// uncorrelated readings of 0..255
+} bench_sample_set_t;
+
+static int32_t bench_values[BENCH_BATCH_SAMPLES*BENCH_BATCHES];
+
+static void bench_fill(bench_sample_set_t set) {
+	uint32_t seed=12345;
+	int32_t drift=2150;
+	for(size_t i=0;i<BENCH_BATCH_SAMPLES*BENCH_BATCHES;i++) {
+		seed=seed*1103515245+12345;
+		uint32_t r=(seed>>16)&0x7fff;
+		switch(set) {
+		case BENCH_TEMP_DRIFT:
+			drift+=(int32_t)(r%5)-2;
+			bench_values[i]=drift;
+			break;
+		case BENCH_NOISY_CURRENT:
+			bench_values[i]=(int32_t)(1500.0*sin(2*M_PI*50*i/1000.0))+(int32_t)(r%41)-20;
+			break;
+		case BENCH_RANDOM_BYTE:
+			bench_values[i]=r&0xff;
+			break;
+		}
+	}
+}
+
+/* Sizing each reading as it is added, then rendering the batch, as WIoTP_Batcher does; out B/op is per batch */
+static void bench_batch(gw_bench_t& b, wiotp_format_t format, bench_sample_set_t set) {
+	bench_fill(set);
+	char payload[1024];
+	size_t len=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		const int32_t* values=bench_values+(i%BENCH_BATCHES)*BENCH_BATCH_SAMPLES;
+		size_t body_len=0;
+		for(size_t n=0;n<BENCH_BATCH_SAMPLES;n++) {
+			body_len+=wiotp_batch_sample_len(format,values,n,values[n]);
+		}
+		len=wiotp_batch_encode(payload,format,"temp",4,values,BENCH_BATCH_SAMPLES,body_len);
+		gw_bench_keep(payload);
+	}
+	b.bytes=len;
+}
+
+GW_BENCH(batch50_json_temp_drift, 20000) {
+	bench_batch(b,WIOTP_FMT_JSON,BENCH_TEMP_DRIFT);
+}
+
+GW_BENCH(batch50_cbor_temp_drift, 20000) {
+	bench_batch(b,WIOTP_FMT_CBOR,BENCH_TEMP_DRIFT);
+}
+
+GW_BENCH(batch50_json_noisy_current, 20000) {
+	bench_batch(b,WIOTP_FMT_JSON,BENCH_NOISY_CURRENT);
+}
+
+GW_BENCH(batch50_cbor_noisy_current, 20000) {
+	bench_batch(b,WIOTP_FMT_CBOR,BENCH_NOISY_CURRENT);
+}
+
+GW_BENCH(batch50_json_random_byte, 20000) {
+	bench_batch(b,WIOTP_FMT_JSON,BENCH_RANDOM_BYTE);
+}
+
+GW_BENCH(batch50_cbor_random_byte, 20000) {
+	bench_batch(b,WIOTP_FMT_CBOR,BENCH_RANDOM_BYTE);
+}
+
+WIOTP_INT_FIELD(BenchGainTemp,"temp");
+
+/* Batcher whose batches are only counted */
+class Bench_Batcher : public WIoTP_Batcher {
+protected:
+	int publish(const char* payload, size_t len) override {
+		gw_bench_keep(payload);
+		return ++msg_id;
+	}
+
+public:
+	int msg_id=0;
+
+	Bench_Batcher(wiotp_format_t format)
+	: WIoTP_Batcher(NULL,"iot-2/type/t/id/d/evt/data/fmt/json","temp",format) {}
+};
+
+/**
+ * One operation adds GW_BATCH_MAX_SAMPLES readings at the sampling rate through WIoTP_Batcher, with the
+ * configured batch limits: out B/op is what is published for them, in B/op what one {"d":{"temp":N}} message
+ * per reading, as published before batching, would cost, and the ratio the gain of batching.
+ */
+static void bench_batcher_gain(gw_bench_t& b, wiotp_format_t format) {
+	const int64_t period_us=1000000/CONFIG_GW_SAMPLE_RATE_HZ;
+	char payload[WIoTP_Encoder<BenchGainTemp>::max_len+1];
+	size_t single_bytes=0;
+	for(size_t n=0;n<CONFIG_GW_BATCH_MAX_SAMPLES;n++) {
+		single_bytes+=WIoTP_Encoder<BenchGainTemp>::encode(payload,(int32_t)(40+n%7));
+	}
+	Bench_Batcher batcher(format);
+	gw_bench_reset_timer(b);
+	int64_t ts_us=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		for(size_t n=0;n<CONFIG_GW_BATCH_MAX_SAMPLES;n++) {
+			batcher.add(ts_us,(int32_t)(40+n%7));
+			ts_us+=period_us;
+		}
+	}
+	batcher.flush();
+	b.bytes=b.iterations>0?batcher.bytes()/b.iterations:0;
+	b.in_bytes=single_bytes;
+}
+
+GW_BENCH(batcher_gain_json, 200000) {
+	bench_batcher_gain(b,WIOTP_FMT_JSON);
+}
+
+GW_BENCH(batcher_gain_cbor, 200000) {
+	bench_batcher_gain(b,WIOTP_FMT_CBOR);
+}
+
+GW_BENCH(batcher_gain_gorilla, 200000) {
+	bench_batcher_gain(b,WIOTP_FMT_GORILLA);
+}
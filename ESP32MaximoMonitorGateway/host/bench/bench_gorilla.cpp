@@ -0,0 +1,220 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench_gorilla.cpp
+#
+# Benchmarks of the Gorilla codec: compression ratio and throughput on traces of readings
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "bench.h"
+#include "WIoTPGorilla.h"
+
+extern "C" {
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+}
+
+/* Readings of a block, and bytes of a reading before compression, a timestamp in ms and a value */
+#define BENCH_GORILLA_READINGS 256
+#define BENCH_GORILLA_RAW_LEN (sizeof(int64_t)+sizeof(int32_t))
+/* Longest trace loaded */
+#define BENCH_GORILLA_MAX_TRACE 65536
+
+typedef struct {
+	int64_t ts;
+	int32_t value;
+} bench_reading_t;
+
+typedef enum {
+	BENCH_TRACE_FLAT,			// channel unchanged for hours, sampled every second
+	BENCH_TRACE_TEMP,			// drifting temperature in hundredths of a degree, every second with 1 ms jitter
+	BENCH_TRACE_CURRENT,		// 50 Hz current in mA with noise, every ms
+	BENCH_TRACE_RBE,			// reported by exception: irregular times, changes beyond a deadband
+	BENCH_TRACE_RECORDED,		// loaded from the file of GW_BENCH_TRACE
+} bench_trace_t;
+
+static bench_reading_t bench_trace[BENCH_GORILLA_MAX_TRACE];
+static size_t bench_trace_len;
+static uint8_t bench_block[WIOTP_GORILLA_HEADER_LEN+BENCH_GORILLA_READINGS*((WIOTP_GORILLA_MAX_BITS+7)/8)];
+
+/* Load a trace as served by GET /history of the gateway, {"d":{"temp":[[<ts>,<value>],...]}}, or as
+ * any list of pairs of integers. Returns the number of readings */
+static size_t bench_load_trace(const char* path) {
+	FILE* f=fopen(path,"r");
+	if(f==NULL) {
+		fprintf(stderr,"Cannot open trace %s\n",path);
+		exit(2);
+	}
+	size_t n=0;
+	long long ts, value;
+	int c;
+	while(n<BENCH_GORILLA_MAX_TRACE && (c=fgetc(f))!=EOF) {
+		if(c=='[' && fscanf(f," %lld , %lld ]",&ts,&value)==2) {
+			bench_trace[n].ts=ts;
+			bench_trace[n].value=(int32_t)value;
+			n++;
+		}
+	}
+	fclose(f);
+	return n;
+}
+
+static void bench_fill_trace(bench_trace_t set) {
+	if(set==BENCH_TRACE_RECORDED) {
+		bench_trace_len=bench_load_trace(getenv("GW_BENCH_TRACE"));
+		if(bench_trace_len<2) {
+			fprintf(stderr,"Trace %s holds less than 2 readings\n",getenv("GW_BENCH_TRACE"));
+			exit(2);
+		}
+		return;
+	}
+	uint32_t seed=12345;
+	int64_t ts=1000000;
+	int32_t drift=2150;
+	bench_trace_len=BENCH_GORILLA_MAX_TRACE;
+	for(size_t i=0;i<bench_trace_len;i++) {
+		seed=seed*1103515245+12345;
+		uint32_t r=(seed>>16)&0x7fff;
+		switch(set) {
+		case BENCH_TRACE_FLAT:
+			ts+=1000;
+			bench_trace[i].value=2150;
+			break;
+		case BENCH_TRACE_TEMP:
+			ts+=1000+(int64_t)(r%3)-1;
+			drift+=(int32_t)(r%5)-2;
+			bench_trace[i].value=drift;
+			break;
+		case BENCH_TRACE_CURRENT:
+			ts+=1;
+			bench_trace[i].value=(int32_t)(1500.0*sin(2*M_PI*50*i/1000.0))+(int32_t)(r%41)-20;
+			break;
+		case BENCH_TRACE_RBE:
+			ts+=1000*(1+r%300);
+			drift+=(int32_t)(r%41)-20;
+			bench_trace[i].value=drift;
+			break;
+		case BENCH_TRACE_RECORDED:
+			break;
+		}
+		bench_trace[i].ts=ts;
+	}
+}
+
+/* Compress readings [from,from+n) of the trace into bench_block, returns its length */
+static size_t bench_compress(size_t from, size_t n) {
+	wiotp_gorilla_t g;
+	wiotp_gorilla_init(&g);
+	for(size_t i=from;i<from+n;i++) {
+		wiotp_gorilla_append(&g,bench_block,bench_trace[i].ts,bench_trace[i].value);
+	}
+	return wiotp_gorilla_len(&g);
+}
+
+/* Block of the readings following the one of iteration i, wrapping around the trace */
+static size_t bench_block_start(size_t i) {
+	size_t blocks=bench_trace_len/BENCH_GORILLA_READINGS;
+	return blocks>0?(i%blocks)*BENCH_GORILLA_READINGS:0;
+}
+
+static size_t bench_block_readings() {
+	return bench_trace_len<BENCH_GORILLA_READINGS?bench_trace_len:BENCH_GORILLA_READINGS;
+}
+
+/* One operation compresses a block of readings: out B/op is its size, the ratio that of the raw readings to it */
+static void bench_encode(gw_bench_t& b, bench_trace_t set) {
+	bench_fill_trace(set);
+	size_t n=bench_block_readings();
+	gw_bench_reset_timer(b);
+	size_t total=0;
+	for(size_t i=0;i<b.iterations;i++) {
+		total+=bench_compress(bench_block_start(i),n);
+		gw_bench_keep(bench_block);
+	}
+	b.bytes=b.iterations>0?total/b.iterations:0;
+	b.in_bytes=n*BENCH_GORILLA_RAW_LEN;
+}
+
+/* One operation decompresses a block of readings, checked against the trace */
+static void bench_decode(gw_bench_t& b, bench_trace_t set) {
+	bench_fill_trace(set);
+	size_t n=bench_block_readings();
+	size_t len=bench_compress(0,n);
+	gw_bench_reset_timer(b);
+	for(size_t i=0;i<b.iterations;i++) {
+		wiotp_gorilla_reader_t r;
+		memset(&r,0,sizeof(r));
+		size_t count=wiotp_gorilla_open(&r,bench_block,len);
+		int64_t ts=0;
+		int32_t value=0;
+		for(size_t k=0;k<count;k++) {
+			if(!wiotp_gorilla_next(&r,&ts,&value) || ts!=bench_trace[k].ts || value!=bench_trace[k].value) {
+				fprintf(stderr,"Reading %u decoded as %lld %d\n",(unsigned)k,(long long)ts,value);
+				abort();
+			}
+		}
+	}
+	b.bytes=len;
+	b.in_bytes=n*BENCH_GORILLA_RAW_LEN;
+}
+
+GW_BENCH(gorilla_encode_flat, 100000) {
+	bench_encode(b,BENCH_TRACE_FLAT);
+}
+
+GW_BENCH(gorilla_decode_flat, 100000) {
+	bench_decode(b,BENCH_TRACE_FLAT);
+}
+
+GW_BENCH(gorilla_encode_temp, 100000) {
+	bench_encode(b,BENCH_TRACE_TEMP);
+}
+
+GW_BENCH(gorilla_decode_temp, 100000) {
+	bench_decode(b,BENCH_TRACE_TEMP);
+}
+
+GW_BENCH(gorilla_encode_current, 100000) {
+	bench_encode(b,BENCH_TRACE_CURRENT);
+}
+
+GW_BENCH(gorilla_decode_current, 100000) {
+	bench_decode(b,BENCH_TRACE_CURRENT);
+}
+
+GW_BENCH(gorilla_encode_rbe, 100000) {
+	bench_encode(b,BENCH_TRACE_RBE);
+}
+
+GW_BENCH(gorilla_decode_rbe, 100000) {
+	bench_decode(b,BENCH_TRACE_RBE);
+}
+
+static void bench_gorilla_encode_recorded(gw_bench_t& b) {
+	bench_encode(b,BENCH_TRACE_RECORDED);
+}
+
+static void bench_gorilla_decode_recorded(gw_bench_t& b) {
+	bench_decode(b,BENCH_TRACE_RECORDED);
+}
+
+/* Benchmarks of a recorded trace, only when one is given */
+static struct bench_gorilla_recorded {
+	bench_gorilla_recorded() {
+		if(getenv("GW_BENCH_TRACE")!=NULL) {
+			gw_bench_register("gorilla_encode_recorded",&bench_gorilla_encode_recorded,100000);
+			gw_bench_register("gorilla_decode_recorded",&bench_gorilla_decode_recorded,100000);
+		}
+	}
+} bench_gorilla_recorded_reg;
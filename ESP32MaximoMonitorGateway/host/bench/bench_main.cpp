@@ -0,0 +1,153 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench_main.cpp
+#
+# Runs the microbenchmarks, reporting ns/op and heap bytes allocated per operation
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "bench.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+}
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+// Time over which an operation is measured
+#define BENCH_MIN_NS 200000000ull
+#define BENCH_MAX_BENCHES 64
+
+typedef struct {
+	const char* name;
+	gw_bench_fn fn;
+	uint32_t max_ns;
+	int32_t max_alloc;
+} bench_entry_t;
+
+static bench_entry_t benches[BENCH_MAX_BENCHES];
+static size_t n_benches=0;
+
+gw_bench_register::gw_bench_register(const char* name, gw_bench_fn fn, uint32_t max_ns, int32_t max_alloc) {
+	if(n_benches==BENCH_MAX_BENCHES) {
+		fprintf(stderr,"Too many benchmarks, raise BENCH_MAX_BENCHES\n");
+		abort();
+	}
+	benches[n_benches++]={ name, fn, max_ns, max_alloc };
+}
+
+/* Allocations are counted by wrapping the allocator at link time, operator new included */
+static std::atomic<uint64_t> allocated(0);
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+void* __wrap_malloc(size_t size) {
+	allocated.fetch_add(size,std::memory_order_relaxed);
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+	allocated.fetch_add(n*size,std::memory_order_relaxed);
+	return __real_calloc(n,size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+	allocated.fetch_add(size,std::memory_order_relaxed);
+	return __real_realloc(p,size);
+}
+}
+
+void* operator new(size_t size) {
+	void* p=malloc(size);
+	if(p==NULL) throw std::bad_alloc();
+	return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+uint64_t gw_bench_allocated(void) {
+	return allocated.load(std::memory_order_relaxed);
+}
+
+static uint64_t bench_now_ns(void) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void gw_bench_reset_timer(gw_bench_t& b) {
+	b.start_alloc=gw_bench_allocated();
+	b.start_ns=bench_now_ns();
+}
+
+/**
+ * gateway_bench [--check] [name...]
+ * Runs the benchmarks, or those whose name starts with one of the arguments, and prints for each
+ * the time, rate and heap bytes allocated per operation, and the bytes it produces per operation.
+ * With --check, exits with 1 if a benchmark is slower than its limit or allocates more than allowed.
+ */
+int main(int argc, char** argv) {
+	bool check=false;
+	int first=1;
+	if(argc>1 && strcmp(argv[1],"--check")==0) {
+		check=true;
+		first=2;
+	}
+	// Modules log through the emulated esp_log, only their warnings are worth interleaving with results
+	esp_log_level_set("*",ESP_LOG_WARN);
+	int failures=0;
+	printf("%-32s %12s %12s %14s %12s\n","benchmark","ns/op","op/s","alloc B/op","out B/op");
+	for(size_t i=0;i<n_benches;i++) {
+		const bench_entry_t& e=benches[i];
+		bool selected=first>=argc;
+		for(int a=first;a<argc && !selected;a++) {
+			selected=strncmp(e.name,argv[a],strlen(argv[a]))==0;
+		}
+		if(!selected) {
+			continue;
+		}
+		// Double the iterations until the run is long enough to be timed
+		gw_bench_t b={ 1, 0, 0, 0, 0 };
+		uint64_t ns, alloc;
+		while(true) {
+			gw_bench_reset_timer(b);
+			e.fn(b);
+			ns=bench_now_ns()-b.start_ns;
+			alloc=gw_bench_allocated()-b.start_alloc;
+			if(ns>=BENCH_MIN_NS || b.iterations>=(1ull<<40)) break;
+			b.iterations*=ns<BENCH_MIN_NS/64?8:2;
+		}
+		double ns_op=(double)ns/b.iterations;
+		double alloc_op=(double)alloc/b.iterations;
+		printf("%-32s %12.1f %12.0f %14.1f",e.name,ns_op,ns_op>0?1e9/ns_op:0.0,alloc_op);
+		if(b.bytes>0) printf(" %12u",(unsigned)b.bytes); else printf(" %12s","-");
+		if(b.in_bytes>0 && ns_op>0) printf("  %.1f MB/s",b.in_bytes*1e3/ns_op);
+		if(b.in_bytes>0 && b.bytes>0) printf(" ratio %.2f",(double)b.in_bytes/b.bytes);
+		bool slow=ns_op>e.max_ns;
+		bool allocates=e.max_alloc>=0 && alloc_op>e.max_alloc;
+		if(slow) printf("  SLOW (limit %u ns)",e.max_ns);
+		if(allocates) printf("  ALLOCATES (limit %d B)",e.max_alloc);
+		printf("\n");
+		if(check && (slow || allocates)) failures++;
+	}
+	return failures>0?1:0;
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# bench_queue.cpp
+#
+# Replay benchmark of the offline queue, in records read back from the segment files per second
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "bench.h"
+#include "ESP32SPIFFSQueue.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <unistd.h>
+}
+
+/* Largest backlog replayed, segments are never dropped below it */
+#define BENCH_QUEUE_SEGMENTS 4096
+
+static const char BENCH_TOPIC[]="iot-2/type/ESP32/id/dev-0042/evt/data/fmt/json";
+static const char BENCH_PAYLOAD[]="{\"d\":{\"temp\":[2031,2032,2032,2030,2029,2031,2033,2032,2031,2030]}}";
+
+static void bench_queue_clean(const char* dir) {
+	DIR* d=opendir(dir);
+	if(d==NULL) {
+		return;
+	}
+	struct dirent* entry;
+	char path[PATH_MAX];
+	while((entry=readdir(d))!=NULL) {
+		if(entry->d_name[0]=='.') continue;
+		snprintf(path,sizeof(path),"%s/%s",dir,entry->d_name);
+		unlink(path);
+	}
+	closedir(d);
+	rmdir(dir);
+}
+
+/**
+ * Replay of a backlog of batch records, as read by drain() ahead of each publish: the queue side of the
+ * replay, the publisher being timed on its own. The cursor is persisted every cursor_records records.
+ */
+static void bench_queue_replay(gw_bench_t& b, uint32_t cursor_records) {
+	char dir[]="/tmp/gw_bench_queue_XXXXXX";
+	if(mkdtemp(dir)==NULL) {
+		perror("mkdtemp");
+		abort();
+	}
+	{
+		ESP32_SPIFFS_Queue queue(dir,CONFIG_GW_QUEUE_SEGMENT_SIZE,BENCH_QUEUE_SEGMENTS,CONFIG_GW_QUEUE_SYNC_RECORDS,
+				CONFIG_GW_QUEUE_SYNC_MS,CONFIG_GW_QUEUE_MAX_RECORD,CONFIG_GW_QUEUE_DRAIN_RATE,CONFIG_GW_QUEUE_DRAIN_BURST,
+				cursor_records);
+		for(size_t i=0;i<b.iterations;i++) {
+			queue.push(BENCH_TOPIC,BENCH_PAYLOAD,sizeof(BENCH_PAYLOAD)-1);
+		}
+		queue.sync();
+		gw_bench_reset_timer(b);
+
+		const char* topic;
+		const char* payload;
+		size_t len=0;
+		while(queue.peek(&topic,&payload,&len)) {
+			gw_bench_keep(payload);
+			queue.pop();
+		}
+		b.bytes=len;
+		if(queue.drained()!=b.iterations) {
+			fprintf(stderr,"Replayed %u of %u records\n",queue.drained(),(unsigned)b.iterations);
+			abort();
+		}
+	}
+	bench_queue_clean(dir);
+}
+
+/* Cursor written after each record, as drain() did once per call of up to GW_QUEUE_DRAIN_BURST records.
+ * Bound by the file system of the machine rather than by the queue, hence the loose limit */
+GW_BENCH(queue_replay_cursor_each, 1000000) {
+	bench_queue_replay(b,1);
+}
+
+GW_BENCH(queue_replay, 20000) {
+	bench_queue_replay(b,CONFIG_GW_QUEUE_CURSOR_RECORDS);
+}
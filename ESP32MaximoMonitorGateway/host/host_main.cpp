@@ -0,0 +1,120 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# host_main.cpp
+#
+# Runs app_main on Linux over the host emulation, with scripted Wifi and broker outages
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "host_emul.h"
+
+void app_main(void);
+}
+
+#include <vector>
+
+static const char *LOG_TAG="HOST";
+
+static void main_task(void* arg) {
+	app_main();
+	vTaskDelete(NULL);
+}
+
+/* Publish each "<topic> <payload>" line of the standard input through the broker, e.g. commands.
+ * A "@<file>" payload publishes the contents of the file. Lines starting with ! change the network */
+static void stdin_task(void* arg) {
+	static char line[4096];
+	while(fgets(line,sizeof(line),stdin)!=NULL) {
+		line[strcspn(line,"\r\n")]='\0';
+		// Changes of the simulated network, "!dns <name> <address>" and "!broker <address>"
+		char name[256], addr[64];
+		if(sscanf(line,"!dns %255s %63s",name,addr)==2) {
+			host_dns_set(name,addr);
+			continue;
+		}
+		if(sscanf(line,"!broker %63s",addr)==1) {
+			host_broker_move(addr);
+			continue;
+		}
+		char* payload=strchr(line,' ');
+		if(payload==NULL) {
+			continue;
+		}
+		*payload++='\0';
+		std::vector<char> contents;
+		size_t len=strlen(payload);
+		if(*payload=='@') {
+			// Not through fopen, which maps paths to the SPIFFS image
+			int fd=open(payload+1,O_RDONLY);
+			if(fd<0) {
+				ESP_LOGE(LOG_TAG,"Cannot open %s",payload+1);
+				continue;
+			}
+			char buf[4096];
+			ssize_t n;
+			while((n=read(fd,buf,sizeof(buf)))>0) {
+				contents.insert(contents.end(),buf,buf+n);
+			}
+			close(fd);
+			payload=contents.data();
+			len=contents.size();
+		}
+		int n=host_broker_publish(line,payload,len);
+		ESP_LOGI(LOG_TAG,"Published %d bytes to %s, %d subscribers",len,line,n);
+	}
+	vTaskDelete(NULL);
+}
+
+/**
+ * Lines of the standard input are published by the broker, see stdin_task.
+ * Besides the settings of host_emul_init, the environment gives, in seconds unless noted:
+ *  HOST_RUN_S             time after which the process exits, 0 to run forever (0)
+ *  HOST_WIFI_DROP_S       period of AP outages, 0 for none (0)
+ *  HOST_WIFI_DOWN_MS      duration of each AP outage (5000)
+ *  HOST_BROKER_RESTART_S  period of broker restarts, 0 for none (0)
+ *  HOST_BROKER_DOWN_MS    duration of each broker restart (3000)
+ */
+int main(int argc, char** argv) {
+	host_emul_init();
+	uint32_t run_s=host_env("HOST_RUN_S",0);
+	uint32_t wifi_drop_s=host_env("HOST_WIFI_DROP_S",0);
+	uint32_t wifi_down_ms=host_env("HOST_WIFI_DOWN_MS",5000);
+	uint32_t broker_restart_s=host_env("HOST_BROKER_RESTART_S",0);
+	uint32_t broker_down_ms=host_env("HOST_BROKER_DOWN_MS",3000);
+
+	xTaskCreate(&main_task,"main",CONFIG_ESP_MAIN_TASK_STACK_SIZE,NULL,1,NULL);
+	xTaskCreate(&stdin_task,"stdin",4096,NULL,1,NULL);
+
+	TickType_t wake=xTaskGetTickCount();
+	for(uint32_t s=1;run_s==0 || s<=run_s;s++) {
+		vTaskDelayUntil(&wake,pdMS_TO_TICKS(1000));
+		if(wifi_drop_s>0 && s%wifi_drop_s==0) {
+			host_wifi_drop(wifi_down_ms);
+		}
+		if(broker_restart_s>0 && s%broker_restart_s==0) {
+			host_broker_restart(broker_down_ms);
+		}
+	}
+	ESP_LOGI(LOG_TAG,"Ran for %u s, exiting",run_s);
+	fflush(stdout);
+	// Tasks never return, leave without running destructors under them
+	_exit(0);
+}
@@ -0,0 +1,188 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# adc.cpp
+#
+# Host emulation of the continuous-mode and one-shot ADC1 drivers, converting simulated signals
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <math.h>
+#include <string.h>
+
+#include "driver/adc.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "host_emul.h"
+}
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const char *LOG_TAG="HOST_ADC";
+
+/* Conversions are produced at the configured rate from the start, and handed out in whole frames.
+ * Channel c carries a sine of (c+1)*HOST_ADC_SIGNAL_HZ around mid-scale, with some noise */
+static struct {
+	std::mutex lock;
+	bool initialized = false;
+	bool started = false;
+	uint32_t buffer_conv = 0;				// conversions held by the buffer
+	uint32_t frame_conv = 0;				// conversions per frame
+	std::vector<adc_digi_pattern_config_t> pattern;
+	uint32_t freq_hz = 0;
+	double signal_hz = 0;
+	int64_t start_us = 0;
+	uint64_t consumed = 0;					// conversions read or lost since the start
+	bool oneshot = false;					// one-shot conversions, once the width is configured
+	int64_t oneshot_start_us = 0;
+	uint32_t oneshot_mask = 0;				// channels configured for one-shot conversions
+} adc;
+
+/* Conversion of the channel, at t seconds from the start */
+static uint16_t host_adc_convert(uint8_t channel, double t) {
+	int32_t v=2048+(int32_t)(1500*sin(2*M_PI*adc.signal_hz*(channel+1)*t))+(int32_t)(esp_random()%33)-16;
+	return std::max(0,std::min(4095,v));
+}
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	if(init_config->conv_num_each_intr==0 || init_config->conv_num_each_intr%4!=0
+			|| init_config->max_store_buf_size<init_config->conv_num_each_intr) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	adc.buffer_conv=init_config->max_store_buf_size/sizeof(adc_digi_output_data_t);
+	adc.frame_conv=init_config->conv_num_each_intr/sizeof(adc_digi_output_data_t);
+	adc.signal_hz=host_env("HOST_ADC_SIGNAL_HZ",50);
+	adc.initialized=true;
+	return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	if(!adc.initialized) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	if(config->pattern_num==0 || config->adc_pattern==NULL || config->sample_freq_hz<20000 || config->sample_freq_hz>2000000
+			|| config->format!=ADC_DIGI_OUTPUT_FORMAT_TYPE1 || !config->conv_limit_en) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	adc.pattern.assign(config->adc_pattern,config->adc_pattern+config->pattern_num);
+	adc.freq_hz=config->sample_freq_hz;
+	return ESP_OK;
+}
+
+esp_err_t adc_digi_start(void) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	if(!adc.initialized || adc.pattern.empty()) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	adc.start_us=esp_timer_get_time();
+	adc.consumed=0;
+	adc.started=true;
+	ESP_LOGI(LOG_TAG,"Converting %d channels at %u Hz",(int)adc.pattern.size(),adc.freq_hz);
+	return ESP_OK;
+}
+
+esp_err_t adc_digi_stop(void) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	adc.started=false;
+	return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize(void) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	adc.started=false;
+	adc.initialized=false;
+	adc.pattern.clear();
+	return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms) {
+	int64_t deadline_us=esp_timer_get_time()+(int64_t)timeout_ms*1000;
+	std::unique_lock<std::mutex> lock(adc.lock);
+	*out_length=0;
+	if(!adc.started) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	while(true) {
+		int64_t now=esp_timer_get_time();
+		uint64_t produced=(uint64_t)(now-adc.start_us)*adc.freq_hz/1000000;
+		// Frames which do not fit in the buffer are lost
+		bool overflow=false;
+		if(produced-adc.consumed>adc.buffer_conv) {
+			uint64_t held=adc.buffer_conv/adc.frame_conv*adc.frame_conv;
+			adc.consumed=produced/adc.frame_conv*adc.frame_conv-held;
+			overflow=true;
+		}
+		uint64_t ready=(produced-adc.consumed)/adc.frame_conv*adc.frame_conv;
+		uint32_t n=(uint32_t)std::min<uint64_t>(ready,length_max/sizeof(adc_digi_output_data_t));
+		if(n>0 || overflow) {
+			adc_digi_output_data_t* out=(adc_digi_output_data_t*)buf;
+			for(uint32_t i=0;i<n;i++) {
+				uint64_t k=adc.consumed+i;
+				const adc_digi_pattern_config_t& p=adc.pattern[k%adc.pattern.size()];
+				out[i].val=0;
+				out[i].type1.channel=p.channel;
+				out[i].type1.data=host_adc_convert(p.channel,(double)k/adc.freq_hz);
+			}
+			adc.consumed+=n;
+			*out_length=n*sizeof(adc_digi_output_data_t);
+			return overflow?ESP_ERR_INVALID_STATE:ESP_OK;
+		}
+		if(now>=deadline_us) {
+			return ESP_ERR_TIMEOUT;
+		}
+		// Until the next frame is complete, or the timeout
+		int64_t next_us=adc.start_us+(int64_t)((adc.consumed+adc.frame_conv)*1000000/adc.freq_hz);
+		lock.unlock();
+		std::this_thread::sleep_for(std::chrono::microseconds(std::min(next_us,deadline_us)-now));
+		lock.lock();
+		if(!adc.started) {
+			return ESP_ERR_INVALID_STATE;
+		}
+	}
+}
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	if(width_bit!=ADC_WIDTH_BIT_12) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(!adc.oneshot) {
+		adc.signal_hz=host_env("HOST_ADC_SIGNAL_HZ",50);
+		adc.oneshot_start_us=esp_timer_get_time();
+		adc.oneshot=true;
+	}
+	return ESP_OK;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	if(channel<ADC1_CHANNEL_0 || channel>=ADC1_CHANNEL_MAX) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	adc.oneshot_mask|=1<<channel;
+	return ESP_OK;
+}
+
+int adc1_get_raw(adc1_channel_t channel) {
+	std::lock_guard<std::mutex> lock(adc.lock);
+	if(channel<ADC1_CHANNEL_0 || channel>=ADC1_CHANNEL_MAX || !adc.oneshot || !(adc.oneshot_mask&(1<<channel))) {
+		return -1;
+	}
+	return host_adc_convert(channel,(esp_timer_get_time()-adc.oneshot_start_us)/1e6);
+}
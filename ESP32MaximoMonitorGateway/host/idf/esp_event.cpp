@@ -0,0 +1,143 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_event.cpp
+#
+# Host emulation of the default event loop, dispatched from the sys_evt task
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <string.h>
+#include "esp_event.h"
+#include "freertos/task.h"
+}
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct host_event_handler {
+	esp_event_base_t base;
+	int32_t id;
+	esp_event_handler_t handler;
+	void* arg;
+	std::atomic<bool> removed;
+};
+
+struct host_event {
+	esp_event_base_t base;
+	int32_t id;
+	std::vector<uint8_t> data;
+};
+
+static std::mutex event_lock;
+static std::condition_variable event_cv;
+static std::vector<std::shared_ptr<host_event_handler>> event_handlers;
+static std::deque<host_event> event_queue;
+static bool event_loop_created=false;
+
+static void event_task(void* arg) {
+	for(;;) {
+		host_event event;
+		std::vector<std::shared_ptr<host_event_handler>> handlers;
+		{
+			std::unique_lock<std::mutex> lock(event_lock);
+			event_cv.wait(lock,[]() { return !event_queue.empty(); });
+			event=std::move(event_queue.front());
+			event_queue.pop_front();
+			handlers=event_handlers;
+		}
+		// Handlers are called without the lock, they may post or (un)register
+		for(auto& h : handlers) {
+			if(h->removed) continue;
+			if((h->base==ESP_EVENT_ANY_BASE || h->base==event.base) && (h->id==ESP_EVENT_ANY_ID || h->id==event.id)) {
+				h->handler(h->arg,event.base,event.id,event.data.empty()?NULL:event.data.data());
+			}
+		}
+	}
+}
+
+esp_err_t esp_event_loop_create_default(void) {
+	std::lock_guard<std::mutex> lock(event_lock);
+	if(event_loop_created) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	event_loop_created=true;
+	xTaskCreate(&event_task,"sys_evt",CONFIG_ESP_SYSTEM_EVENT_TASK_STACK_SIZE,NULL,20,NULL);
+	return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void* data, size_t size, TickType_t ticks) {
+	std::lock_guard<std::mutex> lock(event_lock);
+	if(!event_loop_created) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	host_event event;
+	event.base=base;
+	event.id=id;
+	if(data!=NULL && size>0) {
+		event.data.assign((const uint8_t*)data,(const uint8_t*)data+size);
+	}
+	event_queue.push_back(std::move(event));
+	event_cv.notify_one();
+	return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler,
+		void* arg, esp_event_handler_instance_t* instance) {
+	std::lock_guard<std::mutex> lock(event_lock);
+	if(!event_loop_created) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	std::shared_ptr<host_event_handler> h(new host_event_handler());
+	h->base=base;
+	h->id=id;
+	h->handler=handler;
+	h->arg=arg;
+	h->removed=false;
+	event_handlers.push_back(h);
+	if(instance!=NULL) {
+		*instance=h.get();
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_unregister(esp_event_base_t base, int32_t id, esp_event_handler_instance_t instance) {
+	std::lock_guard<std::mutex> lock(event_lock);
+	for(auto it=event_handlers.begin();it!=event_handlers.end();++it) {
+		if(it->get()==instance && (*it)->base==base && (*it)->id==id) {
+			(*it)->removed=true;
+			event_handlers.erase(it);
+			return ESP_OK;
+		}
+	}
+	return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* arg) {
+	return esp_event_handler_instance_register(base,id,handler,arg,NULL);
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t base, int32_t id, esp_event_handler_t handler) {
+	std::lock_guard<std::mutex> lock(event_lock);
+	for(auto it=event_handlers.begin();it!=event_handlers.end();++it) {
+		if((*it)->handler==handler && (*it)->base==base && (*it)->id==id) {
+			(*it)->removed=true;
+			event_handlers.erase(it);
+			return ESP_OK;
+		}
+	}
+	return ESP_ERR_NOT_FOUND;
+}
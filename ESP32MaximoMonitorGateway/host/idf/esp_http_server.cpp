@@ -0,0 +1,390 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_http_server.cpp
+#
+# Host emulation of esp_http_server, serving the loopback interface from a single task
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_server.h"
+#include "host_emul.h"
+}
+
+#include <string>
+#include <vector>
+
+static const char *LOG_TAG="HOST_HTTPD";
+
+// Time between checks for a stop request
+#define HTTPD_POLL_MS 100
+
+/* Open connection, holding the part of the next request received so far */
+struct host_httpd_session {
+	int fd;
+	int64_t last_us;
+	std::string in;
+};
+
+struct host_httpd {
+	httpd_config_t config;
+	int listen_fd;
+	std::vector<httpd_uri_t> handlers;
+	std::vector<host_httpd_session> sessions;
+	volatile bool stop;
+	volatile bool stopped;
+};
+
+/* Response being written, the aux of a request */
+struct host_httpd_resp {
+	int fd;
+	std::string query;
+	std::string status;
+	std::string type;
+	std::string headers;
+	bool started;			// status line and headers sent
+	bool chunked;
+	bool failed;
+};
+
+static bool send_all(int fd, const char* buf, size_t len) {
+	while(len>0) {
+		ssize_t n=send(fd,buf,len,MSG_NOSIGNAL);
+		if(n<0) {
+			if(errno==EINTR) continue;
+			return false;
+		}
+		buf+=n;
+		len-=n;
+	}
+	return true;
+}
+
+/* Send the status line and headers, with either a length or chunked transfer */
+static bool send_head(host_httpd_resp* resp, ssize_t content_len) {
+	std::string head="HTTP/1.1 "+resp->status+"\r\nContent-Type: "+resp->type+"\r\n"+resp->headers;
+	char length[48];
+	if(content_len<0) {
+		head+="Transfer-Encoding: chunked\r\n";
+		resp->chunked=true;
+	} else {
+		snprintf(length,sizeof(length),"Content-Length: %d\r\n",(int)content_len);
+		head+=length;
+	}
+	head+="\r\n";
+	resp->started=true;
+	return send_all(resp->fd,head.data(),head.size());
+}
+
+static void close_session(host_httpd* server, size_t i) {
+	close(server->sessions[i].fd);
+	server->sessions.erase(server->sessions.begin()+i);
+}
+
+/* Serve the complete requests received on session i, returns false if it must be closed */
+static bool serve(host_httpd* server, host_httpd_session& session) {
+	size_t end;
+	while((end=session.in.find("\r\n\r\n"))!=std::string::npos) {
+		std::string head=session.in.substr(0,end+2);
+		size_t content_len=0;
+		const char* cl=strcasestr(head.c_str(),"\r\nContent-Length:");
+		if(cl!=NULL) {
+			content_len=strtoul(cl+17,NULL,10);
+		}
+		if(session.in.size()<end+4+content_len) {
+			return true;
+		}
+		// Request bodies are not used, they are discarded
+		session.in.erase(0,end+4+content_len);
+
+		char method[16], target[HTTPD_MAX_URI_LEN+1];
+		if(sscanf(head.c_str(),"%15s %512s",method,target)!=2) {
+			return false;
+		}
+		bool close_after=strcasestr(head.c_str(),"\r\nConnection: close")!=NULL;
+
+		// The uri of httpd_req_t is const, so that handlers do not change it
+		alignas(httpd_req_t) char req_storage[sizeof(httpd_req_t)];
+		memset(req_storage,0,sizeof(req_storage));
+		httpd_req_t& req=*(httpd_req_t*)req_storage;
+		host_httpd_resp resp;
+		resp.fd=session.fd;
+		resp.status=HTTPD_200;
+		resp.type=HTTPD_TYPE_TEXT;
+		resp.started=false;
+		resp.chunked=false;
+		resp.failed=false;
+		req.handle=server;
+		req.aux=&resp;
+		req.content_len=content_len;
+		req.method=strcmp(method,"GET")==0?HTTP_GET:strcmp(method,"POST")==0?HTTP_POST:
+				strcmp(method,"HEAD")==0?HTTP_HEAD:strcmp(method,"PUT")==0?HTTP_PUT:strcmp(method,"DELETE")==0?HTTP_DELETE:-1;
+		char* query=strchr(target,'?');
+		if(query!=NULL) {
+			*query++='\0';
+			resp.query=query;
+		}
+		strcpy((char*)req.uri,target);
+
+		const httpd_uri_t* handler=NULL;
+		bool uri_found=false;
+		for(const httpd_uri_t& h : server->handlers) {
+			if(strcmp(h.uri,target)==0) {
+				uri_found=true;
+				if(h.method==req.method) {
+					handler=&h;
+				}
+			}
+		}
+		if(handler==NULL) {
+			if(uri_found) {
+				httpd_resp_send_err(&req,HTTPD_405_METHOD_NOT_ALLOWED,"Request method for this URI is not handled by server");
+			} else {
+				httpd_resp_send_err(&req,HTTPD_404_NOT_FOUND,"Nothing matches the given URI");
+			}
+		} else {
+			req.user_ctx=handler->user_ctx;
+			if(handler->handler(&req)!=ESP_OK) {
+				// As esp_http_server, a failed handler closes the connection
+				return false;
+			}
+		}
+		if(resp.failed || close_after) {
+			return false;
+		}
+	}
+	if(session.in.size()>HTTPD_MAX_REQ_HDR_LEN) {
+		ESP_LOGW(LOG_TAG,"Request header too long, closing");
+		return false;
+	}
+	return true;
+}
+
+static void httpd_task(void* arg) {
+	host_httpd* server=(host_httpd*)arg;
+	std::vector<struct pollfd> fds;
+	char buf[1024];
+	while(!server->stop) {
+		fds.clear();
+		fds.push_back({ server->listen_fd, POLLIN, 0 });
+		for(host_httpd_session& s : server->sessions) {
+			fds.push_back({ s.fd, POLLIN, 0 });
+		}
+		if(poll(fds.data(),fds.size(),HTTPD_POLL_MS)<=0) {
+			continue;
+		}
+		int64_t now=esp_timer_get_time();
+
+		// Sessions first, as accepting may purge one of them
+		for(size_t i=fds.size()-1;i>0;i--) {
+			if(fds[i].revents==0) continue;
+			host_httpd_session& s=server->sessions[i-1];
+			ssize_t n=recv(s.fd,buf,sizeof(buf),0);
+			if(n<=0) {
+				close_session(server,i-1);
+				continue;
+			}
+			s.in.append(buf,n);
+			s.last_us=now;
+			if(!serve(server,s)) {
+				close_session(server,i-1);
+			}
+		}
+
+		if(fds[0].revents&POLLIN) {
+			int fd=accept(server->listen_fd,NULL,NULL);
+			if(fd<0) continue;
+			if(server->sessions.size()>=server->config.max_open_sockets) {
+				if(!server->config.lru_purge_enable) {
+					ESP_LOGW(LOG_TAG,"Too many connections, closing the new one");
+					close(fd);
+					continue;
+				}
+				size_t lru=0;
+				for(size_t i=1;i<server->sessions.size();i++) {
+					if(server->sessions[i].last_us<server->sessions[lru].last_us) lru=i;
+				}
+				close_session(server,lru);
+			}
+			int one=1;
+			setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&one,sizeof(one));
+			server->sessions.push_back({ fd, now, std::string() });
+		}
+	}
+	for(host_httpd_session& s : server->sessions) {
+		close(s.fd);
+	}
+	server->sessions.clear();
+	close(server->listen_fd);
+	server->stopped=true;
+	vTaskDelete(NULL);
+}
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config) {
+	uint16_t port=host_env("HOST_HTTP_PORT",config->server_port);
+	int fd=socket(AF_INET,SOCK_STREAM,0);
+	int one=1;
+	setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one));
+	struct sockaddr_in addr;
+	memset(&addr,0,sizeof(addr));
+	addr.sin_family=AF_INET;
+	addr.sin_port=htons(port);
+	addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+	if(fd<0 || bind(fd,(struct sockaddr*)&addr,sizeof(addr))<0 || listen(fd,config->backlog_conn)<0) {
+		ESP_LOGE(LOG_TAG,"Failed to listen on port %u: %s",port,strerror(errno));
+		if(fd>=0) close(fd);
+		return ESP_FAIL;
+	}
+
+	host_httpd* server=new host_httpd();
+	server->config=*config;
+	server->listen_fd=fd;
+	server->stop=false;
+	server->stopped=false;
+	xTaskCreatePinnedToCore(&httpd_task,"httpd",config->stack_size,server,config->task_priority,NULL,config->core_id);
+	ESP_LOGI(LOG_TAG,"Listening on 127.0.0.1:%u",port);
+	*handle=server;
+	return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+	host_httpd* server=(host_httpd*)handle;
+	if(server==NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	server->stop=true;
+	while(!server->stopped) {
+		vTaskDelay(1);
+	}
+	delete server;
+	return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri_handler) {
+	host_httpd* server=(host_httpd*)handle;
+	for(const httpd_uri_t& h : server->handlers) {
+		if(strcmp(h.uri,uri_handler->uri)==0 && h.method==uri_handler->method) {
+			return ESP_ERR_HTTPD_HANDLER_EXISTS;
+		}
+	}
+	if(server->handlers.size()>=server->config.max_uri_handlers) {
+		return ESP_ERR_HTTPD_HANDLERS_FULL;
+	}
+	server->handlers.push_back(*uri_handler);
+	return ESP_OK;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* r, char* buf, size_t buf_len) {
+	host_httpd_resp* resp=(host_httpd_resp*)r->aux;
+	if(resp->query.empty()) {
+		return ESP_ERR_NOT_FOUND;
+	}
+	if(buf_len==0) {
+		return ESP_ERR_HTTPD_RESULT_TRUNC;
+	}
+	strncpy(buf,resp->query.c_str(),buf_len-1);
+	buf[buf_len-1]='\0';
+	return resp->query.size()<buf_len?ESP_OK:ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+esp_err_t httpd_query_key_value(const char* qry, const char* key, char* val, size_t val_size) {
+	size_t key_len=strlen(key);
+	const char* p=qry;
+	while(p!=NULL && *p!='\0') {
+		const char* end=strchr(p,'&');
+		if(end==NULL) end=p+strlen(p);
+		if(strncmp(p,key,key_len)==0 && p[key_len]=='=') {
+			const char* v=p+key_len+1;
+			size_t len=end-v;
+			if(val_size==0) {
+				return ESP_ERR_HTTPD_RESULT_TRUNC;
+			}
+			size_t n=len<val_size-1?len:val_size-1;
+			memcpy(val,v,n);
+			val[n]='\0';
+			return n<len?ESP_ERR_HTTPD_RESULT_TRUNC:ESP_OK;
+		}
+		p=*end=='&'?end+1:NULL;
+	}
+	return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t* r, const char* status) {
+	((host_httpd_resp*)r->aux)->status=status;
+	return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t* r, const char* type) {
+	((host_httpd_resp*)r->aux)->type=type;
+	return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t* r, const char* field, const char* value) {
+	host_httpd_resp* resp=(host_httpd_resp*)r->aux;
+	resp->headers+=std::string(field)+": "+value+"\r\n";
+	return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t* r, const char* buf, ssize_t buf_len) {
+	host_httpd_resp* resp=(host_httpd_resp*)r->aux;
+	if(buf_len==HTTPD_RESP_USE_STRLEN) {
+		buf_len=buf!=NULL?strlen(buf):0;
+	}
+	if(resp->started || !send_head(resp,buf_len) || (buf_len>0 && !send_all(resp->fd,buf,buf_len))) {
+		resp->failed=true;
+		return ESP_ERR_HTTPD_RESP_SEND;
+	}
+	return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* r, const char* buf, ssize_t buf_len) {
+	host_httpd_resp* resp=(host_httpd_resp*)r->aux;
+	if(buf_len==HTTPD_RESP_USE_STRLEN) {
+		buf_len=buf!=NULL?strlen(buf):0;
+	}
+	if(buf==NULL) {
+		buf_len=0;
+	}
+	if(resp->failed || (!resp->started && !send_head(resp,-1)) || !resp->chunked) {
+		resp->failed=true;
+		return ESP_ERR_HTTPD_RESP_SEND;
+	}
+	char size[16];
+	int n=snprintf(size,sizeof(size),"%x\r\n",(unsigned)buf_len);
+	if(!send_all(resp->fd,size,n) || (buf_len>0 && !send_all(resp->fd,buf,buf_len)) || !send_all(resp->fd,"\r\n",2)) {
+		resp->failed=true;
+		return ESP_ERR_HTTPD_RESP_SEND;
+	}
+	return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t* req, httpd_err_code_t error, const char* msg) {
+	static const char* statuses[HTTPD_ERR_CODE_MAX]={ "500 Internal Server Error", "501 Method Not Implemented",
+			"505 Version Not Supported", "400 Bad Request", "401 Unauthorized", "403 Forbidden", "404 Not Found",
+			"405 Method Not Allowed", "408 Request Timeout", "411 Length Required", "414 URI Too Long",
+			"431 Request Header Fields Too Large" };
+	httpd_resp_set_status(req,statuses[error<HTTPD_ERR_CODE_MAX?error:0]);
+	httpd_resp_set_type(req,HTTPD_TYPE_TEXT);
+	return httpd_resp_send(req,msg,HTTPD_RESP_USE_STRLEN);
+}
@@ -0,0 +1,244 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_ota.cpp
+#
+# Host emulation of the app partitions and of the OTA update API
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <string.h>
+#include <sys/mman.h>
+
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+}
+
+#include <mutex>
+
+static const char *LOG_TAG="HOST_OTA";
+
+/* App partitions of partitions_2OTA_spiffs.csv */
+static esp_partition_t partitions[]={
+	{ NULL, ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, 0x100000, 0x100000, "factory", false },
+	{ NULL, ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x200000, 0x100000, "ota_0", false },
+	{ NULL, ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x300000, 0x100000, "ota_1", false },
+};
+#define N_PARTITIONS (sizeof(partitions)/sizeof(partitions[0]))
+
+static std::mutex flash_lock;
+// Contents of each partition, mapped outside of the emulated heap
+static uint8_t* flash[N_PARTITIONS];
+
+static const esp_partition_t* running=&partitions[0];
+static const esp_partition_t* boot=&partitions[0];
+
+/* Single OTA in progress */
+static struct {
+	const esp_partition_t* partition;
+	esp_ota_handle_t handle;
+	size_t wrote;
+	bool sequential;
+} ota;
+static esp_ota_handle_t next_handle=1;
+
+static const esp_app_desc_t app_desc={ ESP_APP_DESC_MAGIC_WORD, 0, { 0, 0 }, "host", "ESP32MaximoMonitorGateway",
+		__TIME__, __DATE__, "host", { 0 }, { 0 } };
+
+static int partition_index(const esp_partition_t* partition) {
+	for(size_t i=0;i<N_PARTITIONS;i++) {
+		if(partition==&partitions[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static uint8_t* partition_flash(const esp_partition_t* partition) {
+	int i=partition_index(partition);
+	if(i<0) {
+		return NULL;
+	}
+	if(flash[i]==NULL) {
+		void* p=mmap(NULL,partition->size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+		if(p==MAP_FAILED) {
+			abort();
+		}
+		memset(p,0xff,partition->size);
+		flash[i]=(uint8_t*)p;
+	}
+	return flash[i];
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+	for(size_t i=0;i<N_PARTITIONS;i++) {
+		if(partitions[i].type==type && (subtype==ESP_PARTITION_SUBTYPE_ANY || partitions[i].subtype==subtype)
+				&& (label==NULL || strcmp(label,partitions[i].label)==0)) {
+			return &partitions[i];
+		}
+	}
+	return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+	std::lock_guard<std::mutex> lock(flash_lock);
+	uint8_t* p=partition_flash(partition);
+	if(p==NULL || src_offset+size>partition->size) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	memcpy(dst,p+src_offset,size);
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+	std::lock_guard<std::mutex> lock(flash_lock);
+	uint8_t* p=partition_flash(partition);
+	if(p==NULL || dst_offset+size>partition->size) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	for(size_t i=0;i<size;i++) {
+		p[dst_offset+i]&=((const uint8_t*)src)[i];
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+	std::lock_guard<std::mutex> lock(flash_lock);
+	uint8_t* p=partition_flash(partition);
+	if(p==NULL || offset+size>partition->size || offset%SPI_FLASH_SEC_SIZE!=0 || size%SPI_FLASH_SEC_SIZE!=0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	memset(p+offset,0xff,size);
+	return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+	return running;
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from) {
+	if(start_from==NULL) {
+		start_from=running;
+	}
+	// Next OTA partition after start_from, wrapping around
+	int i=partition_index(start_from);
+	for(size_t n=1;n<=N_PARTITIONS;n++) {
+		const esp_partition_t* p=&partitions[(i+n)%N_PARTITIONS];
+		if(p->subtype!=ESP_PARTITION_SUBTYPE_APP_FACTORY && p!=running) {
+			return p;
+		}
+	}
+	return NULL;
+}
+
+const esp_app_desc_t* esp_ota_get_app_description(void) {
+	return &app_desc;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle) {
+	if(partition_index(partition)<0 || partition->subtype==ESP_PARTITION_SUBTYPE_APP_FACTORY) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(partition==running) {
+		return ESP_ERR_OTA_PARTITION_CONFLICT;
+	}
+	if(image_size!=OTA_SIZE_UNKNOWN && image_size!=OTA_WITH_SEQUENTIAL_WRITES && image_size>partition->size) {
+		return ESP_ERR_INVALID_SIZE;
+	}
+	ota.sequential=image_size==OTA_WITH_SEQUENTIAL_WRITES;
+	if(!ota.sequential) {
+		size_t erase=image_size==OTA_SIZE_UNKNOWN?partition->size
+				:(image_size+SPI_FLASH_SEC_SIZE-1)/SPI_FLASH_SEC_SIZE*SPI_FLASH_SEC_SIZE;
+		esp_partition_erase_range(partition,0,erase);
+	}
+	ota.partition=partition;
+	ota.handle=next_handle++;
+	ota.wrote=0;
+	*out_handle=ota.handle;
+	ESP_LOGI(LOG_TAG,"OTA to %s started",partition->label);
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+	if(ota.partition==NULL || handle!=ota.handle) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(ota.wrote==0 && size>0 && ((const uint8_t*)data)[0]!=ESP_IMAGE_HEADER_MAGIC) {
+		return ESP_ERR_OTA_VALIDATE_FAILED;
+	}
+	if(ota.wrote+size>ota.partition->size) {
+		return ESP_ERR_INVALID_SIZE;
+	}
+	if(ota.sequential) {
+		// Erase the sectors reached by this write
+		size_t first=(ota.wrote+SPI_FLASH_SEC_SIZE-1)/SPI_FLASH_SEC_SIZE;
+		size_t last=(ota.wrote+size+SPI_FLASH_SEC_SIZE-1)/SPI_FLASH_SEC_SIZE;
+		if(last>first) {
+			esp_partition_erase_range(ota.partition,first*SPI_FLASH_SEC_SIZE,(last-first)*SPI_FLASH_SEC_SIZE);
+		}
+	}
+	esp_err_t err=esp_partition_write(ota.partition,ota.wrote,data,size);
+	if(err==ESP_OK) {
+		ota.wrote+=size;
+	}
+	return err;
+}
+
+/* The image starts with its header and that of its first segment, followed by the app description */
+static esp_err_t verify_image(const esp_partition_t* partition) {
+	uint8_t magic;
+	esp_app_desc_t desc;
+	if(esp_partition_read(partition,0,&magic,1)!=ESP_OK
+			|| esp_partition_read(partition,sizeof(esp_image_header_t)+sizeof(esp_image_segment_header_t),&desc,sizeof(desc))!=ESP_OK
+			|| magic!=ESP_IMAGE_HEADER_MAGIC || desc.magic_word!=ESP_APP_DESC_MAGIC_WORD) {
+		return ESP_ERR_OTA_VALIDATE_FAILED;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+	if(ota.partition==NULL || handle!=ota.handle) {
+		return ESP_ERR_NOT_FOUND;
+	}
+	esp_err_t err=verify_image(ota.partition);
+	ESP_LOGI(LOG_TAG,"OTA to %s ended after %u bytes: %s",ota.partition->label,ota.wrote,esp_err_to_name(err));
+	ota.partition=NULL;
+	return err;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+	if(ota.partition==NULL || handle!=ota.handle) {
+		return ESP_ERR_NOT_FOUND;
+	}
+	ota.partition=NULL;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+	if(partition_index(partition)<0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	esp_err_t err=verify_image(partition);
+	if(err==ESP_OK) {
+		boot=partition;
+		ESP_LOGI(LOG_TAG,"Boot partition set to %s",partition->label);
+	}
+	return err;
+}
+
+const esp_partition_t* esp_ota_get_boot_partition(void) {
+	return boot;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void) {
+	return ESP_OK;
+}
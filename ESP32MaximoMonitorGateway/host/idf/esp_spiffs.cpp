@@ -0,0 +1,166 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_spiffs.cpp
+#
+# Host emulation of the SPIFFS VFS, redirecting the paths of the gateway to a host directory
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+#include "esp_spiffs.h"
+}
+
+#include "host_internal.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const char *LOG_TAG="HOST_SPIFFS";
+
+// Size of the storage partition in partitions_2OTA_spiffs.csv
+#define HOST_SPIFFS_SIZE 0xef000
+
+static std::string spiffs_dir;
+static std::mutex spiffs_lock;
+static std::vector<std::string> spiffs_mounts;
+
+// Unwrapped libc functions, the gateway objects are linked with -Wl,--wrap=<function>
+extern "C" {
+FILE* __real_fopen(const char* path, const char* mode);
+int __real_stat(const char* path, struct stat* st);
+DIR* __real_opendir(const char* path);
+int __real_remove(const char* path);
+int __real_rename(const char* from, const char* to);
+int __real_unlink(const char* path);
+}
+
+/* Create the directories leading to path, SPIFFS has a flat namespace where any name can be created */
+static void make_parents(const char* path) {
+	char dir[PATH_MAX];
+	snprintf(dir,sizeof(dir),"%s",path);
+	for(char* p=dir+1;*p!='\0';p++) {
+		if(*p=='/') {
+			*p='\0';
+			mkdir(dir,0755);
+			*p='/';
+		}
+	}
+}
+
+/* Host path of a path under a mounted base path, or path itself */
+static const char* host_path(const char* path, char* buf, size_t size) {
+	std::lock_guard<std::mutex> lock(spiffs_lock);
+	for(const std::string& base : spiffs_mounts) {
+		if(path[0]=='/' && strncmp(path,base.c_str(),base.size())==0 && path[base.size()]=='/') {
+			snprintf(buf,size,"%s%s",spiffs_dir.c_str(),path+base.size());
+			return buf;
+		}
+	}
+	return path;
+}
+
+void host_spiffs_init(const char* dir) {
+	spiffs_dir=dir;
+}
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t* conf) {
+	std::lock_guard<std::mutex> lock(spiffs_lock);
+	for(const std::string& base : spiffs_mounts) {
+		if(base==conf->base_path) {
+			return ESP_ERR_INVALID_STATE;
+		}
+	}
+	struct stat st;
+	if(__real_stat(spiffs_dir.c_str(),&st)<0 || !S_ISDIR(st.st_mode)) {
+		if(!conf->format_if_mount_failed) {
+			ESP_LOGE(LOG_TAG,"No directory %s for the SPIFFS partition",spiffs_dir.c_str());
+			return ESP_FAIL;
+		}
+		mkdir(spiffs_dir.c_str(),0755);
+	}
+	spiffs_mounts.push_back(conf->base_path);
+	ESP_LOGI(LOG_TAG,"Mounted %s on '%s'",spiffs_dir.c_str(),conf->base_path);
+	return ESP_OK;
+}
+
+esp_err_t esp_vfs_spiffs_unregister(const char* partition_label) {
+	std::lock_guard<std::mutex> lock(spiffs_lock);
+	if(spiffs_mounts.empty()) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	spiffs_mounts.clear();
+	return ESP_OK;
+}
+
+static size_t spiffs_used;
+
+static int add_file_size(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+	if(type==FTW_F) {
+		spiffs_used+=st->st_size;
+	}
+	return 0;
+}
+
+esp_err_t esp_spiffs_info(const char* partition_label, size_t* total_bytes, size_t* used_bytes) {
+	std::lock_guard<std::mutex> lock(spiffs_lock);
+	if(spiffs_mounts.empty()) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	spiffs_used=0;
+	nftw(spiffs_dir.c_str(),&add_file_size,16,FTW_PHYS);
+	*total_bytes=HOST_SPIFFS_SIZE;
+	*used_bytes=spiffs_used;
+	return ESP_OK;
+}
+
+extern "C" FILE* __wrap_fopen(const char* path, const char* mode) {
+	char buf[PATH_MAX];
+	const char* mapped=host_path(path,buf,sizeof(buf));
+	if(mapped!=path && strpbrk(mode,"wa")!=NULL) {
+		make_parents(mapped);
+	}
+	return __real_fopen(mapped,mode);
+}
+
+extern "C" int __wrap_stat(const char* path, struct stat* st) {
+	char buf[PATH_MAX];
+	return __real_stat(host_path(path,buf,sizeof(buf)),st);
+}
+
+extern "C" DIR* __wrap_opendir(const char* path) {
+	char buf[PATH_MAX];
+	return __real_opendir(host_path(path,buf,sizeof(buf)));
+}
+
+extern "C" int __wrap_remove(const char* path) {
+	char buf[PATH_MAX];
+	return __real_remove(host_path(path,buf,sizeof(buf)));
+}
+
+extern "C" int __wrap_rename(const char* from, const char* to) {
+	char from_buf[PATH_MAX], to_buf[PATH_MAX];
+	return __real_rename(host_path(from,from_buf,sizeof(from_buf)),host_path(to,to_buf,sizeof(to_buf)));
+}
+
+extern "C" int __wrap_unlink(const char* path) {
+	char buf[PATH_MAX];
+	return __real_unlink(host_path(path,buf,sizeof(buf)));
+}
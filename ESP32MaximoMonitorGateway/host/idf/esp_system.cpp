@@ -0,0 +1,197 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_system.cpp
+#
+# Host emulation of error names, logging, system and GPIO functions
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "nvs.h"
+#include "driver/gpio.h"
+}
+
+#include "host_internal.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+
+static const char *LOG_TAG="HOST";
+
+typedef struct {
+	esp_err_t code;
+	const char* name;
+} esp_err_name_t;
+
+#define ERR_NAME(code) { code, #code }
+static const esp_err_name_t esp_err_names[]={
+	ERR_NAME(ESP_OK),
+	ERR_NAME(ESP_FAIL),
+	ERR_NAME(ESP_ERR_NO_MEM),
+	ERR_NAME(ESP_ERR_INVALID_ARG),
+	ERR_NAME(ESP_ERR_INVALID_STATE),
+	ERR_NAME(ESP_ERR_INVALID_SIZE),
+	ERR_NAME(ESP_ERR_NOT_FOUND),
+	ERR_NAME(ESP_ERR_NOT_SUPPORTED),
+	ERR_NAME(ESP_ERR_TIMEOUT),
+	ERR_NAME(ESP_ERR_NVS_NOT_INITIALIZED),
+	ERR_NAME(ESP_ERR_NVS_NOT_FOUND),
+	ERR_NAME(ESP_ERR_NVS_TYPE_MISMATCH),
+	ERR_NAME(ESP_ERR_NVS_READ_ONLY),
+	ERR_NAME(ESP_ERR_NVS_INVALID_HANDLE),
+	ERR_NAME(ESP_ERR_NVS_INVALID_LENGTH),
+	ERR_NAME(ESP_ERR_WIFI_NOT_INIT),
+	ERR_NAME(ESP_ERR_WIFI_NOT_STARTED),
+	ERR_NAME(ESP_ERR_WIFI_CONN),
+	ERR_NAME(ESP_ERR_WIFI_NOT_CONNECT),
+};
+
+const char* esp_err_to_name(esp_err_t code) {
+	for(size_t i=0;i<sizeof(esp_err_names)/sizeof(esp_err_names[0]);i++) {
+		if(esp_err_names[i].code==code) {
+			return esp_err_names[i].name;
+		}
+	}
+	return "ERROR";
+}
+
+static std::mutex log_lock;
+static std::map<std::string,esp_log_level_t> log_levels;
+static esp_log_level_t log_default_level=(esp_log_level_t)CONFIG_LOG_DEFAULT_LEVEL;
+static vprintf_like_t log_vprintf=&vprintf;
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+	std::lock_guard<std::mutex> lock(log_lock);
+	if(strcmp(tag,"*")==0) {
+		log_default_level=level;
+		log_levels.clear();
+	} else {
+		log_levels[tag]=level;
+	}
+}
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func) {
+	std::lock_guard<std::mutex> lock(log_lock);
+	vprintf_like_t previous=log_vprintf;
+	log_vprintf=func;
+	return previous;
+}
+
+uint32_t esp_log_timestamp(void) {
+	return (uint32_t)(esp_timer_get_time()/1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+	// Whole lines are written under the lock, so that tasks do not interleave
+	std::lock_guard<std::mutex> lock(log_lock);
+	auto it=log_levels.find(tag);
+	if(level>(it!=log_levels.end()?it->second:log_default_level)) {
+		return;
+	}
+	va_list args;
+	va_start(args,format);
+	(*log_vprintf)(format,args);
+	va_end(args);
+	fflush(stdout);
+}
+
+static std::mutex random_lock;
+static std::mt19937 random_engine(std::random_device{}());
+
+uint32_t esp_random(void) {
+	std::lock_guard<std::mutex> lock(random_lock);
+	return random_engine();
+}
+
+void esp_fill_random(void* buf, size_t len) {
+	uint8_t* p=(uint8_t*)buf;
+	for(size_t i=0;i<len;i+=4) {
+		uint32_t r=esp_random();
+		memcpy(p+i,&r,len-i<4?len-i:4);
+	}
+}
+
+/* Espressif OUI, the process id makes the address of each running gateway unique */
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type) {
+	uint32_t pid=(uint32_t)getpid();
+	mac[0]=0x24; mac[1]=0x0a; mac[2]=0xc4;
+	mac[3]=pid>>16; mac[4]=pid>>8; mac[5]=pid;
+	return ESP_OK;
+}
+
+void esp_restart(void) {
+	ESP_LOGW(LOG_TAG,"Restart requested, exiting");
+	fflush(stdout);
+	_exit(0);
+}
+
+static uint32_t heap_size;
+static size_t heap_base;
+static std::atomic<uint32_t> heap_min_free(UINT32_MAX);
+
+/* Bytes allocated from the single malloc arena, small blocks and mmapped ones */
+static size_t heap_used() {
+	struct mallinfo2 info=mallinfo2();
+	return info.uordblks+info.hblkhd;
+}
+
+void host_heap_init(uint32_t heap_kb) {
+	// One arena for all threads, so that mallinfo2 accounts for all of them
+	mallopt(M_ARENA_MAX,1);
+	heap_size=heap_kb*1024;
+	heap_base=heap_used();
+}
+
+uint32_t esp_get_free_heap_size(void) {
+	size_t used=heap_used()-heap_base;
+	uint32_t free_size=used<heap_size?heap_size-used:0;
+	uint32_t min_free=heap_min_free.load();
+	while(free_size<min_free && !heap_min_free.compare_exchange_weak(min_free,free_size));
+	return free_size;
+}
+
+void host_heap_sample(void) {
+	esp_get_free_heap_size();
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+	uint32_t free_size=esp_get_free_heap_size();
+	uint32_t min_free=heap_min_free.load();
+	return min_free<free_size?min_free:free_size;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+	return gpio_num<GPIO_NUM_MAX?ESP_OK:ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+	ESP_LOGV(LOG_TAG,"GPIO %d set to %u",gpio_num,level);
+	return gpio_num<GPIO_NUM_MAX?ESP_OK:ESP_ERR_INVALID_ARG;
+}
+
+/* Internal temperature sensor in degrees Fahrenheit, around 130 F */
+extern "C" uint8_t temprature_sens_read() {
+	return 125+esp_random()%10;
+}
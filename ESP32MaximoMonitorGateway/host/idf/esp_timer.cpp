@@ -0,0 +1,155 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_timer.cpp
+#
+# Host emulation of esp_timer, callbacks run in order on the esp_timer task
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+#include "host_internal.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct esp_timer {
+	esp_timer_cb_t callback;
+	void* arg;
+	std::string name;
+	bool skip_unhandled_events;
+	bool armed;
+	int64_t alarm_us;
+	uint64_t period_us;
+};
+
+static std::mutex timer_lock;
+static std::condition_variable timer_cv;
+static std::vector<esp_timer*> timers;
+static esp_timer* timer_running=NULL;
+static std::once_flag timer_task_once;
+static TaskHandle_t timer_task_handle;
+
+int64_t esp_timer_get_time(void) {
+	static const std::chrono::steady_clock::time_point epoch=std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-epoch).count();
+}
+
+/* Fire the due timers, sleeping until the next alarm */
+static void timer_task(void* arg) {
+	std::unique_lock<std::mutex> lock(timer_lock);
+	for(;;) {
+		esp_timer* next=NULL;
+		for(esp_timer* timer : timers) {
+			if(timer->armed && (next==NULL || timer->alarm_us<next->alarm_us)) {
+				next=timer;
+			}
+		}
+		if(next==NULL) {
+			timer_cv.wait(lock);
+			continue;
+		}
+		int64_t now=esp_timer_get_time();
+		if(next->alarm_us>now) {
+			timer_cv.wait_for(lock,std::chrono::microseconds(next->alarm_us-now));
+			continue;
+		}
+
+		if(next->period_us>0) {
+			next->alarm_us=next->skip_unhandled_events?now+next->period_us:next->alarm_us+next->period_us;
+		} else {
+			next->armed=false;
+		}
+		// The callback may start, stop or delete timers
+		timer_running=next;
+		lock.unlock();
+		next->callback(next->arg);
+		host_heap_sample();
+		lock.lock();
+		timer_running=NULL;
+		timer_cv.notify_all();
+	}
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+	if(args==NULL || args->callback==NULL || handle==NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	std::call_once(timer_task_once,[]() {
+		xTaskCreate(&timer_task,"esp_timer",CONFIG_ESP_TIMER_TASK_STACK_SIZE,NULL,22,&timer_task_handle);
+	});
+	esp_timer* timer=new esp_timer();
+	timer->callback=args->callback;
+	timer->arg=args->arg;
+	timer->name=args->name!=NULL?args->name:"";
+	timer->skip_unhandled_events=args->skip_unhandled_events;
+	timer->armed=false;
+	std::lock_guard<std::mutex> lock(timer_lock);
+	timers.push_back(timer);
+	*handle=timer;
+	return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+	std::lock_guard<std::mutex> lock(timer_lock);
+	if(timer->armed) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	timer->armed=true;
+	timer->alarm_us=esp_timer_get_time()+timeout_us;
+	timer->period_us=period_us;
+	timer_cv.notify_all();
+	return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+	return timer_start(timer,timeout_us,0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+	return timer_start(timer,period_us,period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+	std::lock_guard<std::mutex> lock(timer_lock);
+	if(!timer->armed) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	timer->armed=false;
+	return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+	std::unique_lock<std::mutex> lock(timer_lock);
+	if(timer->armed) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	// Wait for a running callback to return, unless deleted from it
+	if(xTaskGetCurrentTaskHandle()!=timer_task_handle) {
+		timer_cv.wait(lock,[timer]() { return timer_running!=timer; });
+	}
+	for(auto it=timers.begin();it!=timers.end();++it) {
+		if(*it==timer) {
+			timers.erase(it);
+			break;
+		}
+	}
+	delete timer;
+	return ESP_OK;
+}
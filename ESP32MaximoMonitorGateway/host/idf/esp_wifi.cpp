@@ -0,0 +1,359 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_wifi.cpp
+#
+# Host emulation of the Wifi station, the network interface, DNS and mDNS, with a single simulated AP
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <string.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "mdns.h"
+#include "freertos/task.h"
+#include "host_emul.h"
+}
+
+#include "host_internal.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+static const char *LOG_TAG="HOST_WIFI";
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+// The simulated AP, which accepts any SSID and password
+static const uint8_t host_ap_bssid[6]={ 0x02, 0x00, 0x5e, 0x10, 0x00, 0x01 };
+#define HOST_AP_CHANNEL 6
+#define HOST_AP_RSSI -55
+
+struct esp_netif_obj {
+	char hostname[33];
+	esp_netif_ip_info_t ip_info;
+};
+
+static esp_netif_obj sta_netif;
+
+static std::mutex wifi_lock;
+static wifi_config_t wifi_config;
+static bool wifi_initialised=false;
+static bool wifi_started=false;
+static bool wifi_associated=false;
+static std::atomic<bool> wifi_has_ip(false);
+static int64_t wifi_down_until_us=0;
+static uint32_t wifi_connect_ms;
+static esp_timer_handle_t wifi_connect_timer=NULL;
+
+static void post_disconnected(uint8_t reason) {
+	wifi_event_sta_disconnected_t event;
+	memset(&event,0,sizeof(event));
+	memcpy(event.ssid,wifi_config.sta.ssid,sizeof(event.ssid));
+	event.ssid_len=strnlen((const char*)event.ssid,sizeof(event.ssid));
+	event.reason=reason;
+	esp_event_post(WIFI_EVENT,WIFI_EVENT_STA_DISCONNECTED,&event,sizeof(event),portMAX_DELAY);
+}
+
+/* End of an association attempt, made of the authentication, association and DHCP exchanges */
+static void connect_done(void* arg) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_started || wifi_associated) {
+		return;
+	}
+	bool pinned_elsewhere=wifi_config.sta.bssid_set
+			&& (memcmp(wifi_config.sta.bssid,host_ap_bssid,sizeof(host_ap_bssid))!=0
+					|| (wifi_config.sta.channel!=0 && wifi_config.sta.channel!=HOST_AP_CHANNEL));
+	if(esp_timer_get_time()<wifi_down_until_us || wifi_config.sta.ssid[0]=='\0' || pinned_elsewhere) {
+		post_disconnected(WIFI_REASON_NO_AP_FOUND);
+		return;
+	}
+	wifi_associated=true;
+
+	wifi_event_sta_connected_t connected;
+	memset(&connected,0,sizeof(connected));
+	memcpy(connected.ssid,wifi_config.sta.ssid,sizeof(connected.ssid));
+	connected.ssid_len=strnlen((const char*)connected.ssid,sizeof(connected.ssid));
+	memcpy(connected.bssid,host_ap_bssid,sizeof(host_ap_bssid));
+	connected.channel=HOST_AP_CHANNEL;
+	connected.authmode=WIFI_AUTH_WPA2_PSK;
+	esp_event_post(WIFI_EVENT,WIFI_EVENT_STA_CONNECTED,&connected,sizeof(connected),portMAX_DELAY);
+
+	ip_event_got_ip_t got_ip;
+	memset(&got_ip,0,sizeof(got_ip));
+	got_ip.esp_netif=&sta_netif;
+	sta_netif.ip_info.ip.addr=ESP_IP4TOADDR(192,168,4,2);
+	sta_netif.ip_info.netmask.addr=ESP_IP4TOADDR(255,255,255,0);
+	sta_netif.ip_info.gw.addr=ESP_IP4TOADDR(192,168,4,1);
+	got_ip.ip_info=sta_netif.ip_info;
+	wifi_has_ip=true;
+	esp_event_post(IP_EVENT,IP_EVENT_STA_GOT_IP,&got_ip,sizeof(got_ip),portMAX_DELAY);
+}
+
+/* Drop the association under wifi_lock, as the AP or the station would */
+static void disassociate(uint8_t reason) {
+	if(wifi_associated) {
+		wifi_associated=false;
+		wifi_has_ip=false;
+		memset(&sta_netif.ip_info,0,sizeof(sta_netif.ip_info));
+		post_disconnected(reason);
+	}
+}
+
+// Names of the simulated DNS server and mDNS responders, to addresses in network order
+static std::mutex dns_lock;
+static std::map<std::string,uint32_t> dns_names;
+static uint32_t dns_ms;
+
+void host_wifi_init(uint32_t connect_ms, uint32_t dns_ms, const char* dns_names) {
+	wifi_connect_ms=connect_ms;
+	::dns_ms=dns_ms;
+	std::string names=dns_names;
+	size_t start=0;
+	while(start<names.size()) {
+		size_t end=names.find(',',start);
+		if(end==std::string::npos) end=names.size();
+		std::string entry=names.substr(start,end-start);
+		size_t eq=entry.find('=');
+		if(eq!=std::string::npos) {
+			host_dns_set(entry.substr(0,eq).c_str(),entry.substr(eq+1).c_str());
+		}
+		start=end+1;
+	}
+}
+
+void host_dns_set(const char* name, const char* addr) {
+	struct in_addr in;
+	if(inet_aton(addr,&in)==0) {
+		ESP_LOGE(LOG_TAG,"Invalid address %s for %s",addr,name);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(dns_lock);
+	dns_names[name]=in.s_addr;
+	ESP_LOGI(LOG_TAG,"%s is at %s",name,addr);
+}
+
+bool host_dns_lookup(const char* name, uint32_t* addr) {
+	struct in_addr in;
+	if(inet_aton(name,&in)!=0) {
+		*addr=in.s_addr;
+		return true;
+	}
+	vTaskDelay(pdMS_TO_TICKS(dns_ms));
+	std::lock_guard<std::mutex> lock(dns_lock);
+	auto it=dns_names.find(name);
+	if(it==dns_names.end()) {
+		return false;
+	}
+	*addr=it->second;
+	return true;
+}
+
+/* getaddrinfo of lwip/netdb.h, not included here as it renames getaddrinfo */
+extern "C" int host_getaddrinfo(const char* nodename, const char* servname, const struct addrinfo* hints, struct addrinfo** res) {
+	uint32_t addr;
+	if(!host_wifi_up()) {
+		return EAI_AGAIN;
+	}
+	if(nodename==NULL || !host_dns_lookup(nodename,&addr)) {
+		return EAI_NONAME;
+	}
+	// The system resolver builds the result, from the numeric address only
+	struct addrinfo numeric;
+	memset(&numeric,0,sizeof(numeric));
+	if(hints!=NULL) {
+		numeric=*hints;
+	}
+	numeric.ai_flags|=AI_NUMERICHOST;
+	struct in_addr in;
+	in.s_addr=addr;
+	return getaddrinfo(inet_ntoa(in),servname,&numeric,res);
+}
+
+bool host_wifi_up(void) {
+	return wifi_has_ip;
+}
+
+void host_wifi_drop(uint32_t down_ms) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	ESP_LOGW(LOG_TAG,"AP down for %u ms",down_ms);
+	wifi_down_until_us=esp_timer_get_time()+(int64_t)down_ms*1000;
+	disassociate(WIFI_REASON_BEACON_TIMEOUT);
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_initialised) {
+		esp_timer_create_args_t timer_args;
+		memset(&timer_args,0,sizeof(timer_args));
+		timer_args.callback=&connect_done;
+		timer_args.name="host_wifi";
+		esp_err_t err=esp_timer_create(&timer_args,&wifi_connect_timer);
+		if(err!=ESP_OK) {
+			return err;
+		}
+		wifi_initialised=true;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	return wifi_initialised?ESP_OK:ESP_ERR_WIFI_NOT_INIT;
+}
+
+esp_err_t esp_wifi_set_config(esp_interface_t interface, wifi_config_t* conf) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_initialised) {
+		return ESP_ERR_WIFI_NOT_INIT;
+	}
+	wifi_config=*conf;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(esp_interface_t interface, wifi_config_t* conf) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_initialised) {
+		return ESP_ERR_WIFI_NOT_INIT;
+	}
+	*conf=wifi_config;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_initialised) {
+		return ESP_ERR_WIFI_NOT_INIT;
+	}
+	if(!wifi_started) {
+		wifi_started=true;
+		esp_event_post(WIFI_EVENT,WIFI_EVENT_STA_START,NULL,0,portMAX_DELAY);
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_initialised) {
+		return ESP_ERR_WIFI_NOT_INIT;
+	}
+	if(wifi_started) {
+		disassociate(WIFI_REASON_ASSOC_LEAVE);
+		esp_timer_stop(wifi_connect_timer);
+		wifi_started=false;
+		esp_event_post(WIFI_EVENT,WIFI_EVENT_STA_STOP,NULL,0,portMAX_DELAY);
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_started) {
+		return ESP_ERR_WIFI_NOT_STARTED;
+	}
+	if(wifi_associated) {
+		return ESP_ERR_WIFI_CONN;
+	}
+	// A new attempt supersedes the one in progress
+	esp_timer_stop(wifi_connect_timer);
+	esp_timer_start_once(wifi_connect_timer,(uint64_t)wifi_connect_ms*1000);
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_started) {
+		return ESP_ERR_WIFI_NOT_STARTED;
+	}
+	esp_timer_stop(wifi_connect_timer);
+	disassociate(WIFI_REASON_ASSOC_LEAVE);
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	if(!wifi_associated) {
+		return ESP_ERR_WIFI_NOT_CONNECT;
+	}
+	memset(ap_info,0,sizeof(*ap_info));
+	memcpy(ap_info->bssid,host_ap_bssid,sizeof(host_ap_bssid));
+	memcpy(ap_info->ssid,wifi_config.sta.ssid,sizeof(wifi_config.sta.ssid));
+	ap_info->primary=HOST_AP_CHANNEL;
+	ap_info->rssi=HOST_AP_RSSI;
+	ap_info->authmode=WIFI_AUTH_WPA2_PSK;
+	return ESP_OK;
+}
+
+esp_err_t esp_netif_init(void) {
+	return ESP_OK;
+}
+
+esp_netif_t* esp_netif_create_default_wifi_sta(void) {
+	return &sta_netif;
+}
+
+esp_err_t esp_netif_set_hostname(esp_netif_t* netif, const char* hostname) {
+	snprintf(netif->hostname,sizeof(netif->hostname),"%s",hostname);
+	return ESP_OK;
+}
+
+esp_err_t esp_netif_get_hostname(esp_netif_t* netif, const char** hostname) {
+	*hostname=netif->hostname;
+	return ESP_OK;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t* netif, esp_netif_ip_info_t* ip_info) {
+	std::lock_guard<std::mutex> lock(wifi_lock);
+	*ip_info=netif->ip_info;
+	return ESP_OK;
+}
+
+esp_err_t mdns_init(void) {
+	return ESP_OK;
+}
+
+esp_err_t mdns_hostname_set(const char* hostname) {
+	return ESP_OK;
+}
+
+esp_err_t mdns_instance_name_set(const char* instance_name) {
+	return ESP_OK;
+}
+
+esp_err_t mdns_service_add(const char* instance_name, const char* service_type, const char* proto, uint16_t port,
+		mdns_txt_item_t txt[], size_t num_items) {
+	return ESP_OK;
+}
+
+esp_err_t mdns_service_txt_item_set(const char* service_type, const char* proto, const char* key, const char* value) {
+	return ESP_OK;
+}
+
+esp_err_t mdns_query_a(const char* host_name, uint32_t timeout, esp_ip4_addr_t* addr) {
+	std::string name=std::string(host_name)+".local";
+	uint32_t a;
+	if(!host_wifi_up() || !host_dns_lookup(name.c_str(),&a)) {
+		// No answer, after the whole query
+		vTaskDelay(pdMS_TO_TICKS(timeout));
+		return ESP_ERR_NOT_FOUND;
+	}
+	addr->addr=a;
+	return ESP_OK;
+}
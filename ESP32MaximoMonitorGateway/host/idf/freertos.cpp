@@ -0,0 +1,331 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# freertos.cpp
+#
+# Host emulation of FreeRTOS tasks, semaphores and event groups over C++11 threads
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <time.h>
+}
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct host_task {
+	std::string name;
+	uint32_t stack_depth;
+	UBaseType_t priority;
+	BaseType_t core;
+	pthread_t thread;
+	bool running=false;
+	std::mutex lock;
+	std::condition_variable cv;
+	uint32_t notify=0;
+};
+
+struct host_semaphore {
+	std::mutex lock;
+	std::condition_variable cv;
+	UBaseType_t count;
+	UBaseType_t max_count;
+};
+
+struct host_event_group {
+	std::mutex lock;
+	std::condition_variable cv;
+	EventBits_t bits=0;
+};
+
+// Task of the calling thread, created on first use for threads not started by xTaskCreate
+static thread_local host_task* current_task=NULL;
+
+// Tasks created so far, for run time statistics
+static std::mutex tasks_lock;
+static std::vector<host_task*> tasks;
+
+/* Start running task in the calling thread */
+static void task_attach(host_task* task) {
+	current_task=task;
+	std::lock_guard<std::mutex> guard(tasks_lock);
+	task->thread=pthread_self();
+	task->running=true;
+	tasks.push_back(task);
+}
+
+/* Wait on cv until done() holds or ticks elapse, returns done() */
+template<typename Pred> static bool wait_ticks(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+		TickType_t ticks, Pred done) {
+	if(ticks==portMAX_DELAY) {
+		cv.wait(lock,done);
+		return true;
+	}
+	return cv.wait_for(lock,std::chrono::milliseconds((uint64_t)ticks*portTICK_PERIOD_MS),done);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+		UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+	host_task* task=new host_task();
+	task->name=name;
+	task->stack_depth=stack_depth;
+	task->priority=priority;
+	task->core=core;
+	if(handle!=NULL) {
+		*handle=task;
+	}
+	std::thread([=]() {
+		task_attach(task);
+		fn(arg);
+	}).detach();
+	return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+		UBaseType_t priority, TaskHandle_t* handle) {
+	return xTaskCreatePinnedToCore(fn,name,stack_depth,arg,priority,handle,tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+	if(task==NULL || task==current_task) {
+		// Ends the thread, the handle is leaked as other tasks may still hold it
+		if(current_task!=NULL) {
+			std::lock_guard<std::mutex> guard(tasks_lock);
+			current_task->running=false;
+		}
+		pthread_exit(NULL);
+	}
+}
+
+void vTaskDelay(TickType_t ticks) {
+	std::this_thread::sleep_for(std::chrono::milliseconds((uint64_t)ticks*portTICK_PERIOD_MS));
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake, TickType_t period) {
+	*previous_wake+=period;
+	int64_t wake_us=(int64_t)*previous_wake*portTICK_PERIOD_MS*1000;
+	int64_t now_us=esp_timer_get_time();
+	if(wake_us>now_us) {
+		std::this_thread::sleep_for(std::chrono::microseconds(wake_us-now_us));
+	}
+}
+
+/* Ticks count from the same origin as esp_timer_get_time */
+TickType_t xTaskGetTickCount(void) {
+	return (TickType_t)(esp_timer_get_time()/1000/portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	if(current_task==NULL) {
+		host_task* task=new host_task();
+		task->name="host";
+		task->stack_depth=0;
+		task->priority=0;
+		task->core=tskNO_AFFINITY;
+		task_attach(task);
+	}
+	return current_task;
+}
+
+char* pcTaskGetTaskName(TaskHandle_t task) {
+	if(task==NULL) {
+		task=xTaskGetCurrentTaskHandle();
+	}
+	return (char*)task->name.c_str();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+	if(task==NULL) {
+		task=xTaskGetCurrentTaskHandle();
+	}
+	return task->stack_depth;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t size, uint32_t* total_run_time) {
+	std::lock_guard<std::mutex> guard(tasks_lock);
+	UBaseType_t n=0;
+	for(host_task* task : tasks) {
+		n+=task->running;
+	}
+	if(n>size) {
+		return 0;
+	}
+	n=0;
+	for(size_t i=0;i<tasks.size();i++) {
+		host_task* task=tasks[i];
+		clockid_t clock;
+		struct timespec ts;
+		if(!task->running || pthread_getcpuclockid(task->thread,&clock)!=0 || clock_gettime(clock,&ts)!=0) {
+			continue;
+		}
+		TaskStatus_t& s=status[n++];
+		s.xHandle=task;
+		s.pcTaskName=task->name.c_str();
+		s.xTaskNumber=i+1;
+		s.uxCurrentPriority=task->priority;
+		s.uxBasePriority=task->priority;
+		s.ulRunTimeCounter=(uint32_t)((uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000);
+		s.usStackHighWaterMark=task->stack_depth;
+		s.xCoreID=task->core;
+	}
+	if(total_run_time!=NULL) {
+		*total_run_time=(uint32_t)esp_timer_get_time();
+	}
+	return n;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+	std::lock_guard<std::mutex> guard(tasks_lock);
+	UBaseType_t n=0;
+	for(host_task* task : tasks) {
+		n+=task->running;
+	}
+	return n;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandleForCPU(UBaseType_t cpu) {
+	return NULL;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+	host_task* task=xTaskGetCurrentTaskHandle();
+	std::unique_lock<std::mutex> lock(task->lock);
+	if(!wait_ticks(task->cv,lock,ticks,[task]() { return task->notify>0; })) {
+		return 0;
+	}
+	uint32_t value=task->notify;
+	task->notify=clear_on_exit?0:value-1;
+	return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+	{
+		std::lock_guard<std::mutex> lock(task->lock);
+		task->notify++;
+	}
+	task->cv.notify_one();
+	return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+	xTaskNotifyGive(task);
+	if(higher_priority_task_woken!=NULL) {
+		*higher_priority_task_woken=pdFALSE;
+	}
+}
+
+static SemaphoreHandle_t semaphore_create(UBaseType_t max_count, UBaseType_t initial_count) {
+	host_semaphore* sem=new host_semaphore();
+	sem->count=initial_count;
+	sem->max_count=max_count;
+	return sem;
+}
+
+/* Mutexes are binary semaphores given at creation, without priority inheritance */
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+	return semaphore_create(1,1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+	return semaphore_create(1,0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+	return semaphore_create(max_count,initial_count);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+	delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+	std::unique_lock<std::mutex> lock(sem->lock);
+	if(!wait_ticks(sem->cv,lock,ticks,[sem]() { return sem->count>0; })) {
+		return pdFALSE;
+	}
+	sem->count--;
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+	{
+		std::lock_guard<std::mutex> lock(sem->lock);
+		if(sem->count>=sem->max_count) {
+			return pdFALSE;
+		}
+		sem->count++;
+	}
+	sem->cv.notify_one();
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* higher_priority_task_woken) {
+	if(higher_priority_task_woken!=NULL) {
+		*higher_priority_task_woken=pdFALSE;
+	}
+	return xSemaphoreGive(sem);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem) {
+	std::lock_guard<std::mutex> lock(sem->lock);
+	return sem->count;
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+	return new host_event_group();
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+	delete group;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+		BaseType_t wait_for_all, TickType_t ticks) {
+	std::unique_lock<std::mutex> lock(group->lock);
+	auto done=[=]() { return wait_for_all?(group->bits&bits)==bits:(group->bits&bits)!=0; };
+	bool set=wait_ticks(group->cv,lock,ticks,done);
+	EventBits_t value=group->bits;
+	if(set && clear_on_exit) {
+		group->bits&=~bits;
+	}
+	return value;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+	std::lock_guard<std::mutex> lock(group->lock);
+	group->bits|=bits;
+	group->cv.notify_all();
+	return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+	std::lock_guard<std::mutex> lock(group->lock);
+	EventBits_t value=group->bits;
+	group->bits&=~bits;
+	return value;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+	std::lock_guard<std::mutex> lock(group->lock);
+	return group->bits;
+}
@@ -0,0 +1,41 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# host_emul.cpp
+#
+# Start up of the host emulation from environment settings
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <stdlib.h>
+#include "host_emul.h"
+}
+
+#include "host_internal.h"
+
+uint32_t host_env(const char* name, uint32_t def) {
+	const char* value=getenv(name);
+	return value!=NULL?strtoul(value,NULL,10):def;
+}
+
+const char* host_env_str(const char* name, const char* def) {
+	const char* value=getenv(name);
+	return value!=NULL?value:def;
+}
+
+void host_emul_init(void) {
+	host_heap_init(host_env("HOST_HEAP_KB",300));
+	host_spiffs_init(host_env_str("HOST_SPIFFS_DIR","spiffs_image"));
+	host_wifi_init(host_env("HOST_WIFI_CONNECT_MS",100),host_env("HOST_DNS_MS",20),host_env_str("HOST_DNS",""));
+	host_broker_init(host_env("HOST_MQTT_CONNECT_MS",50),host_env("HOST_MQTT_TLS_MS",1500),host_env("HOST_MQTT_LATENCY_MS",20),
+			host_env("HOST_MQTT_LOSS_PCT",0),host_env("HOST_BROKER_REPORT_S",10),host_env_str("HOST_BROKER_ADDR",""));
+}
@@ -0,0 +1,39 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# host_internal.h
+#
+# Functions shared between the parts of the host emulation
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_INTERNAL_H_
+#define HOST_INTERNAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Take the current allocations as the baseline of the emulated heap */
+void host_heap_init(uint32_t heap_kb);
+/* Update the minimum free heap, called periodically by the emulation tasks */
+void host_heap_sample(void);
+
+void host_spiffs_init(const char* dir);
+void host_wifi_init(uint32_t connect_ms, uint32_t dns_ms, const char* dns_names);
+/* Address of a name known to the simulated DNS, or of a numeric address, in network order.
+ * Names take dns_ms to resolve, numeric addresses none */
+bool host_dns_lookup(const char* name, uint32_t* addr);
+/* True while the station has an IP address */
+bool host_wifi_up(void);
+void host_broker_init(uint32_t connect_ms, uint32_t tls_ms, uint32_t latency_ms, uint32_t loss_pct, uint32_t report_s, const char* addr);
+
+#endif /* HOST_INTERNAL_H_ */
@@ -0,0 +1,120 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# adc.h
+#
+# Host emulation of the continuous-mode and one-shot ADC1 drivers, converting simulated signals
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_DRIVER_ADC_H_
+#define HOST_DRIVER_ADC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	ADC_ATTEN_DB_0=0,
+	ADC_ATTEN_DB_2_5,
+	ADC_ATTEN_DB_6,
+	ADC_ATTEN_DB_11
+} adc_atten_t;
+
+typedef enum {
+	ADC_WIDTH_BIT_9=0,
+	ADC_WIDTH_BIT_10,
+	ADC_WIDTH_BIT_11,
+	ADC_WIDTH_BIT_12
+} adc_bits_width_t;
+
+typedef enum {
+	ADC1_CHANNEL_0=0,
+	ADC1_CHANNEL_1,
+	ADC1_CHANNEL_2,
+	ADC1_CHANNEL_3,
+	ADC1_CHANNEL_4,
+	ADC1_CHANNEL_5,
+	ADC1_CHANNEL_6,
+	ADC1_CHANNEL_7,
+	ADC1_CHANNEL_MAX
+} adc1_channel_t;
+
+typedef enum {
+	ADC_CONV_SINGLE_UNIT_1=1,
+	ADC_CONV_SINGLE_UNIT_2=2,
+	ADC_CONV_BOTH_UNIT=3,
+	ADC_CONV_ALTER_UNIT=7
+} adc_digi_convert_mode_t;
+
+typedef enum {
+	ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+	ADC_DIGI_OUTPUT_FORMAT_TYPE2
+} adc_digi_output_format_t;
+
+typedef struct {
+	uint32_t max_store_buf_size;
+	uint32_t conv_num_each_intr;
+	uint32_t adc1_chan_mask;
+	uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+	uint8_t atten;
+	uint8_t channel;
+	uint8_t unit;
+	uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+	bool conv_limit_en;
+	uint32_t conv_limit_num;
+	uint32_t pattern_num;
+	adc_digi_pattern_config_t* adc_pattern;
+	uint32_t sample_freq_hz;
+	adc_digi_convert_mode_t conv_mode;
+	adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+typedef struct {
+	union {
+		struct {
+			uint16_t data:12;
+			uint16_t channel:4;
+		} type1;
+		uint16_t val;
+	};
+} adc_digi_output_data_t;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config);
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config);
+esp_err_t adc_digi_start(void);
+esp_err_t adc_digi_stop(void);
+esp_err_t adc_digi_deinitialize(void);
+/* Conversions received, in whole frames. Returns ESP_ERR_TIMEOUT if none were received within timeout_ms,
+ * ESP_ERR_INVALID_STATE along with the conversions if the buffer overflowed since the previous call */
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms);
+
+/* One-shot conversions, of the drivers before ESP-IDF 4.4 */
+esp_err_t adc1_config_width(adc_bits_width_t width_bit);
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten);
+/* Conversion of the channel at the current time, -1 if it is not configured */
+int adc1_get_raw(adc1_channel_t channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_DRIVER_ADC_H_ */
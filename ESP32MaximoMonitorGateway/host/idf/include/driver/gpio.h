@@ -0,0 +1,46 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# gpio.h
+#
+# Host emulation of the GPIO driver, outputs are only logged
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_DRIVER_GPIO_H_
+#define HOST_DRIVER_GPIO_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	GPIO_NUM_0=0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7,
+	GPIO_NUM_MAX=40
+} gpio_num_t;
+
+typedef enum {
+	GPIO_MODE_DISABLE=0,
+	GPIO_MODE_INPUT,
+	GPIO_MODE_OUTPUT
+} gpio_mode_t;
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_DRIVER_GPIO_H_ */
@@ -0,0 +1,33 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_crt_bundle.h
+#
+# Host emulation of the mbedTLS certificate bundle, which the emulated broker always passes
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_CRT_BUNDLE_H_
+#define HOST_ESP_CRT_BUNDLE_H_
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_crt_bundle_attach(void* conf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_CRT_BUNDLE_H_ */
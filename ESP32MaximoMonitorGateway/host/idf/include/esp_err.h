@@ -0,0 +1,61 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_err.h
+#
+# Host emulation of the ESP-IDF error codes
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_ERR_H_
+#define HOST_ESP_ERR_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+
+#define ESP_ERR_WIFI_BASE 0x3000
+#define ESP_ERR_NVS_BASE 0x1100
+
+const char* esp_err_to_name(esp_err_t code);
+
+#define ESP_ERROR_CHECK(x) do {															\
+		esp_err_t err_rc_=(x);															\
+		if(err_rc_!=ESP_OK) {															\
+			fprintf(stderr,"ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\n%s\n",	\
+					err_rc_,esp_err_to_name(err_rc_),__FILE__,__LINE__,#x);				\
+			abort();																	\
+		}																				\
+	} while(0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_ERR_H_ */
@@ -0,0 +1,35 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_idf_version.h
+#
+# Host emulation of the ESP-IDF version, that of the APIs emulated
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_IDF_VERSION_H_
+#define HOST_ESP_IDF_VERSION_H_
+
+/* May be given on the command line, e.g. -DESP_IDF_VERSION_MINOR=3, to build the code for an earlier version */
+#ifndef ESP_IDF_VERSION_MAJOR
+#define ESP_IDF_VERSION_MAJOR 4
+#endif
+#ifndef ESP_IDF_VERSION_MINOR
+#define ESP_IDF_VERSION_MINOR 4
+#endif
+#ifndef ESP_IDF_VERSION_PATCH
+#define ESP_IDF_VERSION_PATCH 0
+#endif
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) ((major << 16) | (minor << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(ESP_IDF_VERSION_MAJOR, ESP_IDF_VERSION_MINOR, ESP_IDF_VERSION_PATCH)
+
+#endif /* HOST_ESP_IDF_VERSION_H_ */
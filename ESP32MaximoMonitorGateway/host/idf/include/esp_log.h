@@ -0,0 +1,68 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_log.h
+#
+# Host emulation of the ESP-IDF logging macros, printed to stdout
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_LOG_H_
+#define HOST_ESP_LOG_H_
+
+#include <stdint.h>
+#include <stdarg.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	ESP_LOG_NONE,
+	ESP_LOG_ERROR,
+	ESP_LOG_WARN,
+	ESP_LOG_INFO,
+	ESP_LOG_DEBUG,
+	ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+typedef int (*vprintf_like_t)(const char*, va_list);
+
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
+uint32_t esp_log_timestamp(void);
+/* Not format checked: the gateway prints size_t with %d, which is right on the 32 bit target only */
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...);
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL CONFIG_LOG_DEFAULT_LEVEL
+#endif
+
+#define LOG_FORMAT(letter, format) #letter " (%u) %s: " format "\n"
+
+#define ESP_LOG_LEVEL_LOCAL(level, letter, tag, format, ...) do {						\
+		if(LOG_LOCAL_LEVEL>=level) {													\
+			esp_log_write(level,tag,LOG_FORMAT(letter,format),esp_log_timestamp(),tag,##__VA_ARGS__);	\
+		}																				\
+	} while(0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR, E, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN, W, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO, I, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG, D, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, V, tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_LOG_H_ */
@@ -0,0 +1,71 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_netif.h
+#
+# Host emulation of the esp_netif station interface
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_NETIF_H_
+#define HOST_ESP_NETIF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct esp_ip4_addr {
+	uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+	esp_ip4_addr_t ip;
+	esp_ip4_addr_t netmask;
+	esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct {
+	int if_index;
+	esp_netif_t* esp_netif;
+	esp_netif_ip_info_t ip_info;
+	bool ip_changed;
+} ip_event_got_ip_t;
+
+ESP_EVENT_DECLARE_BASE(IP_EVENT);
+
+typedef enum {
+	IP_EVENT_STA_GOT_IP,
+	IP_EVENT_STA_LOST_IP
+} ip_event_t;
+
+#define ESP_IP4TOADDR(a, b, c, d) (((uint32_t)(d)<<24)|((uint32_t)(c)<<16)|((uint32_t)(b)<<8)|(uint32_t)(a))
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) (int)((ipaddr)->addr&0xff),(int)(((ipaddr)->addr>>8)&0xff),	\
+		(int)(((ipaddr)->addr>>16)&0xff),(int)(((ipaddr)->addr>>24)&0xff)
+
+esp_err_t esp_netif_init(void);
+esp_netif_t* esp_netif_create_default_wifi_sta(void);
+esp_err_t esp_netif_set_hostname(esp_netif_t* netif, const char* hostname);
+esp_err_t esp_netif_get_hostname(esp_netif_t* netif, const char** hostname);
+esp_err_t esp_netif_get_ip_info(esp_netif_t* netif, esp_netif_ip_info_t* ip_info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_NETIF_H_ */
@@ -0,0 +1,57 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_ota_ops.h
+#
+# Host emulation of the OTA update API, over the emulated partitions
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_OTA_OPS_H_
+#define HOST_ESP_OTA_OPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_app_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ERR_OTA_BASE 0x1500
+#define ESP_ERR_OTA_PARTITION_CONFLICT (ESP_ERR_OTA_BASE+0x01)
+#define ESP_ERR_OTA_VALIDATE_FAILED (ESP_ERR_OTA_BASE+0x03)
+
+#define OTA_SIZE_UNKNOWN 0xffffffff
+#define OTA_WITH_SEQUENTIAL_WRITES 0xfffffffe
+
+typedef uint32_t esp_ota_handle_t;
+
+const esp_partition_t* esp_ota_get_running_partition(void);
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from);
+const esp_app_desc_t* esp_ota_get_app_description(void);
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle);
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size);
+/* Checks the image header, the partition must then be selected by esp_ota_set_boot_partition */
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition);
+const esp_partition_t* esp_ota_get_boot_partition(void);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_OTA_OPS_H_ */
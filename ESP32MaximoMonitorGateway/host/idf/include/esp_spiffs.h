@@ -0,0 +1,45 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_spiffs.h
+#
+# Host emulation of the SPIFFS VFS, mounted on a host directory
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_SPIFFS_H_
+#define HOST_ESP_SPIFFS_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	const char* base_path;
+	const char* partition_label;
+	size_t max_files;
+	bool format_if_mount_failed;
+} esp_vfs_spiffs_conf_t;
+
+/* Paths under base_path are redirected to the HOST_SPIFFS_DIR directory */
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t* conf);
+esp_err_t esp_vfs_spiffs_unregister(const char* partition_label);
+esp_err_t esp_spiffs_info(const char* partition_label, size_t* total_bytes, size_t* used_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_SPIFFS_H_ */
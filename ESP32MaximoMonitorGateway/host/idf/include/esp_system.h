@@ -0,0 +1,49 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_system.h
+#
+# Host emulation of the ESP-IDF system functions
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_SYSTEM_H_
+#define HOST_ESP_SYSTEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	ESP_MAC_WIFI_STA
+} esp_mac_type_t;
+
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type);
+uint32_t esp_random(void);
+void esp_fill_random(void* buf, size_t len);
+void esp_restart(void);
+
+/* The heap is the HOST_HEAP_KB emulated DRAM, less the bytes allocated since host_emul_init */
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_SYSTEM_H_ */
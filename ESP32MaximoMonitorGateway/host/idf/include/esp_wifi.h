@@ -0,0 +1,151 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# esp_wifi.h
+#
+# Host emulation of the Wifi station driver, connecting to a simulated AP
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_ESP_WIFI_H_
+#define HOST_ESP_WIFI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ERR_WIFI_NOT_INIT (ESP_ERR_WIFI_BASE+1)
+#define ESP_ERR_WIFI_NOT_STARTED (ESP_ERR_WIFI_BASE+2)
+#define ESP_ERR_WIFI_CONN (ESP_ERR_WIFI_BASE+7)
+#define ESP_ERR_WIFI_NOT_CONNECT (ESP_ERR_WIFI_BASE+15)
+
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+
+typedef enum {
+	WIFI_EVENT_WIFI_READY=0,
+	WIFI_EVENT_SCAN_DONE,
+	WIFI_EVENT_STA_START,
+	WIFI_EVENT_STA_STOP,
+	WIFI_EVENT_STA_CONNECTED,
+	WIFI_EVENT_STA_DISCONNECTED
+} wifi_event_t;
+
+typedef enum {
+	WIFI_REASON_ASSOC_LEAVE=8,
+	WIFI_REASON_BEACON_TIMEOUT=200,
+	WIFI_REASON_NO_AP_FOUND=201
+} wifi_err_reason_t;
+
+typedef enum {
+	WIFI_MODE_NULL=0,
+	WIFI_MODE_STA
+} wifi_mode_t;
+
+typedef enum {
+	ESP_IF_WIFI_STA=0
+} esp_interface_t;
+
+typedef enum {
+	WIFI_AUTH_OPEN=0,
+	WIFI_AUTH_WEP,
+	WIFI_AUTH_WPA_PSK,
+	WIFI_AUTH_WPA2_PSK,
+	WIFI_AUTH_WPA_WPA2_PSK
+} wifi_auth_mode_t;
+
+typedef enum {
+	WIFI_FAST_SCAN=0,
+	WIFI_ALL_CHANNEL_SCAN
+} wifi_scan_method_t;
+
+typedef enum {
+	WIFI_CONNECT_AP_BY_SIGNAL=0,
+	WIFI_CONNECT_AP_BY_SECURITY
+} wifi_sort_method_t;
+
+typedef struct {
+	int8_t rssi;
+	wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+	bool capable;
+	bool required;
+} wifi_pmf_config_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t password[64];
+	wifi_scan_method_t scan_method;
+	bool bssid_set;
+	uint8_t bssid[6];
+	uint8_t channel;
+	uint16_t listen_interval;
+	wifi_sort_method_t sort_method;
+	wifi_scan_threshold_t threshold;
+	wifi_pmf_config_t pmf_cfg;
+} wifi_sta_config_t;
+
+typedef union {
+	wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+	int magic;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() { 0x1F2F3F4F }
+
+typedef struct {
+	uint8_t bssid[6];
+	uint8_t ssid[33];
+	uint8_t primary;
+	int8_t rssi;
+	wifi_auth_mode_t authmode;
+} wifi_ap_record_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t ssid_len;
+	uint8_t bssid[6];
+	uint8_t channel;
+	wifi_auth_mode_t authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t ssid_len;
+	uint8_t bssid[6];
+	uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(esp_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_get_config(esp_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_stop(void);
+/* Associates after HOST_WIFI_CONNECT_MS, or fails with WIFI_REASON_NO_AP_FOUND while the AP is down */
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_WIFI_H_ */
@@ -0,0 +1,59 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# FreeRTOS.h
+#
+# Host emulation of the FreeRTOS base definitions
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_FREERTOS_H_
+#define HOST_FREERTOS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define configMAX_PRIORITIES 25
+#define configMAX_TASK_NAME_LEN 16
+#define portNUM_PROCESSORS 2
+#define portTICK_PERIOD_MS (1000/configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms)*configTICK_RATE_HZ)/1000))
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7fffffff
+
+#define IRAM_ATTR
+#define portYIELD_FROM_ISR()
+
+#define BIT(n) (1UL<<(n))
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#define BIT3 0x00000008
+#define BIT4 0x00000010
+#define BIT5 0x00000020
+#define BIT6 0x00000040
+#define BIT7 0x00000080
+
+#endif /* HOST_FREERTOS_H_ */
@@ -0,0 +1,72 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# task.h
+#
+# Host emulation of FreeRTOS tasks, delays and notifications over threads
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_FREERTOS_TASK_H_
+#define HOST_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+/* Subset of the task status of FreeRTOS run time statistics */
+typedef struct {
+	TaskHandle_t xHandle;
+	const char* pcTaskName;
+	UBaseType_t xTaskNumber;
+	UBaseType_t uxCurrentPriority;
+	UBaseType_t uxBasePriority;
+	uint32_t ulRunTimeCounter;		// CPU time of the thread in us
+	uint32_t usStackHighWaterMark;
+	BaseType_t xCoreID;
+} TaskStatus_t;
+
+/* Tasks run as threads: priority and core are accepted but not enforced, stack_depth is only reported */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+		UBaseType_t priority, TaskHandle_t* handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+		UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+/* Only the calling task can be deleted, other tasks are left running */
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previous_wake, TickType_t period);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+char* pcTaskGetTaskName(TaskHandle_t task);
+/* Stack usage is not measured, this returns the requested stack depth */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+/* Status of the running tasks, total_run_time being the time since start in us.
+ * Returns 0 if there are more than size tasks, as FreeRTOS does */
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t size, uint32_t* total_run_time);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+/* There are no idle tasks, this returns NULL */
+TaskHandle_t xTaskGetIdleTaskHandleForCPU(UBaseType_t cpu);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_TASK_H_ */
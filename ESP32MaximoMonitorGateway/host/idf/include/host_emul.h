@@ -0,0 +1,66 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# host_emul.h
+#
+# Control of the host emulation: start up, and fault injection into the simulated network
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_EMUL_H_
+#define HOST_EMUL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Settings read from the environment by host_emul_init, times in ms unless noted:
+ *  HOST_SPIFFS_DIR        directory holding the SPIFFS partition contents (spiffs_image)
+ *  HOST_HEAP_KB           size of the emulated heap (300)
+ *  HOST_WIFI_CONNECT_MS   time to associate and get an address (100)
+ *  HOST_MQTT_CONNECT_MS   time to open the broker session (50)
+ *  HOST_MQTT_TLS_MS       time added by the TLS handshake of mqtts:// connections (1500)
+ *  HOST_MQTT_LATENCY_MS   PUBACK latency, plus up to half of it as jitter (20)
+ *  HOST_MQTT_LOSS_PCT     percentage of publishes lost and resent after a second (0)
+ *  HOST_BROKER_REPORT_S   period of the broker traffic report (10)
+ *  HOST_BROKER_ADDR       address of the broker, which clients must connect to, any address when empty ("")
+ *  HOST_DNS               names known to the simulated DNS and mDNS, as name=address,... ("")
+ *  HOST_DNS_MS            time to resolve a known name (20), unknown mDNS names take the whole query timeout
+ *  HOST_ADC_SIGNAL_HZ     frequency of the signal of ADC channel 0, channel c carrying (c+1) times it (50)
+ */
+void host_emul_init(void);
+
+/* Value of an environment setting, or def when unset */
+uint32_t host_env(const char* name, uint32_t def);
+const char* host_env_str(const char* name, const char* def);
+
+/* Take the AP down for down_ms, disconnecting the station */
+void host_wifi_drop(uint32_t down_ms);
+/* Stop the broker for down_ms, closing all sessions */
+void host_broker_restart(uint32_t down_ms);
+/* Change the PUBACK latency and the message loss percentage */
+void host_broker_set_link(uint32_t latency_ms, uint32_t loss_pct);
+/* Move the broker to another address, closing all sessions */
+void host_broker_move(const char* addr);
+/* Add or change a name of the simulated DNS, a name ending with .local being resolved by mDNS */
+void host_dns_set(const char* name, const char* addr);
+/* Publish from the broker to the clients subscribed to topic, returns the number of deliveries */
+int host_broker_publish(const char* topic, const char* data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_EMUL_H_ */
@@ -0,0 +1,21 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# err.h
+#
+# Placeholder for the lwIP header, nothing of it is used by the gateway
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_LWIP_ERR_H_
+#define HOST_LWIP_ERR_H_
+
+#endif /* HOST_LWIP_ERR_H_ */
@@ -0,0 +1,36 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# netdb.h
+#
+# Host emulation of the lwIP resolver, over the simulated DNS
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_LWIP_NETDB_H_
+#define HOST_LWIP_NETDB_H_
+
+#include <netdb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Resolves the names of the simulated DNS only, see host_dns_set() */
+int host_getaddrinfo(const char* nodename, const char* servname, const struct addrinfo* hints, struct addrinfo** res);
+
+#define getaddrinfo host_getaddrinfo
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_LWIP_NETDB_H_ */
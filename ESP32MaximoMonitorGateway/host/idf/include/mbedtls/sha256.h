@@ -0,0 +1,47 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# sha256.h
+#
+# Host emulation of the mbedTLS SHA-256 API of ESP-IDF 4.x
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_MBEDTLS_SHA256_H_
+#define HOST_MBEDTLS_SHA256_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque to the gateway, which must not save and restore it: with CONFIG_MBEDTLS_HARDWARE_SHA, the
+ * state of a digest in progress is held by the SHA accelerator of the ESP32 rather than by the context */
+typedef struct {
+	uint32_t total[2];
+	uint32_t state[8];
+	unsigned char buffer[64];
+	int is224;
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx);
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context* ctx, int is224);
+int mbedtls_sha256_update_ret(mbedtls_sha256_context* ctx, const unsigned char* input, size_t ilen);
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context* ctx, unsigned char output[32]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_MBEDTLS_SHA256_H_ */
@@ -0,0 +1,47 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# mdns.h
+#
+# Host emulation of mDNS, which advertises nothing and resolves no host
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_MDNS_H_
+#define HOST_MDNS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	const char* key;
+	const char* value;
+} mdns_txt_item_t;
+
+esp_err_t mdns_init(void);
+esp_err_t mdns_hostname_set(const char* hostname);
+esp_err_t mdns_instance_name_set(const char* instance_name);
+esp_err_t mdns_service_add(const char* instance_name, const char* service_type, const char* proto, uint16_t port,
+		mdns_txt_item_t txt[], size_t num_items);
+esp_err_t mdns_service_txt_item_set(const char* service_type, const char* proto, const char* key, const char* value);
+esp_err_t mdns_query_a(const char* host_name, uint32_t timeout, esp_ip4_addr_t* addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_MDNS_H_ */
@@ -0,0 +1,121 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# mqtt_client.h
+#
+# Host emulation of the esp-mqtt client, talking to an in-process simulated broker
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_MQTT_CLIENT_H_
+#define HOST_MQTT_CLIENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_mqtt_client* esp_mqtt_client_handle_t;
+
+ESP_EVENT_DECLARE_BASE(MQTT_EVENTS);
+
+typedef enum {
+	MQTT_EVENT_ANY=-1,
+	MQTT_EVENT_ERROR=0,
+	MQTT_EVENT_CONNECTED,
+	MQTT_EVENT_DISCONNECTED,
+	MQTT_EVENT_SUBSCRIBED,
+	MQTT_EVENT_UNSUBSCRIBED,
+	MQTT_EVENT_PUBLISHED,
+	MQTT_EVENT_DATA,
+	MQTT_EVENT_BEFORE_CONNECT,
+	MQTT_EVENT_DELETED
+} esp_mqtt_event_id_t;
+
+typedef struct esp_mqtt_event_t {
+	esp_mqtt_event_id_t event_id;
+	esp_mqtt_client_handle_t client;
+	void* user_context;
+	char* data;
+	int data_len;
+	int total_data_len;
+	int current_data_offset;
+	char* topic;
+	int topic_len;
+	int msg_id;
+	int session_present;
+	bool retain;
+	int qos;
+	bool dup;
+} esp_mqtt_event_t;
+
+typedef esp_mqtt_event_t* esp_mqtt_event_handle_t;
+
+typedef struct {
+	const char* host;
+	const char* uri;
+	uint32_t port;
+	const char* client_id;
+	const char* username;
+	const char* password;
+	const char* lwt_topic;
+	const char* lwt_msg;
+	int lwt_qos;
+	int lwt_retain;
+	int lwt_msg_len;
+	int disable_clean_session;
+	int keepalive;
+	bool disable_auto_reconnect;
+	void* user_context;
+	int task_prio;
+	int task_stack;
+	int buffer_size;
+	const char* cert_pem;
+	size_t cert_len;
+	const char* client_cert_pem;
+	size_t client_cert_len;
+	const char* client_key_pem;
+	size_t client_key_len;
+	bool use_global_ca_store;
+	esp_err_t (*crt_bundle_attach)(void* conf);
+	int reconnect_timeout_ms;
+	int out_buffer_size;
+	bool skip_cert_common_name_check;
+	/* Name the server certificate is checked against, also sent as SNI, else the host of the URI */
+	const char* common_name;
+	int network_timeout_ms;
+} esp_mqtt_client_config_t;
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config);
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+		esp_event_handler_t event_handler, void* event_handler_arg);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client);
+/* Taken for the next connection, may be called from MQTT_EVENT_BEFORE_CONNECT */
+esp_err_t esp_mqtt_client_set_uri(esp_mqtt_client_handle_t client, const char* uri);
+/* QoS 0 messages are dropped while disconnected, QoS 1 and 2 ones are kept in the outbox and resent */
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data, int len,
+		int qos, int retain);
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char* topic, int qos);
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char* topic);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_MQTT_CLIENT_H_ */
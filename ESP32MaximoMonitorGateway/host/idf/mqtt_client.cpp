@@ -0,0 +1,635 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# mqtt_client.cpp
+#
+# Host emulation of the esp-mqtt client, connected to an in-process simulated broker
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mqtt_client.h"
+#include "esp_crt_bundle.h"
+#include "freertos/task.h"
+#include "host_emul.h"
+}
+
+#include "host_internal.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const char *LOG_TAG="HOST_BROKER";
+
+ESP_EVENT_DEFINE_BASE(MQTT_EVENTS);
+
+// esp-mqtt defaults
+#define MQTT_RECON_DEFAULT_MS 10000
+#define MQTT_BUFFER_SIZE_BYTE 1024
+#define MQTT_TASK_STACK 6144
+#define MQTT_TASK_PRIORITY 5
+#define OUTBOX_EXPIRED_TIMEOUT_MS (30*1000)
+// Time after which an unacknowledged message is sent again
+#define MQTT_RETRANSMIT_MS 1000
+// Period at which the client task checks the link when idle
+#define MQTT_POLL_MS 10
+
+/* QoS 1 or 2 message in the outbox, until its PUBACK */
+struct host_outbox_msg {
+	int msg_id;
+	int qos;
+	std::string topic;
+	char* payload;			// malloc'ed, so that the outbox shows in the emulated heap
+	int len;
+	int64_t queued_us;
+	bool sent;
+	bool received;			// reached the broker, else lost and sent again at due_us
+	int64_t due_us;
+};
+
+/* SUBACK or UNSUBACK to come */
+struct host_ack {
+	esp_mqtt_event_id_t event;
+	int msg_id;
+	int64_t due_us;
+};
+
+struct host_inbound {
+	std::string topic;
+	std::string data;
+};
+
+struct host_event_handler {
+	esp_mqtt_event_id_t event;
+	esp_event_handler_t handler;
+	void* arg;
+};
+
+struct esp_mqtt_client {
+	std::string uri;
+	std::string client_id;
+	std::string username;
+	bool verify_server;		// a CA is given for mqtts:// connections
+	std::string common_name;	// checked against the certificate instead of the host of the URI
+	void* user_context;
+	int reconnect_timeout_ms;
+	bool auto_reconnect;
+	int buffer_size;
+	int task_prio;
+	int task_stack;
+	std::vector<host_event_handler> handlers;
+
+	std::mutex lock;
+	std::condition_variable cv;
+	bool running=false;
+	bool stopping=false;
+	bool connected=false;
+	int64_t next_connect_us=0;
+	uint32_t broker_epoch=0;
+	int next_msg_id=0;
+	std::deque<host_outbox_msg> outbox;
+	std::deque<host_ack> acks;
+	std::deque<host_inbound> inbox;
+	std::vector<std::string> subscriptions;
+};
+
+/* The simulated broker, shared by all clients */
+static struct {
+	std::mutex lock;
+	std::vector<esp_mqtt_client*> clients;
+	uint32_t connect_ms=50;
+	uint32_t tls_ms=1500;
+	uint32_t latency_ms=20;
+	uint32_t loss_pct=0;
+	uint32_t addr=0;			// in network order, 0 to accept connections to any address
+	int64_t down_until_us=0;
+	uint32_t epoch=0;
+	uint64_t received=0;
+	uint64_t received_bytes=0;
+	uint64_t acked=0;
+	uint64_t lost=0;
+	uint64_t expired=0;
+	uint32_t restarts=0;
+	uint64_t reported=0;
+	int64_t reported_us=0;
+	esp_timer_handle_t report_timer=NULL;
+} broker;
+
+/* MQTT topic filter matching, with the + and # wildcards */
+static bool topic_matches(const char* filter, const char* topic) {
+	while(*filter!='\0') {
+		if(*filter=='#') {
+			return true;
+		}
+		if(*filter=='+') {
+			while(*topic!='\0' && *topic!='/') topic++;
+			filter++;
+		} else {
+			if(*filter!=*topic) return false;
+			filter++;
+			topic++;
+		}
+	}
+	return *topic=='\0';
+}
+
+static bool broker_up(int64_t now) {
+	std::lock_guard<std::mutex> lock(broker.lock);
+	return now>=broker.down_until_us;
+}
+
+/* Transmit a message to the broker, which acknowledges it after the link latency unless it is lost */
+static void broker_send(host_outbox_msg& msg, int64_t now) {
+	std::lock_guard<std::mutex> lock(broker.lock);
+	msg.sent=true;
+	if(broker.loss_pct>0 && esp_random()%100<broker.loss_pct) {
+		broker.lost++;
+		msg.received=false;
+		msg.due_us=now+(int64_t)MQTT_RETRANSMIT_MS*1000;
+		return;
+	}
+	broker.received++;
+	broker.received_bytes+=msg.len;
+	// Metrics events carry the latency and heap figures of the gateway itself
+	if(strstr(msg.topic.c_str(),"/evt/metrics/")!=NULL) {
+		ESP_LOGI(LOG_TAG,"%s %.*s",msg.topic.c_str(),msg.len,msg.payload);
+	} else {
+		ESP_LOGD(LOG_TAG,"%s %d bytes",msg.topic.c_str(),msg.len);
+	}
+	msg.received=true;
+	uint32_t latency_us=broker.latency_ms*1000;
+	msg.due_us=now+latency_us+(latency_us>=2?esp_random()%(latency_us/2):0);
+}
+
+static void broker_report(void* arg) {
+	std::lock_guard<std::mutex> lock(broker.lock);
+	int64_t now=esp_timer_get_time();
+	int64_t elapsed_ms=(now-broker.reported_us)/1000;
+	ESP_LOGI(LOG_TAG,"received %llu (%llu msg/s), %llu bytes, acked %llu, lost %llu, expired %llu, restarts %u",
+			(unsigned long long)broker.received,
+			(unsigned long long)(elapsed_ms>0?(broker.received-broker.reported)*1000/elapsed_ms:0),
+			(unsigned long long)broker.received_bytes,(unsigned long long)broker.acked,
+			(unsigned long long)broker.lost,(unsigned long long)broker.expired,broker.restarts);
+	broker.reported=broker.received;
+	broker.reported_us=now;
+}
+
+void host_broker_init(uint32_t connect_ms, uint32_t tls_ms, uint32_t latency_ms, uint32_t loss_pct, uint32_t report_s, const char* addr) {
+	broker.connect_ms=connect_ms;
+	broker.tls_ms=tls_ms;
+	broker.latency_ms=latency_ms;
+	broker.loss_pct=loss_pct;
+	if(*addr!='\0' && !host_dns_lookup(addr,&broker.addr)) {
+		ESP_LOGE(LOG_TAG,"Invalid broker address %s",addr);
+	}
+	if(report_s>0) {
+		esp_timer_create_args_t timer_args;
+		memset(&timer_args,0,sizeof(timer_args));
+		timer_args.callback=&broker_report;
+		timer_args.name="host_broker";
+		ESP_ERROR_CHECK(esp_timer_create(&timer_args,&broker.report_timer));
+		ESP_ERROR_CHECK(esp_timer_start_periodic(broker.report_timer,(uint64_t)report_s*1000000));
+	}
+}
+
+static void notify_clients() {
+	for(esp_mqtt_client* client : broker.clients) {
+		client->cv.notify_all();
+	}
+}
+
+void host_broker_restart(uint32_t down_ms) {
+	std::lock_guard<std::mutex> lock(broker.lock);
+	ESP_LOGW(LOG_TAG,"Broker down for %u ms",down_ms);
+	broker.down_until_us=esp_timer_get_time()+(int64_t)down_ms*1000;
+	broker.epoch++;
+	broker.restarts++;
+	notify_clients();
+}
+
+void host_broker_move(const char* addr) {
+	uint32_t a;
+	if(!host_dns_lookup(addr,&a)) {
+		ESP_LOGE(LOG_TAG,"Invalid broker address %s",addr);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(broker.lock);
+	ESP_LOGW(LOG_TAG,"Broker moved to %s",addr);
+	broker.addr=a;
+	broker.epoch++;
+	notify_clients();
+}
+
+/* Host of the URI, a name or an address */
+static std::string uri_host(const std::string& uri) {
+	size_t start=uri.find("://");
+	start=start==std::string::npos?0:start+3;
+	return uri.substr(start,uri.find_first_of(":/",start)-start);
+}
+
+/* Whether the host of the URI is an IPv4 address rather than a name */
+static bool uri_host_is_address(const std::string& uri) {
+	struct in_addr addr;
+	return inet_pton(AF_INET,uri_host(uri).c_str(),&addr)==1;
+}
+
+/* Whether the host of the URI is the broker, resolving it and blocking as esp-mqtt does.
+ * Any host is when the broker has no address */
+static bool broker_reachable(const std::string& uri) {
+	uint32_t broker_addr;
+	{
+		std::lock_guard<std::mutex> lock(broker.lock);
+		broker_addr=broker.addr;
+	}
+	if(broker_addr==0) {
+		return true;
+	}
+	std::string host=uri_host(uri);
+	uint32_t addr;
+	if(!host_dns_lookup(host.c_str(),&addr)) {
+		ESP_LOGW(LOG_TAG,"Cannot resolve %s",host.c_str());
+		return false;
+	}
+	if(addr!=broker_addr) {
+		ESP_LOGW(LOG_TAG,"No broker at %s",host.c_str());
+		return false;
+	}
+	return true;
+}
+
+void host_broker_set_link(uint32_t latency_ms, uint32_t loss_pct) {
+	std::lock_guard<std::mutex> lock(broker.lock);
+	broker.latency_ms=latency_ms;
+	broker.loss_pct=loss_pct;
+}
+
+int host_broker_publish(const char* topic, const char* data, size_t len) {
+	// Clients take the broker lock under their own, never the reverse
+	std::vector<esp_mqtt_client*> clients;
+	{
+		std::lock_guard<std::mutex> lock(broker.lock);
+		clients=broker.clients;
+	}
+	int n=0;
+	for(esp_mqtt_client* client : clients) {
+		std::lock_guard<std::mutex> client_lock(client->lock);
+		if(!client->connected) continue;
+		for(const std::string& filter : client->subscriptions) {
+			if(topic_matches(filter.c_str(),topic)) {
+				client->inbox.push_back({ topic, std::string(data,len) });
+				client->cv.notify_all();
+				n++;
+				break;
+			}
+		}
+	}
+	return n;
+}
+
+/* Event to dispatch once the client lock is released */
+struct host_mqtt_event {
+	esp_mqtt_event_id_t event_id;
+	int msg_id;
+	int session_present;
+	std::string topic;
+	std::string data;
+};
+
+static void dispatch(esp_mqtt_client* client, host_mqtt_event& e) {
+	esp_mqtt_event_t event;
+	memset(&event,0,sizeof(event));
+	event.event_id=e.event_id;
+	event.client=client;
+	event.user_context=client->user_context;
+	event.msg_id=e.msg_id;
+	event.session_present=e.session_present;
+
+	// Payloads larger than the receive buffer come in several events, as with esp-mqtt
+	int total=e.data.size();
+	int offset=0;
+	do {
+		int len=std::min(total-offset,client->buffer_size);
+		event.topic=offset==0?(char*)e.topic.data():NULL;
+		event.topic_len=offset==0?e.topic.size():0;
+		event.data=(char*)e.data.data()+offset;
+		event.data_len=len;
+		event.total_data_len=total;
+		event.current_data_offset=offset;
+		for(const host_event_handler& h : client->handlers) {
+			if(h.event==MQTT_EVENT_ANY || h.event==e.event_id) {
+				h.handler(h.arg,MQTT_EVENTS,e.event_id,&event);
+			}
+		}
+		offset+=len;
+	} while(offset<total);
+}
+
+static int new_msg_id(esp_mqtt_client* client) {
+	client->next_msg_id=client->next_msg_id%65535+1;
+	return client->next_msg_id;
+}
+
+/* Connect, exchange messages and reconnect, as the esp-mqtt task does */
+static void mqtt_task(void* arg) {
+	esp_mqtt_client* client=(esp_mqtt_client*)arg;
+	std::vector<host_mqtt_event> events;
+	std::unique_lock<std::mutex> lock(client->lock);
+	while(!client->stopping) {
+		int64_t now=esp_timer_get_time();
+		int64_t wake_us=now+MQTT_POLL_MS*1000;
+
+		if(!client->connected) {
+			if(now>=client->next_connect_us) {
+				// The handlers may change the URI, then the DNS lookup, TCP and CONNECT exchanges
+				lock.unlock();
+				host_mqtt_event before={ MQTT_EVENT_BEFORE_CONNECT, 0, 0 };
+				dispatch(client,before);
+				std::string uri;
+				{
+					std::lock_guard<std::mutex> uri_lock(client->lock);
+					uri=client->uri;
+				}
+				bool reachable=host_wifi_up() && broker_reachable(uri);
+				// Full TLS handshake on each connection, as esp-mqtt does not resume sessions
+				bool tls=uri.compare(0,8,"mqtts://")==0;
+				if(tls && !client->verify_server) {
+					ESP_LOGW(LOG_TAG,"No server verification option set, connecting to %s without checking the broker",uri.c_str());
+				} else if(tls && client->common_name.empty() && uri_host_is_address(uri)) {
+					// The certificate names the broker, never its address
+					ESP_LOGE(LOG_TAG,"Certificate of the broker does not match %s",uri.c_str());
+					reachable=false;
+				}
+				vTaskDelay(pdMS_TO_TICKS(broker.connect_ms+(tls?broker.tls_ms:0)));
+				lock.lock();
+				now=esp_timer_get_time();
+				if(reachable && host_wifi_up() && broker_up(now)) {
+					client->connected=true;
+					{
+						std::lock_guard<std::mutex> broker_lock(broker.lock);
+						client->broker_epoch=broker.epoch;
+					}
+					events.push_back({ MQTT_EVENT_CONNECTED, 0, 0 });
+					// Clean session: subscriptions are lost, pending messages are sent again
+					client->subscriptions.clear();
+					for(host_outbox_msg& msg : client->outbox) {
+						broker_send(msg,now);
+					}
+				} else {
+					events.push_back({ MQTT_EVENT_ERROR, 0, 0 });
+					events.push_back({ MQTT_EVENT_DISCONNECTED, 0, 0 });
+					client->next_connect_us=client->auto_reconnect?now+(int64_t)client->reconnect_timeout_ms*1000:INT64_MAX;
+				}
+			} else {
+				wake_us=std::min(wake_us,client->next_connect_us);
+			}
+		} else {
+			bool restarted;
+			{
+				std::lock_guard<std::mutex> broker_lock(broker.lock);
+				restarted=client->broker_epoch!=broker.epoch;
+			}
+			if(!host_wifi_up() || restarted) {
+				client->connected=false;
+				client->acks.clear();
+				client->inbox.clear();
+				for(host_outbox_msg& msg : client->outbox) {
+					msg.sent=false;
+				}
+				events.push_back({ MQTT_EVENT_DISCONNECTED, 0, 0 });
+				client->next_connect_us=client->auto_reconnect?now+(int64_t)client->reconnect_timeout_ms*1000:INT64_MAX;
+			} else {
+				for(auto it=client->outbox.begin();it!=client->outbox.end();) {
+					if(!it->sent || it->due_us>now) {
+						if(it->sent) wake_us=std::min(wake_us,it->due_us);
+						++it;
+					} else if(!it->received) {
+						broker_send(*it,now);
+						++it;
+					} else {
+						events.push_back({ MQTT_EVENT_PUBLISHED, it->msg_id, 0 });
+						free(it->payload);
+						it=client->outbox.erase(it);
+						std::lock_guard<std::mutex> broker_lock(broker.lock);
+						broker.acked++;
+					}
+				}
+				while(!client->acks.empty() && client->acks.front().due_us<=now) {
+					events.push_back({ client->acks.front().event, client->acks.front().msg_id, 0 });
+					client->acks.pop_front();
+				}
+				if(!client->acks.empty()) {
+					wake_us=std::min(wake_us,client->acks.front().due_us);
+				}
+				while(!client->inbox.empty()) {
+					events.push_back({ MQTT_EVENT_DATA, 0, 0, client->inbox.front().topic, client->inbox.front().data });
+					client->inbox.pop_front();
+				}
+			}
+		}
+
+		// Messages which could not be delivered in time are deleted, without event
+		while(!client->outbox.empty() && now-client->outbox.front().queued_us>(int64_t)OUTBOX_EXPIRED_TIMEOUT_MS*1000) {
+			ESP_LOGW(LOG_TAG,"%s: message %d expired",client->client_id.c_str(),client->outbox.front().msg_id);
+			free(client->outbox.front().payload);
+			client->outbox.pop_front();
+			std::lock_guard<std::mutex> broker_lock(broker.lock);
+			broker.expired++;
+		}
+
+		if(!events.empty()) {
+			lock.unlock();
+			for(host_mqtt_event& e : events) {
+				dispatch(client,e);
+			}
+			events.clear();
+			host_heap_sample();
+			lock.lock();
+			continue;
+		}
+		client->cv.wait_for(lock,std::chrono::microseconds(std::max<int64_t>(wake_us-now,0)));
+	}
+	client->running=false;
+	client->cv.notify_all();
+	lock.unlock();
+	vTaskDelete(NULL);
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config) {
+	esp_mqtt_client* client=new esp_mqtt_client();
+	client->uri=config->uri!=NULL?config->uri:"";
+	client->client_id=config->client_id!=NULL?config->client_id:"";
+	client->username=config->username!=NULL?config->username:"";
+	client->verify_server=config->cert_pem!=NULL || config->crt_bundle_attach!=NULL || config->use_global_ca_store;
+	client->common_name=config->common_name!=NULL?config->common_name:"";
+	client->user_context=config->user_context;
+	client->reconnect_timeout_ms=config->reconnect_timeout_ms>0?config->reconnect_timeout_ms:MQTT_RECON_DEFAULT_MS;
+	client->auto_reconnect=!config->disable_auto_reconnect;
+	client->buffer_size=config->buffer_size>0?config->buffer_size:MQTT_BUFFER_SIZE_BYTE;
+	client->task_prio=config->task_prio>0?config->task_prio:MQTT_TASK_PRIORITY;
+	client->task_stack=config->task_stack>0?config->task_stack:MQTT_TASK_STACK;
+	std::lock_guard<std::mutex> lock(broker.lock);
+	broker.clients.push_back(client);
+	return client;
+}
+
+esp_err_t esp_crt_bundle_attach(void* conf) {
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client) {
+	esp_mqtt_client_stop(client);
+	{
+		std::lock_guard<std::mutex> lock(broker.lock);
+		broker.clients.erase(std::find(broker.clients.begin(),broker.clients.end(),client));
+	}
+	for(host_outbox_msg& msg : client->outbox) {
+		free(msg.payload);
+	}
+	delete client;
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+		esp_event_handler_t event_handler, void* event_handler_arg) {
+	std::lock_guard<std::mutex> lock(client->lock);
+	if(client->running) {
+		// Handlers are read by the client task without the lock
+		return ESP_ERR_INVALID_STATE;
+	}
+	client->handlers.push_back({ event, event_handler, event_handler_arg });
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+	std::lock_guard<std::mutex> lock(client->lock);
+	if(client->running) {
+		ESP_LOGE(LOG_TAG,"Client has started");
+		return ESP_FAIL;
+	}
+	client->running=true;
+	client->stopping=false;
+	client->next_connect_us=0;
+	ESP_LOGI(LOG_TAG,"Client %s connecting to %s as %s",client->client_id.c_str(),client->uri.c_str(),client->username.c_str());
+	xTaskCreate(&mqtt_task,"mqtt_task",client->task_stack,client,client->task_prio,NULL);
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client) {
+	std::unique_lock<std::mutex> lock(client->lock);
+	if(!client->running) {
+		return ESP_FAIL;
+	}
+	client->stopping=true;
+	client->cv.notify_all();
+	client->cv.wait(lock,[client]() { return !client->running; });
+	client->connected=false;
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_set_uri(esp_mqtt_client_handle_t client, const char* uri) {
+	std::lock_guard<std::mutex> lock(client->lock);
+	client->uri=uri;
+	return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+	std::lock_guard<std::mutex> lock(client->lock);
+	if(!client->running || client->connected) {
+		return ESP_FAIL;
+	}
+	client->next_connect_us=0;
+	client->cv.notify_all();
+	return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data, int len,
+		int qos, int retain) {
+	if(len<=0) {
+		len=data!=NULL?strlen(data):0;
+	}
+	std::lock_guard<std::mutex> lock(client->lock);
+	int64_t now=esp_timer_get_time();
+	if(qos==0) {
+		if(!client->connected) {
+			return -1;
+		}
+		host_outbox_msg msg;
+		msg.topic=topic;
+		msg.payload=(char*)data;
+		msg.len=len;
+		broker_send(msg,now);
+		return 0;
+	}
+
+	host_outbox_msg msg;
+	msg.payload=(char*)malloc(len>0?len:1);
+	if(msg.payload==NULL) {
+		return -1;
+	}
+	memcpy(msg.payload,data,len);
+	msg.msg_id=new_msg_id(client);
+	msg.qos=qos;
+	msg.topic=topic;
+	msg.len=len;
+	msg.queued_us=now;
+	msg.sent=false;
+	msg.received=false;
+	if(client->connected) {
+		broker_send(msg,now);
+	}
+	client->outbox.push_back(msg);
+	client->cv.notify_all();
+	return msg.msg_id;
+}
+
+static int queue_ack(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event) {
+	int64_t due_us;
+	{
+		std::lock_guard<std::mutex> lock(broker.lock);
+		due_us=esp_timer_get_time()+(int64_t)broker.latency_ms*1000;
+	}
+	int msg_id=new_msg_id(client);
+	client->acks.push_back({ event, msg_id, due_us });
+	client->cv.notify_all();
+	return msg_id;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char* topic, int qos) {
+	std::lock_guard<std::mutex> lock(client->lock);
+	if(!client->connected) {
+		return -1;
+	}
+	client->subscriptions.push_back(topic);
+	return queue_ack(client,MQTT_EVENT_SUBSCRIBED);
+}
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char* topic) {
+	std::lock_guard<std::mutex> lock(client->lock);
+	if(!client->connected) {
+		return -1;
+	}
+	auto it=std::find(client->subscriptions.begin(),client->subscriptions.end(),topic);
+	if(it!=client->subscriptions.end()) {
+		client->subscriptions.erase(it);
+	}
+	return queue_ack(client,MQTT_EVENT_UNSUBSCRIBED);
+}
@@ -0,0 +1,184 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# nvs.cpp
+#
+# Host emulation of NVS, namespaces of typed entries held in memory
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <string.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+}
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef enum {
+	NVS_TYPE_U32,
+	NVS_TYPE_I32,
+	NVS_TYPE_STR,
+	NVS_TYPE_BLOB
+} nvs_type_t;
+
+struct nvs_entry {
+	nvs_type_t type;
+	std::vector<uint8_t> value;
+};
+
+struct nvs_open_handle {
+	std::string name;
+	bool writable;
+};
+
+static std::mutex nvs_lock;
+static bool nvs_initialised=false;
+static std::map<std::string,std::map<std::string,nvs_entry>> nvs_namespaces;
+static std::map<nvs_handle_t,nvs_open_handle> nvs_handles;
+static nvs_handle_t nvs_next_handle=1;
+
+esp_err_t nvs_flash_init(void) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	nvs_initialised=true;
+	return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	nvs_namespaces.clear();
+	return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* handle) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	if(!nvs_initialised) {
+		return ESP_ERR_NVS_NOT_INITIALIZED;
+	}
+	if(open_mode==NVS_READONLY && nvs_namespaces.find(name)==nvs_namespaces.end()) {
+		return ESP_ERR_NVS_NOT_FOUND;
+	}
+	nvs_namespaces[name];
+	*handle=nvs_next_handle++;
+	nvs_handles[*handle]={ name, open_mode==NVS_READWRITE };
+	return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	nvs_handles.erase(handle);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	return nvs_handles.count(handle)?ESP_OK:ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+/* Entry of key for handle, created if set, under nvs_lock */
+static esp_err_t nvs_find(nvs_handle_t handle, const char* key, bool set, nvs_entry** entry) {
+	auto h=nvs_handles.find(handle);
+	if(h==nvs_handles.end()) {
+		return ESP_ERR_NVS_INVALID_HANDLE;
+	}
+	if(set && !h->second.writable) {
+		return ESP_ERR_NVS_READ_ONLY;
+	}
+	std::map<std::string,nvs_entry>& entries=nvs_namespaces[h->second.name];
+	if(set) {
+		*entry=&entries[key];
+		return ESP_OK;
+	}
+	auto e=entries.find(key);
+	if(e==entries.end()) {
+		return ESP_ERR_NVS_NOT_FOUND;
+	}
+	*entry=&e->second;
+	return ESP_OK;
+}
+
+static esp_err_t nvs_set(nvs_handle_t handle, const char* key, nvs_type_t type, const void* value, size_t length) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	nvs_entry* entry;
+	esp_err_t err=nvs_find(handle,key,true,&entry);
+	if(err==ESP_OK) {
+		entry->type=type;
+		entry->value.assign((const uint8_t*)value,(const uint8_t*)value+length);
+	}
+	return err;
+}
+
+/* Copy the value into a buffer of *length bytes, or only return its length if value is NULL */
+static esp_err_t nvs_get(nvs_handle_t handle, const char* key, nvs_type_t type, void* value, size_t* length) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	nvs_entry* entry;
+	esp_err_t err=nvs_find(handle,key,false,&entry);
+	if(err!=ESP_OK) {
+		return err;
+	}
+	if(entry->type!=type) {
+		return ESP_ERR_NVS_TYPE_MISMATCH;
+	}
+	if(value!=NULL) {
+		if(*length<entry->value.size()) {
+			return ESP_ERR_NVS_INVALID_LENGTH;
+		}
+		memcpy(value,entry->value.data(),entry->value.size());
+	}
+	*length=entry->value.size();
+	return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+	std::lock_guard<std::mutex> lock(nvs_lock);
+	nvs_entry* entry;
+	esp_err_t err=nvs_find(handle,key,false,&entry);
+	if(err==ESP_OK) {
+		nvs_namespaces[nvs_handles[handle].name].erase(key);
+	}
+	return err;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* value) {
+	size_t length=sizeof(*value);
+	return nvs_get(handle,key,NVS_TYPE_U32,value,&length);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+	return nvs_set(handle,key,NVS_TYPE_U32,&value,sizeof(value));
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* value) {
+	size_t length=sizeof(*value);
+	return nvs_get(handle,key,NVS_TYPE_I32,value,&length);
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value) {
+	return nvs_set(handle,key,NVS_TYPE_I32,&value,sizeof(value));
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* value, size_t* length) {
+	return nvs_get(handle,key,NVS_TYPE_STR,value,length);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+	return nvs_set(handle,key,NVS_TYPE_STR,value,strlen(value)+1);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* value, size_t* length) {
+	return nvs_get(handle,key,NVS_TYPE_BLOB,value,length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+	return nvs_set(handle,key,NVS_TYPE_BLOB,value,length);
+}
@@ -0,0 +1,228 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# http_load.cpp
+#
+# Load test of the HTTP endpoint of the gateway, in requests per second
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sdkconfig.h"
+}
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Polls a path of the HTTP endpoint of a gateway, e.g. gateway_host with HOST_HTTP_PORT, over <connections>
+ * keep-alive connections each sending its next request once the previous response is complete, as
+ * technicians polling the gateway would. Prints the requests per second, the response latency percentiles
+ * and the responses by status, 429 being those beyond GW_HTTP_MAX_RATE.
+ *   gateway_http_load <connections> <seconds> [<path> [<address> [<port>]]]
+ */
+
+#define HTTP_LOAD_MAX_STATUS 600
+
+static struct sockaddr_in server;
+static const char* path;
+static std::atomic<bool> running(true);
+
+static int64_t now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (int64_t)ts.tv_sec*1000000000LL+ts.tv_nsec;
+}
+
+/* Results of a connection */
+struct http_load_conn {
+	std::vector<uint32_t> latency_us;
+	uint64_t status[HTTP_LOAD_MAX_STATUS] = { 0 };
+	uint64_t errors = 0;		// failed connections and malformed responses
+	uint64_t bytes = 0;
+};
+
+static int http_connect() {
+	int fd=socket(AF_INET,SOCK_STREAM,0);
+	if(fd<0) {
+		return -1;
+	}
+	int one=1;
+	setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&one,sizeof(one));
+	if(connect(fd,(struct sockaddr*)&server,sizeof(server))<0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Offset of the end of the body of the response at the start of in, or 0 while incomplete, -1 if malformed */
+static long http_response_end(const std::string& in) {
+	size_t head_end=in.find("\r\n\r\n");
+	if(head_end==std::string::npos) {
+		return 0;
+	}
+	size_t body=head_end+4;
+	std::string head=in.substr(0,body);
+	const char* cl=strcasestr(head.c_str(),"\r\nContent-Length:");
+	if(cl!=NULL) {
+		size_t end=body+strtoul(cl+17,NULL,10);
+		return in.size()>=end?end:0;
+	}
+	if(strcasestr(head.c_str(),"\r\nTransfer-Encoding: chunked")==NULL) {
+		return -1;
+	}
+	// Chunks up to the last one, of size 0
+	size_t p=body;
+	while(true) {
+		size_t eol=in.find("\r\n",p);
+		if(eol==std::string::npos) {
+			return 0;
+		}
+		char* end;
+		unsigned long size=strtoul(in.c_str()+p,&end,16);
+		if(end==in.c_str()+p) {
+			return -1;
+		}
+		p=eol+2+size+2;
+		if(p>in.size()) {
+			return 0;
+		}
+		if(size==0) {
+			return p;
+		}
+	}
+}
+
+static void http_load_task(http_load_conn* conn) {
+	char request[256];
+	int request_len=snprintf(request,sizeof(request),"GET %s HTTP/1.1\r\nHost: gateway\r\n\r\n",path);
+	char buf[4096];
+	int fd=-1;
+	while(running) {
+		if(fd<0 && (fd=http_connect())<0) {
+			conn->errors++;
+			usleep(10000);
+			continue;
+		}
+		int64_t start=now_ns();
+		std::string in;
+		long end=0;
+		if(send(fd,request,request_len,MSG_NOSIGNAL)==request_len) {
+			while(end==0) {
+				ssize_t n=recv(fd,buf,sizeof(buf),0);
+				if(n<=0) {
+					end=-1;
+					break;
+				}
+				in.append(buf,n);
+				end=http_response_end(in);
+			}
+		} else {
+			end=-1;
+		}
+		int status=0;
+		if(end<0 || sscanf(in.c_str(),"HTTP/1.%*d %d",&status)!=1 || status<=0 || status>=HTTP_LOAD_MAX_STATUS) {
+			conn->errors++;
+			close(fd);
+			fd=-1;
+			continue;
+		}
+		conn->latency_us.push_back((now_ns()-start)/1000);
+		conn->status[status]++;
+		conn->bytes+=end;
+		// The server closes the connection after a failed handler
+		if(strcasestr(in.c_str(),"\r\nConnection: close")!=NULL) {
+			close(fd);
+			fd=-1;
+		}
+	}
+	if(fd>=0) {
+		close(fd);
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc<3) {
+		fprintf(stderr,"usage: %s <connections> <seconds> [<path> [<address> [<port>]]]\n",argv[0]);
+		return 2;
+	}
+	uint32_t connections=strtoul(argv[1],NULL,10);
+	double seconds=strtod(argv[2],NULL);
+	path=argc>3?argv[3]:"/readings";
+	const char* address=argc>4?argv[4]:"127.0.0.1";
+	uint16_t port=argc>5?(uint16_t)strtoul(argv[5],NULL,10):CONFIG_GW_HTTP_PORT;
+	if(connections==0 || seconds<=0) {
+		fprintf(stderr,"connections and duration must be positive\n");
+		return 2;
+	}
+	memset(&server,0,sizeof(server));
+	server.sin_family=AF_INET;
+	server.sin_port=htons(port);
+	if(inet_pton(AF_INET,address,&server.sin_addr)!=1) {
+		fprintf(stderr,"invalid address %s\n",address);
+		return 2;
+	}
+
+	printf("GET %s on %s:%u over %u connections for %.0f s\n",path,address,port,connections,seconds);
+	fflush(stdout);
+	std::vector<http_load_conn> conns(connections);
+	std::vector<std::thread> threads;
+	int64_t start=now_ns();
+	for(uint32_t i=0;i<connections;i++) {
+		threads.emplace_back(http_load_task,&conns[i]);
+	}
+	usleep((useconds_t)(seconds*1e6));
+	running=false;
+	for(std::thread& t : threads) {
+		t.join();
+	}
+	double elapsed_s=(now_ns()-start)/1e9;
+
+	std::vector<uint32_t> latency_us;
+	uint64_t status[HTTP_LOAD_MAX_STATUS]={ 0 };
+	uint64_t errors=0, bytes=0;
+	for(const http_load_conn& c : conns) {
+		latency_us.insert(latency_us.end(),c.latency_us.begin(),c.latency_us.end());
+		for(int s=0;s<HTTP_LOAD_MAX_STATUS;s++) {
+			status[s]+=c.status[s];
+		}
+		errors+=c.errors;
+		bytes+=c.bytes;
+	}
+	std::sort(latency_us.begin(),latency_us.end());
+	size_t n=latency_us.size();
+	printf("%zu responses in %.1f s: %.0f requests/s, %.0f bytes/s\n",n,elapsed_s,n/elapsed_s,bytes/elapsed_s);
+	if(n>0) {
+		printf("latency p50 %u us, p99 %u us, max %u us\n",latency_us[n/2],latency_us[(n*99)/100],latency_us[n-1]);
+	}
+	for(int s=0;s<HTTP_LOAD_MAX_STATUS;s++) {
+		if(status[s]>0) {
+			printf("status %d: %llu\n",s,(unsigned long long)status[s]);
+		}
+	}
+	printf("errors: %llu\n",(unsigned long long)errors);
+	return errors>0 || n==0?1:0;
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# load_main.cpp
+#
+# Load generator of the gateway: N downstream devices sending readings at a given rate
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+extern "C" {
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sdkconfig.h"
+}
+
+/**
+ * Sends the readings of <devices> downstream devices, each at <rate_hz>, to the UDP fan-in port of a gateway,
+ * e.g. gateway_host, one datagram per device and period in the "<type>/<id> <value>" format of ESP32_FanIn.
+ * Periods are scheduled on absolute times, so that a late period is caught up and the offered load is kept.
+ * Prints each second, and at the end, the readings sent per second against the offered load, and the send errors.
+ * The throughput, ack latency and heap low-water mark of the gateway are in the broker log and metrics events of gateway_host.
+ *   gateway_load <devices> <rate_hz> [<seconds> [<address> [<port>]]]
+ */
+
+#define LOAD_DEVICE_TYPE "load"
+
+static int64_t now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (int64_t)ts.tv_sec*1000000000LL+ts.tv_nsec;
+}
+
+static void sleep_until(int64_t t_ns) {
+	struct timespec ts;
+	ts.tv_sec=t_ns/1000000000LL;
+	ts.tv_nsec=t_ns%1000000000LL;
+	while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL)==EINTR) {
+	}
+}
+
+/* Reading of a device: a slow sine, distinct per device, with some noise */
+static int32_t reading(uint32_t device, uint64_t period) {
+	return (int32_t)(1000.0*sin((double)period*0.01+device)+(rand()%21-10));
+}
+
+int main(int argc, char** argv) {
+	if(argc<3) {
+		fprintf(stderr,"usage: %s <devices> <rate_hz> [<seconds> [<address> [<port>]]]\n",argv[0]);
+		return 2;
+	}
+	uint32_t devices=strtoul(argv[1],NULL,10);
+	double rate_hz=strtod(argv[2],NULL);
+	double seconds=argc>3?strtod(argv[3],NULL):10.0;
+	const char* address=argc>4?argv[4]:"127.0.0.1";
+	uint16_t port=argc>5?(uint16_t)strtoul(argv[5],NULL,10):CONFIG_GW_FANIN_PORT;
+	if(devices==0 || rate_hz<=0 || seconds<=0) {
+		fprintf(stderr,"devices, rate and duration must be positive\n");
+		return 2;
+	}
+	if(devices>CONFIG_GW_FANIN_MAX_DEVICES) {
+		fprintf(stderr,"warning: readings of devices beyond GW_FANIN_MAX_DEVICES (%d) are rejected by the gateway\n",
+				CONFIG_GW_FANIN_MAX_DEVICES);
+	}
+
+	struct sockaddr_in to;
+	memset(&to,0,sizeof(to));
+	to.sin_family=AF_INET;
+	to.sin_port=htons(port);
+	if(inet_pton(AF_INET,address,&to.sin_addr)!=1) {
+		fprintf(stderr,"invalid address %s\n",address);
+		return 2;
+	}
+	int sock=socket(AF_INET,SOCK_DGRAM,IPPROTO_UDP);
+	if(sock<0) {
+		perror("socket");
+		return 1;
+	}
+
+	printf("%u devices at %.1f Hz, %.0f readings/s offered to %s:%u for %.0f s\n",
+			devices,rate_hz,devices*rate_hz,address,port,seconds);
+	fflush(stdout);
+
+	const int64_t period_ns=(int64_t)(1e9/rate_hz);
+	const int64_t start_ns=now_ns();
+	const int64_t end_ns=start_ns+(int64_t)(seconds*1e9);
+	int64_t report_ns=start_ns+1000000000LL;
+	uint64_t sent=0, errors=0, reported=0;
+	char datagram[64];
+	for(uint64_t period=0;;period++) {
+		int64_t due_ns=start_ns+(int64_t)period*period_ns;
+		if(due_ns>=end_ns) {
+			break;
+		}
+		sleep_until(due_ns);
+		if(due_ns>=report_ns) {
+			printf("%llu readings/s, %llu send errors\n",(unsigned long long)(sent-reported),(unsigned long long)errors);
+			fflush(stdout);
+			reported=sent;
+			report_ns+=1000000000LL;
+		}
+		for(uint32_t device=0;device<devices;device++) {
+			int len=snprintf(datagram,sizeof(datagram),LOAD_DEVICE_TYPE "/d%u %d",device,reading(device,period));
+			if(sendto(sock,datagram,len,0,(struct sockaddr*)&to,sizeof(to))==len) {
+				sent++;
+			} else {
+				errors++;
+			}
+		}
+	}
+	double elapsed_s=(now_ns()-start_ns)/1e9;
+	printf("sent %llu readings in %.1f s: %.0f readings/s of %.0f offered, %llu send errors\n",
+			(unsigned long long)sent,elapsed_s,sent/elapsed_s,devices*rate_hz,(unsigned long long)errors);
+	close(sock);
+	return errors>0?1:0;
+}
@@ -0,0 +1,84 @@
+# Generates sdkconfig.h as the ESP-IDF build does, from the project sdkconfig,
+# completed with the defaults of main/Kconfig.projbuild for the options it does
+# not set, such as the gateway options before the first menuconfig.
+# Further sdkconfig fragments given after output override the options they set.
+function(gateway_sdkconfig sdkconfig kconfig output)
+	set(defines "")
+	set(seen "")
+	set(lines "")
+	foreach(file ${ARGN} ${sdkconfig})
+		file(STRINGS ${file} file_lines REGEX "^(# )?CONFIG_")
+		list(APPEND lines ${file_lines})
+	endforeach()
+	foreach(line ${lines})
+		if(line MATCHES "^(# )?(CONFIG_[A-Za-z0-9_]+)[ =]" AND CMAKE_MATCH_2 IN_LIST seen)
+			# Set by an override
+		elseif(line MATCHES "^# (CONFIG_[A-Za-z0-9_]+) is not set$")
+			# Unset booleans keep off rather than take their default
+			list(APPEND seen ${CMAKE_MATCH_1})
+		elseif(line MATCHES "^(CONFIG_[A-Za-z0-9_]+)=(.*)$")
+			set(value ${CMAKE_MATCH_2})
+			if(value STREQUAL "y")
+				set(value 1)
+			endif()
+			string(APPEND defines "#define ${CMAKE_MATCH_1} ${value}\n")
+			list(APPEND seen ${CMAKE_MATCH_1})
+		endif()
+	endforeach()
+
+	set(config "")
+	set(type "")
+	set(in_choice FALSE)
+	set(in_help FALSE)
+	file(STRINGS ${kconfig} lines)
+	foreach(line ${lines})
+		if(line MATCHES "^[ \t]*(menu)?config[ \t]+([A-Za-z0-9_]+)")
+			set(config CONFIG_${CMAKE_MATCH_2})
+			if(in_choice AND config IN_LIST seen)
+				set(choice_set TRUE)
+			endif()
+			set(type "")
+			set(in_help FALSE)
+		elseif(line MATCHES "^[ \t]*(choice|endchoice|menu|endmenu|comment|if|endif)([ \t]|$)")
+			if(CMAKE_MATCH_1 STREQUAL "choice")
+				set(in_choice TRUE)
+				set(choice_default "")
+				set(choice_set FALSE)
+			elseif(CMAKE_MATCH_1 STREQUAL "endchoice")
+				# The default member only when the sdkconfig selects none
+				if(NOT choice_set AND NOT choice_default STREQUAL "")
+					string(APPEND defines "#define ${choice_default} 1\n")
+					list(APPEND seen ${choice_default})
+				endif()
+				set(in_choice FALSE)
+			endif()
+			set(config "")
+			set(in_help FALSE)
+		elseif(in_help)
+		elseif(line MATCHES "^[ \t]*help[ \t]*$")
+			set(in_help TRUE)
+		elseif(line MATCHES "^[ \t]*(bool|int|hex|string)([ \t]|$)")
+			set(type ${CMAKE_MATCH_1})
+		elseif(line MATCHES "^[ \t]*default[ \t]+(.*)$")
+			string(REGEX REPLACE "[ \t]+if[ \t].*$" "" value "${CMAKE_MATCH_1}")
+			if(in_choice AND config STREQUAL "")
+				# Default member of a choice, applied at its end
+				set(choice_default CONFIG_${value})
+			elseif(NOT config STREQUAL "" AND NOT config IN_LIST seen)
+				if(type STREQUAL "bool")
+					if(value STREQUAL "y")
+						string(APPEND defines "#define ${config} 1\n")
+					endif()
+				else()
+					string(APPEND defines "#define ${config} ${value}\n")
+				endif()
+				list(APPEND seen ${config})
+			endif()
+		endif()
+	endforeach()
+
+	# Rewritten only when changed, so that a cmake run does not rebuild everything
+	file(WRITE ${output}.tmp "/* Generated from ${ARGN} ${sdkconfig} and ${kconfig} */\n#pragma once\n${defines}")
+	configure_file(${output}.tmp ${output} COPYONLY)
+	set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${sdkconfig} ${kconfig} ${ARGN})
+endfunction()
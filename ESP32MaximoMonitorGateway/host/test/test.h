@@ -0,0 +1,44 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test.h
+#
+# Unit test harness of the host build
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <stdint.h>
+
+typedef void (*gw_test_fn)(void);
+
+/* Registers a test of a suite at startup, suites being run by ctest one at a time */
+struct gw_test_register {
+	gw_test_register(const char* suite, const char* name, gw_test_fn fn);
+};
+
+#define GW_TEST(suite, name) \
+	static void test_##suite##_##name(void); \
+	static gw_test_register test_reg_##suite##_##name(#suite,#name,&test_##suite##_##name); \
+	static void test_##suite##_##name(void)
+
+/* Record a failure of the running test, which goes on */
+void gw_test_fail(const char* file, int line, const char* expr, long long a, long long b);
+
+#define GW_CHECK(cond) do { if(!(cond)) gw_test_fail(__FILE__,__LINE__,#cond,0,0); } while(0)
+/* Integer comparisons, which print both values on failure */
+#define GW_CHECK_OP(a, op, b) do { long long _a=(long long)(a), _b=(long long)(b); \
+	if(!(_a op _b)) gw_test_fail(__FILE__,__LINE__,#a " " #op " " #b,_a,_b); } while(0)
+#define GW_CHECK_EQ(a, b) GW_CHECK_OP(a,==,b)
+
+#endif /* HOST_TEST_H_ */
@@ -0,0 +1,137 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_batcher.cpp
+#
+# Tests of the batching publisher: flush limits, batch age, failures, and the gain over one message per reading
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "WIoTPBatcher.h"
+#include "WIoTPEncoder.h"
+
+extern "C" {
+#include <string.h>
+#include "esp_timer.h"
+}
+
+/* Batcher whose publishes are captured, and fail when told to */
+class Test_Batcher : public WIoTP_Batcher {
+public:
+	int published = 0;
+	size_t last_len = 0;
+	char last[1024];
+	bool fail = false;
+
+	Test_Batcher(wiotp_format_t format, size_t max_bytes, size_t max_samples, uint32_t max_age_ms)
+	: WIoTP_Batcher(NULL,"iot-2/type/t/id/d/evt/data/fmt/json","temp",format,max_bytes,max_samples,max_age_ms) {}
+
+protected:
+	virtual int publish(const char* payload, size_t len) {
+		if(fail) {
+			return -1;
+		}
+		memcpy(last,payload,len);
+		last[len]='\0';
+		last_len=len;
+		return ++published;
+	}
+};
+
+GW_TEST(batcher, flush_on_count) {
+	Test_Batcher b(WIOTP_FMT_JSON,512,3,60000);
+	int64_t now=esp_timer_get_time();
+	GW_CHECK(!b.add(now,21));
+	GW_CHECK(!b.add(now,22));
+	GW_CHECK(b.add(now,-23));
+	GW_CHECK(strcmp(b.last,"{\"d\":{\"temp\":[21,22,-23]}}")==0);
+	GW_CHECK_EQ(b.messages(),1);
+	GW_CHECK_EQ(b.samples(),3);
+	GW_CHECK_EQ(b.pending(),0);
+}
+
+GW_TEST(batcher, flush_on_size) {
+	// {"d":{"temp":[]}} is 17 bytes, leaving room for two 10 digit readings and a comma
+	Test_Batcher b(WIOTP_FMT_JSON,40,100,60000);
+	int64_t now=esp_timer_get_time();
+	GW_CHECK(!b.add(now,1000000000));
+	GW_CHECK(!b.add(now,1000000001));
+	GW_CHECK(b.add(now,1000000002));
+	GW_CHECK(strcmp(b.last,"{\"d\":{\"temp\":[1000000000,1000000001]}}")==0);
+	GW_CHECK_OP(b.last_len,<=,40);
+	GW_CHECK_EQ(b.pending(),1);
+}
+
+/* The age of a batch runs from the time its first reading was taken, not from when it was added */
+GW_TEST(batcher, age_from_reading_time) {
+	Test_Batcher b(WIOTP_FMT_JSON,512,100,1000);
+	int64_t now=esp_timer_get_time();
+	GW_CHECK(b.add(now-1001000,5));
+	GW_CHECK_EQ(b.messages(),1);
+
+	GW_CHECK(!b.add(now-500000,6));
+	GW_CHECK(!b.poll());
+	GW_CHECK_EQ(b.pending(),1);
+	Test_Batcher late(WIOTP_FMT_JSON,512,100,1000);
+	GW_CHECK(!late.add(esp_timer_get_time()-999000,7));
+	while(esp_timer_get_time()-now<600000 && late.pending()>0) {
+		late.poll();
+	}
+	GW_CHECK_EQ(late.messages(),1);
+}
+
+GW_TEST(batcher, failed_publish_not_counted) {
+	Test_Batcher b(WIOTP_FMT_JSON,512,2,60000);
+	int64_t now=esp_timer_get_time();
+	b.fail=true;
+	b.add(now,1);
+	GW_CHECK(!b.add(now,2));
+	GW_CHECK_EQ(b.messages(),0);
+	GW_CHECK_EQ(b.samples(),0);
+	GW_CHECK_EQ(b.bytes(),0);
+	GW_CHECK_EQ(b.pending(),0);
+	b.fail=false;
+	b.add(now,3);
+	GW_CHECK(b.add(now,4));
+	GW_CHECK_EQ(b.messages(),1);
+	GW_CHECK_EQ(b.samples(),2);
+}
+
+WIOTP_INT_FIELD(TestTemp,"temp");
+
+/**
+ * Fewer messages and bytes per reading at the default sampling rate and batch limits than one
+ * {"d":{"temp":N}} message per reading as published before batching. batcher_gain_* of gateway_bench report them.
+ */
+GW_TEST(batcher, gain_over_one_message_per_reading) {
+	const size_t readings=10000;
+	const double rate_hz=CONFIG_GW_SAMPLE_RATE_HZ;
+	uint64_t single_bytes=0;
+	char payload[WIoTP_Encoder<TestTemp>::max_len+1];
+	for(size_t i=0;i<readings;i++) {
+		single_bytes+=WIoTP_Encoder<TestTemp>::encode(payload,(int32_t)(40+i%7));
+	}
+
+	const wiotp_format_t formats[]={ WIOTP_FMT_JSON, WIOTP_FMT_CBOR, WIOTP_FMT_GORILLA };
+	for(size_t f=0;f<sizeof(formats)/sizeof(formats[0]);f++) {
+		Test_Batcher b(formats[f],CONFIG_GW_BATCH_MAX_BYTES,CONFIG_GW_BATCH_MAX_SAMPLES,CONFIG_GW_BATCH_MAX_AGE_MS);
+		int64_t now=esp_timer_get_time();
+		for(size_t i=0;i<readings;i++) {
+			b.add(now+(int64_t)(i*1000000/rate_hz),(int32_t)(40+i%7));
+		}
+		b.flush();
+		GW_CHECK_EQ(b.samples(),readings);
+		// At least the batch size fewer messages, each reading costing fewer bytes
+		GW_CHECK_OP(b.messages()*CONFIG_GW_BATCH_MAX_SAMPLES,<=,readings+CONFIG_GW_BATCH_MAX_SAMPLES);
+		GW_CHECK_OP(b.bytes(),<,single_bytes);
+	}
+}
@@ -0,0 +1,66 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_config.cpp
+#
+# Tests of the NVS cache of the gateway configuration
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "ESP32Config.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <utime.h>
+#include "nvs_flash.h"
+}
+
+static void test_config_write(const char* path, const char* text) {
+	FILE* f=fopen(path,"w");
+	fputs(text,f);
+	fclose(f);
+}
+
+/* An edit keeping the size and modification time of the file is not served from the stale cache */
+GW_TEST(config, cache_follows_content) {
+	nvs_flash_init();
+	char path[]="/tmp/gw_test_config_XXXXXX";
+	int fd=mkstemp(path);
+	GW_CHECK(fd>=0);
+	close(fd);
+
+	test_config_write(path,"wifi_ssid=plant-a\nwiotp_orgid=abc123\n");
+	struct stat st;
+	GW_CHECK(stat(path,&st)==0);
+	{
+		ESP32_Config config(path,"test_config");
+		GW_CHECK(strcmp(config.get("wifi_ssid",""),"plant-a")==0);
+	}
+	{
+		ESP32_Config cached(path,"test_config");
+		GW_CHECK(strcmp(cached.get("wifi_ssid",""),"plant-a")==0);
+		GW_CHECK(strcmp(cached.get("wiotp_orgid",""),"abc123")==0);
+	}
+
+	test_config_write(path,"wifi_ssid=plant-b\nwiotp_orgid=abc123\n");
+	struct utimbuf times={ st.st_atime, st.st_mtime };
+	GW_CHECK(utime(path,&times)==0);
+	{
+		ESP32_Config edited(path,"test_config");
+		GW_CHECK(strcmp(edited.get("wifi_ssid",""),"plant-b")==0);
+	}
+	unlink(path);
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_deadband.cpp
+#
+# Unit tests of the report by exception of readings and summaries
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "WIoTPBatcher.h"
+#include "WIoTPAggregator.h"
+#include "WIoTPDeadband.h"
+
+extern "C" {
+#include "esp_timer.h"
+}
+
+/* Batcher whose batches are dropped, readings being only counted */
+class Deadband_Batcher : public WIoTP_Batcher {
+public:
+	Deadband_Batcher() : WIoTP_Batcher(NULL,"iot-2/type/t/id/d/evt/data/fmt/json","temp",WIOTP_FMT_JSON,512,100,60000) {}
+
+protected:
+	virtual int publish(const char* payload, size_t len) {
+		return 1;
+	}
+};
+
+/* Each channel has its own deadband, in its own unit, and its own last reported reading */
+GW_TEST(deadband, per_channel) {
+	GW_CHECK_EQ(WIoTP_Deadband::nth("50,5",0),50);
+	GW_CHECK_EQ(WIoTP_Deadband::nth("50,5",1),5);
+	GW_CHECK_EQ(WIoTP_Deadband::nth("50,5",2),5);
+	GW_CHECK_EQ(WIoTP_Deadband::nth("",0),0);
+
+	WIoTP_Deadband coarse(WIoTP_Deadband::nth("50,5",0),60000), fine(WIoTP_Deadband::nth("50,5",1),60000);
+	Deadband_Batcher a, b;
+	a.set_deadband(&coarse);
+	b.set_deadband(&fine);
+	int64_t now=esp_timer_get_time();
+	for(int i=0;i<5;i++) {
+		a.add(now+i*1000,2000+i*10);
+		b.add(now+i*1000,2000+i*10);
+	}
+	GW_CHECK_EQ(a.suppressed(),4);
+	GW_CHECK_EQ(b.suppressed(),0);
+}
+
+/* Aggregator whose summaries are captured */
+class Test_Aggregator : public WIoTP_Aggregator {
+public:
+	int published = 0;
+
+	Test_Aggregator() : WIoTP_Aggregator(NULL,"iot-2/type/t/id/d/evt/summary/fmt/json","temp",1000,1000) {}
+
+protected:
+	virtual int publish(const char* payload, size_t len) {
+		return ++published;
+	}
+};
+
+/* With a deadband, summaries are published when their mean moves beyond it, or as a heartbeat */
+GW_TEST(deadband, summary) {
+	WIoTP_Deadband deadband(10,5000);
+	Test_Aggregator agg;
+	agg.set_deadband(&deadband);
+	const int64_t start=1000000;
+	// Window means 100, 105, 120, then 120 for 6 s
+	const float means[]={ 100, 105, 120, 120, 120, 120, 120, 120, 120 };
+	for(size_t w=0;w<sizeof(means)/sizeof(means[0]);w++) {
+		agg.add(start+w*1000000,means[w]-1);
+		agg.add(start+w*1000000+500000,means[w]+1);
+	}
+	agg.poll(start+9*1000000);
+	// 100 first, 105 suppressed, 120 changed, four suppressed, then the heartbeat 5 s after 120
+	GW_CHECK_EQ(agg.published,3);
+	GW_CHECK_EQ(agg.suppressed(),6);
+}
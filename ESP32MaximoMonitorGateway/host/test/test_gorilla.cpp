@@ -0,0 +1,105 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_gorilla.cpp
+#
+# Unit tests of the Gorilla compression of timestamped readings
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "WIoTPGorilla.h"
+
+extern "C" {
+#include <stdint.h>
+}
+
+/* A block is read back whole, and cut blocks as far as they go */
+GW_TEST(gorilla, truncated_block) {
+	uint8_t block[64];
+	wiotp_gorilla_t g;
+	wiotp_gorilla_init(&g);
+	for(int i=0;i<3;i++) {
+		wiotp_gorilla_append(&g,block,1000000+i*20000,2150+i);
+	}
+	wiotp_gorilla_reader_t r;
+	int64_t ts=0;
+	int32_t value=0;
+	GW_CHECK_EQ(wiotp_gorilla_open(&r,block,wiotp_gorilla_len(&g)),3u);
+	for(int i=0;i<3;i++) {
+		GW_CHECK(wiotp_gorilla_next(&r,&ts,&value));
+		GW_CHECK_EQ(ts,1000000+i*20000);
+		GW_CHECK_EQ(value,2150+i);
+	}
+	GW_CHECK(!wiotp_gorilla_next(&r,&ts,&value));
+	// A block cut within its header holds no reading, one cut after it only the first one
+	GW_CHECK_EQ(wiotp_gorilla_open(&r,block,6),0u);
+	GW_CHECK(!wiotp_gorilla_next(&r,&ts,&value));
+	GW_CHECK_EQ(wiotp_gorilla_open(&r,block,WIOTP_GORILLA_HEADER_LEN),3u);
+	GW_CHECK(wiotp_gorilla_next(&r,&ts,&value));
+	GW_CHECK_EQ(value,2150);
+	GW_CHECK(!wiotp_gorilla_next(&r,&ts,&value));
+}
+
+/**
+ * Round trip through each encoding: delta of delta of 0, 7, 9, 12 and 32 bits, a timestamp going back,
+ * values unchanged, in a new XOR window and in the window of the previous XOR, and the extreme values.
+ */
+GW_TEST(gorilla, round_trip_all_encodings) {
+	static const struct {
+		int32_t delta;		// from the previous timestamp
+		int32_t value;
+		unsigned bits;		// taken by the reading, 0 if not checked
+	} readings[]={
+		{ 0, 2150, WIOTP_GORILLA_HEADER_BITS },
+		{ 20000, 2150, 4+32+1 },				// delta of delta 20000 from 0, same value
+		{ 20000, 2150, 1+1 },					// same delta, same value
+		{ 20050, 2150^0xFF0, 2+7+2+5+5+8 },		// delta of delta 50, XOR 0xFF0 in a new window
+		{ 19850, 2150^0xF00, 3+9+2+8 },			// -200, XOR 0x0F0 in the previous window
+		{ 20850, 2150^0xF30, 4+12+2+8 },		// 1000, XOR 0x030 in the previous window
+		{ 120850, -7, 0 },						// 100000
+		{ -500, INT32_MAX, 0 },					// a timestamp going back
+		{ 20000, INT32_MIN, 0 },
+		{ 20000, -7, 0 },
+	};
+	const size_t n=sizeof(readings)/sizeof(readings[0]);
+	uint8_t block[128];
+	wiotp_gorilla_t g;
+	wiotp_gorilla_init(&g);
+	int64_t ts=1000000;
+	for(size_t i=0;i<n;i++) {
+		ts+=readings[i].delta;
+		unsigned bits=wiotp_gorilla_bits(&g,ts,readings[i].value);
+		uint32_t before=g.bits;
+		wiotp_gorilla_append(&g,block,ts,readings[i].value);
+		GW_CHECK_EQ(g.bits-before,bits);
+		if(readings[i].bits>0) {
+			GW_CHECK_EQ(bits,readings[i].bits);
+		}
+	}
+	GW_CHECK_EQ(wiotp_gorilla_dod_bits(100000),4+32);
+	GW_CHECK_EQ(wiotp_gorilla_dod_bits(-500-120850),4+32);
+
+	wiotp_gorilla_reader_t r;
+	GW_CHECK_EQ(wiotp_gorilla_open(&r,block,wiotp_gorilla_len(&g)),n);
+	ts=1000000;
+	for(size_t i=0;i<n;i++) {
+		int64_t read_ts=0;
+		int32_t value=0;
+		ts+=readings[i].delta;
+		GW_CHECK(wiotp_gorilla_next(&r,&read_ts,&value));
+		GW_CHECK_EQ(read_ts,ts);
+		GW_CHECK_EQ(value,readings[i].value);
+	}
+	int64_t read_ts;
+	int32_t value;
+	GW_CHECK(!wiotp_gorilla_next(&r,&read_ts,&value));
+}
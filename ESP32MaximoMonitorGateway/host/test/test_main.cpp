@@ -0,0 +1,80 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_main.cpp
+#
+# Runs the unit tests of the host build
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+}
+
+#define TEST_MAX_TESTS 256
+
+typedef struct {
+	const char* suite;
+	const char* name;
+	gw_test_fn fn;
+} test_entry_t;
+
+static test_entry_t tests[TEST_MAX_TESTS];
+static size_t n_tests=0;
+static int failures=0;
+
+gw_test_register::gw_test_register(const char* suite, const char* name, gw_test_fn fn) {
+	if(n_tests==TEST_MAX_TESTS) {
+		fprintf(stderr,"Too many tests, raise TEST_MAX_TESTS\n");
+		abort();
+	}
+	tests[n_tests++]={ suite, name, fn };
+}
+
+void gw_test_fail(const char* file, int line, const char* expr, long long a, long long b) {
+	failures++;
+	fprintf(stderr,"%s:%d: check failed: %s (%lld, %lld)\n",file,line,expr,a,b);
+}
+
+/**
+ * gateway_test [suite...]
+ * Runs the tests of the given suites, or all of them, and exits with 1 if any check failed.
+ */
+int main(int argc, char** argv) {
+	esp_log_level_set("*",ESP_LOG_WARN);
+	int failed_tests=0, run=0;
+	for(size_t i=0;i<n_tests;i++) {
+		bool selected=argc<2;
+		for(int a=1;a<argc && !selected;a++) {
+			selected=strcmp(tests[i].suite,argv[a])==0;
+		}
+		if(!selected) {
+			continue;
+		}
+		int before=failures;
+		tests[i].fn();
+		run++;
+		bool ok=failures==before;
+		failed_tests+=ok?0:1;
+		printf("[%s] %s.%s\n",ok?"  OK  ":"FAILED",tests[i].suite,tests[i].name);
+	}
+	printf("%d tests, %d failed\n",run,failed_tests);
+	// Threads of the emulation, such as the esp_timer task, may still run: exit without static destructors
+	fflush(stdout);
+	_exit(run==0 || failed_tests>0?1:0);
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_metrics.cpp
+#
+# Unit tests of the metrics payload, encoded from several tasks
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "WIoTPMetrics.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+}
+
+#include <atomic>
+
+#define TEST_METRICS_ENCODES 2000
+
+/* A task encoding the metrics in a loop, as the publishing task with reset and the HTTP server without */
+struct Test_Encoder {
+	bool reset;
+	std::atomic<bool> started;
+	std::atomic<bool> done;
+	std::atomic<int> bad;
+	TaskHandle_t handle;
+	char payload[WIOTP_METRICS_MAX_LEN];
+};
+
+static size_t test_count_keys(const char* payload, const char* prefix) {
+	size_t n=0;
+	for(const char* p=payload;(p=strstr(p,prefix))!=NULL;p++) {
+		n++;
+	}
+	return n;
+}
+
+/* Whole payload, with the stack of each watched task and, with run time statistics, its CPU usage within 0..1000 */
+static bool test_metrics_valid(const char* payload, size_t len) {
+	if(len==0 || strncmp(payload,"{\"d\":{",6)!=0 || strcmp(payload+len-2,"}}")!=0) {
+		return false;
+	}
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+	if(test_count_keys(payload,"\"cpu_")!=test_count_keys(payload,"\"stack_")) {
+		return false;
+	}
+	for(const char* p=payload;(p=strstr(p,"\"cpu_"))!=NULL;p++) {
+		const char* value=strchr(p+1,':');
+		if(value==NULL || strtoul(value+1,NULL,10)>1000) {
+			return false;
+		}
+	}
+#endif
+	return true;
+}
+
+static void test_encode_task(void* arg) {
+	Test_Encoder* e=(Test_Encoder*)arg;
+	e->started=true;
+	// Until both tasks run and are watched
+	ulTaskNotifyTake(pdTRUE,portMAX_DELAY);
+	for(int i=0;i<TEST_METRICS_ENCODES;i++) {
+		size_t len=WIoTP_Metrics::encode(e->payload,sizeof(e->payload),e->reset);
+		if(!test_metrics_valid(e->payload,len)) {
+			e->bad++;
+		}
+	}
+	e->done=true;
+	// Watched until both tasks are done
+	ulTaskNotifyTake(pdTRUE,portMAX_DELAY);
+	vTaskDelete(NULL);
+}
+
+/* The metrics event and GET /metrics encode the same snapshot of the tasks at the same time */
+GW_TEST(metrics, encode_from_two_tasks) {
+	Test_Encoder encoders[2];
+	for(int i=0;i<2;i++) {
+		encoders[i].reset=i==0;
+		encoders[i].started=false;
+		encoders[i].done=false;
+		encoders[i].bad=0;
+		GW_CHECK(xTaskCreate(&test_encode_task,i==0?"Publish":"httpd",4096,&encoders[i],5,&encoders[i].handle)==pdPASS);
+		WIoTP_Metrics::watch_task(encoders[i].handle);
+	}
+	while(!encoders[0].started || !encoders[1].started) {
+		vTaskDelay(pdMS_TO_TICKS(1));
+	}
+	for(int i=0;i<2;i++) {
+		xTaskNotifyGive(encoders[i].handle);
+	}
+	while(!encoders[0].done || !encoders[1].done) {
+		vTaskDelay(pdMS_TO_TICKS(10));
+	}
+	for(int i=0;i<2;i++) {
+		xTaskNotifyGive(encoders[i].handle);
+	}
+	GW_CHECK_EQ(encoders[0].bad,0);
+	GW_CHECK_EQ(encoders[1].bad,0);
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_ota.cpp
+#
+# Unit tests of the firmware update, resumed from a checkpoint after a restart
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "ESP32OTA.h"
+
+extern "C" {
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_app_format.h"
+#include "mqtt_client.h"
+#include "nvs_flash.h"
+}
+
+#define TEST_OTA_SIZE (3*GW_OTA_WRITE_CHUNK+100)
+
+static uint8_t test_image[TEST_OTA_SIZE];
+static uint8_t test_sha256[32];
+
+/* An app image of this project, then arbitrary bytes */
+static void test_ota_image() {
+	uint32_t seed=1;
+	for(size_t i=0;i<sizeof(test_image);i++) {
+		seed=seed*1103515245+12345;
+		test_image[i]=seed>>16;
+	}
+	test_image[0]=ESP_IMAGE_HEADER_MAGIC;
+	esp_app_desc_t* desc=(esp_app_desc_t*)(test_image+sizeof(esp_image_header_t)+sizeof(esp_image_segment_header_t));
+	*desc=*esp_ota_get_app_description();
+
+	mbedtls_sha256_context sha;
+	mbedtls_sha256_init(&sha);
+	mbedtls_sha256_starts_ret(&sha,0);
+	mbedtls_sha256_update_ret(&sha,test_image,sizeof(test_image));
+	mbedtls_sha256_finish_ret(&sha,test_sha256);
+	mbedtls_sha256_free(&sha);
+}
+
+static void test_ota_command(ESP32_OTA& ota, const char* format, const void* data, size_t len) {
+	wiotp_command_t cmd;
+	memset(&cmd,0,sizeof(cmd));
+	cmd.format=format;
+	cmd.format_len=strlen(format);
+	if(ota.begin(cmd,len)) {
+		ota.data((const char*)data,len,0);
+		ota.end();
+	}
+}
+
+static void test_ota_start(ESP32_OTA& ota) {
+	char json[128];
+	int len=snprintf(json,sizeof(json),"{\"size\":%u,\"sha256\":\"",(unsigned)sizeof(test_image));
+	for(size_t i=0;i<sizeof(test_sha256);i++) {
+		len+=snprintf(json+len,sizeof(json)-len,"%02x",test_sha256[i]);
+	}
+	len+=snprintf(json+len,sizeof(json)-len,"\"}");
+	test_ota_command(ota,"json",json,len);
+}
+
+static void test_ota_chunk(ESP32_OTA& ota, uint32_t offset, size_t len) {
+	static uint8_t chunk[4+TEST_OTA_SIZE];
+	chunk[0]=offset;
+	chunk[1]=offset>>8;
+	chunk[2]=offset>>16;
+	chunk[3]=offset>>24;
+	memcpy(chunk+4,test_image+offset,len);
+	test_ota_command(ota,"bin",chunk,4+len);
+}
+
+/* Two sectors and some bytes of the image received before a restart, checkpointed on each sector */
+static const esp_partition_t* test_ota_interrupted(WIoTP_Publisher& publisher) {
+	ESP32_OTA* ota=new ESP32_OTA(publisher,"iot-2/type/GW/id/gw1/evt/ota/fmt/json",GW_OTA_WRITE_CHUNK/1024);
+	test_ota_start(*ota);
+	GW_CHECK(ota->in_progress());
+	test_ota_chunk(*ota,0,2*GW_OTA_WRITE_CHUNK+50);
+	GW_CHECK_EQ(ota->progress(),2*GW_OTA_WRITE_CHUNK+50);
+	delete ota;
+	return esp_ota_get_next_update_partition(NULL);
+}
+
+/* The digest is not restored from the checkpoint but computed again from the partition, so that
+ * a corrupted sector written before the restart is detected */
+GW_TEST(ota, resume_rehashes_partition) {
+	nvs_flash_init();
+	test_ota_image();
+	esp_mqtt_client_config_t config;
+	memset(&config,0,sizeof(config));
+	esp_mqtt_client_handle_t client=esp_mqtt_client_init(&config);
+	WIoTP_Publisher publisher(client);
+	const esp_partition_t* boot=esp_ota_get_boot_partition();
+
+	const esp_partition_t* partition=test_ota_interrupted(publisher);
+	uint8_t zero=0;
+	GW_CHECK(esp_partition_write(partition,GW_OTA_WRITE_CHUNK+10,&zero,1)==ESP_OK);
+	{
+		ESP32_OTA ota(publisher,"iot-2/type/GW/id/gw1/evt/ota/fmt/json",GW_OTA_WRITE_CHUNK/1024);
+		test_ota_start(ota);
+		GW_CHECK(ota.in_progress());
+		GW_CHECK_EQ(ota.progress(),2*GW_OTA_WRITE_CHUNK);
+		test_ota_chunk(ota,2*GW_OTA_WRITE_CHUNK,TEST_OTA_SIZE-2*GW_OTA_WRITE_CHUNK);
+		GW_CHECK(!ota.in_progress());
+		GW_CHECK(esp_ota_get_boot_partition()==boot);
+	}
+
+	// Resumed intact, the image is selected for boot. This test must be the last one: the gateway then restarts in 2 s
+	partition=test_ota_interrupted(publisher);
+	{
+		ESP32_OTA ota(publisher,"iot-2/type/GW/id/gw1/evt/ota/fmt/json",GW_OTA_WRITE_CHUNK/1024);
+		test_ota_start(ota);
+		GW_CHECK_EQ(ota.progress(),2*GW_OTA_WRITE_CHUNK);
+		test_ota_chunk(ota,2*GW_OTA_WRITE_CHUNK,TEST_OTA_SIZE-2*GW_OTA_WRITE_CHUNK);
+		GW_CHECK(!ota.in_progress());
+		GW_CHECK(esp_ota_get_boot_partition()==partition);
+	}
+	esp_mqtt_client_destroy(client);
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_queue.cpp
+#
+# Tests of the offline queue read position across restarts
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "ESP32SPIFFSQueue.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <unistd.h>
+}
+
+static const char TEST_TOPIC[]="iot-2/type/t/id/d/evt/data/fmt/json";
+
+static void test_queue_clean(const char* dir) {
+	DIR* d=opendir(dir);
+	if(d==NULL) {
+		return;
+	}
+	struct dirent* entry;
+	char path[PATH_MAX];
+	while((entry=readdir(d))!=NULL) {
+		if(entry->d_name[0]=='.') continue;
+		snprintf(path,sizeof(path),"%s/%s",dir,entry->d_name);
+		unlink(path);
+	}
+	closedir(d);
+	rmdir(dir);
+}
+
+static ESP32_SPIFFS_Queue* test_queue_open(const char* dir, uint32_t cursor_records) {
+	return new ESP32_SPIFFS_Queue(dir,1024,16,1,0,256,1000,1000,cursor_records);
+}
+
+/* Index of the next record, whose payload is its index */
+static int test_queue_next(ESP32_SPIFFS_Queue* queue) {
+	const char* topic;
+	const char* payload;
+	size_t len;
+	return queue->peek(&topic,&payload,&len)?atoi(payload):-1;
+}
+
+/* A queue opened after a crash resumes at the last cursor written, every cursor_records records */
+GW_TEST(queue, cursor_every_n_records) {
+	char dir[]="/tmp/gw_test_queue_XXXXXX";
+	GW_CHECK(mkdtemp(dir)!=NULL);
+	ESP32_SPIFFS_Queue* queue=test_queue_open(dir,8);
+	char payload[16];
+	for(int i=0;i<30;i++) {
+		size_t len=snprintf(payload,sizeof(payload),"%d",i);
+		GW_CHECK(queue->push(TEST_TOPIC,payload,len));
+	}
+	GW_CHECK_OP(queue->segments(),>,1);
+	for(int i=0;i<20;i++) {
+		GW_CHECK_EQ(test_queue_next(queue),i);
+		queue->pop();
+	}
+	// Records 0..15 acknowledged by two cursor writes, 16..19 delivered again
+	GW_CHECK_EQ(queue->cursor_writes(),2);
+	ESP32_SPIFFS_Queue* restarted=test_queue_open(dir,8);
+	GW_CHECK_EQ(test_queue_next(restarted),16);
+	delete restarted;
+
+	// Emptying the queue writes the cursor, as does closing it
+	for(int i=20;i<30;i++) {
+		GW_CHECK_EQ(test_queue_next(queue),i);
+		queue->pop();
+	}
+	GW_CHECK(queue->empty());
+	uint32_t writes=queue->cursor_writes();
+	GW_CHECK_OP(writes,<=,5);
+	GW_CHECK(queue->push(TEST_TOPIC,"30",2));
+	GW_CHECK_EQ(test_queue_next(queue),30);
+	queue->pop();
+	delete queue;
+	restarted=test_queue_open(dir,8);
+	GW_CHECK_EQ(test_queue_next(restarted),-1);
+	delete restarted;
+	test_queue_clean(dir);
+}
@@ -0,0 +1,236 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# test_wifi_policy.cpp
+#
+# Tests of the Wifi reconnection policy, driven by a simulated link
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "test.h"
+#include "ESP32WifiPolicy.h"
+
+extern "C" {
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+}
+
+#define TEST_MIN_MS 500
+#define TEST_MAX_MS 60000
+#define TEST_FAILOVER 3
+#define TEST_RESCAN 5
+#define TEST_MAX_RETRY 20
+#define TEST_MAX_APS 4
+
+/**
+ * Event source standing for the Wifi driver: APs go down and up at given times, and an attempt made at t
+ * on an AP succeeds if the AP is up at t, the connection taking connect_ms, else fails after connect_ms.
+ * The policy sees the same sequence of disconnection and connection events as on target.
+ */
+class Test_Link {
+public:
+	ESP32_Wifi_Policy policy;
+	int64_t now_ms = 0;
+	int64_t down_from_ms[TEST_MAX_APS];		// outage of each AP, [down_from_ms,down_until_ms)
+	int64_t down_until_ms[TEST_MAX_APS];
+	const int64_t connect_ms = 100;
+	bool connected = false;
+
+	// Every attempt decided by the policy
+	wifi_attempt_t attempts[256];
+	uint32_t failures_before[256];	// failed attempts of the outage before each attempt
+	size_t n_attempts = 0;
+
+	Test_Link(uint32_t seed, size_t n_aps) : policy(seed,TEST_MIN_MS,TEST_MAX_MS,TEST_FAILOVER,TEST_RESCAN,TEST_MAX_RETRY) {
+		policy.set_ap_count(n_aps);
+		for(size_t i=0;i<TEST_MAX_APS;i++) {
+			down_from_ms[i]=down_until_ms[i]=0;
+		}
+	}
+
+	bool ap_up(size_t ap, int64_t t) const {
+		return t<down_from_ms[ap] || t>=down_until_ms[ap];
+	}
+
+	void start() {
+		policy.on_start(now_ms);
+		now_ms+=connect_ms;
+		connected=ap_up(policy.current_ap(),now_ms);
+		if(connected) {
+			policy.on_connected(now_ms);
+		}
+	}
+
+	/* The link drops at now_ms, attempts go on until connected or until limit_ms */
+	void outage(int64_t limit_ms) {
+		connected=false;
+		uint32_t failed=0;
+		wifi_attempt_t attempt=policy.on_disconnected(now_ms);
+		while(n_attempts<sizeof(attempts)/sizeof(attempts[0])) {
+			attempts[n_attempts]=attempt;
+			failures_before[n_attempts++]=failed;
+			now_ms+=attempt.delay_ms+connect_ms;
+			if(now_ms>=limit_ms) {
+				return;
+			}
+			if(ap_up(attempt.ap,now_ms)) {
+				connected=true;
+				policy.on_connected(now_ms);
+				return;
+			}
+			failed++;
+			attempt=policy.on_disconnected(now_ms);
+		}
+	}
+};
+
+/* Delays stay within [min,max], grow at most threefold, and sit in [max/2,max] once failed() */
+GW_TEST(wifi_policy, backoff_bounds) {
+	for(uint32_t seed=1;seed<=200;seed++) {
+		Test_Link link(seed,1);
+		link.start();
+		GW_CHECK(link.connected);
+		link.down_from_ms[0]=link.now_ms;
+		link.down_until_ms[0]=INT64_MAX;
+		link.outage(INT64_MAX);
+		GW_CHECK_EQ(link.n_attempts,256);
+		uint32_t previous=TEST_MIN_MS;
+		for(size_t i=0;i<link.n_attempts;i++) {
+			uint32_t d=link.attempts[i].delay_ms;
+			GW_CHECK_OP(d,>=,TEST_MIN_MS);
+			GW_CHECK_OP(d,<=,TEST_MAX_MS);
+			if(link.failures_before[i]<TEST_MAX_RETRY) {
+				GW_CHECK_OP(d,<=,previous*3>TEST_MIN_MS?previous*3:TEST_MIN_MS);
+			} else {
+				GW_CHECK_OP(d,>=,TEST_MAX_MS/2);
+			}
+			previous=d;
+		}
+		GW_CHECK(link.policy.failed());
+	}
+}
+
+/**
+ * Gateways losing the same AP at once must not retry in lockstep: the times of their attempts are spread,
+ * no 100 ms slot getting more than a few of the attempts of 1000 gateways.
+ */
+GW_TEST(wifi_policy, jitter_spread) {
+	const size_t gateways=1000, slot_ms=100, slots=TEST_MAX_MS*4/slot_ms;
+	static uint16_t per_slot[3][slots];
+	memset(per_slot,0,sizeof(per_slot));
+	double sum[3]={ 0, 0, 0 }, sum2[3]={ 0, 0, 0 };
+	for(uint32_t g=0;g<gateways;g++) {
+		Test_Link link(0x9e3779b9u*(g+1),1);
+		link.start();
+		int64_t lost_ms=link.now_ms;
+		link.down_from_ms[0]=lost_ms;
+		link.down_until_ms[0]=INT64_MAX;
+		link.outage(INT64_MAX);
+		int64_t t=lost_ms;
+		for(size_t i=0;i<3;i++) {
+			t+=link.attempts[i].delay_ms;
+			size_t slot=(t-lost_ms)/slot_ms;
+			if(slot<slots) per_slot[i][slot]++;
+			sum[i]+=link.attempts[i].delay_ms;
+			sum2[i]+=(double)link.attempts[i].delay_ms*link.attempts[i].delay_ms;
+			t+=link.connect_ms;
+		}
+	}
+	for(size_t i=0;i<3;i++) {
+		uint16_t peak=0;
+		for(size_t s=0;s<slots;s++) {
+			if(per_slot[i][s]>peak) peak=per_slot[i][s];
+		}
+		double mean=sum[i]/gateways, sd=sqrt(sum2[i]/gateways-mean*mean);
+		printf("attempt %d: mean delay %.0f ms, standard deviation %.0f ms, busiest 100 ms slot %u of %d gateways\n",
+				(int)i+1,mean,sd,peak,(int)gateways);
+		// The first delay is uniform over [min,3*min], 1000 ms wide: about 100 gateways per slot, later ones wider
+		GW_CHECK_OP(peak,<=,i==0?160:80);
+		GW_CHECK_OP(sd,>=,i==0?250:500);
+	}
+}
+
+/* After failover_attempts failures on an AP which stays down, the next AP is tried and joined */
+GW_TEST(wifi_policy, failover) {
+	Test_Link link(42,3);
+	link.start();
+	GW_CHECK(link.connected);
+	GW_CHECK_EQ(link.policy.current_ap(),0);
+	link.down_from_ms[0]=link.now_ms;
+	link.down_until_ms[0]=INT64_MAX;
+	link.outage(INT64_MAX);
+	GW_CHECK(link.connected);
+	GW_CHECK_EQ(link.policy.current_ap(),1);
+	GW_CHECK_EQ(link.policy.failovers(),1);
+	// The first attempt and the failover_attempts-1 next ones stay on AP 0
+	for(size_t i=0;i<link.n_attempts;i++) {
+		GW_CHECK_EQ(link.attempts[i].ap,i<TEST_FAILOVER?0:1);
+	}
+	GW_CHECK_EQ(link.n_attempts,TEST_FAILOVER+1);
+	GW_CHECK_EQ(link.policy.reconnects(),1);
+
+	// Both remaining APs down: failover cycles through all of them
+	link.n_attempts=0;
+	for(size_t ap=0;ap<3;ap++) {
+		link.down_from_ms[ap]=link.now_ms;
+		link.down_until_ms[ap]=INT64_MAX;
+	}
+	link.down_until_ms[0]=link.now_ms+100000;
+	link.outage(INT64_MAX);
+	GW_CHECK(link.connected);
+	GW_CHECK_EQ(link.policy.current_ap(),0);
+	GW_CHECK_OP(link.policy.failovers(),>=,3);
+}
+
+/* A full scan is requested on every rescan_attempts-th failure of an outage, and only then */
+GW_TEST(wifi_policy, rescan_triggers) {
+	Test_Link link(7,1);
+	link.start();
+	link.down_from_ms[0]=link.now_ms;
+	link.down_until_ms[0]=INT64_MAX;
+	link.outage(INT64_MAX);
+	for(size_t i=0;i<link.n_attempts;i++) {
+		uint32_t failures=link.failures_before[i];
+		GW_CHECK_EQ(link.attempts[i].full_scan,failures>0 && failures%TEST_RESCAN==0);
+	}
+
+	// The count restarts with each outage
+	Test_Link again(7,1);
+	again.start();
+	again.down_from_ms[0]=again.now_ms;
+	again.down_until_ms[0]=again.now_ms+5000;
+	again.outage(INT64_MAX);
+	GW_CHECK(again.connected);
+	size_t first=again.n_attempts;
+	again.down_from_ms[0]=again.now_ms;
+	again.down_until_ms[0]=INT64_MAX;
+	again.outage(INT64_MAX);
+	GW_CHECK(!again.attempts[first].full_scan);
+	GW_CHECK(again.attempts[first+TEST_RESCAN].full_scan);
+}
+
+/* Reconnection times span from the loss of the link to the connection, the first connection not counted */
+GW_TEST(wifi_policy, reconnect_times) {
+	Test_Link link(3,1);
+	link.start();
+	GW_CHECK_EQ(link.policy.reconnects(),0);
+	int64_t lost_ms=link.now_ms;
+	link.down_from_ms[0]=lost_ms;
+	link.down_until_ms[0]=lost_ms+3000;
+	link.outage(INT64_MAX);
+	GW_CHECK(link.connected);
+	GW_CHECK_EQ(link.policy.reconnects(),1);
+	GW_CHECK_EQ(link.policy.last_reconnect_time(),link.now_ms-lost_ms);
+	GW_CHECK_OP(link.policy.last_reconnect_time(),>=,3000);
+	GW_CHECK(!link.policy.down());
+	GW_CHECK(!link.policy.failed());
+}
@@ -0,0 +1,211 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Adc.h
+#
+# Continuous-mode ADC driver, reading DMA frames of conversions, or one-shot conversions before ESP-IDF 4.4
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32ADC_H_
+#define MAIN_ESP32ADC_H_
+
+extern "C" {
+#include <stdint.h>
+#include "driver/adc.h"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+#include "ESP32Sensors.h"
+#include "WIoTPMetrics.h"
+
+// The continuous-mode driver API, adc_digi_*, appeared in ESP-IDF 4.4
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0)
+#define GW_ADC_CONTINUOUS 1
+#else
+#define GW_ADC_CONTINUOUS 0
+#endif
+
+/**
+ * Analog inputs of ADC1 in continuous mode: the ADC converts the channels of Mask in turn at FreqHz,
+ * and the driver fills a buffer of BufferSize bytes with DMA frames of FrameSize bytes, without the CPU.
+ * At each sampling period, read() drains the frames received, and averages each run of Decimation
+ * conversions of a channel into one reading, each channel being read at FreqHz/channels/Decimation.
+ * Decimation applies at the sampling rate given to begin(): a change of sampling rate scales the readings of
+ * each channel in proportion, the decimation being recomputed.
+ * Readings are timestamped from a conversion clock, resynchronized when it drifts from the time of the read.
+ * Overflows of the buffer, which lose conversions, are counted as WIOTP_CNT_OVERRUNS.
+ * Before ESP-IDF 4.4, without continuous mode, read() instead converts each channel once per sampling period
+ * with adc1_get_raw(), averaging up to 16 conversions of it: FreqHz, FrameSize and BufferSize are then unused.
+ */
+template<uint32_t Mask, uint32_t FreqHz, uint32_t Decimation, uint32_t FrameSize=256, uint32_t BufferSize=4096>
+class ESP32_AdcSensor {
+	static_assert(Mask!=0 && Mask<=0xFF,"ADC1 channels are 0 to 7");
+	static_assert(Decimation>=1 && Decimation<=65535,"decimation out of range");
+#if GW_ADC_CONTINUOUS
+	static_assert(FrameSize%sizeof(adc_digi_output_data_t)==0 && BufferSize>=2*FrameSize,"frames must hold whole conversions");
+#endif
+
+public:
+	typedef uint16_t sample_type;
+	static constexpr size_t channels=gw_popcount(Mask);
+	static const char* channel_name(size_t channel) {
+		static const char* names[]={ "ain0", "ain1", "ain2", "ain3", "ain4", "ain5", "ain6", "ain7" };
+		return names[gw_nth_bit(Mask,channel)];
+	}
+
+#if GW_ADC_CONTINUOUS
+private:
+	static constexpr int64_t period_ns=1000000000LL/FreqHz;
+
+	uint8_t frame[FrameSize];
+	uint32_t sum[channels];
+	uint16_t count[channels];
+	int8_t index[8];			// ADC channel to driver channel, -1 when not converted
+	int64_t clock_ns = 0;		// time of the next conversion
+	uint32_t base_rate_hz = 0;	// sampling rate at which Decimation applies
+	uint32_t decimation = Decimation;
+
+public:
+	bool begin(uint32_t rate_hz) {
+		adc_digi_init_config_t init;
+		init.max_store_buf_size=BufferSize;
+		init.conv_num_each_intr=FrameSize;
+		init.adc1_chan_mask=Mask;
+		init.adc2_chan_mask=0;
+		esp_err_t err=adc_digi_initialize(&init);
+
+		adc_digi_pattern_config_t pattern[channels];
+		for(size_t i=0;i<channels;i++) {
+			pattern[i].atten=ADC_ATTEN_DB_11;
+			pattern[i].channel=gw_nth_bit(Mask,i);
+			pattern[i].unit=0;
+			pattern[i].bit_width=12;		// the only width of the ESP32 continuous mode
+		}
+		adc_digi_configuration_t config;
+		config.conv_limit_en=true;			// required on the ESP32
+		config.conv_limit_num=250;
+		config.pattern_num=channels;
+		config.adc_pattern=pattern;
+		config.sample_freq_hz=FreqHz;
+		config.conv_mode=ADC_CONV_SINGLE_UNIT_1;
+		config.format=ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+		if(err==ESP_OK) err=adc_digi_controller_configure(&config);
+		if(err==ESP_OK) err=adc_digi_start();
+		if(err!=ESP_OK) {
+			ESP_LOGE("ADC","Failed to start continuous conversions (%s)",esp_err_to_name(err));
+			return false;
+		}
+
+		for(size_t i=0;i<8;i++) {
+			index[i]=-1;
+		}
+		for(size_t i=0;i<channels;i++) {
+			index[gw_nth_bit(Mask,i)]=i;
+			sum[i]=0;
+			count[i]=0;
+		}
+		clock_ns=esp_timer_get_time()*1000;
+		base_rate_hz=rate_hz;
+		ESP_LOGI("ADC","Converting %d channels at %u Hz, %u Hz per channel after decimation",
+				(int)channels,FreqHz,(uint32_t)(FreqHz/channels/decimation));
+		return true;
+	}
+
+	void set_rate(uint32_t rate_hz) {
+		uint64_t d=(uint64_t)Decimation*base_rate_hz/rate_hz;
+		decimation=d<1?1:d>65535?65535:(uint32_t)d;
+		// Runs in progress were averaging at the previous decimation
+		for(size_t i=0;i<channels;i++) {
+			sum[i]=0;
+			count[i]=0;
+		}
+		ESP_LOGI("ADC","Decimation %u, %u Hz per channel",decimation,(uint32_t)(FreqHz/channels/decimation));
+	}
+
+	template<class Sink> void read(Sink& sink, int64_t now_us) {
+		uint32_t len=0;
+		esp_err_t err;
+		while((err=adc_digi_read_bytes(frame,FrameSize,&len,0))==ESP_OK || err==ESP_ERR_INVALID_STATE) {
+			if(err==ESP_ERR_INVALID_STATE) {
+				// The buffer overflowed: frames were lost, which the clock does not account for
+				WIoTP_Metrics::count(WIOTP_CNT_OVERRUNS);
+			}
+			const adc_digi_output_data_t* data=(const adc_digi_output_data_t*)frame;
+			for(size_t i=0;i<len/sizeof(adc_digi_output_data_t);i++) {
+				int64_t ts_ns=clock_ns;
+				clock_ns+=period_ns;
+				int c=index[data[i].type1.channel&7];
+				if(c<0) {
+					continue;
+				}
+				sum[c]+=data[i].type1.data;
+				if(++count[c]==decimation) {
+					sink(c,ts_ns/1000,(sample_type)(sum[c]/decimation));
+					sum[c]=0;
+					count[c]=0;
+				}
+			}
+			if(len<FrameSize) {
+				break;
+			}
+		}
+		// Conversions are never from the future, nor older than the buffer can hold
+		int64_t now_ns=now_us*1000;
+		if(clock_ns>now_ns || clock_ns<now_ns-(int64_t)(BufferSize/sizeof(adc_digi_output_data_t))*period_ns) {
+			clock_ns=now_ns;
+		}
+	}
+#else
+private:
+	static constexpr uint32_t oversample=Decimation<16?Decimation:16;
+
+public:
+	bool begin(uint32_t rate_hz) {
+		esp_err_t err=adc1_config_width(ADC_WIDTH_BIT_12);
+		for(size_t i=0;i<channels && err==ESP_OK;i++) {
+			err=adc1_config_channel_atten((adc1_channel_t)gw_nth_bit(Mask,i),ADC_ATTEN_DB_11);
+		}
+		if(err!=ESP_OK) {
+			ESP_LOGE("ADC","Failed to configure one-shot conversions (%s)",esp_err_to_name(err));
+			return false;
+		}
+		ESP_LOGI("ADC","Converting %d channels once per sampling period, %u conversions averaged",(int)channels,oversample);
+		return true;
+	}
+
+	// A reading of each channel per sampling period follows the rate by itself
+	void set_rate(uint32_t rate_hz) {
+	}
+
+	template<class Sink> void read(Sink& sink, int64_t now_us) {
+		for(size_t c=0;c<channels;c++) {
+			uint32_t total=0;
+			uint32_t n=0;
+			for(uint32_t i=0;i<oversample;i++) {
+				int raw=adc1_get_raw((adc1_channel_t)gw_nth_bit(Mask,c));
+				if(raw>=0) {
+					total+=raw;
+					n++;
+				}
+			}
+			// No reading of the channel for this period when all of its conversions failed
+			if(n>0) {
+				sink(c,now_us,(sample_type)(total/n));
+			}
+		}
+	}
+#endif
+};
+
+#endif /* MAIN_ESP32ADC_H_ */
@@ -0,0 +1,53 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Boot.cpp
+#
+# Timestamps of the startup phases
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32Boot.h"
+
+extern "C" {
+#include "esp_timer.h"
+#include "esp_log.h"
+}
+
+static const char *LOG_TAG="BOOT";
+
+int64_t ESP32_Boot::times_us[GW_BOOT_PHASES];
+
+bool ESP32_Boot::mark(gw_boot_phase_t phase) {
+	if(times_us[phase]!=0) {
+		return false;
+	}
+	times_us[phase]=esp_timer_get_time();
+	ESP_LOGD(LOG_TAG,"%s at %lld ms",phase_name(phase),times_us[phase]/1000);
+	return true;
+}
+
+const char* ESP32_Boot::phase_name(gw_boot_phase_t phase) {
+	static const char* names[GW_BOOT_PHASES]={ "config", "wifi_start", "wifi_connected", "got_ip", "mqtt_connected", "first_publish" };
+	return names[phase];
+}
+
+void ESP32_Boot::log() {
+	int64_t previous=0;
+	for(int i=0;i<GW_BOOT_PHASES;i++) {
+		if(times_us[i]==0) {
+			ESP_LOGI(LOG_TAG,"%-15s not reached",phase_name((gw_boot_phase_t)i));
+			continue;
+		}
+		ESP_LOGI(LOG_TAG,"%-15s %6lld ms (+%lld ms)",phase_name((gw_boot_phase_t)i),times_us[i]/1000,(times_us[i]-previous)/1000);
+		previous=times_us[i];
+	}
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Boot.h
+#
+# Timestamps of the startup phases
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32BOOT_H_
+#define MAIN_ESP32BOOT_H_
+
+extern "C" {
+#include <stdint.h>
+}
+
+/* Startup phases, in their expected order */
+typedef enum {
+	GW_BOOT_CONFIG,				// configuration loaded
+	GW_BOOT_WIFI_START,			// Wifi station started
+	GW_BOOT_WIFI_CONNECTED,		// associated to the AP
+	GW_BOOT_GOT_IP,				// IP address obtained
+	GW_BOOT_MQTT_CONNECTED,		// connected to the broker
+	GW_BOOT_FIRST_PUBLISH,		// first publish acknowledged
+	GW_BOOT_PHASES
+} gw_boot_phase_t;
+
+/**
+ * Records the time since boot at which each startup phase is first reached.
+ * Phases are marked from the tasks and event handlers which complete them.
+ */
+class ESP32_Boot {
+private:
+	static int64_t times_us[GW_BOOT_PHASES];
+
+public:
+	/* Record the phase as reached now, returns false if it was already reached */
+	static bool mark(gw_boot_phase_t phase);
+
+	/* Time since boot at which the phase was reached, 0 if not reached yet */
+	static int64_t time_us(gw_boot_phase_t phase) { return times_us[phase]; }
+
+	static const char* phase_name(gw_boot_phase_t phase);
+
+	/* Log the time reached by each phase, and the time spent since the previous one */
+	static void log();
+};
+
+#endif /* MAIN_ESP32BOOT_H_ */
@@ -0,0 +1,178 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Config.cpp
+#
+# Consolidated gateway configuration, parsed once and cached in NVS
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32Config.h"
+#include "WIoTPConfigArena.h"
+#include "WIoTPBudget.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+}
+
+static const char *LOG_TAG="CONFIG";
+
+/* Keys of the one-liner files used before the consolidated configuration */
+static const char* CONFIG_LEGACY_KEYS[]={ "wifi_ssid", "wifi_pass", "wiotp_orgid", "wiotp_gw_type",
+		"wiotp_gw_id", "wiotp_gw_token", "wiotp_dev_type", "wiotp_dev_id", "wiotp_host" };
+#define CONFIG_LEGACY_COUNT (sizeof(CONFIG_LEGACY_KEYS)/sizeof(CONFIG_LEGACY_KEYS[0]))
+#define CONFIG_LEGACY_MAX_LEN 256
+
+/* Mix the content and size of a file into h, returns false if it does not exist.
+ * A file rewritten within the same second with the same size, or copied with its time, still changes h */
+static bool fingerprint_file(const char* path, uint32_t* h) {
+	FILE* f=fopen(path,"r");
+	if(f==NULL) {
+		*h=wiotp_fnv1a(*h,"-",1);
+		return false;
+	}
+	char buf[128];
+	uint32_t size=0;
+	size_t n;
+	while((n=fread(buf,1,sizeof(buf),f))>0) {
+		*h=wiotp_fnv1a(*h,buf,n);
+		size+=n;
+	}
+	fclose(f);
+	*h=wiotp_fnv1a(*h,&size,sizeof(size));
+	return true;
+}
+
+ESP32_Config::ESP32_Config(const char* path, const char* nvs_namespace) : nvs_namespace(nvs_namespace) {
+	int64_t start_us=esp_timer_get_time();
+	uint32_t heap=esp_get_free_heap_size();
+
+	char legacy_path[64];
+	uint32_t fingerprint=WIOTP_FNV_OFFSET;
+	bool legacy=!fingerprint_file(path,&fingerprint);
+	if(legacy) {
+		for(size_t i=0;i<CONFIG_LEGACY_COUNT;i++) {
+			snprintf(legacy_path,sizeof(legacy_path),"/secret/%s.txt",CONFIG_LEGACY_KEYS[i]);
+			fingerprint_file(legacy_path,&fingerprint);
+		}
+	}
+
+	if(load_cache(fingerprint)) {
+		ESP_LOGI(LOG_TAG,"Loaded %d bytes of configuration from NVS in %lld us",arena_size,esp_timer_get_time()-start_us);
+		return;
+	}
+
+	// Gather the configuration text in scratch memory, from the file or from the legacy files
+	char* blob=NULL;
+	size_t blob_size=0, len=0;
+	if(!legacy) {
+		struct stat st;
+		FILE* f=fopen(path,"r");
+		if(f!=NULL && stat(path,&st)==0) {
+			blob_size=st.st_size+1;
+			blob=(char*)WIoTP_Budget::alloc(WIOTP_MEM_SCRATCH,blob_size);
+			len=fread(blob,1,st.st_size,f);
+		}
+		if(f!=NULL) fclose(f);
+	} else {
+		ESP_LOGW(LOG_TAG,"%s not found, reading legacy configuration files",path);
+		blob_size=CONFIG_LEGACY_COUNT*(CONFIG_LEGACY_MAX_LEN+32);
+		blob=(char*)WIoTP_Budget::alloc(WIOTP_MEM_SCRATCH,blob_size);
+		for(size_t i=0;i<CONFIG_LEGACY_COUNT;i++) {
+			snprintf(legacy_path,sizeof(legacy_path),"/secret/%s.txt",CONFIG_LEGACY_KEYS[i]);
+			FILE* f=fopen(legacy_path,"r");
+			if(f==NULL) continue;
+			len+=sprintf(blob+len,"%s=",CONFIG_LEGACY_KEYS[i]);
+			size_t n=fread(blob+len,1,CONFIG_LEGACY_MAX_LEN,f);
+			fclose(f);
+			// Keep the first line only
+			char* eol=(char*)memchr(blob+len,'\n',n);
+			len+=eol!=NULL?eol-(blob+len):n;
+			blob[len++]='\n';
+		}
+	}
+	if(blob==NULL) {
+		ESP_LOGE(LOG_TAG,"Failed to read configuration %s",path);
+		return;
+	}
+
+	arena_size=wiotp_config_size(blob,len);
+	if(arena_size<=UINT16_MAX) {
+		arena=(uint8_t*)WIoTP_Budget::alloc(WIOTP_MEM_CONFIG,arena_size);
+		wiotp_config_build(blob,len,arena,arena_size);
+		save_cache(fingerprint);
+	} else {
+		ESP_LOGE(LOG_TAG,"Configuration too large: %d bytes",arena_size);
+		arena_size=0;
+	}
+	WIoTP_Budget::release(WIOTP_MEM_SCRATCH,blob,blob_size);
+	ESP_LOGI(LOG_TAG,"Parsed %d bytes of configuration in %lld us, heap used %d bytes",
+			arena_size,esp_timer_get_time()-start_us,heap-esp_get_free_heap_size());
+}
+
+ESP32_Config::~ESP32_Config() {
+	WIoTP_Budget::release(WIOTP_MEM_CONFIG,arena,arena_size);
+}
+
+bool ESP32_Config::load_cache(uint32_t fingerprint) {
+	nvs_handle_t handle;
+	if(nvs_open(nvs_namespace,NVS_READONLY,&handle)!=ESP_OK) {
+		return false;
+	}
+	uint32_t cached;
+	size_t size=0;
+	bool ok=nvs_get_u32(handle,"fingerprint",&cached)==ESP_OK && cached==fingerprint
+			&& nvs_get_blob(handle,"arena",NULL,&size)==ESP_OK && size<=UINT16_MAX;
+	if(ok) {
+		arena=(uint8_t*)WIoTP_Budget::alloc(WIOTP_MEM_CONFIG,size);
+		ok=nvs_get_blob(handle,"arena",arena,&size)==ESP_OK && wiotp_config_check(arena,size);
+	}
+	nvs_close(handle);
+
+	if(!ok) {
+		// Given back as the last allocation of the region
+		WIoTP_Budget::release(WIOTP_MEM_CONFIG,arena,size);
+		arena=NULL;
+		return false;
+	}
+	arena_size=size;
+	return true;
+}
+
+void ESP32_Config::save_cache(uint32_t fingerprint) {
+	nvs_handle_t handle;
+	esp_err_t err=nvs_open(nvs_namespace,NVS_READWRITE,&handle);
+	if(err==ESP_OK) {
+		err=nvs_set_blob(handle,"arena",arena,arena_size);
+		if(err==ESP_OK) err=nvs_set_u32(handle,"fingerprint",fingerprint);
+		if(err==ESP_OK) err=nvs_commit(handle);
+		nvs_close(handle);
+	}
+	if(err!=ESP_OK) {
+		ESP_LOGW(LOG_TAG,"Failed to cache configuration in NVS (%s)",esp_err_to_name(err));
+	}
+}
+
+const char* ESP32_Config::get(const char* key, const char* def) const {
+	if(arena==NULL) {
+		return def;
+	}
+	const char* value=wiotp_config_get(arena,key);
+	return value!=NULL?value:def;
+}
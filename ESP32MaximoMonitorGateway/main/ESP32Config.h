@@ -0,0 +1,57 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Config.h
+#
+# Consolidated gateway configuration, parsed once and cached in NVS
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32CONFIG_H_
+#define MAIN_ESP32CONFIG_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+}
+
+/**
+ * Key/value configuration of the gateway.
+ * Usage:
+ *   Init ESP32_Config() after SPIFFS and NVS
+ *   get() values, which remain valid for the lifetime of the instance
+ *
+ * The configuration is a single file of key=value lines, '#' starting a comment.
+ * When it does not exist, the legacy one-liner files /secret/<key>.txt are read instead.
+ * It is parsed into one arena holding an open-addressing hash table and the strings (see wiotp_config_parse()), which is
+ * cached in NVS along with an FNV-1a hash of the file content. Later boots only hash the file, which takes
+ * no allocation, and load the arena from NVS in a single read.
+ */
+class ESP32_Config {
+private:
+	uint8_t* arena = NULL;
+	size_t arena_size = 0;
+	const char* nvs_namespace;
+
+	bool load_cache(uint32_t fingerprint);
+	void save_cache(uint32_t fingerprint);
+
+public:
+	ESP32_Config(const char* path="/secret/config.txt", const char* nvs_namespace="gw_config");
+	virtual ~ESP32_Config();
+
+	/* Value of key, or def if not set */
+	const char* get(const char* key, const char* def=NULL) const;
+
+	size_t size() const { return arena_size; }
+};
+
+#endif /* MAIN_ESP32CONFIG_H_ */
@@ -0,0 +1,158 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32FanIn.cpp
+#
+# UDP ingestion of the readings of downstream devices
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32FanIn.h"
+#include "ESP32Tasks.h"
+
+extern "C" {
+#include <errno.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+}
+
+static const char *LOG_TAG="FANIN";
+
+/* Parse an integer at p, returns the character after it or NULL */
+static const char* parse_int(const char* p, const char* end, int32_t* value) {
+	bool neg=p<end && *p=='-';
+	if(neg) {
+		p++;
+	}
+	if(p>=end || *p<'0' || *p>'9') {
+		return NULL;
+	}
+	int64_t v=0;
+	while(p<end && *p>='0' && *p<='9') {
+		v=v*10+(*p++-'0');
+		if(v>(int64_t)INT32_MAX+1) {
+			return NULL;
+		}
+	}
+	if(p<end && *p!=' ' && *p!='\t' && *p!='\r') {
+		return NULL;
+	}
+	v=neg?-v:v;
+	if(v>INT32_MAX) {
+		return NULL;
+	}
+	*value=(int32_t)v;
+	return p;
+}
+
+ESP32_FanIn::ESP32_FanIn(WIoTP_Devices& devices, uint16_t port) : devices(devices), port(port) {
+}
+
+ESP32_FanIn::~ESP32_FanIn() {
+	if(task!=NULL) {
+		vTaskDelete(task);
+	}
+	if(sock>=0) {
+		close(sock);
+	}
+}
+
+bool ESP32_FanIn::start(UBaseType_t priority, uint32_t stack_size, int core) {
+	sock=socket(AF_INET,SOCK_DGRAM,IPPROTO_UDP);
+	if(sock<0) {
+		ESP_LOGE(LOG_TAG,"Failed to create socket: errno %d",errno);
+		return false;
+	}
+	struct sockaddr_in addr;
+	memset(&addr,0,sizeof(addr));
+	addr.sin_family=AF_INET;
+	addr.sin_addr.s_addr=htonl(INADDR_ANY);
+	addr.sin_port=htons(port);
+	if(bind(sock,(struct sockaddr*)&addr,sizeof(addr))<0) {
+		ESP_LOGE(LOG_TAG,"Failed to bind UDP port %u: errno %d",port,errno);
+		close(sock);
+		sock=-1;
+		return false;
+	}
+
+	xTaskCreatePinnedToCore(&_listen_task, "FanIn", stack_size, this, priority, &task, gw_task_core(core));
+	ESP_LOGI(LOG_TAG,"Listening on UDP port %u for up to %d devices",port,devices.capacity());
+	return true;
+}
+
+void ESP32_FanIn::_listen_task(void* that) {
+	((ESP32_FanIn*)that)->listen_task();
+}
+
+void ESP32_FanIn::listen_task() {
+	while(true) {
+		int len=recv(sock,datagram,sizeof(datagram),0);
+		if(len<0) {
+			ESP_LOGW(LOG_TAG,"Receive failed: errno %d",errno);
+			vTaskDelay(pdMS_TO_TICKS(1000));
+			continue;
+		}
+		stat_datagrams++;
+		parse(datagram,len,esp_timer_get_time());
+	}
+}
+
+size_t ESP32_FanIn::parse(const char* buf, size_t len, int64_t ts_us) {
+	size_t n=0;
+	const char* end=buf+len;
+	for(const char* line=buf;line<end;) {
+		const char* eol=(const char*)memchr(line,'\n',end-line);
+		if(eol==NULL) {
+			eol=end;
+		}
+
+		// <type>/<id>, up to the first blank
+		const char* sep=(const char*)memchr(line,'/',eol-line);
+		const char* key_end=line;
+		while(key_end<eol && *key_end!=' ' && *key_end!='\t' && *key_end!='\r') {
+			key_end++;
+		}
+		if(sep==NULL || sep>=key_end) {
+			if(key_end>line) {
+				stat_malformed++;
+			}
+			line=eol+1;
+			continue;
+		}
+		// Lines of rejected devices are counted by the registry
+		int device=devices.lookup(line,sep-line,sep+1,key_end-sep-1);
+
+		const char* p=key_end;
+		while(device>=0) {
+			while(p<eol && (*p==' ' || *p=='\t' || *p=='\r')) {
+				p++;
+			}
+			if(p>=eol) {
+				break;
+			}
+			gw_device_sample_t sample;
+			p=parse_int(p,eol,&sample.value);
+			if(p==NULL) {
+				// Readings before the malformed one are kept
+				stat_malformed++;
+				break;
+			}
+			sample.ts_us=ts_us;
+			sample.device=device;
+			ring.push(sample);
+			n++;
+		}
+		line=eol+1;
+	}
+	return n;
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32FanIn.h
+#
+# UDP ingestion of the readings of downstream devices
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32FANIN_H_
+#define MAIN_ESP32FANIN_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+#include "SPSCRing.h"
+#include "WIoTPDevices.h"
+
+/* Largest datagram accepted */
+#define GW_FANIN_MAX_DATAGRAM 1024
+
+/* One timestamped reading of a downstream device */
+typedef struct {
+	int64_t ts_us;
+	int32_t value;
+	uint16_t device;			// index in the device registry
+} gw_device_sample_t;
+
+/**
+ * Receives the readings of downstream devices on a UDP port, in a dedicated task.
+ * Each datagram holds lines of "<type>/<id> <value> [<value>...]", with integer values.
+ * Devices are resolved, and registered on their first reading, in the receiving task, and their
+ * readings pushed into a SPSC ring consumed by the publishing task, which batches them per device.
+ */
+class ESP32_FanIn {
+private:
+	WIoTP_Devices& devices;
+	const uint16_t port;
+	int sock = -1;
+	TaskHandle_t task = NULL;
+	char datagram[GW_FANIN_MAX_DATAGRAM];
+
+	// Statistics since creation, receiving task only
+	uint32_t stat_datagrams = 0;
+	uint32_t stat_malformed = 0;
+
+	static void _listen_task(void* that);
+
+protected:
+	virtual void listen_task();
+
+public:
+	SPSC_Ring<gw_device_sample_t, CONFIG_GW_FANIN_RING_SIZE> ring;
+
+	ESP32_FanIn(WIoTP_Devices& devices, uint16_t port=CONFIG_GW_FANIN_PORT);
+	virtual ~ESP32_FanIn();
+
+	/* Bind the UDP port and create the receiving task, pinned to core unless -1. Returns false if the port cannot be bound */
+	bool start(UBaseType_t priority=CONFIG_GW_FANIN_TASK_PRIORITY, uint32_t stack_size=CONFIG_GW_FANIN_TASK_STACK,
+			int core=CONFIG_GW_NET_TASK_CORE);
+
+	/* Push the readings of the lines of a datagram into the ring, returns the number of readings */
+	size_t parse(const char* buf, size_t len, int64_t ts_us);
+
+	uint32_t datagrams() const { return stat_datagrams; }
+	uint32_t malformed() const { return stat_malformed; }
+	TaskHandle_t task_handle() const { return task; }
+};
+
+#endif /* MAIN_ESP32FANIN_H_ */
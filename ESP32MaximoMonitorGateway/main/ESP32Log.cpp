@@ -0,0 +1,362 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Log.cpp
+#
+# Deferred logging: records taken on the hot paths, formatted and written by a low priority task
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32Log.h"
+
+#ifdef CONFIG_GW_LOG_DEFERRED
+
+#include "ESP32Tasks.h"
+#include "WIoTPMetrics.h"
+
+extern "C" {
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+}
+
+static const char *LOG_TAG="LOG";
+
+// Tags whose rate is limited, records of other tags are not
+#define LOG_MAX_TAGS 16
+
+#ifdef CONFIG_GW_LOG_OUTPUT_FILE
+static const char* LOG_FILE="/log/gw.log";
+static const char* LOG_FILE_OLD="/log/gw.1.log";
+#endif
+
+MPSC_Ring<gw_log_record_t, CONFIG_GW_LOG_RING_SIZE> ESP32_Log::ring;
+std::atomic<uint32_t> ESP32_Log::stat_limited(0);
+TaskHandle_t ESP32_Log::task=NULL;
+
+/* Records of a tag within the current second */
+typedef struct {
+	std::atomic<const char*> tag;
+	std::atomic<uint32_t> second;
+	std::atomic<uint32_t> count;
+} log_tag_t;
+
+static log_tag_t log_tags[LOG_MAX_TAGS];
+
+bool gw_log_next_spec(const char* format, gw_log_spec_t* spec) {
+	const char* p=format;
+	while(true) {
+		p=strchr(p,'%');
+		if(p==NULL) {
+			return false;
+		}
+		if(p[1]!='%') {
+			break;
+		}
+		p+=2;
+	}
+	spec->start=p++;
+	spec->stars=0;
+	spec->star_precision=false;
+	spec->precision=-1;
+	while(*p!='\0' && strchr("-+ #0",*p)!=NULL) p++;
+	if(*p=='*') {
+		spec->stars++;
+		p++;
+	} else {
+		while(*p>='0' && *p<='9') p++;
+	}
+	if(*p=='.') {
+		p++;
+		if(*p=='*') {
+			spec->stars++;
+			spec->star_precision=true;
+			p++;
+		} else {
+			spec->precision=0;
+			while(*p>='0' && *p<='9') spec->precision=spec->precision*10+*p++-'0';
+		}
+	}
+	spec->length=p;
+	while(*p!='\0' && strchr("hlLqjzt",*p)!=NULL) p++;
+	if(*p=='\0') {
+		return false;
+	}
+	spec->end=p+1;
+	return true;
+}
+
+void ESP32_Log::Packer::advance() {
+	if(pending>0) {
+		return;
+	}
+	gw_log_spec_t spec;
+	if(next==NULL || !gw_log_next_spec(next,&spec)) {
+		// More arguments than conversions, they are ignored
+		next=NULL;
+		pending=1;
+		return;
+	}
+	next=spec.end;
+	pending=spec.stars+1;
+	star_precision=spec.star_precision;
+	precision=spec.precision;
+}
+
+void ESP32_Log::Packer::add_int(int64_t v) {
+	advance();
+	// The precision given as an argument bounds the string which follows
+	if(pending==2 && star_precision) {
+		precision=(int)v;
+	}
+	pending--;
+	if(record.n_args<GW_LOG_MAX_ARGS) {
+		record.kinds[record.n_args]=GW_LOG_ARG_INT;
+		record.args[record.n_args++].i=v;
+	}
+}
+
+void ESP32_Log::Packer::add_double(double v) {
+	advance();
+	pending--;
+	if(record.n_args<GW_LOG_MAX_ARGS) {
+		record.kinds[record.n_args]=GW_LOG_ARG_DOUBLE;
+		record.args[record.n_args++].d=v;
+	}
+}
+
+void ESP32_Log::Packer::add_text(const char* s) {
+	advance();
+	pending--;
+	if(record.n_args>=GW_LOG_MAX_ARGS) {
+		return;
+	}
+	if(s==NULL) {
+		s="(null)";
+	}
+	// Never reads past the precision, strings such as MQTT topics being unterminated
+	size_t max=GW_LOG_MAX_TEXT-1-record.text_len;
+	if(precision>=0 && (size_t)precision<max) {
+		max=precision;
+	}
+	size_t len=strnlen(s,max);
+	memcpy(record.text+record.text_len,s,len);
+	record.kinds[record.n_args]=GW_LOG_ARG_TEXT;
+	record.args[record.n_args++].i=record.text_len;
+	record.text_len+=len;
+	record.text[record.text_len++]='\0';
+}
+
+bool ESP32_Log::admit(const char* tag, int64_t now_us) {
+	if(CONFIG_GW_LOG_TAG_RATE==0) {
+		return true;
+	}
+	for(int i=0;i<LOG_MAX_TAGS;i++) {
+		log_tag_t& t=log_tags[i];
+		const char* current=t.tag.load(std::memory_order_acquire);
+		if(current==NULL) {
+			// First record of the tag, unless another task registered a tag in this slot meanwhile
+			if(!t.tag.compare_exchange_strong(current,tag,std::memory_order_acq_rel) && current!=tag) {
+				continue;
+			}
+		} else if(current!=tag) {
+			continue;
+		}
+		// A new second resets the count, racing callers at worst letting a few more records through
+		uint32_t second=(uint32_t)(now_us/1000000);
+		if(t.second.load(std::memory_order_relaxed)!=second) {
+			t.second.store(second,std::memory_order_relaxed);
+			t.count.store(0,std::memory_order_relaxed);
+		}
+		if(t.count.fetch_add(1,std::memory_order_relaxed)<CONFIG_GW_LOG_TAG_RATE) {
+			return true;
+		}
+		stat_limited.fetch_add(1,std::memory_order_relaxed);
+		WIoTP_Metrics::count(WIOTP_CNT_LOG_LIMITED);
+		return false;
+	}
+	// Too many tags to track, not limited
+	return true;
+}
+
+void ESP32_Log::push(const gw_log_record_t& record) {
+	if(!ring.push(record)) {
+		WIoTP_Metrics::count(WIOTP_CNT_LOG_DROPPED);
+	}
+}
+
+/* Append the conversion fmt of one argument, after the values of its * width and precision */
+template<typename T> static int log_convert(char* out, size_t len, const char* fmt, const int* stars, int n_stars, T value) {
+	switch(n_stars) {
+	case 0: return snprintf(out,len,fmt,value);
+	case 1: return snprintf(out,len,fmt,stars[0],value);
+	default: return snprintf(out,len,fmt,stars[0],stars[1],value);
+	}
+}
+
+/* Value of a signed conversion, as the length modifier would read it from the arguments */
+static long long log_signed(const char* length, size_t n, int64_t v) {
+	if(n==0) return (int)v;
+	if(length[0]=='h') return n==2?(long long)(signed char)v:(long long)(short)v;
+	if(length[0]=='l' && n==1) return (long)v;
+	if(length[0]=='z' || length[0]=='t') return (ptrdiff_t)v;
+	return v;
+}
+
+static unsigned long long log_unsigned(const char* length, size_t n, int64_t v) {
+	if(n==0) return (unsigned int)v;
+	if(length[0]=='h') return n==2?(unsigned long long)(unsigned char)v:(unsigned long long)(unsigned short)v;
+	if(length[0]=='l' && n==1) return (unsigned long)v;
+	if(length[0]=='z' || length[0]=='t') return (size_t)v;
+	return (uint64_t)v;
+}
+
+size_t ESP32_Log::format(const gw_log_record_t& record, char* line, size_t len) {
+	static const char letters[]="NEWIDV";
+	size_t n=snprintf(line,len,"%c (%u) %s: ",letters[record.level<=ESP_LOG_VERBOSE?record.level:0],
+			(uint32_t)(record.ts_us/1000),record.tag);
+	const char* p=record.format;
+	int arg=0;
+	gw_log_spec_t spec;
+	while(true) {
+		bool more=gw_log_next_spec(p,&spec);
+		// Literal text up to the conversion, %% being printed as %
+		const char* literal_end=more?spec.start:p+strlen(p);
+		while(p<literal_end && n<len-1) {
+			line[n++]=*p;
+			p+=(p[0]=='%' && p[1]=='%')?2:1;
+		}
+		if(!more) {
+			break;
+		}
+		p=spec.end;
+
+		int stars[2]={ 0, 0 };
+		for(int i=0;i<spec.stars;i++) {
+			stars[i]=(arg<record.n_args && record.kinds[arg]==GW_LOG_ARG_INT)?(int)record.args[arg].i:0;
+			arg++;
+		}
+		// The conversion, its length modifier replaced by the one of the value passed
+		char fmt[24];
+		size_t length_n=spec.end-1-spec.length;
+		size_t head=spec.length-spec.start;
+		char conversion=spec.end[-1];
+		if(head>sizeof(fmt)-4 || arg>=record.n_args) {
+			n+=snprintf(line+n,len-n,"?");
+		} else {
+			memcpy(fmt,spec.start,head);
+			int kind=record.kinds[arg];
+			int written;
+			if(strchr("di",conversion)!=NULL && kind==GW_LOG_ARG_INT) {
+				snprintf(fmt+head,sizeof(fmt)-head,"ll%c",conversion);
+				written=log_convert(line+n,len-n,fmt,stars,spec.stars,log_signed(spec.length,length_n,record.args[arg].i));
+			} else if(strchr("uoxX",conversion)!=NULL && kind==GW_LOG_ARG_INT) {
+				snprintf(fmt+head,sizeof(fmt)-head,"ll%c",conversion);
+				written=log_convert(line+n,len-n,fmt,stars,spec.stars,log_unsigned(spec.length,length_n,record.args[arg].i));
+			} else if(conversion=='c' && kind==GW_LOG_ARG_INT) {
+				snprintf(fmt+head,sizeof(fmt)-head,"c");
+				written=log_convert(line+n,len-n,fmt,stars,spec.stars,(int)record.args[arg].i);
+			} else if(conversion=='p' && kind==GW_LOG_ARG_INT) {
+				snprintf(fmt+head,sizeof(fmt)-head,"p");
+				written=log_convert(line+n,len-n,fmt,stars,spec.stars,(void*)(intptr_t)record.args[arg].i);
+			} else if(strchr("eEfFgGaA",conversion)!=NULL && kind==GW_LOG_ARG_DOUBLE) {
+				snprintf(fmt+head,sizeof(fmt)-head,"%c",conversion);
+				written=log_convert(line+n,len-n,fmt,stars,spec.stars,record.args[arg].d);
+			} else if(conversion=='s' && kind==GW_LOG_ARG_TEXT) {
+				snprintf(fmt+head,sizeof(fmt)-head,"s");
+				written=log_convert(line+n,len-n,fmt,stars,spec.stars,(const char*)record.text+record.args[arg].i);
+			} else {
+				written=snprintf(line+n,len-n,"?");
+			}
+			n+=written>0?written:0;
+		}
+		arg++;
+		if(n>=len-1) {
+			n=len-1;
+			break;
+		}
+	}
+	if(n>=len-1) {
+		n=len-2;
+	}
+	line[n++]='\n';
+	line[n]='\0';
+	return n;
+}
+
+void ESP32_Log::_log_task(void* arg) {
+	// Static, to keep the stack small
+	static gw_log_record_t record;
+	static char line[GW_LOG_MAX_LINE];
+#ifdef CONFIG_GW_LOG_OUTPUT_FILE
+	FILE* file=fopen(LOG_FILE,"a");
+	long file_size=0;
+	if(file!=NULL) {
+		fseek(file,0,SEEK_END);
+		file_size=ftell(file);
+	} else {
+		ESP_LOGE(LOG_TAG,"Failed to open %s, logging to the console",LOG_FILE);
+	}
+#endif
+	uint32_t dropped=0, limited=0;
+	int64_t reported_us=0;
+	while(true) {
+		while(ring.pop(record)) {
+#ifdef CONFIG_GW_LOG_OUTPUT_FILE
+			size_t len=format(record,line,sizeof(line));
+			if(file!=NULL) {
+				if(file_size+(long)len>CONFIG_GW_LOG_FILE_SIZE) {
+					// The previous file is replaced by the current one
+					fclose(file);
+					remove(LOG_FILE_OLD);
+					rename(LOG_FILE,LOG_FILE_OLD);
+					file=fopen(LOG_FILE,"w");
+					file_size=0;
+					if(file==NULL) {
+						ESP_LOGE(LOG_TAG,"Failed to open %s, logging to the console",LOG_FILE);
+					}
+				}
+				if(file!=NULL) {
+					fwrite(line,1,len,file);
+					file_size+=len;
+					continue;
+				}
+			}
+#else
+			format(record,line,sizeof(line));
+#endif
+			esp_log_write((esp_log_level_t)record.level,record.tag,"%s",line);
+		}
+#ifdef CONFIG_GW_LOG_OUTPUT_FILE
+		if(file!=NULL) {
+			fflush(file);
+		}
+#endif
+		// Reported at most once a second, not to become a storm of its own
+		int64_t now_us=esp_timer_get_time();
+		if(now_us-reported_us>=1000000 && (ring.overrun_count()!=dropped || limited!=ESP32_Log::limited())) {
+			ESP_LOGW(LOG_TAG,"%u records dropped on a full ring, %u beyond the rate of their tag",
+					ring.overrun_count()-dropped,ESP32_Log::limited()-limited);
+			dropped=ring.overrun_count();
+			limited=ESP32_Log::limited();
+			reported_us=now_us;
+		}
+		vTaskDelay(pdMS_TO_TICKS(CONFIG_GW_LOG_FLUSH_MS));
+	}
+}
+
+void ESP32_Log::start() {
+	xTaskCreatePinnedToCore(&_log_task,"Log",CONFIG_GW_LOG_TASK_STACK,NULL,CONFIG_GW_LOG_TASK_PRIORITY,&task,
+			gw_task_core(CONFIG_GW_NET_TASK_CORE));
+	ESP_LOGI(LOG_TAG,"Deferred logging through a ring of %d records",ring.capacity());
+}
+
+#endif /* CONFIG_GW_LOG_DEFERRED */
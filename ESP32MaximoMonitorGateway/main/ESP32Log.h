@@ -0,0 +1,187 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Log.h
+#
+# Deferred logging: records taken on the hot paths, formatted and written by a low priority task
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32LOG_H_
+#define MAIN_ESP32LOG_H_
+
+extern "C" {
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+#ifdef CONFIG_GW_LOG_DEFERRED
+
+#include <atomic>
+#include <type_traits>
+
+#include "MPSCRing.h"
+
+// Arguments and bytes of string arguments kept per record, those beyond being printed as ?
+#define GW_LOG_MAX_ARGS 12
+#define GW_LOG_MAX_TEXT 64
+// Longest line written, longer ones being truncated
+#define GW_LOG_MAX_LINE 256
+
+typedef enum {
+	GW_LOG_ARG_INT,				// any integer, or a pointer other than a string
+	GW_LOG_ARG_DOUBLE,
+	GW_LOG_ARG_TEXT				// string copied into the record, at the offset held by the argument
+} gw_log_arg_t;
+
+/* A log call: its format, which must be a literal, and its raw arguments */
+typedef struct {
+	int64_t ts_us;
+	const char* tag;
+	const char* format;
+	uint8_t level;
+	uint8_t n_args;
+	uint8_t text_len;
+	uint8_t kinds[GW_LOG_MAX_ARGS];
+	union {
+		int64_t i;
+		double d;
+	} args[GW_LOG_MAX_ARGS];
+	char text[GW_LOG_MAX_TEXT];
+} gw_log_record_t;
+
+/* A conversion of a format, such as %-8.*lld */
+typedef struct {
+	const char* start;			// the %
+	const char* length;			// the length modifier, or the conversion when there is none
+	const char* end;			// past the conversion character
+	uint8_t stars;				// arguments taken by * width and precision, before the converted one
+	bool star_precision;		// the last of these is the precision
+	int precision;				// literal precision, -1 when none
+} gw_log_spec_t;
+
+/* Next conversion of format, %% excluded. Returns false when there is none */
+bool gw_log_next_spec(const char* format, gw_log_spec_t* spec);
+
+/**
+ * Deferred log backend. A call costs a copy of its arguments into a record, pushed into a lock-free ring
+ * shared by all tasks: nothing is formatted nor written by the caller. A task of priority GW_LOG_TASK_PRIORITY
+ * drains the ring every GW_LOG_FLUSH_MS, formats the records as ESP_LOG does and writes them to the console
+ * through esp_log_write, which applies the log levels set at run time, or to a rotating file on SPIFFS.
+ * Strings are copied, up to the precision of their conversion, so they need not outlive the call.
+ * Records logged while the ring is full, and those of a tag beyond GW_LOG_TAG_RATE per second, are dropped
+ * and counted as WIOTP_CNT_LOG_DROPPED and WIOTP_CNT_LOG_LIMITED, which the log task also reports.
+ * Use through the GW_LOGx macros, which fall back to ESP_LOGx without GW_LOG_DEFERRED.
+ */
+class ESP32_Log {
+private:
+	static MPSC_Ring<gw_log_record_t, CONFIG_GW_LOG_RING_SIZE> ring;
+	static std::atomic<uint32_t> stat_limited;
+	static TaskHandle_t task;
+
+	/* Arguments of a record, paired with the conversions of its format */
+	class Packer {
+	private:
+		gw_log_record_t& record;
+		const char* next;		// rest of the format
+		int pending = 0;		// arguments left in the current conversion, * ones included
+		bool star_precision = false;
+		int precision = -1;
+
+		/* Start the next conversion if the current one has taken all its arguments */
+		void advance();
+		void add_int(int64_t v);
+		void add_double(double v);
+		void add_text(const char* s);
+
+		template<typename T> typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type put(T v) {
+			add_int((int64_t)v);
+		}
+		template<typename T> typename std::enable_if<std::is_floating_point<T>::value>::type put(T v) {
+			add_double(v);
+		}
+		template<typename T> void put(const T* p) {
+			add_int((int64_t)(intptr_t)p);
+		}
+		void put(const char* s) {
+			add_text(s);
+		}
+
+	public:
+		Packer(gw_log_record_t& record) : record(record), next(record.format) {}
+
+		void add() {}
+		template<typename T, typename... Others> void add(T v, Others... others) {
+			put(v);
+			add(others...);
+		}
+	};
+
+	/* Whether a record of tag is within the rate of its tag */
+	static bool admit(const char* tag, int64_t now_us);
+	static void _log_task(void* arg);
+
+public:
+	/* Create the log task, once SPIFFS is mounted when writing to a file */
+	static void start();
+
+	template<typename... Args> static void write(esp_log_level_t level, const char* tag, const char* format, Args... args) {
+		int64_t now_us=esp_timer_get_time();
+		if(level!=ESP_LOG_ERROR && !admit(tag,now_us)) {
+			return;
+		}
+		gw_log_record_t record;
+		record.ts_us=now_us;
+		record.tag=tag;
+		record.format=format;
+		record.level=level;
+		record.n_args=0;
+		record.text_len=0;
+		Packer(record).add(args...);
+		push(record);
+	}
+
+	static void push(const gw_log_record_t& record);
+
+	/* Render a record as ESP_LOG does, into line of len bytes. Returns the length of the line */
+	static size_t format(const gw_log_record_t& record, char* line, size_t len);
+
+	static uint32_t dropped() { return ring.overrun_count(); }
+	static uint32_t limited() { return stat_limited.load(std::memory_order_relaxed); }
+	static TaskHandle_t task_handle() { return task; }
+};
+
+#define GW_LOG_LEVEL_LOCAL(level, tag, format, ...) do {						\
+		if(LOG_LOCAL_LEVEL>=level) {											\
+			ESP32_Log::write(level,tag,format,##__VA_ARGS__);					\
+		}																		\
+	} while(0)
+
+#define GW_LOGE(tag, format, ...) GW_LOG_LEVEL_LOCAL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define GW_LOGW(tag, format, ...) GW_LOG_LEVEL_LOCAL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define GW_LOGI(tag, format, ...) GW_LOG_LEVEL_LOCAL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define GW_LOGD(tag, format, ...) GW_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define GW_LOGV(tag, format, ...) GW_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#else
+
+#define GW_LOGE ESP_LOGE
+#define GW_LOGW ESP_LOGW
+#define GW_LOGI ESP_LOGI
+#define GW_LOGD ESP_LOGD
+#define GW_LOGV ESP_LOGV
+
+#endif /* CONFIG_GW_LOG_DEFERRED */
+
+#endif /* MAIN_ESP32LOG_H_ */
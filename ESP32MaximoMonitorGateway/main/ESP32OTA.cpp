@@ -0,0 +1,415 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32OTA.cpp
+#
+# Streaming firmware update over chunked MQTT commands, with resume
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32OTA.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_app_format.h"
+#include "nvs.h"
+}
+
+static const char *LOG_TAG="OTA";
+
+static const char* OTA_NVS_NAMESPACE="ota";
+
+// Offset of the app description in the image, after the image header and the first segment header
+#define OTA_APP_DESC_OFFSET (sizeof(esp_image_header_t)+sizeof(esp_image_segment_header_t))
+
+/* Parse 64 hex digits into a SHA-256 digest */
+static bool parse_sha256(const char* hex, uint8_t* sha256) {
+	for(int i=0;i<64;i++) {
+		char c=hex[i];
+		int v=c>='0' && c<='9'?c-'0':c>='a' && c<='f'?c-'a'+10:c>='A' && c<='F'?c-'A'+10:-1;
+		if(v<0) {
+			return false;
+		}
+		sha256[i/2]=i%2==0?v<<4:sha256[i/2]|v;
+	}
+	return true;
+}
+
+/* Start of the value of "key": in a flat JSON object, NULL if absent */
+static const char* json_value(const char* json, const char* key) {
+	char quoted[16];
+	snprintf(quoted,sizeof(quoted),"\"%s\"",key);
+	const char* p=strstr(json,quoted);
+	if(p==NULL || (p=strchr(p+strlen(quoted),':'))==NULL) {
+		return NULL;
+	}
+	p++;
+	while(*p==' ') {
+		p++;
+	}
+	return p;
+}
+
+ESP32_OTA::ESP32_OTA(WIoTP_Publisher& publisher, const char* topic, uint32_t checkpoint_kb)
+: publisher(publisher), topic(topic),
+  checkpoint_bytes((checkpoint_kb*1024+GW_OTA_WRITE_CHUNK-1)/GW_OTA_WRITE_CHUNK*GW_OTA_WRITE_CHUNK) {
+	memset(&state,0,sizeof(state));
+	mbedtls_sha256_init(&sha);
+	gw_ota_checkpoint_t checkpoint;
+	if(load_checkpoint(&checkpoint)) {
+		ESP_LOGI(LOG_TAG,"Transfer of %u bytes can resume from %u",checkpoint.size,checkpoint.offset);
+	}
+}
+
+ESP32_OTA::~ESP32_OTA() {
+	if(active && !resumed && handle!=0) {
+		esp_ota_abort(handle);
+	}
+	mbedtls_sha256_free(&sha);
+}
+
+/* Free the digest, which holds the SHA accelerator while in use, and start another */
+void ESP32_OTA::reset_digest() {
+	mbedtls_sha256_free(&sha);
+	mbedtls_sha256_init(&sha);
+	mbedtls_sha256_starts_ret(&sha,0);
+}
+
+/* Digest of the first len bytes written to the partition, read back one sector at a time */
+bool ESP32_OTA::hash_partition(uint32_t len) {
+	reset_digest();
+	for(uint32_t off=0;off<len;off+=GW_OTA_WRITE_CHUNK) {
+		size_t n=len-off<GW_OTA_WRITE_CHUNK?len-off:GW_OTA_WRITE_CHUNK;
+		esp_err_t err=esp_partition_read(partition,off,chunk,n);
+		if(err!=ESP_OK) {
+			ESP_LOGE(LOG_TAG,"Failed to read %s at %u (%s)",partition->label,off,esp_err_to_name(err));
+			return false;
+		}
+		mbedtls_sha256_update_ret(&sha,chunk,n);
+	}
+	return true;
+}
+
+bool ESP32_OTA::load_checkpoint(gw_ota_checkpoint_t* checkpoint) {
+	nvs_handle_t nvs;
+	if(nvs_open(OTA_NVS_NAMESPACE,NVS_READONLY,&nvs)!=ESP_OK) {
+		return false;
+	}
+	size_t size=sizeof(*checkpoint);
+	bool ok=nvs_get_blob(nvs,"checkpoint",checkpoint,&size)==ESP_OK && size==sizeof(*checkpoint);
+	nvs_close(nvs);
+	return ok;
+}
+
+void ESP32_OTA::save_checkpoint() {
+	nvs_handle_t nvs;
+	esp_err_t err=nvs_open(OTA_NVS_NAMESPACE,NVS_READWRITE,&nvs);
+	if(err==ESP_OK) {
+		err=nvs_set_blob(nvs,"checkpoint",&state,sizeof(state));
+		if(err==ESP_OK) err=nvs_commit(nvs);
+		nvs_close(nvs);
+	}
+	if(err!=ESP_OK) {
+		ESP_LOGW(LOG_TAG,"Failed to save checkpoint at %u (%s)",state.offset,esp_err_to_name(err));
+	}
+}
+
+void ESP32_OTA::clear_checkpoint() {
+	nvs_handle_t nvs;
+	if(nvs_open(OTA_NVS_NAMESPACE,NVS_READWRITE,&nvs)==ESP_OK) {
+		if(nvs_erase_key(nvs,"checkpoint")==ESP_OK) {
+			nvs_commit(nvs);
+		}
+		nvs_close(nvs);
+	}
+}
+
+void ESP32_OTA::reply(const char* state_name, const char* reason) {
+	char payload[192];
+	int len=snprintf(payload,sizeof(payload),"{\"d\":{\"state\":\"%s\",\"offset\":%u,\"size\":%u",state_name,received,state.size);
+	if(reason!=NULL) {
+		len+=snprintf(payload+len,sizeof(payload)-len,",\"reason\":\"%s\"",reason);
+	} else if(strcmp(state_name,"done")==0) {
+		int64_t ms=(esp_timer_get_time()-start_us)/1000;
+		len+=snprintf(payload+len,sizeof(payload)-len,",\"ms\":%lld,\"bytes_per_s\":%lld,\"heap_peak\":%u",
+				(long long)ms,ms>0?(received-start_offset)*1000LL/ms:0LL,heap_start-heap_min);
+	}
+	len+=snprintf(payload+len,sizeof(payload)-len,"}}");
+	// Not waiting for a slot, as this runs in the MQTT client task
+	publisher.publish(topic,payload,len,1,WIOTP_PRIO_HIGH);
+}
+
+bool ESP32_OTA::begin(const wiotp_command_t& cmd, size_t total_len) {
+	control=cmd.format_len==4 && memcmp(cmd.format,"json",4)==0;
+	if(control) {
+		if(total_len>=sizeof(json)) {
+			reply("error","command too long");
+			return false;
+		}
+		json_len=0;
+		return true;
+	}
+	if(!active) {
+		reply("error","no transfer");
+		return false;
+	}
+	header_len=0;
+	skip=false;
+	return true;
+}
+
+void ESP32_OTA::data(const char* data, size_t len, size_t offset) {
+	if(control) {
+		memcpy(json+json_len,data,len);
+		json_len+=len;
+		return;
+	}
+
+	// Offset of the chunk, little endian, which may span fragments
+	const uint8_t* p=(const uint8_t*)data;
+	while(header_len<sizeof(header) && len>0) {
+		header[header_len++]=*p++;
+		len--;
+		if(header_len==sizeof(header)) {
+			uint32_t chunk_offset=header[0]|header[1]<<8|header[2]<<16|(uint32_t)header[3]<<24;
+			if(chunk_offset!=received) {
+				ESP_LOGW(LOG_TAG,"Chunk at %u ignored, expecting %u",chunk_offset,received);
+				skip=true;
+				reply("receiving");
+			}
+		}
+	}
+	if(!skip && len>0) {
+		consume(p,len);
+	}
+}
+
+void ESP32_OTA::end() {
+	if(control) {
+		json[json_len]='\0';
+		control_command();
+	} else if(active && !skip && received==state.size) {
+		finish();
+	}
+}
+
+void ESP32_OTA::control_command() {
+	if(json_value(json,"abort")!=NULL) {
+		if(active) {
+			stop(NULL);
+		}
+		reply("idle");
+		return;
+	}
+	const char* size=json_value(json,"size");
+	const char* hex=json_value(json,"sha256");
+	uint8_t sha256[32];
+	if(size==NULL || hex==NULL || *hex!='"' || strlen(hex)<65 || !parse_sha256(hex+1,sha256)) {
+		reply("error","invalid command");
+		return;
+	}
+	start(sha256,strtoul(size,NULL,10));
+}
+
+void ESP32_OTA::start(const uint8_t* sha256, uint32_t size) {
+	if(active && state.size==size && memcmp(state.sha256,sha256,sizeof(state.sha256))==0) {
+		// Same image, resume where the previous chunks stopped
+		ESP_LOGI(LOG_TAG,"Transfer of %u bytes resumes at %u",size,received);
+	} else {
+		if(active) {
+			stop(NULL);
+		}
+		partition=esp_ota_get_next_update_partition(NULL);
+		if(partition==NULL || size==0 || size>partition->size) {
+			reply("error","invalid size");
+			return;
+		}
+
+		gw_ota_checkpoint_t checkpoint;
+		if(load_checkpoint(&checkpoint) && checkpoint.size==size && memcmp(checkpoint.sha256,sha256,sizeof(checkpoint.sha256))==0
+				&& checkpoint.address==partition->address && checkpoint.offset<size) {
+			// Interrupted by a restart: the OTA handle is lost, the rest of the image is written to the partition
+			if(!hash_partition(checkpoint.offset)) {
+				clear_checkpoint();
+				reply("error","checkpoint unreadable");
+				return;
+			}
+			state=checkpoint;
+			resumed=true;
+			ESP_LOGI(LOG_TAG,"Transfer of %u bytes to %s resumes from checkpoint %u",size,partition->label,state.offset);
+		} else {
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+			// Sectors are erased as they are written, rather than all at once here
+			esp_err_t err=esp_ota_begin(partition,OTA_WITH_SEQUENTIAL_WRITES,&handle);
+#else
+			esp_err_t err=esp_ota_begin(partition,size,&handle);
+#endif
+			if(err!=ESP_OK) {
+				ESP_LOGE(LOG_TAG,"Failed to start OTA to %s (%s)",partition->label,esp_err_to_name(err));
+				reply("error",esp_err_to_name(err));
+				return;
+			}
+			clear_checkpoint();
+			memcpy(state.sha256,sha256,sizeof(state.sha256));
+			state.size=size;
+			state.offset=0;
+			state.address=partition->address;
+			reset_digest();
+			resumed=false;
+			ESP_LOGI(LOG_TAG,"Transfer of %u bytes to %s started",size,partition->label);
+		}
+		active=true;
+		received=state.offset;
+		chunk_len=0;
+	}
+
+	start_us=esp_timer_get_time();
+	start_offset=received;
+	heap_start=esp_get_free_heap_size();
+	heap_min=heap_start;
+	reply("receiving");
+}
+
+void ESP32_OTA::stop(const char* reason) {
+	if(reason!=NULL) {
+		ESP_LOGE(LOG_TAG,"Transfer failed at %u/%u: %s",received,state.size,reason);
+		reply("error",reason);
+	} else {
+		ESP_LOGW(LOG_TAG,"Transfer abandoned at %u/%u",received,state.size);
+	}
+	if(!resumed && handle!=0) {
+		esp_ota_abort(handle);
+	}
+	handle=0;
+	active=false;
+	skip=true;
+	mbedtls_sha256_free(&sha);
+	clear_checkpoint();
+}
+
+void ESP32_OTA::consume(const uint8_t* data, size_t len) {
+	if(received+len>state.size) {
+		stop("image larger than announced");
+		return;
+	}
+	while(len>0) {
+		// The digest only covers bytes in the buffer or written, so that it matches each checkpoint
+		size_t n=GW_OTA_WRITE_CHUNK-chunk_len;
+		if(n>len) {
+			n=len;
+		}
+		memcpy(chunk+chunk_len,data,n);
+		mbedtls_sha256_update_ret(&sha,data,n);
+		chunk_len+=n;
+		received+=n;
+		data+=n;
+		len-=n;
+		if(chunk_len==GW_OTA_WRITE_CHUNK && !write_chunk()) {
+			return;
+		}
+	}
+}
+
+bool ESP32_OTA::write_chunk() {
+	if(state.offset==0) {
+		// Reject images of other projects before anything is written
+		const esp_app_desc_t* desc=(const esp_app_desc_t*)(chunk+OTA_APP_DESC_OFFSET);
+		if(chunk_len<OTA_APP_DESC_OFFSET+sizeof(esp_app_desc_t) || chunk[0]!=ESP_IMAGE_HEADER_MAGIC
+				|| desc->magic_word!=ESP_APP_DESC_MAGIC_WORD) {
+			stop("not an app image");
+			return false;
+		}
+		const esp_app_desc_t* running=esp_ota_get_app_description();
+		if(strncmp(desc->project_name,running->project_name,sizeof(desc->project_name))!=0) {
+			stop("image of another project");
+			return false;
+		}
+		ESP_LOGI(LOG_TAG,"Receiving %.32s version %.32s",desc->project_name,desc->version);
+	}
+
+	esp_err_t err;
+	if(resumed) {
+		err=esp_partition_erase_range(partition,state.offset,GW_OTA_WRITE_CHUNK);
+		if(err==ESP_OK) {
+			err=esp_partition_write(partition,state.offset,chunk,chunk_len);
+		}
+	} else {
+		err=esp_ota_write(handle,chunk,chunk_len);
+	}
+	if(err!=ESP_OK) {
+		stop(esp_err_to_name(err));
+		return false;
+	}
+	state.offset+=chunk_len;
+	chunk_len=0;
+
+	uint32_t heap=esp_get_free_heap_size();
+	if(heap<heap_min) {
+		heap_min=heap;
+	}
+	if(state.offset%checkpoint_bytes==0) {
+		save_checkpoint();
+	}
+	return true;
+}
+
+void ESP32_OTA::finish() {
+	if(chunk_len>0 && !write_chunk()) {
+		return;
+	}
+	uint8_t sha256[32];
+	mbedtls_sha256_finish_ret(&sha,sha256);
+	mbedtls_sha256_free(&sha);
+	if(memcmp(sha256,state.sha256,sizeof(sha256))!=0) {
+		stop("digest mismatch");
+		return;
+	}
+
+	// Both check the image, set_boot_partition alone when the OTA handle was lost
+	esp_err_t err=ESP_OK;
+	if(!resumed) {
+		err=esp_ota_end(handle);
+		handle=0;
+	}
+	if(err==ESP_OK) {
+		err=esp_ota_set_boot_partition(partition);
+	}
+	if(err!=ESP_OK) {
+		stop(esp_err_to_name(err));
+		return;
+	}
+	active=false;
+	clear_checkpoint();
+
+	int64_t ms=(esp_timer_get_time()-start_us)/1000;
+	ESP_LOGI(LOG_TAG,"Image of %u bytes written to %s in %lld ms (%lld bytes/s), heap used %u bytes, restarting",
+			state.size,partition->label,ms,ms>0?(received-start_offset)*1000LL/ms:0LL,heap_start-heap_min);
+	reply("done");
+
+	// Leave time for the reply to be sent
+	esp_timer_create_args_t timer_args;
+	memset(&timer_args,0,sizeof(timer_args));
+	timer_args.callback=&_restart;
+	timer_args.name="ota_restart";
+	esp_timer_handle_t timer;
+	ESP_ERROR_CHECK(esp_timer_create(&timer_args,&timer));
+	ESP_ERROR_CHECK(esp_timer_start_once(timer,2000000));
+}
+
+void ESP32_OTA::_restart(void* arg) {
+	esp_restart();
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32OTA.h
+#
+# Streaming firmware update over chunked MQTT commands, with resume
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32OTA_H_
+#define MAIN_ESP32OTA_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "mbedtls/sha256.h"
+}
+
+#include "WIoTPCommands.h"
+#include "WIoTPPublisher.h"
+
+/* Size of each write to flash, one flash sector */
+#define GW_OTA_WRITE_CHUNK SPI_FLASH_SEC_SIZE
+
+/* Progress of a transfer, saved in NVS to resume it after a restart */
+typedef struct {
+	uint8_t sha256[32];			// expected digest of the image
+	uint32_t size;				// image size
+	uint32_t offset;			// bytes written to flash, a multiple of GW_OTA_WRITE_CHUNK
+	uint32_t address;			// target partition
+} gw_ota_checkpoint_t;
+
+/**
+ * Firmware update received as gateway commands, and written to the next OTA partition as it arrives:
+ *  cmd/ota/fmt/json {"size":<bytes>,"sha256":"<hex>"} starts a transfer, or resumes it
+ *  cmd/ota/fmt/bin  <offset, 4 bytes little endian><image bytes> carries the image from offset
+ *  cmd/ota/fmt/json {"abort":true} abandons the transfer
+ * Each command is answered by a evt/ota/fmt/json event, {"d":{"state":"receiving","offset":<bytes>}}
+ * telling the offset of the next expected chunk, then {"d":{"state":"done",..}} or {"d":{"state":"error",..}}.
+ *
+ * Chunks may be of any size: they are streamed fragment by fragment into a one sector buffer, written
+ * through esp_ota_write when full. The image header and app description are checked in the first sector,
+ * the SHA-256 digest is computed on the fly and checked at the end, before the image is selected for boot.
+ * A chunk which does not start at the expected offset is ignored, so a transfer interrupted by a
+ * disconnection resumes at the first byte not received. Every checkpoint_kb, progress is saved in NVS:
+ * after a restart, the same image resumes from the last checkpoint, written with esp_partition_write
+ * as the OTA handle was lost. The digest state is not saved, as with CONFIG_MBEDTLS_HARDWARE_SHA it is
+ * held by the SHA accelerator rather than by the context: the bytes before the checkpoint are read back
+ * from the partition and hashed again when the transfer resumes.
+ */
+class ESP32_OTA : public WIoTP_CommandHandler {
+private:
+	WIoTP_Publisher& publisher;
+	const char* topic;
+	const uint32_t checkpoint_bytes;
+
+	const esp_partition_t* partition = NULL;
+	esp_ota_handle_t handle = 0;
+	bool active = false;
+	bool resumed = false;		// written with esp_partition_write after a restart
+	gw_ota_checkpoint_t state;
+	mbedtls_sha256_context sha;	// digest of the bytes received
+	uint32_t received = 0;		// bytes received and hashed
+	uint8_t chunk[GW_OTA_WRITE_CHUNK];
+	size_t chunk_len = 0;
+
+	// Current command
+	bool control = false;		// JSON control command, else image chunk
+	char json[128];
+	size_t json_len = 0;
+	uint8_t header[4];			// offset of the chunk
+	size_t header_len = 0;
+	bool skip = false;			// rest of the chunk is ignored
+
+	// Transfer statistics, since the last start or resume
+	int64_t start_us = 0;
+	uint32_t start_offset = 0;
+	uint32_t heap_start = 0;
+	uint32_t heap_min = 0;
+
+	void start(const uint8_t* sha256, uint32_t size);
+	void stop(const char* reason);
+	void consume(const uint8_t* data, size_t len);
+	bool write_chunk();
+	bool hash_partition(uint32_t len);
+	void reset_digest();
+	void finish();
+	bool load_checkpoint(gw_ota_checkpoint_t* checkpoint);
+	void save_checkpoint();
+	void clear_checkpoint();
+	void reply(const char* state, const char* reason=NULL);
+	void control_command();
+
+	static void _restart(void* arg);
+
+public:
+	/* topic is the evt/ota topic of the gateway */
+	ESP32_OTA(WIoTP_Publisher& publisher, const char* topic, uint32_t checkpoint_kb=CONFIG_GW_OTA_CHECKPOINT_KB);
+	virtual ~ESP32_OTA();
+
+	virtual bool begin(const wiotp_command_t& cmd, size_t total_len);
+	virtual void data(const char* data, size_t len, size_t offset);
+	virtual void end();
+
+	bool in_progress() const { return active; }
+	uint32_t progress() const { return received; }
+};
+
+#endif /* MAIN_ESP32OTA_H_ */
@@ -0,0 +1,262 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Resolver.cpp
+#
+# Cache of host name resolutions, refreshed in the background and persisted in NVS
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32Resolver.h"
+#include "ESP32Wifi.h"
+#include "ESP32Tasks.h"
+
+extern "C" {
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+}
+
+static const char *LOG_TAG="RESOLVER";
+
+#define RESOLVER_NVS_KEY "hosts"
+// Time given to mDNS responders to answer
+#define RESOLVER_MDNS_TIMEOUT_MS 2000
+
+ESP32_Resolver::ESP32_Resolver(uint32_t ttl_s, uint32_t retry_s, const char* nvs_namespace)
+: ttl_us((int64_t)ttl_s*1000000), retry_us((int64_t)retry_s*1000000), nvs_namespace(nvs_namespace) {
+	lock=xSemaphoreCreateMutex();
+	if(lock==NULL) {
+		abort();
+	}
+}
+
+ESP32_Resolver::~ESP32_Resolver() {
+	if(instance_got_ip!=NULL) {
+		esp_event_handler_instance_unregister(IP_EVENT,IP_EVENT_STA_GOT_IP,instance_got_ip);
+	}
+	if(task!=NULL) {
+		vTaskDelete(task);
+	}
+	vSemaphoreDelete(lock);
+}
+
+void ESP32_Resolver::start(UBaseType_t priority, uint32_t stack_size, int core) {
+	load();
+	// Hosts which could not be resolved are tried again as soon as the network is back
+	ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,IP_EVENT_STA_GOT_IP,&_got_ip_handler,this,&instance_got_ip));
+	xTaskCreatePinnedToCore(&_resolve_task,"Resolver",stack_size,this,priority,&task,gw_task_core(core));
+}
+
+gw_resolver_entry_t* ESP32_Resolver::find(const char* host, bool create) {
+	for(size_t i=0;i<n_entries;i++) {
+		if(strcmp(entries[i].cached.host,host)==0) {
+			return &entries[i];
+		}
+	}
+	if(!create || n_entries>=CONFIG_GW_RESOLVER_MAX_HOSTS || strlen(host)>=GW_RESOLVER_MAX_HOST_LEN) {
+		return NULL;
+	}
+	gw_resolver_entry_t* entry=&entries[n_entries++];
+	memset(entry,0,sizeof(*entry));
+	strcpy(entry->cached.host,host);
+	return entry;
+}
+
+void ESP32_Resolver::load() {
+	nvs_handle_t handle;
+	if(nvs_open(nvs_namespace,NVS_READONLY,&handle)!=ESP_OK) {
+		return;
+	}
+	gw_resolver_cached_t cached[CONFIG_GW_RESOLVER_MAX_HOSTS];
+	size_t size=sizeof(cached);
+	if(nvs_get_blob(handle,RESOLVER_NVS_KEY,cached,&size)==ESP_OK) {
+		xSemaphoreTake(lock,portMAX_DELAY);
+		for(size_t i=0;i<size/sizeof(cached[0]);i++) {
+			cached[i].host[GW_RESOLVER_MAX_HOST_LEN-1]='\0';
+			gw_resolver_entry_t* entry=find(cached[i].host,true);
+			if(entry!=NULL && entry->cached.addr==0) {
+				// Known good until resolved again, which is due at once
+				entry->cached.addr=cached[i].addr;
+				esp_ip4_addr_t addr={ cached[i].addr };
+				ESP_LOGI(LOG_TAG,"%s was last at " IPSTR,cached[i].host,IP2STR(&addr));
+			}
+		}
+		xSemaphoreGive(lock);
+	}
+	nvs_close(handle);
+}
+
+void ESP32_Resolver::save() {
+	gw_resolver_cached_t cached[CONFIG_GW_RESOLVER_MAX_HOSTS];
+	size_t n=0;
+	xSemaphoreTake(lock,portMAX_DELAY);
+	for(size_t i=0;i<n_entries;i++) {
+		if(entries[i].cached.addr!=0) {
+			cached[n++]=entries[i].cached;
+		}
+	}
+	xSemaphoreGive(lock);
+
+	nvs_handle_t handle;
+	esp_err_t err=nvs_open(nvs_namespace,NVS_READWRITE,&handle);
+	if(err==ESP_OK) {
+		err=nvs_set_blob(handle,RESOLVER_NVS_KEY,cached,n*sizeof(cached[0]));
+		if(err==ESP_OK) err=nvs_commit(handle);
+		nvs_close(handle);
+	}
+	if(err!=ESP_OK) {
+		ESP_LOGW(LOG_TAG,"Failed to save addresses in NVS (%s)",esp_err_to_name(err));
+	}
+}
+
+bool ESP32_Resolver::lookup(const char* host, esp_ip4_addr_t* addr) {
+	struct in_addr numeric;
+	if(inet_aton(host,&numeric)) {
+		addr->addr=numeric.s_addr;
+		return true;
+	}
+
+	xSemaphoreTake(lock,portMAX_DELAY);
+	gw_resolver_entry_t* entry=find(host,true);
+	bool known=entry!=NULL && entry->cached.addr!=0;
+	if(known) {
+		addr->addr=entry->cached.addr;
+	}
+	bool due=entry!=NULL && esp_timer_get_time()>=entry->refresh_us;
+	xSemaphoreGive(lock);
+
+	if(due && task!=NULL) {
+		xTaskNotifyGive(task);
+	}
+	return known;
+}
+
+void ESP32_Resolver::refresh(const char* host) {
+	xSemaphoreTake(lock,portMAX_DELAY);
+	gw_resolver_entry_t* entry=find(host,false);
+	bool due=entry!=NULL && entry->refresh_us>0;
+	if(due) {
+		entry->refresh_us=0;
+	}
+	xSemaphoreGive(lock);
+
+	if(due && task!=NULL) {
+		xTaskNotifyGive(task);
+	}
+}
+
+void ESP32_Resolver::_got_ip_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+	ESP32_Resolver* that=(ESP32_Resolver*)arg;
+	that->got_ip=true;
+	xSemaphoreTake(that->lock,portMAX_DELAY);
+	for(size_t i=0;i<that->n_entries;i++) {
+		if(that->entries[i].failed) {
+			that->entries[i].refresh_us=0;
+		}
+	}
+	xSemaphoreGive(that->lock);
+	xTaskNotifyGive(that->task);
+}
+
+void ESP32_Resolver::_resolve_task(void* that) {
+	((ESP32_Resolver*)that)->resolve_task();
+}
+
+esp_err_t ESP32_Resolver::resolve(const char* host, uint32_t* addr) {
+	size_t len=strlen(host), local_len=strlen(IPADDR_LOCAL_DOMAIN);
+	if(len>local_len && strcmp(host+len-local_len,IPADDR_LOCAL_DOMAIN)==0) {
+		esp_ip4_addr_t mdns_addr;
+		esp_err_t err=ESP32_Wifi::query_mdns_host(host,&mdns_addr,RESOLVER_MDNS_TIMEOUT_MS);
+		if(err==ESP_OK) {
+			*addr=mdns_addr.addr;
+		}
+		return err;
+	}
+
+	struct addrinfo hints;
+	memset(&hints,0,sizeof(hints));
+	hints.ai_family=AF_INET;
+	hints.ai_socktype=SOCK_STREAM;
+	struct addrinfo* res=NULL;
+	int err=getaddrinfo(host,NULL,&hints,&res);
+	if(err!=0 || res==NULL) {
+		return ESP_ERR_NOT_FOUND;
+	}
+	*addr=((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+	freeaddrinfo(res);
+	return ESP_OK;
+}
+
+void ESP32_Resolver::resolve_task() {
+	char host[GW_RESOLVER_MAX_HOST_LEN];
+	while(true) {
+		// Earliest entry due for a resolution
+		int64_t now=esp_timer_get_time();
+		int64_t next_us=INT64_MAX;
+		bool due=false;
+		xSemaphoreTake(lock,portMAX_DELAY);
+		for(size_t i=0;got_ip && i<n_entries && !due;i++) {
+			if(entries[i].refresh_us<=now) {
+				strcpy(host,entries[i].cached.host);
+				due=true;
+			} else if(entries[i].refresh_us<next_us) {
+				next_us=entries[i].refresh_us;
+			}
+		}
+		xSemaphoreGive(lock);
+		if(!due) {
+			ulTaskNotifyTake(pdTRUE,next_us==INT64_MAX?portMAX_DELAY:pdMS_TO_TICKS((next_us-now)/1000)+1);
+			continue;
+		}
+
+		// Blocks this task only
+		uint32_t addr=0;
+		esp_err_t err=resolve(host,&addr);
+		int64_t end=esp_timer_get_time();
+
+		bool changed=false;
+		esp_ip4_addr_t known={ 0 };
+		xSemaphoreTake(lock,portMAX_DELAY);
+		gw_resolver_entry_t* entry=find(host,false);
+		entry->failed=err!=ESP_OK;
+		if(err==ESP_OK) {
+			changed=entry->cached.addr!=addr;
+			if(changed && entry->cached.addr!=0) {
+				stat_moved++;
+			}
+			entry->cached.addr=addr;
+			entry->refresh_us=end+ttl_us;
+			stat_resolved++;
+		} else {
+			entry->refresh_us=end+retry_us;
+			stat_failed++;
+		}
+		known.addr=entry->cached.addr;
+		xSemaphoreGive(lock);
+
+		if(err==ESP_OK) {
+			ESP_LOGI(LOG_TAG,"%s resolved to " IPSTR " in %lld ms%s",host,IP2STR(&known),(long long)(end-now)/1000,
+					changed?", address changed":"");
+			if(changed) {
+				save();
+			}
+		} else if(known.addr!=0) {
+			ESP_LOGW(LOG_TAG,"Failed to resolve %s (%s), keeping " IPSTR,host,esp_err_to_name(err),IP2STR(&known));
+		} else {
+			ESP_LOGW(LOG_TAG,"Failed to resolve %s (%s)",host,esp_err_to_name(err));
+		}
+	}
+}
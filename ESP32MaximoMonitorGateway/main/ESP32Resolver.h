@@ -0,0 +1,109 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Resolver.h
+#
+# Cache of host name resolutions, refreshed in the background and persisted in NVS
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32RESOLVER_H_
+#define MAIN_ESP32RESOLVER_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+}
+
+/* Longest host name cached */
+#define GW_RESOLVER_MAX_HOST_LEN 64
+
+/* Host and its last known good address, as persisted in NVS */
+typedef struct {
+	char host[GW_RESOLVER_MAX_HOST_LEN];
+	uint32_t addr;				// IPv4 address in network order, 0 if never resolved
+} gw_resolver_cached_t;
+
+typedef struct {
+	gw_resolver_cached_t cached;
+	int64_t refresh_us;			// time of the next resolution, 0 for at once
+	bool failed;				// the last attempt failed
+} gw_resolver_entry_t;
+
+/**
+ * Resolves host names in a background task, so that callers, such as reconnects, never block on DNS.
+ * lookup() answers from the cache: the last known good address, even once its TTL has elapsed or a
+ * refresh failed, and asks the task for a refresh when due. Names ending with .local are resolved by
+ * mDNS, others by DNS. Addresses are kept in NVS, so they are known from boot, before any resolution.
+ * Neither lwIP nor mDNS report record TTLs, addresses are kept ttl_s, and a failed resolution is
+ * retried every retry_s.
+ */
+class ESP32_Resolver {
+private:
+	const int64_t ttl_us;
+	const int64_t retry_us;
+	const char* nvs_namespace;
+	gw_resolver_entry_t entries[CONFIG_GW_RESOLVER_MAX_HOSTS];
+	size_t n_entries = 0;
+	SemaphoreHandle_t lock = NULL;
+	TaskHandle_t task = NULL;
+	esp_event_handler_instance_t instance_got_ip = NULL;
+	volatile bool got_ip = false;		// resolutions wait for the first address of the station
+
+	// Statistics since start, under the lock
+	uint32_t stat_resolved = 0;
+	uint32_t stat_failed = 0;
+	uint32_t stat_moved = 0;
+
+	static void _resolve_task(void* that);
+	static void _got_ip_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+
+	/* Entry of host, added if create, NULL if not found or the cache is full. Under the lock */
+	gw_resolver_entry_t* find(const char* host, bool create);
+	void load();
+	void save();
+
+protected:
+	virtual void resolve_task();
+	/* Resolve host by mDNS or DNS, blocking, from the resolver task */
+	virtual esp_err_t resolve(const char* host, uint32_t* addr);
+
+public:
+	ESP32_Resolver(uint32_t ttl_s=CONFIG_GW_RESOLVER_TTL_S, uint32_t retry_s=CONFIG_GW_RESOLVER_RETRY_S, const char* nvs_namespace="gw_dns");
+	virtual ~ESP32_Resolver();
+
+	/* Load the cache from NVS, which must be initialised, and create the resolver task, pinned to core unless -1 */
+	void start(UBaseType_t priority=CONFIG_GW_RESOLVER_TASK_PRIORITY, uint32_t stack_size=CONFIG_GW_RESOLVER_TASK_STACK,
+			int core=CONFIG_GW_NET_TASK_CORE);
+
+	/**
+	 * Address of host from the cache, without blocking. Returns false if it was never resolved.
+	 * A host not in the cache is added, and the resolver task woken when it is due for a resolution.
+	 * Numeric addresses are returned as they are
+	 */
+	bool lookup(const char* host, esp_ip4_addr_t* addr);
+
+	/* Resolve host again in the background, such as when its address cannot be reached. Callers limit the rate,
+	 * as MQTT reconnects do */
+	void refresh(const char* host);
+
+	uint32_t resolved() const { return stat_resolved; }
+	uint32_t failed() const { return stat_failed; }
+	uint32_t moved() const { return stat_moved; }
+	TaskHandle_t task_handle() const { return task; }
+};
+
+#endif /* MAIN_ESP32RESOLVER_H_ */
@@ -16,6 +16,7 @@
 # Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
 # *****************************************************************************/
 #include "ESP32SPIFFS.h"
+#include "WIoTPBudget.h"
 
 extern "C" {
 #include <stdio.h>
@@ -73,16 +74,16 @@ ESP32_SPIFFS::~ESP32_SPIFFS() {
 char* ESP32_SPIFFS::read_string(const char* filename, size_t max_len) {
 	struct stat filestat;
 
-	if(stat (filename,&filestat)<0) {
+	if(stat (filename,&filestat)<0 || filestat.st_size<0) {
 		return NULL;
 	}
 
-	if(filestat.st_size>max_len) filestat.st_size=max_len;
-	char* filebuf=(char*)malloc(filestat.st_size+1);
+	if((size_t)filestat.st_size>max_len) filestat.st_size=max_len;
+	char* filebuf=(char*)WIoTP_Budget::alloc(WIOTP_MEM_CONFIG,filestat.st_size+1);
 
 	if(!read_string(filename, filebuf, filestat.st_size+1)) {
-		// free the buffer and return NULL
-		free(filebuf);
+		// give the buffer back and return NULL
+		WIoTP_Budget::release(WIOTP_MEM_CONFIG,filebuf,filestat.st_size+1);
 		filebuf=NULL;
 	}
 
@@ -36,7 +36,8 @@ public:
 	/* Read a string from file, at most buflen-1 chars, always zero-terminated */
 	static bool read_string(const char* filename, char* buf, size_t buflen);
 
-	/* Read heap-mallocate and read a string from file. A buffer of appropriate siez is malloced, up to max_len+1 size */
+	/* Read a string from file into a buffer of the WIOTP_MEM_CONFIG region, up to max_len+1 size.
+	 * The buffer is not to be freed and lives as long as the gateway, so this is meant for boot-time strings */
 	static char* read_string(const char* filename, size_t max_len=256);
 };
 
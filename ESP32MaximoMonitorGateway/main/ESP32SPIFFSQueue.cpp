@@ -0,0 +1,346 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32SPIFFSQueue.cpp
+#
+# Persistent store-and-forward queue on SPIFFS
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32SPIFFSQueue.h"
+#include "WIoTPMetrics.h"
+#include "WIoTPBudget.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+static const char *LOG_TAG="QUEUE";
+
+#define QUEUE_RECORD_MAGIC 0x5157
+
+/* On-flash record header, followed by topic_len bytes of topic and payload_len bytes of payload */
+typedef struct {
+	uint16_t magic;
+	uint16_t topic_len;
+	uint16_t payload_len;
+	uint16_t check;
+} queue_record_hdr_t;
+
+/* Persisted read position */
+typedef struct {
+	uint32_t seg;
+	uint32_t offset;
+} queue_cursor_t;
+
+/* Fletcher-16 over a buffer, continuing from a previous value */
+static uint16_t fletcher16(uint16_t check, const char* buf, size_t len) {
+	uint32_t s1=check&0xff, s2=check>>8;
+	for(size_t i=0;i<len;i++) {
+		s1=(s1+(uint8_t)buf[i])%255;
+		s2=(s2+s1)%255;
+	}
+	return (uint16_t)((s2<<8)|s1);
+}
+
+ESP32_SPIFFS_Queue::ESP32_SPIFFS_Queue(const char* dir, size_t segment_size, uint32_t max_segments,
+		uint32_t sync_records, uint32_t sync_ms, size_t max_record, uint32_t drain_rate, uint32_t drain_burst,
+		uint32_t cursor_records)
+: dir(dir), segment_size(segment_size), max_segments(max_segments), sync_records(sync_records),
+  sync_us((int64_t)sync_ms*1000), max_record(max_record), cursor_records(cursor_records), head_seg(0), tail_seg(0), read_offset(0), write_offset(0),
+  drain_bucket(drain_rate,drain_burst) {
+	// Room for the zero terminators of both topic and payload
+	record=(char*)WIoTP_Budget::alloc(WIOTP_MEM_BUFFERS,max_record+2);
+
+	// Find the oldest and newest segments left by a previous run
+	DIR* d=opendir(dir);
+	if(d!=NULL) {
+		struct dirent* entry;
+		while((entry=readdir(d))!=NULL) {
+			if(!isdigit((unsigned char)entry->d_name[0])) continue;
+			uint32_t seg=strtoul(entry->d_name,NULL,10);
+			if(head_seg==0 || seg<head_seg) head_seg=seg;
+			if(seg>tail_seg) tail_seg=seg;
+		}
+		closedir(d);
+	}
+
+	if(head_seg==0) {
+		head_seg=1;
+		tail_seg=1;
+	} else {
+		load_cursor();
+		// Never append after a possibly torn record, always start a fresh segment
+		tail_seg++;
+	}
+	open_writer();
+
+	while(segments()>max_segments) {
+		remove_head();
+		stat_dropped_segments++;
+	}
+	last_sync_us=esp_timer_get_time();
+
+	ESP_LOGI(LOG_TAG,"Queue %s holds segments %u..%u, read offset %u",dir,head_seg,tail_seg,read_offset);
+}
+
+ESP32_SPIFFS_Queue::~ESP32_SPIFFS_Queue() {
+	sync();
+	if(unsaved>0) {
+		save_cursor();
+	}
+	if(writer!=NULL) fclose(writer);
+	if(reader!=NULL) fclose(reader);
+	WIoTP_Budget::release(WIOTP_MEM_BUFFERS,record,max_record+2);
+}
+
+void ESP32_SPIFFS_Queue::segment_path(uint32_t seg, char* path, size_t pathlen) {
+	snprintf(path,pathlen,"%s/%08u",dir,seg);
+}
+
+bool ESP32_SPIFFS_Queue::open_writer() {
+	char path[64];
+	segment_path(tail_seg,path,sizeof(path));
+	writer=fopen(path,"a");
+	write_offset=0;
+	if(writer==NULL) {
+		ESP_LOGE(LOG_TAG,"Failed to open %s",path);
+		return false;
+	}
+	return true;
+}
+
+bool ESP32_SPIFFS_Queue::open_reader() {
+	char path[64];
+	segment_path(head_seg,path,sizeof(path));
+	reader=fopen(path,"r");
+	return reader!=NULL;
+}
+
+/* Delete the oldest segment, which must not be the one being written */
+void ESP32_SPIFFS_Queue::remove_head() {
+	if(reader!=NULL) {
+		fclose(reader);
+		reader=NULL;
+	}
+	char path[64];
+	segment_path(head_seg,path,sizeof(path));
+	remove(path);
+	head_seg++;
+	read_offset=0;
+	peeked=0;
+	// A cursor left on a removed segment is ignored
+	unsaved=0;
+}
+
+void ESP32_SPIFFS_Queue::load_cursor() {
+	char path[64];
+	snprintf(path,sizeof(path),"%s/cursor",dir);
+	FILE* f=fopen(path,"r");
+	if(f==NULL) {
+		return;
+	}
+	queue_cursor_t cursor;
+	if(fread(&cursor,sizeof(cursor),1,f)==1) {
+		// Segments before the cursor were fully read but not yet removed
+		while(head_seg<cursor.seg && head_seg<tail_seg) {
+			remove_head();
+		}
+		if(head_seg==cursor.seg) {
+			read_offset=cursor.offset;
+		}
+	}
+	fclose(f);
+}
+
+void ESP32_SPIFFS_Queue::save_cursor() {
+	char path[64];
+	snprintf(path,sizeof(path),"%s/cursor",dir);
+	FILE* f=fopen(path,"w");
+	if(f==NULL) {
+		ESP_LOGE(LOG_TAG,"Failed to open %s",path);
+		return;
+	}
+	queue_cursor_t cursor={ head_seg, (uint32_t)read_offset };
+	fwrite(&cursor,sizeof(cursor),1,f);
+	fclose(f);
+	unsaved=0;
+	stat_cursor_writes++;
+}
+
+bool ESP32_SPIFFS_Queue::push(const char* topic, const char* payload, size_t len) {
+	size_t topic_len=strlen(topic);
+	if(topic_len+len>max_record) {
+		ESP_LOGE(LOG_TAG,"Record of %d bytes exceeds queue record size %d",topic_len+len,max_record);
+		return false;
+	}
+	size_t size=sizeof(queue_record_hdr_t)+topic_len+len;
+
+	// Roll over to a new segment, dropping the oldest one when over budget
+	if(writer==NULL || (write_offset>0 && write_offset+size>segment_size)) {
+		sync();
+		if(writer!=NULL) fclose(writer);
+		tail_seg++;
+		while(segments()>max_segments) {
+			ESP_LOGW(LOG_TAG,"Queue full, dropping segment %u",head_seg);
+			remove_head();
+			stat_dropped_segments++;
+		}
+		if(!open_writer()) {
+			return false;
+		}
+	}
+
+	queue_record_hdr_t hdr;
+	hdr.magic=QUEUE_RECORD_MAGIC;
+	hdr.topic_len=topic_len;
+	hdr.payload_len=len;
+	hdr.check=fletcher16(fletcher16(0,topic,topic_len),payload,len);
+
+	if(fwrite(&hdr,sizeof(hdr),1,writer)!=1
+			|| fwrite(topic,1,topic_len,writer)!=topic_len
+			|| fwrite(payload,1,len,writer)!=len) {
+		ESP_LOGE(LOG_TAG,"Failed to append to segment %u",tail_seg);
+		return false;
+	}
+	write_offset+=size;
+	stat_pushed++;
+
+	if(++unsynced>=sync_records || esp_timer_get_time()-last_sync_us>=sync_us) {
+		sync();
+	}
+	return true;
+}
+
+void ESP32_SPIFFS_Queue::sync() {
+	if(writer!=NULL && unsynced>0) {
+		fflush(writer);
+		fsync(fileno(writer));
+		unsynced=0;
+	}
+	last_sync_us=esp_timer_get_time();
+}
+
+bool ESP32_SPIFFS_Queue::empty() {
+	return head_seg==tail_seg && read_offset>=write_offset;
+}
+
+bool ESP32_SPIFFS_Queue::peek(const char** topic, const char** payload, size_t* len) {
+	while(peeked==0) {
+		if(empty()) {
+			return false;
+		}
+		if(head_seg==tail_seg && unsynced>0) {
+			// Make buffered records of the current segment visible to the reader
+			fflush(writer);
+		}
+		if(reader==NULL && !open_reader()) {
+			if(head_seg==tail_seg) return false;
+			remove_head();
+			continue;
+		}
+		// Also drops stale buffered data and any end-of-file condition
+		fseek(reader,read_offset,SEEK_SET);
+
+		queue_record_hdr_t hdr;
+		if(fread(&hdr,sizeof(hdr),1,reader)!=1) {
+			// End of a completed segment
+			if(head_seg==tail_seg) return false;
+			remove_head();
+			continue;
+		}
+		bool valid=hdr.magic==QUEUE_RECORD_MAGIC && (size_t)hdr.topic_len+hdr.payload_len<=max_record
+				&& fread(record,1,hdr.topic_len,reader)==hdr.topic_len
+				&& fread(record+hdr.topic_len+1,1,hdr.payload_len,reader)==hdr.payload_len;
+		if(valid) {
+			valid=hdr.check==fletcher16(fletcher16(0,record,hdr.topic_len),record+hdr.topic_len+1,hdr.payload_len);
+		}
+		if(!valid) {
+			// Torn or corrupted record, skip the rest of its segment
+			ESP_LOGW(LOG_TAG,"Corrupted record in segment %u at %u",head_seg,read_offset);
+			stat_corrupt++;
+			if(head_seg==tail_seg) {
+				fclose(reader);
+				reader=NULL;
+				read_offset=write_offset;
+				return false;
+			}
+			remove_head();
+			continue;
+		}
+
+		record[hdr.topic_len]='\0';
+		record[hdr.topic_len+1+hdr.payload_len]='\0';
+		peeked_topic_len=hdr.topic_len;
+		peeked_len=hdr.payload_len;
+		peeked=sizeof(hdr)+hdr.topic_len+hdr.payload_len;
+	}
+
+	*topic=record;
+	*payload=record+peeked_topic_len+1;
+	*len=peeked_len;
+	return true;
+}
+
+void ESP32_SPIFFS_Queue::pop() {
+	if(peeked>0) {
+		read_offset+=peeked;
+		peeked=0;
+		stat_drained++;
+		// Rewriting the cursor costs a SPIFFS block write, so only every cursor_records records
+		if(++unsaved>=cursor_records || empty()) {
+			save_cursor();
+		}
+	}
+}
+
+size_t ESP32_SPIFFS_Queue::drain(WIoTP_Publisher& publisher) {
+	int64_t now=esp_timer_get_time();
+
+	drain_bucket.refill(now);
+
+	size_t n=0;
+	const char* topic;
+	const char* payload;
+	size_t len;
+	while(drain_bucket.available()>0 && peek(&topic,&payload,&len)) {
+		// Publish at QOS 1, no retain, leaving most of the window to live data
+		if(publisher.publish(topic,payload,len,1,WIOTP_PRIO_LOW)<0) {
+			break;
+		}
+		pop();
+		drain_bucket.take();
+		n++;
+		WIoTP_Metrics::count(WIOTP_CNT_REPLAYED);
+	}
+
+	if(n>0) {
+		if(replay_records==0) {
+			replay_start_us=now;
+		}
+		replay_records+=n;
+	}
+
+	if(replay_records>0 && empty()) {
+		int64_t elapsed_ms=(esp_timer_get_time()-replay_start_us)/1000;
+		ESP_LOGI(LOG_TAG,"Replayed %u records in %lld ms (%lld records/s)",
+				replay_records,elapsed_ms,elapsed_ms>0?replay_records*1000LL/elapsed_ms:(long long)replay_records);
+		replay_records=0;
+	}
+	return n;
+}
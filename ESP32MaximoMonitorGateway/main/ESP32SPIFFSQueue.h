@@ -0,0 +1,122 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32SPIFFSQueue.h
+#
+# Persistent store-and-forward queue on SPIFFS
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32SPIFFSQUEUE_H_
+#define MAIN_ESP32SPIFFSQUEUE_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "mqtt_client.h"
+}
+
+#include "WIoTPPublisher.h"
+#include "WIoTPTokenBucket.h"
+
+/**
+ * Append-only segmented log of outbound MQTT messages, kept on the mounted SPIFFS partition.
+ * Usage:
+ *   push() messages which could not be published
+ *   drain() the queue to the publisher once connected again
+ *
+ * Each segment is a file <dir>/<seq> holding records [header][topic][payload].
+ * Writes are fsync'ed every sync_records records or sync_ms milliseconds.
+ * When more than max_segments segments are held, the oldest one is dropped.
+ * The read position is persisted to <dir>/cursor every cursor_records records and once empty, so delivery is
+ * at-least-once across reboots, with at most cursor_records-1 records delivered again. Completed segments are
+ * removed, which needs no cursor write.
+ */
+class ESP32_SPIFFS_Queue {
+private:
+	const char* dir;
+	const size_t segment_size;
+	const uint32_t max_segments;
+	const uint32_t sync_records;
+	const int64_t sync_us;
+	const size_t max_record;
+	const uint32_t cursor_records;
+
+	uint32_t head_seg;			// oldest segment, being read
+	uint32_t tail_seg;			// newest segment, being written
+	size_t read_offset;
+	size_t write_offset;
+	FILE* reader = NULL;
+	FILE* writer = NULL;
+	uint32_t unsynced = 0;
+	uint32_t unsaved = 0;		// records popped since the cursor was written
+	int64_t last_sync_us = 0;
+	char* record;				// single record buffer for peek()
+	size_t peeked = 0;			// size of the record held in record, 0 if none
+	size_t peeked_topic_len;
+	size_t peeked_len;
+
+	// Drain rate limiting, drain_rate records/s
+	WIoTP_TokenBucket drain_bucket;
+	int64_t replay_start_us = 0;
+	uint32_t replay_records = 0;
+
+	// Statistics since creation
+	uint32_t stat_pushed = 0;
+	uint32_t stat_drained = 0;
+	uint32_t stat_dropped_segments = 0;
+	uint32_t stat_corrupt = 0;
+	uint32_t stat_cursor_writes = 0;
+
+	void segment_path(uint32_t seg, char* path, size_t pathlen);
+	bool open_writer();
+	bool open_reader();
+	void remove_head();
+	void save_cursor();
+	void load_cursor();
+
+public:
+	ESP32_SPIFFS_Queue(const char* dir="/queue",
+			size_t segment_size=CONFIG_GW_QUEUE_SEGMENT_SIZE, uint32_t max_segments=CONFIG_GW_QUEUE_MAX_SEGMENTS,
+			uint32_t sync_records=CONFIG_GW_QUEUE_SYNC_RECORDS, uint32_t sync_ms=CONFIG_GW_QUEUE_SYNC_MS,
+			size_t max_record=CONFIG_GW_QUEUE_MAX_RECORD,
+			uint32_t drain_rate=CONFIG_GW_QUEUE_DRAIN_RATE, uint32_t drain_burst=CONFIG_GW_QUEUE_DRAIN_BURST,
+			uint32_t cursor_records=CONFIG_GW_QUEUE_CURSOR_RECORDS);
+	virtual ~ESP32_SPIFFS_Queue();
+
+	/* Append a message to the queue */
+	bool push(const char* topic, const char* payload, size_t len);
+
+	/* Access the oldest message without removing it. Pointers are valid until the next call */
+	bool peek(const char** topic, const char** payload, size_t* len);
+
+	/* Remove the oldest message, persisting the read position every cursor_records messages */
+	void pop();
+
+	/* Flush and fsync pending writes */
+	void sync();
+
+	/* Publish queued messages at QoS 1 and low priority, at most drain_burst per call and drain_rate per second,
+	 * stopping when the in-flight window is full. Returns the number of messages published */
+	size_t drain(WIoTP_Publisher& publisher);
+
+	bool empty();
+
+	uint32_t segments() const { return tail_seg-head_seg+1; }
+	uint32_t pushed() const { return stat_pushed; }
+	uint32_t drained() const { return stat_drained; }
+	uint32_t dropped_segments() const { return stat_dropped_segments; }
+	uint32_t corrupt() const { return stat_corrupt; }
+	uint32_t cursor_writes() const { return stat_cursor_writes; }
+};
+
+#endif /* MAIN_ESP32SPIFFSQUEUE_H_ */
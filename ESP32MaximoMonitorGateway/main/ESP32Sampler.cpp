@@ -0,0 +1,116 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Sampler.cpp
+#
+# Timer-paced sampling task reading the sensor drivers into a lock-free ring
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32Sampler.h"
+#include "ESP32Tasks.h"
+#include "WIoTPMetrics.h"
+
+extern "C" {
+#include "esp_log.h"
+}
+
+static const char *LOG_TAG="SAMPLER";
+
+ESP32_Sampler::ESP32_Sampler(uint32_t rate_hz) : rate_hz(rate_hz), requested_hz(0) {
+}
+
+ESP32_Sampler::~ESP32_Sampler() {
+	if(timer!=NULL) {
+		esp_timer_stop(timer);
+		esp_timer_delete(timer);
+	}
+	if(task!=NULL) {
+		vTaskDelete(task);
+	}
+}
+
+void ESP32_Sampler::start(UBaseType_t priority, uint32_t stack_size, int core) {
+	xTaskCreatePinnedToCore(&_sample_task, "Sampler", stack_size, this, priority, &task, gw_task_core(core));
+
+	esp_timer_create_args_t timer_args;
+	timer_args.callback=&_sample_timer;
+	timer_args.arg=this;
+	timer_args.dispatch_method=ESP_TIMER_TASK;
+	timer_args.name="sampler";
+	timer_args.skip_unhandled_events=false;
+	ESP_ERROR_CHECK(esp_timer_create(&timer_args,&timer));
+	ESP_ERROR_CHECK(esp_timer_start_periodic(timer,1000000/rate_hz));
+
+	ESP_LOGI(LOG_TAG,"Sampling at %u Hz into a ring of %d readings, on core %d",rate(),ring.capacity(),core);
+}
+
+bool ESP32_Sampler::set_rate(uint32_t rate_hz) {
+	if(rate_hz<GW_SAMPLE_RATE_MIN_HZ || rate_hz>GW_SAMPLE_RATE_MAX_HZ) {
+		return false;
+	}
+	if(task==NULL) {
+		this->rate_hz=rate_hz;
+		return true;
+	}
+	// The latest rate wins when several are posted before the task wakes up
+	requested_hz.store(rate_hz);
+	xTaskNotifyGive(task);
+	return true;
+}
+
+/* Runs in the sampling task */
+void ESP32_Sampler::apply_rate(uint32_t rate_hz) {
+	this->rate_hz=rate_hz;
+	last_us=0;
+	if(timer!=NULL) {
+		// Restart the timer, so the next sample is due one new period from now
+		esp_timer_stop(timer);
+		if(esp_timer_start_periodic(timer,1000000/rate_hz)!=ESP_OK) {
+			ESP_LOGE(LOG_TAG,"Failed to restart the sampling timer");
+			abort();
+		}
+	}
+	ESP_LOGI(LOG_TAG,"Sampling at %u Hz",rate_hz);
+}
+
+/* Timer call-back, runs in the esp_timer task: only wake the sampling task */
+void ESP32_Sampler::_sample_timer(void* that) {
+	xTaskNotifyGive(((ESP32_Sampler*)that)->task);
+}
+
+void ESP32_Sampler::_sample_task(void* that) {
+	((ESP32_Sampler*)that)->sample_task();
+}
+
+uint32_t ESP32_Sampler::wait_period() {
+	// One notification per timer period, more than one if the task was held up
+	uint32_t periods=ulTaskNotifyTake(pdTRUE,portMAX_DELAY);
+	uint32_t requested=requested_hz.exchange(0);
+	if(requested!=0) {
+		// The periods counted so far were those of the previous rate
+		apply_rate(requested);
+		return 0;
+	}
+	if(periods>1) {
+		missed+=periods-1;
+	}
+	return periods;
+}
+
+void ESP32_Sampler::record_jitter(uint32_t periods, int64_t ts_us) {
+	// Intervals spanning missed periods are not counted, they are reported as missed
+	if(periods==1 && last_us!=0) {
+		int64_t jitter=ts_us-last_us-1000000/rate();
+		WIoTP_Metrics::record(WIOTP_STAGE_JITTER,jitter<0?-jitter:jitter);
+	}
+	last_us=ts_us;
+}
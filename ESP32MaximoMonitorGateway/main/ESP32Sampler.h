@@ -0,0 +1,156 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Sampler.h
+#
+# Timer-paced sampling task reading the sensor drivers into a lock-free ring
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32SAMPLER_H_
+#define MAIN_ESP32SAMPLER_H_
+
+extern "C" {
+#include <stdint.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+}
+
+#include <atomic>
+
+#include "SPSCRing.h"
+#include "ESP32Sensors.h"
+
+/* One timestamped reading of a channel */
+typedef struct {
+	int64_t ts_us;
+	int32_t value;
+	uint16_t channel;
+} gw_sample_t;
+
+/* Readings handed to the ring at once */
+#define GW_SAMPLE_BATCH 32
+
+/* Range of the sampling rate, that of GW_SAMPLE_RATE_HZ */
+#define GW_SAMPLE_RATE_MIN_HZ 1
+#define GW_SAMPLE_RATE_MAX_HZ 2000
+
+/**
+ * Producer stage of the acquisition pipeline.
+ * A periodic esp_timer wakes a dedicated task at rate_hz, which reads the sensors and pushes the
+ * timestamped readings into a SPSC ring. The consumer drains the ring at its own pace, so a stalled
+ * publish does not delay sampling: it only fills the ring, and overruns are counted.
+ * The deviation of each sampling interval from the period is recorded as the WIOTP_STAGE_JITTER stage.
+ * A change of rate is posted to the sampling task, which alone reconfigures the timer and the drivers.
+ * The sampling loop itself is that of ESP32_SensorSampler.
+ */
+class ESP32_Sampler {
+private:
+	std::atomic<uint32_t> rate_hz;
+	std::atomic<uint32_t> requested_hz;	// rate posted by set_rate(), 0 if none
+	esp_timer_handle_t timer = NULL;
+	TaskHandle_t task = NULL;
+	uint32_t missed = 0;		// timer periods elapsed without a sample
+	int64_t last_us = 0;		// time of the previous sample, 0 after a change of rate
+
+	static void _sample_timer(void* that);
+	static void _sample_task(void* that);
+	void apply_rate(uint32_t rate_hz);
+
+protected:
+	/* Wait for the next timer period, returns the number of periods elapsed, more than one when some were missed,
+	 * or 0 when woken by a change of rate, which was applied to the timer and must be applied to the drivers */
+	uint32_t wait_period();
+	/* Record the jitter of the sampling interval ending at ts_us, spanning periods */
+	void record_jitter(uint32_t periods, int64_t ts_us);
+	virtual void sample_task()=0;
+
+public:
+	SPSC_Ring<gw_sample_t, CONFIG_GW_SAMPLE_RING_SIZE> ring;
+
+	ESP32_Sampler(uint32_t rate_hz=CONFIG_GW_SAMPLE_RATE_HZ);
+	virtual ~ESP32_Sampler();
+
+	/* Create the sampling task, pinned to core unless -1, and start the timer */
+	void start(UBaseType_t priority=CONFIG_GW_SAMPLE_TASK_PRIORITY, uint32_t stack_size=CONFIG_GW_SAMPLE_TASK_STACK,
+			int core=CONFIG_GW_SAMPLE_TASK_CORE);
+
+	/* Post a new sampling rate to the sampling task, which applies it at once. Returns false if out of range */
+	bool set_rate(uint32_t rate_hz);
+
+	uint32_t rate() const { return rate_hz; }
+	uint32_t missed_count() const { return missed; }
+	TaskHandle_t task_handle() const { return task; }
+};
+
+/**
+ * Sampler of the drivers of Sensors, an ESP32_Sensors registry: at each period, the readings of all drivers
+ * are gathered into batches of GW_SAMPLE_BATCH, each pushed into the ring at once.
+ * Driver calls are resolved at compile time.
+ */
+template<class Sensors> class ESP32_SensorSampler : public ESP32_Sampler {
+private:
+	Sensors sensors;
+	gw_sample_t batch[GW_SAMPLE_BATCH];
+	size_t n_batch = 0;
+
+	/* Ring side of the drivers */
+	class Sink {
+	private:
+		ESP32_SensorSampler& sampler;
+	public:
+		Sink(ESP32_SensorSampler& sampler) : sampler(sampler) {}
+		void operator()(uint16_t channel, int64_t ts_us, int32_t value) {
+			gw_sample_t& sample=sampler.batch[sampler.n_batch];
+			sample.ts_us=ts_us;
+			sample.value=value;
+			sample.channel=channel;
+			if(++sampler.n_batch==GW_SAMPLE_BATCH) {
+				sampler.flush();
+			}
+		}
+	};
+
+	void flush() {
+		ring.push_bulk(batch,n_batch);
+		n_batch=0;
+	}
+
+protected:
+	virtual void sample_task() {
+		// Drivers log their own failure
+		if(!sensors.begin(rate())) {
+			abort();
+		}
+		Sink sink(*this);
+		while(true) {
+			uint32_t periods=wait_period();
+			if(periods==0) {
+				sensors.set_rate(rate());
+				continue;
+			}
+			int64_t now_us=esp_timer_get_time();
+			sensors.read(sink,now_us);
+			flush();
+			record_jitter(periods,now_us);
+		}
+	}
+
+public:
+	static constexpr size_t channels=Sensors::channels;
+	static const char* channel_name(size_t channel) { return Sensors::channel_name(channel); }
+
+	ESP32_SensorSampler(uint32_t rate_hz=CONFIG_GW_SAMPLE_RATE_HZ) : ESP32_Sampler(rate_hz) {}
+};
+
+#endif /* MAIN_ESP32SAMPLER_H_ */
@@ -0,0 +1,133 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Sensors.h
+#
+# Sensor drivers and their compile-time registry
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32SENSORS_H_
+#define MAIN_ESP32SENSORS_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+
+extern uint8_t temprature_sens_read();
+}
+
+#include <type_traits>
+
+/**
+ * A sensor driver provides one or more channels, read by the sampling task at each timer period:
+ *	typedef <integer type> sample_type;					type of its readings, at most 32 bits
+ *	static constexpr size_t channels;					number of channels
+ *	static const char* channel_name(size_t channel);	field under which a channel is published
+ *	bool begin(uint32_t rate_hz);						set up the hardware, from the sampling task
+ *	void set_rate(uint32_t rate_hz);					follow a change of the sampling rate, from the sampling task
+ *	template<class Sink> void read(Sink& sink, int64_t now_us);
+ * read() hands each reading available since the previous call to sink(channel, ts_us, value): a polled
+ * driver reads once, at now_us, a driver acquiring by DMA hands all the readings of the frames received.
+ * Drivers are gathered by ESP32_Sensors, whose calls are resolved at compile time.
+ */
+
+/* Internal temperature sensor, in degrees Fahrenheit, read once per period */
+class ESP32_TempSensor {
+public:
+	typedef uint8_t sample_type;
+	static constexpr size_t channels=1;
+	static const char* channel_name(size_t channel) { return "temp"; }
+
+	bool begin(uint32_t rate_hz) { return true; }
+
+	void set_rate(uint32_t rate_hz) {}
+
+	template<class Sink> void read(Sink& sink, int64_t now_us) {
+		sink(0,now_us,temprature_sens_read());
+	}
+};
+
+/* Number of bits set in mask */
+constexpr size_t gw_popcount(uint32_t mask) {
+	return mask==0?0:(mask&1)+gw_popcount(mask>>1);
+}
+
+/* Position of the n-th bit set in mask, from 0 */
+constexpr uint32_t gw_nth_bit(uint32_t mask, size_t n, uint32_t pos=0) {
+	return (mask&1)?(n==0?pos:gw_nth_bit(mask>>1,n-1,pos+1)):gw_nth_bit(mask>>1,n,pos+1);
+}
+
+/* Readings of a driver, numbered from base among the channels of the registry */
+template<class Sink, typename T> class ESP32_ChannelSink {
+	static_assert(std::is_integral<T>::value && sizeof(T)<=sizeof(int32_t),"readings must be integers of at most 32 bits");
+
+private:
+	Sink& sink;
+	const uint16_t base;
+
+public:
+	ESP32_ChannelSink(Sink& sink, uint16_t base) : sink(sink), base(base) {}
+
+	void operator()(uint16_t channel, int64_t ts_us, T value) {
+		sink(base+channel,ts_us,(int32_t)value);
+	}
+};
+
+/**
+ * Compile-time registry of sensor drivers, whose channels are numbered in the order of the drivers.
+ * ESP32_Sensors<ESP32_TempSensor,ESP32_AdcSensor<0xC0> > holds both drivers, channel 0 being the
+ * temperature and channels 1 and 2 the analog inputs.
+ */
+template<class... Drivers> class ESP32_Sensors;
+
+template<> class ESP32_Sensors<> {
+public:
+	static constexpr size_t channels=0;
+	static const char* channel_name(size_t channel) { return NULL; }
+
+	bool begin(uint32_t rate_hz) { return true; }
+
+	void set_rate(uint32_t rate_hz) {}
+
+	template<class Sink> void read(Sink& sink, int64_t now_us, uint16_t base=0) {}
+};
+
+template<class Driver, class... Others> class ESP32_Sensors<Driver, Others...> {
+private:
+	Driver driver;
+	ESP32_Sensors<Others...> others;
+
+public:
+	static constexpr size_t channels=Driver::channels+ESP32_Sensors<Others...>::channels;
+	static const char* channel_name(size_t channel) {
+		return channel<Driver::channels?Driver::channel_name(channel):ESP32_Sensors<Others...>::channel_name(channel-Driver::channels);
+	}
+
+	/* Set up all drivers, returns false if one failed */
+	bool begin(uint32_t rate_hz) {
+		return driver.begin(rate_hz) && others.begin(rate_hz);
+	}
+
+	void set_rate(uint32_t rate_hz) {
+		driver.set_rate(rate_hz);
+		others.set_rate(rate_hz);
+	}
+
+	/* Hand the readings of all drivers to sink(channel, ts_us, value) */
+	template<class Sink> void read(Sink& sink, int64_t now_us, uint16_t base=0) {
+		ESP32_ChannelSink<Sink, typename Driver::sample_type> channel_sink(sink,base);
+		driver.read(channel_sink,now_us);
+		others.read(sink,now_us,base+Driver::channels);
+	}
+};
+
+#endif /* MAIN_ESP32SENSORS_H_ */
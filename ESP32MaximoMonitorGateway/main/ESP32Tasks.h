@@ -0,0 +1,43 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32Tasks.h
+#
+# Placement of the gateway tasks on the cores
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32TASKS_H_
+#define MAIN_ESP32TASKS_H_
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+}
+
+/*
+ * Task topology: the sampling task runs on GW_SAMPLE_TASK_CORE, by default the application core,
+ * and the tasks which use the network, publishing, downstream UDP listener, resolver and HTTP server,
+ * on GW_NET_TASK_CORE, along with the Wifi driver on the protocol core. Sampling is then not held
+ * up by network bursts, and publishing not by sampling.
+ */
+
+/* Core argument of xTaskCreatePinnedToCore() for a GW_*_TASK_CORE option, -1 meaning no affinity */
+static inline BaseType_t gw_task_core(int core) {
+#ifdef CONFIG_FREERTOS_UNICORE
+	return tskNO_AFFINITY;
+#else
+	return core<0?tskNO_AFFINITY:core;
+#endif
+}
+
+#endif /* MAIN_ESP32TASKS_H_ */
@@ -0,0 +1,191 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32WebServer.cpp
+#
+# HTTP endpoint serving live readings, their recent history and the gateway metrics
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32WebServer.h"
+#include "ESP32Tasks.h"
+#include "WIoTPEncoder.h"
+#include "WIoTPMetrics.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+static const char *LOG_TAG="HTTP";
+
+// Longest history row, [<ts>,<value>],
+#define HTTP_MAX_ROW_LEN 36
+
+/* Write a timestamp in ms since boot */
+static char* write_ms(char* p, int64_t us) {
+	int64_t ms=us/1000;
+	if(ms<=0xffffffff) {
+		return wiotp_utoa(p,(uint32_t)ms);
+	}
+	return p+sprintf(p,"%lld",(long long)ms);
+}
+
+ESP32_WebServer::ESP32_WebServer(const ESP32_Sampler& sampler, uint16_t port, uint32_t max_rate)
+: sampler(sampler), port(port), bucket(max_rate,max_rate) {
+}
+
+ESP32_WebServer::~ESP32_WebServer() {
+	if(server!=NULL) {
+		httpd_stop(server);
+	}
+}
+
+bool ESP32_WebServer::start(UBaseType_t priority, uint16_t max_sockets, uint32_t stack_size, int core) {
+	httpd_config_t config=HTTPD_DEFAULT_CONFIG();
+	config.server_port=port;
+	config.task_priority=priority;
+	config.stack_size=stack_size;
+	config.core_id=gw_task_core(core);
+	config.max_open_sockets=max_sockets;
+	// Pollers which went away leave their connection open, make room for new ones
+	config.lru_purge_enable=true;
+
+	esp_err_t err=httpd_start(&server,&config);
+	if(err!=ESP_OK) {
+		ESP_LOGE(LOG_TAG,"Failed to start the HTTP server on port %u (%s)",port,esp_err_to_name(err));
+		server=NULL;
+		return false;
+	}
+	const httpd_uri_t uris[]={
+		{ "/readings", HTTP_GET, &_readings, this },
+		{ "/history", HTTP_GET, &_history, this },
+		{ "/metrics", HTTP_GET, &_metrics, this },
+	};
+	for(size_t i=0;i<sizeof(uris)/sizeof(uris[0]);i++) {
+		ESP_ERROR_CHECK(httpd_register_uri_handler(server,&uris[i]));
+	}
+	ESP_LOGI(LOG_TAG,"Serving on port %u, history of %d readings",port,history.capacity());
+	return true;
+}
+
+esp_err_t ESP32_WebServer::_readings(httpd_req_t* req) {
+	ESP32_WebServer* that=(ESP32_WebServer*)req->user_ctx;
+	return that->admit(req)?that->get_readings(req):ESP_OK;
+}
+
+esp_err_t ESP32_WebServer::_history(httpd_req_t* req) {
+	ESP32_WebServer* that=(ESP32_WebServer*)req->user_ctx;
+	return that->admit(req)?that->get_history(req):ESP_OK;
+}
+
+esp_err_t ESP32_WebServer::_metrics(httpd_req_t* req) {
+	ESP32_WebServer* that=(ESP32_WebServer*)req->user_ctx;
+	return that->admit(req)?that->get_metrics(req):ESP_OK;
+}
+
+bool ESP32_WebServer::admit(httpd_req_t* req) {
+	stat_requests++;
+	bucket.refill(esp_timer_get_time());
+	if(bucket.take()) {
+		return true;
+	}
+	stat_throttled++;
+	httpd_resp_set_status(req,"429 Too Many Requests");
+	httpd_resp_set_hdr(req,"Retry-After","1");
+	httpd_resp_send(req,NULL,0);
+	return false;
+}
+
+esp_err_t ESP32_WebServer::get_readings(httpd_req_t* req) {
+	gw_sample_t sample={};
+	char* p=chunk;
+	memcpy(p,"{\"d\":{",6);
+	p+=6;
+	if(history.latest(&sample)) {
+		memcpy(p,"\"temp\":",7);
+		p=wiotp_itoa(p+7,sample.value);
+		memcpy(p,",\"ts\":",6);
+		p=write_ms(p+6,sample.ts_us);
+		memcpy(p,",\"rate_hz\":",11);
+		p=wiotp_utoa(p+11,sampler.rate());
+	}
+	*p++='}';
+	*p++='}';
+	httpd_resp_set_type(req,HTTPD_TYPE_JSON);
+	httpd_resp_set_hdr(req,"Cache-Control","no-store");
+	return httpd_resp_send(req,chunk,p-chunk);
+}
+
+esp_err_t ESP32_WebServer::get_history(httpd_req_t* req) {
+	// Oldest reading to send, all those held by default
+	uint32_t from=history.begin();
+	char query[32], value[12];
+	if(httpd_req_get_url_query_str(req,query,sizeof(query))==ESP_OK
+			&& httpd_query_key_value(query,"n",value,sizeof(value))==ESP_OK) {
+		uint32_t n=strtoul(value,NULL,10);
+		uint32_t end=history.end();
+		if(n<end-from) {
+			from=end-n;
+		}
+	}
+	// Readings written meanwhile are not sent
+	const uint32_t end=history.end();
+
+	httpd_resp_set_type(req,HTTPD_TYPE_JSON);
+	httpd_resp_set_hdr(req,"Cache-Control","no-store");
+	char* p=chunk;
+	memcpy(p,"{\"d\":{\"temp\":[",14);
+	p+=14;
+	gw_sample_t samples[16];
+	size_t n;
+	bool first=true;
+	while((int32_t)(end-from)>0 && (n=history.read(&from,samples,end-from<16?end-from:16))>0) {
+		for(size_t i=0;i<n;i++) {
+			if(p+HTTP_MAX_ROW_LEN>chunk+sizeof(chunk)) {
+				// Stream the full chunk straight from the buffer
+				if(httpd_resp_send_chunk(req,chunk,p-chunk)!=ESP_OK) {
+					return ESP_FAIL;
+				}
+				p=chunk;
+			}
+			if(!first) *p++=',';
+			first=false;
+			*p++='[';
+			p=write_ms(p,samples[i].ts_us);
+			*p++=',';
+			p=wiotp_itoa(p,samples[i].value);
+			*p++=']';
+		}
+	}
+	*p++=']';
+	*p++='}';
+	*p++='}';
+	if(httpd_resp_send_chunk(req,chunk,p-chunk)!=ESP_OK) {
+		return ESP_FAIL;
+	}
+	return httpd_resp_send_chunk(req,NULL,0);
+}
+
+esp_err_t ESP32_WebServer::get_metrics(httpd_req_t* req) {
+	// Histograms are left to the metrics event
+	size_t len=WIoTP_Metrics::encode(chunk,sizeof(chunk),false);
+	if(len==0) {
+		return httpd_resp_send_err(req,HTTPD_500_INTERNAL_SERVER_ERROR,"Metrics do not fit");
+	}
+	httpd_resp_set_type(req,HTTPD_TYPE_JSON);
+	httpd_resp_set_hdr(req,"Cache-Control","no-store");
+	return httpd_resp_send(req,chunk,len);
+}
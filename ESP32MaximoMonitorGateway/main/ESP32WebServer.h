@@ -0,0 +1,84 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32WebServer.h
+#
+# HTTP endpoint serving live readings, their recent history and the gateway metrics
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32WEBSERVER_H_
+#define MAIN_ESP32WEBSERVER_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_http_server.h"
+}
+
+#include "ESP32Sampler.h"
+#include "WIoTPHistory.h"
+#include "WIoTPTokenBucket.h"
+#include "WIoTPMetrics.h"
+
+/* Size of the chunks of streamed responses, and of the response buffer, which holds the metrics */
+#define GW_HTTP_CHUNK_SIZE WIOTP_METRICS_MAX_LEN
+
+/**
+ * Read-only HTTP endpoint for polling the gateway over the LAN:
+ *  GET /readings       last reading, {"d":{"temp":..,"ts":<ms since boot>,"rate_hz":..}}
+ *  GET /history?n=<n>  last n readings, or all those held, {"d":{"temp":[[<ts>,<value>],...]}}
+ *  GET /metrics        counters, pipeline latencies and heap, as in the metrics event
+ * The publishing task pushes each reading into the history ring, which handlers read without locks,
+ * so requests never wait on, nor hold up, the publish path. Responses are encoded and streamed as
+ * chunks from a buffer of GW_HTTP_CHUNK_SIZE bytes, without allocation.
+ * Requests above max_rate per second are answered 429, bounding the time taken from the
+ * publishing task when it shares its priority with the server task.
+ */
+class ESP32_WebServer {
+private:
+	const ESP32_Sampler& sampler;
+	const uint16_t port;
+	httpd_handle_t server = NULL;
+	WIoTP_TokenBucket bucket;
+	// Server task only
+	char chunk[GW_HTTP_CHUNK_SIZE];
+	uint32_t stat_requests = 0;
+	uint32_t stat_throttled = 0;
+
+	static esp_err_t _readings(httpd_req_t* req);
+	static esp_err_t _history(httpd_req_t* req);
+	static esp_err_t _metrics(httpd_req_t* req);
+
+	/* Count the request, returns false once answered 429 if over the rate */
+	bool admit(httpd_req_t* req);
+
+protected:
+	virtual esp_err_t get_readings(httpd_req_t* req);
+	virtual esp_err_t get_history(httpd_req_t* req);
+	virtual esp_err_t get_metrics(httpd_req_t* req);
+
+public:
+	WIoTP_History<gw_sample_t, CONFIG_GW_HTTP_HISTORY_SIZE> history;
+
+	ESP32_WebServer(const ESP32_Sampler& sampler, uint16_t port=CONFIG_GW_HTTP_PORT, uint32_t max_rate=CONFIG_GW_HTTP_MAX_RATE);
+	virtual ~ESP32_WebServer();
+
+	/* Start the server task, pinned to core unless -1, returns false if the server cannot be started */
+	bool start(UBaseType_t priority=CONFIG_GW_HTTP_TASK_PRIORITY, uint16_t max_sockets=CONFIG_GW_HTTP_MAX_SOCKETS,
+			uint32_t stack_size=CONFIG_GW_HTTP_TASK_STACK, int core=CONFIG_GW_NET_TASK_CORE);
+
+	uint32_t requests() const { return stat_requests; }
+	uint32_t throttled() const { return stat_throttled; }
+};
+
+#endif /* MAIN_ESP32WEBSERVER_H_ */
@@ -18,12 +18,14 @@
 #include "ESP32Wifi.h"
 
 extern "C" {
+#include <stdio.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
@@ -31,9 +33,14 @@ extern "C" {
 #include "mdns.h"
 }
 
+#include "ESP32Boot.h"
+#include "WIoTPBudget.h"
+
 static const char *TAG_WIFI = "ESP32_Wifi";
 static const char *TAG_MDNS = "ESP32_MDNs";
-static const char *TAG_WAIT = "ESP32_MDNs";
+
+#define WIFI_NVS_NAMESPACE "gw_wifi"
+#define WIFI_NVS_FAST_KEY "fast"
 
 void ESP32_Wifi::initialise_mdns()
 {
@@ -45,59 +52,30 @@ void ESP32_Wifi::initialise_mdns()
     //set default mDNS instance name
     ESP_ERROR_CHECK( mdns_instance_name_set(hostname) );
 
+#ifdef CONFIG_GW_HTTP_ENABLE
     //structure with TXT records
-    mdns_txt_item_t serviceTxtData[3] = {
+    mdns_txt_item_t serviceTxtData[2] = {
         {"board","esp32"},
-        {"u","user"},
-        {"p","password"}
+        {"path","/readings"}
     };
 
-    //initialize service
-    ESP_ERROR_CHECK( mdns_service_add("ESP32-WebServer", "_http", "_tcp", 80, serviceTxtData, 3) );
-    //add another TXT item
-    ESP_ERROR_CHECK( mdns_service_txt_item_set("_http", "_tcp", "path", "/foobar") );
-    //change TXT item value
-    ESP_ERROR_CHECK( mdns_service_txt_item_set("_http", "_tcp", "u", "admin") );
-}
-
-void ESP32_Wifi::_wait_tcp_task(void * that) {
-	((ESP32_Wifi*)that)->wait_tcp_task();
-}
-
-void ESP32_Wifi::wait_tcp_task()
-{
-	ESP_LOGI(TAG_WAIT, "Waiting for Wifi");
-	wait_wifi();
-
-    tcpip_adapter_ip_info_t ip_info;
-    tcpip_adapter_get_ip_info(TCPIP_ADAPTER_IF_STA,&ip_info);
-    const char* pHostname;
-    tcpip_adapter_get_hostname(TCPIP_ADAPTER_IF_STA, &pHostname);
-
-    ESP_LOGI(TAG_WAIT, "Wifi init OK, host name '%s'",pHostname);
-
-    ESP_LOGI(TAG_WAIT, "Initializing mDNS ");
-    initialise_mdns();
-//	query_mdns_host(MQTT_BROKER_HOST);
-//
-//	ESP_LOGI(TAG_WAIT, "Starting MQTT client broker to %s",MQTT_BROKER_HOST);
-//	mqtt_app_start(MQTT_BROKER_HOST);
-//
-//	ESP_LOGI(TAG_WAIT,"Starting OTA. Use curl %d.%d.%d.%d:8032 --data-binary @build/$(PROJECT_NAME).bin", (ip_info.ip.addr)&0xff,(ip_info.ip.addr>>8)&0xff,(ip_info.ip.addr>>16)&0xff,ip_info.ip.addr>>24&0xff);
-//    ota_server_start();
-
-    vTaskDelete(NULL);
+    //advertise the HTTP endpoint of ESP32_WebServer
+    ESP_ERROR_CHECK( mdns_service_add("ESP32-WebServer", "_http", "_tcp", CONFIG_GW_HTTP_PORT, serviceTxtData, 2) );
+#endif
 }
 
 ESP32_Wifi::ESP32_Wifi(const char* ssid, const char* password, const char* hostname, wifi_auth_mode_t authmode, int wifi_max_retry)
-: wifi_max_retry(wifi_max_retry), hostname(hostname) {
+: hostname(hostname),
+  reconnect_policy(esp_random(),CONFIG_GW_WIFI_BACKOFF_MIN_MS,CONFIG_GW_WIFI_BACKOFF_MAX_MS,
+		  CONFIG_GW_WIFI_FAILOVER_ATTEMPTS,CONFIG_GW_WIFI_RESCAN_ATTEMPTS,wifi_max_retry) {
 	s_wifi_event_group = xEventGroupCreate();
+	memset(&fast_cache,0,sizeof(fast_cache));
 
 	ESP_ERROR_CHECK(esp_netif_init());
 
 	ESP_ERROR_CHECK(esp_event_loop_create_default());
-	esp_netif_t *esp_netif= esp_netif_create_default_wifi_sta();
-	esp_netif_set_hostname(esp_netif, hostname);
+	netif= esp_netif_create_default_wifi_sta();
+	esp_netif_set_hostname(netif, hostname);
 
 	wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
 	ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -113,51 +91,181 @@ ESP32_Wifi::ESP32_Wifi(const char* ssid, const char* password, const char* hostn
 														&_event_handler,
 														this,
 														&instance_got_ip));
-    // Start TCP wait task which will wait for Wifi connection on s_wifi_event_group
-	xTaskCreate(&_wait_tcp_task, "Wait TCP", 4096, this, 5, NULL);
+
+	// Reconnection attempts are delayed by the policy
+	esp_timer_create_args_t timer_args;
+	memset(&timer_args,0,sizeof(timer_args));
+	timer_args.callback=&_retry_timer;
+	timer_args.arg=this;
+	timer_args.dispatch_method=ESP_TIMER_TASK;
+	timer_args.name="wifi_retry";
+	timer_args.skip_unhandled_events=false;
+	ESP_ERROR_CHECK(esp_timer_create(&timer_args,&retry_timer));
+
+	add_ap(ssid,password);
 
 	wifi_config_t wifi_config;
 	memset(&wifi_config,0,sizeof(wifi_config));
 	wifi_config.sta.threshold.authmode=authmode;
 	wifi_config.sta.pmf_cfg.capable=true;
 	wifi_config.sta.pmf_cfg.required=false;
-
-	// Copy SSID and PW making sure we don't overlap...
-	strncpy((char *)wifi_config.sta.ssid,ssid,sizeof(wifi_config.sta.ssid)-1);
-	wifi_config.sta.ssid[sizeof(wifi_config.sta.ssid)-1]='\0';
-	strncpy((char *)wifi_config.sta.password,password,sizeof(wifi_config.sta.password)-1);
-	wifi_config.sta.password[sizeof(wifi_config.sta.password)-1]='\0';
+	wifi_config.sta.sort_method=WIFI_CONNECT_AP_BY_SIGNAL;
+	set_ap(wifi_config,0);
 
 	ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
 	ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config) );
-	ESP_ERROR_CHECK(esp_wifi_start() );
 
+	// mDNS follows the interface state by itself, no need to wait for the connection
+	initialise_mdns();
+}
+
+bool ESP32_Wifi::add_ap(const char* ssid, const char* password) {
+	if(n_aps>=CONFIG_GW_WIFI_MAX_APS) {
+		ESP_LOGW(TAG_WIFI, "No room for AP %s, %d APs at most",ssid,CONFIG_GW_WIFI_MAX_APS);
+		return false;
+	}
+	// Copy SSID and PW making sure we don't overlap...
+	strncpy(aps[n_aps].ssid,ssid,sizeof(aps[n_aps].ssid)-1);
+	aps[n_aps].ssid[sizeof(aps[n_aps].ssid)-1]='\0';
+	strncpy(aps[n_aps].password,password,sizeof(aps[n_aps].password)-1);
+	aps[n_aps].password[sizeof(aps[n_aps].password)-1]='\0';
+	n_aps++;
+	return true;
+}
+
+void ESP32_Wifi::set_ap(wifi_config_t& wifi_config, size_t ap) {
+	memcpy(wifi_config.sta.ssid,aps[ap].ssid,sizeof(wifi_config.sta.ssid));
+	memcpy(wifi_config.sta.password,aps[ap].password,sizeof(wifi_config.sta.password));
+}
+
+void ESP32_Wifi::start() {
+	ESP32_Boot::mark(GW_BOOT_WIFI_START);
+	reconnect_policy.set_ap_count(n_aps);
+
+	// Go straight to the AP of the last connection, without scanning
+	size_t ap;
+	if(load_fast_cache(ap)) {
+		wifi_config_t wifi_config;
+		ESP_ERROR_CHECK(esp_wifi_get_config(ESP_IF_WIFI_STA,&wifi_config));
+		set_ap(wifi_config,ap);
+		fast_path=true;
+		wifi_config.sta.bssid_set=true;
+		memcpy(wifi_config.sta.bssid,fast_cache.bssid,sizeof(wifi_config.sta.bssid));
+		wifi_config.sta.channel=fast_cache.channel;
+		ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA,&wifi_config));
+		reconnect_policy.select(ap);
+		ESP_LOGI(TAG_WIFI, "Fast reconnect to " MACSTR " on channel %d",MAC2STR(fast_cache.bssid),fast_cache.channel);
+	}
+
+	reconnect_policy.on_start(esp_timer_get_time()/1000);
+	ESP_ERROR_CHECK(esp_wifi_start() );
 	ESP_LOGI(TAG_WIFI, "wifi_init_sta finished.");
-	EventBits_t bits=wait_wifi();
-
-	/* xEventGroupWaitBits() returns the bits before the call returned, hence we can test which event actually
-	 * happened. */
-	if (bits & WIFI_CONNECTED_BIT) {
-		ESP_LOGI(TAG_WIFI, "connected to AP SSID %s",wifi_config.sta.ssid);
-	} else if (bits & WIFI_FAIL_BIT) {
-		ESP_LOGI(TAG_WIFI, "Failed to connect to SSID %s",wifi_config.sta.ssid);
-	} else {
-		ESP_LOGE(TAG_WIFI, "UNEXPECTED EVENT");
+}
+
+void ESP32_Wifi::_retry_timer(void* that) {
+	((ESP32_Wifi*)that)->connect(((ESP32_Wifi*)that)->pending);
+}
+
+/* Connect to the AP chosen by the policy, from the esp_timer task */
+void ESP32_Wifi::connect(const wifi_attempt_t& attempt) {
+	wifi_config_t wifi_config;
+	esp_err_t err=esp_wifi_get_config(ESP_IF_WIFI_STA,&wifi_config);
+	if(err==ESP_OK) {
+		set_ap(wifi_config,attempt.ap);
+		wifi_config.sta.scan_method=attempt.full_scan?WIFI_ALL_CHANNEL_SCAN:WIFI_FAST_SCAN;
+		// The AP cached for the fast path may be gone, any AP of the SSID will do
+		wifi_config.sta.bssid_set=false;
+		wifi_config.sta.channel=0;
+		err=esp_wifi_set_config(ESP_IF_WIFI_STA,&wifi_config);
+	}
+	if(err==ESP_OK) {
+		err=esp_wifi_connect();
+	}
+	if(err!=ESP_OK) {
+		// No disconnection event follows an attempt which did not start, try it again later
+		uint32_t delay_ms=attempt.delay_ms>CONFIG_GW_WIFI_BACKOFF_MIN_MS?attempt.delay_ms:CONFIG_GW_WIFI_BACKOFF_MIN_MS;
+		ESP_LOGW(TAG_WIFI, "failed to connect to %s (%s), retry in %u ms",aps[attempt.ap].ssid,esp_err_to_name(err),delay_ms);
+		esp_timer_start_once(retry_timer,(uint64_t)delay_ms*1000);
 	}
 }
 
-EventBits_t ESP32_Wifi::wait_wifi() {
+EventBits_t ESP32_Wifi::wait_wifi(TickType_t timeout) {
 	return xEventGroupWaitBits(s_wifi_event_group,
 			WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
 			pdFALSE,
 			pdFALSE,
-			portMAX_DELAY);
+			timeout);
+}
+
+/* Load the last association, valid only if made with one of the configured APs, returned in ap */
+bool ESP32_Wifi::load_fast_cache(size_t& ap) {
+#ifdef CONFIG_GW_WIFI_FAST_RECONNECT
+	nvs_handle_t nvs;
+	if(nvs_open(WIFI_NVS_NAMESPACE,NVS_READONLY,&nvs)!=ESP_OK) {
+		return false;
+	}
+	size_t len=sizeof(fast_cache);
+	esp_err_t err=nvs_get_blob(nvs,WIFI_NVS_FAST_KEY,&fast_cache,&len);
+	nvs_close(nvs);
+	if(err!=ESP_OK || len!=sizeof(fast_cache)) {
+		return false;
+	}
+	for(ap=0;ap<n_aps;ap++) {
+		if(strncmp((const char*)fast_cache.ssid,aps[ap].ssid,sizeof(aps[ap].ssid))==0) {
+			return true;
+		}
+	}
+	return false;
+#else
+	return false;
+#endif
+}
+
+/* Save the association just made, unless it is the cached one */
+void ESP32_Wifi::save_fast_cache() {
+#ifdef CONFIG_GW_WIFI_FAST_RECONNECT
+	wifi_fast_cache_t cache;
+	memset(&cache,0,sizeof(cache));
+	wifi_ap_record_t ap;
+	wifi_config_t wifi_config;
+	if(esp_wifi_sta_get_ap_info(&ap)!=ESP_OK || esp_wifi_get_config(ESP_IF_WIFI_STA,&wifi_config)!=ESP_OK) {
+		return;
+	}
+	memcpy(cache.ssid,wifi_config.sta.ssid,sizeof(wifi_config.sta.ssid));
+	memcpy(cache.bssid,ap.bssid,sizeof(cache.bssid));
+	cache.channel=ap.primary;
+	if(memcmp(&cache,&fast_cache,sizeof(cache))==0) {
+		return;
+	}
+
+	nvs_handle_t nvs;
+	if(nvs_open(WIFI_NVS_NAMESPACE,NVS_READWRITE,&nvs)!=ESP_OK) {
+		return;
+	}
+	if(nvs_set_blob(nvs,WIFI_NVS_FAST_KEY,&cache,sizeof(cache))==ESP_OK && nvs_commit(nvs)==ESP_OK) {
+		fast_cache=cache;
+		ESP_LOGI(TAG_WIFI, "Cached AP " MACSTR " on channel %d for fast reconnect",MAC2STR(cache.bssid),cache.channel);
+	}
+	nvs_close(nvs);
+#endif
+}
+
+/* Stop pinning the cached AP, next connections scan for the SSID. Only called while disconnected */
+void ESP32_Wifi::leave_fast_path() {
+	fast_path=false;
+	wifi_config_t wifi_config;
+	ESP_ERROR_CHECK(esp_wifi_get_config(ESP_IF_WIFI_STA,&wifi_config));
+	wifi_config.sta.bssid_set=false;
+	wifi_config.sta.channel=0;
+	ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA,&wifi_config));
 }
 
 ESP32_Wifi::~ESP32_Wifi() {
 	/* The event will not be processed after unregister */
 	ESP_ERROR_CHECK(esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, instance_got_ip));
 	ESP_ERROR_CHECK(esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, instance_any_id));
+	esp_timer_stop(retry_timer);
+	esp_timer_delete(retry_timer);
 	vEventGroupDelete(s_wifi_event_group);
 }
 
@@ -169,20 +277,43 @@ void ESP32_Wifi::_event_handler(void* arg, esp_event_base_t event_base, int32_t
 void ESP32_Wifi::event_handler(esp_event_base_t event_base, int32_t event_id, void* event_data) {
    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
 		esp_wifi_connect();
+	} else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+		ESP32_Boot::mark(GW_BOOT_WIFI_CONNECTED);
 	} else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-		if (s_retry_num < wifi_max_retry) {
+		xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+		if (fast_path) {
+			// The cached AP is gone or has moved, reconnect with a full scan
+			ESP_LOGW(TAG_WIFI, "lost cached AP, scanning");
+			leave_fast_path();
 			esp_wifi_connect();
-			s_retry_num++;
-			ESP_LOGI(TAG_WIFI, "retry to connect to the AP for the %d th time",s_retry_num);
-		} else {
-			ESP_LOGE(TAG_WIFI, "maximum wifi retry reached: %d",s_retry_num);
-			xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+			return;
 		}
 		ESP_LOGI(TAG_WIFI,"connect to the AP fail");
+		pending=reconnect_policy.on_disconnected(esp_timer_get_time()/1000);
+		if (reconnect_policy.failed() && !(xEventGroupGetBits(s_wifi_event_group) & WIFI_FAIL_BIT)) {
+			// Waiters give up, but reconnection goes on at the longest backoff
+			ESP_LOGE(TAG_WIFI, "maximum wifi retry reached: %u",reconnect_policy.attempts());
+			xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+		}
+		ESP_LOGI(TAG_WIFI, "retry to connect to %s in %u ms%s",aps[pending.ap].ssid,pending.delay_ms,pending.full_scan?" with full scan":"");
+		esp_timer_stop(retry_timer);
+		ESP_ERROR_CHECK(esp_timer_start_once(retry_timer,(uint64_t)pending.delay_ms*1000));
 	} else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
 		ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
 		ESP_LOGI(TAG_WIFI, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
-		s_retry_num = 0;
+		ESP32_Boot::mark(GW_BOOT_GOT_IP);
+		uint32_t reconnects=reconnect_policy.reconnects();
+		reconnect_policy.on_connected(esp_timer_get_time()/1000);
+		if (reconnect_policy.reconnects()!=reconnects) {
+			ESP_LOGI(TAG_WIFI, "reconnected in %u ms, mean %u ms, max %u ms over %u outages",reconnect_policy.last_reconnect_time(),
+					reconnect_policy.mean_reconnect_time(),reconnect_policy.max_reconnect_time(),reconnect_policy.reconnects());
+		}
+		xEventGroupClearBits(s_wifi_event_group, WIFI_FAIL_BIT);
+		if (!fast_path) {
+			save_fast_cache();
+		}
+		// Once connected, later losses go through the backoff of the reconnection policy
+		fast_path=false;
 		xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
 	}
 }
@@ -190,15 +321,14 @@ void ESP32_Wifi::event_handler(esp_event_base_t event_base, int32_t event_id, vo
 char* ESP32_Wifi::generate_hostname(const char* hostname_base)
 {
     uint8_t mac[6];
-    char   *hostname;
     esp_read_mac(mac, ESP_MAC_WIFI_STA);
-    if (-1 == asprintf(&hostname, "%s-%02X%02X%02X", hostname_base, mac[3], mac[4], mac[5])) {
-        abort();
-    }
+    size_t len=strlen(hostname_base)+sizeof("-XXXXXX");
+    char *hostname=(char*)WIoTP_Budget::alloc(WIOTP_MEM_CONFIG, len);
+    snprintf(hostname, len, "%s-%02X%02X%02X", hostname_base, mac[3], mac[4], mac[5]);
     return hostname;
 }
 
-void ESP32_Wifi::query_mdns_host(const char * host_name)
+esp_err_t ESP32_Wifi::query_mdns_host(const char * host_name, esp_ip4_addr_t* addr, uint32_t timeout_ms)
 {
 	if(strlen(host_name)>strlen(IPADDR_LOCAL_DOMAIN)) {
 		const char *dot_pos=strrchr(host_name,'.');
@@ -216,19 +346,19 @@ void ESP32_Wifi::query_mdns_host(const char * host_name)
 
     ESP_LOGI(TAG_MDNS, "Query A: %s.local", host_name);
 
-    struct esp_ip4_addr addr;
-    addr.addr = 0;
+    addr->addr = 0;
 
     // This uses the hostname without .local
-    esp_err_t err = mdns_query_a(host_name, 2000,  &addr);
+    esp_err_t err = mdns_query_a(host_name, timeout_ms,  addr);
     if(err){
         if(err == ESP_ERR_NOT_FOUND){
             ESP_LOGW(TAG_MDNS, "%s: Host %s was not found!", esp_err_to_name(err),host_name);
-            return;
+            return err;
         }
         ESP_LOGE(TAG_MDNS, "Query Failed: %s", esp_err_to_name(err));
-        return;
+        return err;
     }
 
-    ESP_LOGI(TAG_MDNS, "Query A: %s.local resolved to: " IPSTR, host_name, IP2STR(&addr));
+    ESP_LOGI(TAG_MDNS, "Query A: %s.local resolved to: " IPSTR, host_name, IP2STR(addr));
+    return ESP_OK;
 }
@@ -22,43 +22,84 @@ extern "C" {
 #include "esp_event.h"
 #include "freertos/event_groups.h"
 #include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
 }
 
+#include "ESP32WifiPolicy.h"
+
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
 #define IPADDR_LOCAL_DOMAIN ".local"
 
+/* Last successful association, cached in NVS for the fast reconnect path.
+ * The IP lease is kept by lwIP itself (CONFIG_LWIP_DHCP_RESTORE_LAST_IP) */
+typedef struct {
+	uint8_t ssid[33];
+	uint8_t bssid[6];
+	uint8_t channel;
+} wifi_fast_cache_t;
+
+/* Credentials of one of the APs to connect to */
+typedef struct {
+	char ssid[32];
+	char password[64];
+} wifi_ap_creds_t;
+
 class ESP32_Wifi {
 private:
 	esp_event_handler_instance_t instance_any_id;
 	esp_event_handler_instance_t instance_got_ip;
-	int s_retry_num = 0;
-	const int wifi_max_retry;
 	const char* hostname;
+	esp_netif_t* netif;
+	wifi_fast_cache_t fast_cache;
+	bool fast_path = false;		// connecting to the cached AP only, without scan
+	wifi_ap_creds_t aps[CONFIG_GW_WIFI_MAX_APS];
+	size_t n_aps = 0;
+	ESP32_Wifi_Policy reconnect_policy;
+	esp_timer_handle_t retry_timer;
+	wifi_attempt_t pending;		// attempt started by retry_timer
 
 	void initialise_mdns();
+	bool load_fast_cache(size_t& ap);
+	void save_fast_cache();
+	void leave_fast_path();
+	void set_ap(wifi_config_t& wifi_config, size_t ap);
+	void connect(const wifi_attempt_t& attempt);
 
 	static void _event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
-	static void _wait_tcp_task(void * that);
+	static void _retry_timer(void* that);
 
 protected:
 	EventGroupHandle_t s_wifi_event_group;
 	virtual void event_handler(esp_event_base_t event_base, int32_t event_id, void* event_data);
-	virtual void wait_tcp_task();
 
 public:
-	/* Create Wifi Client */
+	/* Create Wifi Client, the connection is started by start() */
 	ESP32_Wifi(const char* ssid, const char* password, const char* hostname, wifi_auth_mode_t authmode=WIFI_AUTH_WPA2_PSK, int wifi_max_retry=50);
 
+	/* Add a fallback AP, tried when the previous ones cannot be reached. Call before start() */
+	bool add_ap(const char* ssid, const char* password);
+
+	/* Start connecting in the background. Register for IP_EVENT_STA_GOT_IP beforehand to act once connected */
+	void start();
+
 	/* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
-	 * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
-	virtual EventBits_t wait_wifi();
+	 * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above).
+	 * Reconnection goes on after WIFI_FAIL_BIT, which is cleared once connected */
+	virtual EventBits_t wait_wifi(TickType_t timeout=portMAX_DELAY);
+
+	bool connected() const { return (xEventGroupGetBits(s_wifi_event_group)&WIFI_CONNECTED_BIT)!=0; }
+
+	/* Reconnection counters */
+	const ESP32_Wifi_Policy& policy() const { return reconnect_policy; }
 
-	/* Generate a hostname based on a base prefix and MAC Address */
+	/* Generate a hostname based on a base prefix and MAC Address, in the WIOTP_MEM_CONFIG region */
 	static char* generate_hostname(const char* hostname_base);
 
-	static void query_mdns_host(const char * host_name);
+	/* Resolve host_name, with or without its .local suffix, by mDNS. Blocks for up to timeout_ms */
+	static esp_err_t query_mdns_host(const char * host_name, esp_ip4_addr_t* addr, uint32_t timeout_ms=2000);
 
 	virtual ~ESP32_Wifi();
 };
@@ -0,0 +1,89 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32WifiPolicy.cpp
+#
+# Wifi reconnection policy: backoff, jitter, re-scan and AP failover
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "ESP32WifiPolicy.h"
+
+ESP32_Wifi_Policy::ESP32_Wifi_Policy(uint32_t seed, uint32_t min_ms, uint32_t max_ms, uint32_t failover_attempts,
+		uint32_t rescan_attempts, uint32_t max_retry)
+: min_ms(min_ms), max_ms(max_ms>min_ms?max_ms:min_ms), failover_attempts(failover_attempts),
+  rescan_attempts(rescan_attempts), max_retry(max_retry), delay_ms(min_ms), rng(seed!=0?seed:1) {
+}
+
+/* Uniform in [lo,hi], xorshift32 */
+uint32_t ESP32_Wifi_Policy::random(uint32_t lo, uint32_t hi) {
+	rng^=rng<<13;
+	rng^=rng>>17;
+	rng^=rng<<5;
+	return lo+rng%(hi-lo+1);
+}
+
+void ESP32_Wifi_Policy::on_start(int64_t now_ms) {
+	down_since_ms=now_ms;
+	initial=true;
+}
+
+wifi_attempt_t ESP32_Wifi_Policy::on_disconnected(int64_t now_ms) {
+	if(down_since_ms<0) {
+		// Link lost: start a new outage
+		down_since_ms=now_ms;
+		n_disconnects++;
+		delay_ms=min_ms;
+	} else {
+		// A connection attempt failed
+		failures++;
+		ap_failures++;
+	}
+
+	wifi_attempt_t attempt;
+	attempt.full_scan=false;
+	if(failover_attempts>0 && ap_failures>=failover_attempts && n_aps>1) {
+		ap=(ap+1)%n_aps;
+		ap_failures=0;
+		n_failovers++;
+	}
+	attempt.ap=ap;
+	if(rescan_attempts>0 && failures>0 && failures%rescan_attempts==0) {
+		attempt.full_scan=true;
+	}
+
+	// Decorrelated jitter: uniform between the minimum and three times the previous delay, capped
+	if(failed()) {
+		delay_ms=random(max_ms/2,max_ms);
+	} else {
+		uint32_t hi=delay_ms<max_ms/3?delay_ms*3:max_ms;
+		delay_ms=random(min_ms,hi>min_ms?hi:min_ms);
+	}
+	attempt.delay_ms=delay_ms;
+	n_attempts++;
+	return attempt;
+}
+
+void ESP32_Wifi_Policy::on_connected(int64_t now_ms) {
+	if(down_since_ms>=0 && !initial) {
+		n_reconnects++;
+		last_reconnect_ms=now_ms-down_since_ms;
+		total_reconnect_ms+=last_reconnect_ms;
+		if(last_reconnect_ms>max_reconnect_ms) {
+			max_reconnect_ms=last_reconnect_ms;
+		}
+	}
+	down_since_ms=-1;
+	initial=false;
+	failures=0;
+	ap_failures=0;
+	delay_ms=min_ms;
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# ESP32WifiPolicy.h
+#
+# Wifi reconnection policy: backoff, jitter, re-scan and AP failover
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_ESP32WIFIPOLICY_H_
+#define MAIN_ESP32WIFIPOLICY_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+}
+
+/* Next connection attempt decided by the policy */
+typedef struct {
+	uint32_t delay_ms;	// wait before connecting
+	size_t ap;			// index of the AP to connect to
+	bool full_scan;		// scan all channels and pick the strongest AP, instead of the first found
+} wifi_attempt_t;
+
+/**
+ * Decides when and where to reconnect after the Wifi link is lost.
+ * Delays follow an exponential backoff with decorrelated jitter, so that many gateways losing the same AP
+ * do not retry in lockstep. After failover_attempts failures on one AP the next configured AP is tried,
+ * and every rescan_attempts failures a full scan is requested.
+ * After max_retry consecutive failures the policy reports failed(), but keeps retrying at the maximum delay.
+ *
+ * Only depends on the times and random seed given by the caller, so it runs unchanged off target.
+ */
+class ESP32_Wifi_Policy {
+private:
+	const uint32_t min_ms;
+	const uint32_t max_ms;
+	const uint32_t failover_attempts;
+	const uint32_t rescan_attempts;
+	const uint32_t max_retry;
+	size_t n_aps = 1;
+	size_t ap = 0;
+	uint32_t failures = 0;		// consecutive failures since the last connection
+	uint32_t ap_failures = 0;	// consecutive failures on the current AP
+	uint32_t delay_ms;			// previous delay
+	uint32_t rng;
+	int64_t down_since_ms = -1;	// start of the outage, -1 while connected
+	bool initial = false;		// first connection since start(), not counted as a reconnection
+
+	// Statistics
+	uint32_t n_disconnects = 0;
+	uint32_t n_attempts = 0;
+	uint32_t n_failovers = 0;
+	uint32_t n_reconnects = 0;
+	uint32_t last_reconnect_ms = 0;
+	uint32_t max_reconnect_ms = 0;
+	uint64_t total_reconnect_ms = 0;
+
+	uint32_t random(uint32_t lo, uint32_t hi);
+
+public:
+	ESP32_Wifi_Policy(uint32_t seed, uint32_t min_ms, uint32_t max_ms, uint32_t failover_attempts, uint32_t rescan_attempts, uint32_t max_retry);
+
+	/* Number of configured APs, failover cycles through them */
+	void set_ap_count(size_t n) { n_aps=n>0?n:1; }
+	/* Make ap the current AP, for instance the one of a cached connection */
+	void select(size_t ap) { this->ap=ap<n_aps?ap:0; ap_failures=0; }
+	size_t current_ap() const { return ap; }
+
+	/* The first connection is attempted at now_ms */
+	void on_start(int64_t now_ms);
+	/* The link went down or a connection attempt failed at now_ms, returns the next attempt */
+	wifi_attempt_t on_disconnected(int64_t now_ms);
+	/* The link is up at now_ms */
+	void on_connected(int64_t now_ms);
+
+	bool failed() const { return failures>=max_retry; }
+	bool down() const { return down_since_ms>=0; }
+
+	uint32_t disconnects() const { return n_disconnects; }
+	uint32_t attempts() const { return n_attempts; }
+	uint32_t failovers() const { return n_failovers; }
+	uint32_t reconnects() const { return n_reconnects; }
+	/* Times from the loss of the link to its recovery */
+	uint32_t last_reconnect_time() const { return last_reconnect_ms; }
+	uint32_t max_reconnect_time() const { return max_reconnect_ms; }
+	uint32_t mean_reconnect_time() const { return n_reconnects>0?total_reconnect_ms/n_reconnects:0; }
+};
+
+#endif /* MAIN_ESP32WIFIPOLICY_H_ */
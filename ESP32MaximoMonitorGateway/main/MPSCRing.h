@@ -0,0 +1,93 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# MPSCRing.h
+#
+# Lock-free bounded ring with several producers and one consumer
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_MPSCRING_H_
+#define MAIN_MPSCRING_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+}
+
+#include <atomic>
+
+/**
+ * Fixed-capacity ring written by any number of producer tasks and read by one consumer task, without locks.
+ * Each slot carries a sequence number: a producer claims the next position by compare-and-swap when its slot
+ * has been read, writes the element, then publishes it by advancing the slot sequence, which the consumer waits for.
+ * Indexes run freely and are masked on access, so N must be a power of two.
+ * When the ring is full, push() drops the new element and counts an overrun.
+ */
+template<typename T, size_t N> class MPSC_Ring {
+	static_assert(N>=2 && (N&(N-1))==0,"ring size must be a power of two");
+
+private:
+	struct slot_t {
+		std::atomic<uint32_t> seq;	// position+1 once written, position+N once read
+		T value;
+	};
+	slot_t slots[N];
+	std::atomic<uint32_t> head;		// next position claimed by a producer
+	uint32_t tail = 0;				// next position read by the consumer
+	std::atomic<uint32_t> overruns;
+
+public:
+	MPSC_Ring() : head(0), overruns(0) {
+		for(uint32_t i=0;i<N;i++) {
+			slots[i].seq.store(i,std::memory_order_relaxed);
+		}
+	}
+
+	/* Producer side: append an element, returns false and counts an overrun if the ring is full */
+	bool push(const T& v) {
+		uint32_t pos=head.load(std::memory_order_relaxed);
+		while(true) {
+			slot_t& s=slots[pos&(N-1)];
+			int32_t diff=(int32_t)(s.seq.load(std::memory_order_acquire)-pos);
+			if(diff==0) {
+				// Free slot, claimed unless another producer was first, pos then being reloaded
+				if(head.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) {
+					s.value=v;
+					s.seq.store(pos+1,std::memory_order_release);
+					return true;
+				}
+			} else if(diff<0) {
+				overruns.fetch_add(1,std::memory_order_relaxed);
+				return false;
+			} else {
+				pos=head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/* Consumer side: remove the oldest element, returns false if the ring is empty or it is still being written */
+	bool pop(T& v) {
+		slot_t& s=slots[tail&(N-1)];
+		if(s.seq.load(std::memory_order_acquire)!=tail+1) {
+			return false;
+		}
+		v=s.value;
+		s.seq.store(tail+N,std::memory_order_release);
+		tail++;
+		return true;
+	}
+
+	static constexpr size_t capacity() { return N; }
+	uint32_t overrun_count() const { return overruns.load(std::memory_order_relaxed); }
+};
+
+#endif /* MAIN_MPSCRING_H_ */
@@ -0,0 +1,114 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# SPSCRing.h
+#
+# Lock-free single-producer/single-consumer ring buffer
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_SPSCRING_H_
+#define MAIN_SPSCRING_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+}
+
+#include <atomic>
+
+/**
+ * Fixed-capacity ring shared by exactly one producer task and one consumer task, without locks.
+ * The producer only writes head, the consumer only writes tail; indexes run freely and are
+ * masked on access, so N must be a power of two.
+ * When the ring is full, push() drops the new element and counts an overrun.
+ */
+template<typename T, size_t N> class SPSC_Ring {
+	static_assert(N>=2 && (N&(N-1))==0,"ring size must be a power of two");
+
+private:
+	T buf[N];
+	std::atomic<uint32_t> head;		// next slot written by the producer
+	std::atomic<uint32_t> tail;		// next slot read by the consumer
+	std::atomic<uint32_t> overruns;
+	uint32_t high_water = 0;		// producer side only
+
+public:
+	SPSC_Ring() : head(0), tail(0), overruns(0) {}
+
+	/* Producer side: append an element, returns false and counts an overrun if the ring is full */
+	bool push(const T& v) {
+		uint32_t h=head.load(std::memory_order_relaxed);
+		uint32_t used=h-tail.load(std::memory_order_acquire);
+		if(used>=N) {
+			overruns.fetch_add(1,std::memory_order_relaxed);
+			return false;
+		}
+		buf[h&(N-1)]=v;
+		head.store(h+1,std::memory_order_release);
+		if(used+1>high_water) {
+			high_water=used+1;
+		}
+		return true;
+	}
+
+	/* Producer side: append n elements at once, published together. Those which do not fit are dropped
+	 * and counted as overruns. Returns the number appended */
+	size_t push_bulk(const T* v, size_t n) {
+		uint32_t h=head.load(std::memory_order_relaxed);
+		uint32_t used=h-tail.load(std::memory_order_acquire);
+		size_t room=N-used;
+		if(n>room) {
+			overruns.fetch_add(n-room,std::memory_order_relaxed);
+			n=room;
+		}
+		for(size_t i=0;i<n;i++) {
+			buf[(h+i)&(N-1)]=v[i];
+		}
+		head.store(h+n,std::memory_order_release);
+		if(used+n>high_water) {
+			high_water=used+n;
+		}
+		return n;
+	}
+
+	/* Consumer side: remove the oldest element, returns false if the ring is empty */
+	bool pop(T& v) {
+		uint32_t t=tail.load(std::memory_order_relaxed);
+		if(t==head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		v=buf[t&(N-1)];
+		tail.store(t+1,std::memory_order_release);
+		return true;
+	}
+
+	/* Consumer side: remove up to max elements into out, returns the number removed */
+	size_t pop_bulk(T* out, size_t max) {
+		uint32_t t=tail.load(std::memory_order_relaxed);
+		uint32_t n=head.load(std::memory_order_acquire)-t;
+		if(n>max) {
+			n=max;
+		}
+		for(uint32_t i=0;i<n;i++) {
+			out[i]=buf[(t+i)&(N-1)];
+		}
+		tail.store(t+n,std::memory_order_release);
+		return n;
+	}
+
+	size_t size() const { return head.load(std::memory_order_acquire)-tail.load(std::memory_order_acquire); }
+	static constexpr size_t capacity() { return N; }
+	uint32_t overrun_count() const { return overruns.load(std::memory_order_relaxed); }
+	uint32_t high_water_mark() const { return high_water; }
+};
+
+#endif /* MAIN_SPSCRING_H_ */
@@ -0,0 +1,304 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPAggregator.cpp
+#
+# Windowed on-device aggregation of readings into summary events
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPAggregator.h"
+#include "WIoTPEncoder.h"
+#include "WIoTPBudget.h"
+#include "WIoTPMetrics.h"
+#include "ESP32Log.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "esp_log.h"
+}
+
+static const char *LOG_TAG="AGGREGATOR";
+
+// Largest rendering of a key suffix such as "_mean", and of a value
+#define AGG_MAX_SUFFIX_LEN 6
+#define AGG_MAX_VALUE_LEN 12
+
+void WIoTP_P2Quantile::reset(float p) {
+	this->p=p;
+	count=0;
+}
+
+void WIoTP_P2Quantile::add(float x) {
+	// The first five readings initialise the markers
+	if(count<5) {
+		q[count++]=x;
+		if(count==5) {
+			for(int i=1;i<5;i++) {
+				for(int j=i;j>0 && q[j-1]>q[j];j--) {
+					float t=q[j]; q[j]=q[j-1]; q[j-1]=t;
+				}
+			}
+			for(int i=0;i<5;i++) {
+				n[i]=i+1;
+			}
+			np[0]=1; np[1]=1+2*p; np[2]=1+4*p; np[3]=3+2*p; np[4]=5;
+		}
+		return;
+	}
+	count++;
+
+	// Find the cell of x, extending the extreme markers if needed
+	int k;
+	if(x<q[0]) {
+		q[0]=x;
+		k=0;
+	} else if(x>=q[4]) {
+		q[4]=x;
+		k=3;
+	} else {
+		for(k=0;k<3 && x>=q[k+1];k++);
+	}
+	for(int i=k+1;i<5;i++) {
+		n[i]++;
+	}
+	np[1]+=p/2; np[2]+=p; np[3]+=(1+p)/2; np[4]+=1;
+
+	// Move the middle markers towards their desired positions
+	for(int i=1;i<4;i++) {
+		float d=np[i]-n[i];
+		if((d>=1 && n[i+1]-n[i]>1) || (d<=-1 && n[i-1]-n[i]<-1)) {
+			int s=d>0?1:-1;
+			// Piecewise-parabolic prediction, falling back to linear if it breaks ordering
+			float qp=q[i]+(float)s/(n[i+1]-n[i-1])*((n[i]-n[i-1]+s)*(q[i+1]-q[i])/(n[i+1]-n[i])
+					+(n[i+1]-n[i]-s)*(q[i]-q[i-1])/(n[i]-n[i-1]));
+			if(q[i-1]<qp && qp<q[i+1]) {
+				q[i]=qp;
+			} else {
+				q[i]+=s*(q[i+s]-q[i])/(n[i+s]-n[i]);
+			}
+			n[i]+=s;
+		}
+	}
+}
+
+float WIoTP_P2Quantile::estimate() const {
+	if(count>=5) {
+		return q[2];
+	}
+	if(count==0) {
+		return NAN;
+	}
+	// Too few readings for the markers, take the nearest rank
+	float sorted[5];
+	memcpy(sorted,q,count*sizeof(float));
+	for(uint32_t i=1;i<count;i++) {
+		for(uint32_t j=i;j>0 && sorted[j-1]>sorted[j];j--) {
+			float t=sorted[j]; sorted[j]=sorted[j-1]; sorted[j-1]=t;
+		}
+	}
+	return sorted[(uint32_t)(p*(count-1)+0.5f)];
+}
+
+WIoTP_Aggregator::WIoTP_Aggregator(esp_mqtt_client_handle_t client, const char* topic, const char* field,
+		uint32_t window_ms, uint32_t hop_ms, uint32_t stats, const char* percentiles, int decimals)
+: field(field), stats(stats), hop_us((int64_t)hop_ms*1000), decimals(decimals), n_percentiles(0),
+  current(0), pane_end_us(0), client(client), topic(topic) {
+	n_panes=(hop_ms>0 && window_ms>hop_ms)?window_ms/hop_ms:1;
+	if(n_panes>WIOTP_AGG_MAX_PANES) {
+		ESP_LOGW(LOG_TAG,"Window %u ms holds more than %d hops of %u ms, truncated",window_ms,WIOTP_AGG_MAX_PANES,hop_ms);
+		n_panes=WIOTP_AGG_MAX_PANES;
+	}
+
+	// Parse the list of percentiles
+	for(const char* s=percentiles;*s!='\0' && n_percentiles<WIOTP_AGG_MAX_PERCENTILES;) {
+		char* end;
+		long pct=strtol(s,&end,10);
+		if(end==s) {
+			s++;
+			continue;
+		}
+		if(pct>0 && pct<100) {
+			this->percentiles[n_percentiles++]=pct/100.0f;
+		}
+		s=end;
+	}
+
+	size_t n_stats=n_percentiles;
+	for(uint32_t s=stats;s!=0;s>>=1) {
+		n_stats+=s&1;
+	}
+	if(sizeof("{\"d\":{}}")+n_stats*(sizeof(",\"\":")-1+strlen(field)+AGG_MAX_SUFFIX_LEN+AGG_MAX_VALUE_LEN+decimals)>sizeof(payload)) {
+		ESP_LOGE(LOG_TAG,"Summary of field %s does not fit in %d bytes",field,sizeof(payload));
+		abort();
+	}
+
+	panes=(wiotp_agg_pane_t*)WIoTP_Budget::alloc(WIOTP_MEM_BATCH,n_panes*sizeof(wiotp_agg_pane_t));
+	for(size_t i=0;i<n_panes;i++) {
+		reset_pane(panes[i]);
+	}
+	ESP_LOGI(LOG_TAG,"Aggregating %s over %u ms windows every %u ms",field,window_ms,hop_ms);
+}
+
+WIoTP_Aggregator::~WIoTP_Aggregator() {
+	WIoTP_Budget::release(WIOTP_MEM_BATCH,panes,n_panes*sizeof(wiotp_agg_pane_t));
+}
+
+int WIoTP_Aggregator::publish(const char* payload, size_t len) {
+	// Publish at QOS 1, no retain
+	return esp_mqtt_client_publish(client, topic, payload, len, 1, 0);
+}
+
+void WIoTP_Aggregator::reset_pane(wiotp_agg_pane_t& pane) {
+	pane.count=0;
+	pane.min=INFINITY;
+	pane.max=-INFINITY;
+	pane.mean=0;
+	pane.m2=0;
+	for(size_t i=0;i<n_percentiles;i++) {
+		pane.quantiles[i].reset(percentiles[i]);
+	}
+}
+
+void WIoTP_Aggregator::add(int64_t ts_us, float value) {
+	if(pane_end_us==0) {
+		pane_end_us=ts_us+hop_us;
+	}
+	poll(ts_us);
+
+	wiotp_agg_pane_t& pane=panes[current];
+	pane.count++;
+	if(value<pane.min) pane.min=value;
+	if(value>pane.max) pane.max=value;
+	// Welford's online update
+	double delta=value-pane.mean;
+	pane.mean+=delta/pane.count;
+	pane.m2+=delta*(value-pane.mean);
+	for(size_t i=0;i<n_percentiles;i++) {
+		pane.quantiles[i].add(value);
+	}
+}
+
+void WIoTP_Aggregator::poll(int64_t now_us) {
+	if(pane_end_us==0) {
+		return;
+	}
+	// After a gap longer than the window, all panes are stale: emit once and restart
+	if(now_us-pane_end_us>=(int64_t)n_panes*hop_us) {
+		emit();
+		for(size_t i=0;i<n_panes;i++) {
+			reset_pane(panes[i]);
+		}
+		pane_end_us=now_us+hop_us;
+		return;
+	}
+	while(now_us>=pane_end_us) {
+		emit();
+		current=(current+1)%n_panes;
+		reset_pane(panes[current]);
+		pane_end_us+=hop_us;
+	}
+}
+
+/* Merge the panes of the window and write the summary payload, returns its length or 0 if empty */
+size_t WIoTP_Aggregator::encode() {
+	uint32_t count=0;
+	float min=INFINITY, max=-INFINITY;
+	double mean=0, m2=0;
+	float quantiles[WIOTP_AGG_MAX_PERCENTILES]={ 0 };
+	for(size_t i=0;i<n_panes;i++) {
+		const wiotp_agg_pane_t& pane=panes[i];
+		if(pane.count==0) continue;
+		// Chan et al. pairwise combination of mean and sum of squared differences
+		uint32_t total=count+pane.count;
+		double delta=pane.mean-mean;
+		mean+=delta*pane.count/total;
+		m2+=pane.m2+delta*delta*count*pane.count/total;
+		count=total;
+		if(pane.min<min) min=pane.min;
+		if(pane.max>max) max=pane.max;
+		for(size_t j=0;j<n_percentiles;j++) {
+			quantiles[j]+=pane.quantiles[j].estimate()*pane.count;
+		}
+	}
+	if(count==0) {
+		return 0;
+	}
+	window_mean=mean;
+
+	size_t field_len=strlen(field);
+	char* p=payload;
+	memcpy(p,"{\"d\":{",6);
+	p+=6;
+	// Write ,"<field><suffix>": skipping the comma for the first key
+	auto key=[&](const char* suffix) {
+		if(p[-1]!='{') *p++=',';
+		*p++='"';
+		memcpy(p,field,field_len);
+		p+=field_len;
+		size_t len=strlen(suffix);
+		memcpy(p,suffix,len);
+		p+=len;
+		*p++='"';
+		*p++=':';
+	};
+	if(stats&WIOTP_AGG_COUNT) {
+		key("_n");
+		p=wiotp_utoa(p,count);
+	}
+	if(stats&WIOTP_AGG_MIN) {
+		key("_min");
+		p=wiotp_ftoa(p,min,decimals);
+	}
+	if(stats&WIOTP_AGG_MAX) {
+		key("_max");
+		p=wiotp_ftoa(p,max,decimals);
+	}
+	if(stats&WIOTP_AGG_MEAN) {
+		key("_mean");
+		p=wiotp_ftoa(p,mean,decimals);
+	}
+	if(stats&WIOTP_AGG_STDDEV) {
+		key("_std");
+		p=wiotp_ftoa(p,count>1?sqrt(m2/(count-1)):0,decimals);
+	}
+	for(size_t j=0;j<n_percentiles;j++) {
+		char suffix[AGG_MAX_SUFFIX_LEN]="_p";
+		*wiotp_utoa(suffix+2,(uint32_t)(percentiles[j]*100+0.5f))='\0';
+		key(suffix);
+		p=wiotp_ftoa(p,quantiles[j]/count,decimals);
+	}
+	*p++='}';
+	*p++='}';
+	*p='\0';
+	return p-payload;
+}
+
+void WIoTP_Aggregator::set_deadband(const WIoTP_Deadband* deadband) {
+	this->deadband=deadband;
+	WIoTP_Deadband::reset(rbe);
+}
+
+void WIoTP_Aggregator::emit() {
+	size_t len=encode();
+	if(len>0 && deadband!=NULL && !deadband->report(rbe,(int32_t)lrint(window_mean),pane_end_us)) {
+		stat_suppressed++;
+		WIoTP_Metrics::count(WIOTP_CNT_SUPPRESSED);
+		return;
+	}
+	if(len>0) {
+		int msg_id=publish(payload,len);
+		GW_LOGD(LOG_TAG,"Published summary %.*s, msg_id=%d",len,payload,msg_id);
+	}
+}
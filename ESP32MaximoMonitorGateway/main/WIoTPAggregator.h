@@ -0,0 +1,126 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPAggregator.h
+#
+# Windowed on-device aggregation of readings into summary events
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPAGGREGATOR_H_
+#define MAIN_WIOTPAGGREGATOR_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "mqtt_client.h"
+}
+
+#include "WIoTPDeadband.h"
+
+#define WIOTP_AGG_MAX_PERCENTILES 4
+#define WIOTP_AGG_MAX_PANES 16
+
+/* Statistics which can be selected for the summary */
+#define WIOTP_AGG_COUNT  (1<<0)
+#define WIOTP_AGG_MIN    (1<<1)
+#define WIOTP_AGG_MAX    (1<<2)
+#define WIOTP_AGG_MEAN   (1<<3)
+#define WIOTP_AGG_STDDEV (1<<4)
+
+/**
+ * P-square streaming quantile estimator (Jain & Chlamtac, 1985).
+ * Tracks one quantile in constant memory with five markers.
+ */
+class WIoTP_P2Quantile {
+private:
+	float p;
+	float q[5];		// marker heights
+	int32_t n[5];	// marker positions
+	float np[5];	// desired marker positions
+	uint32_t count;
+
+public:
+	void reset(float p);
+	void add(float x);
+	float estimate() const;
+};
+
+/* Single-pass statistics of one pane, min/max and Welford mean/variance */
+typedef struct {
+	uint32_t count;
+	float min;
+	float max;
+	double mean;
+	double m2;
+	WIoTP_P2Quantile quantiles[WIOTP_AGG_MAX_PERCENTILES];
+} wiotp_agg_pane_t;
+
+/**
+ * Aggregates readings over time windows and publishes one summary per window as
+ * {"d":{"<field>_n":..,"<field>_min":..,"<field>_max":..,"<field>_mean":..,"<field>_std":..,"<field>_p90":..}}
+ * Windows are window_ms long and emitted every hop_ms: tumbling windows when both are equal,
+ * rolling windows when hop_ms is a divisor of window_ms. Rolling windows are kept as window_ms/hop_ms panes,
+ * merged when emitting: exactly for min/max/mean/stddev, and as a count-weighted mean of the pane
+ * estimates for percentiles.
+ * With a deadband, a summary is only published when its mean is reported by the deadband, the summaries
+ * of a flat channel being reduced to heartbeats.
+ */
+class WIoTP_Aggregator {
+private:
+	const char* field;
+	const uint32_t stats;
+	const int64_t hop_us;
+	const int decimals;
+	size_t n_panes;
+	size_t n_percentiles;
+	float percentiles[WIOTP_AGG_MAX_PERCENTILES];
+	wiotp_agg_pane_t* panes;
+	size_t current;			// pane receiving readings
+	int64_t pane_end_us;	// end of the current pane, 0 before the first reading
+	double window_mean;		// mean of the last summary encoded
+	const WIoTP_Deadband* deadband = NULL;
+	wiotp_rbe_t rbe;		// mean of the last summary published
+	uint32_t stat_suppressed = 0;
+	char payload[384];
+
+	void reset_pane(wiotp_agg_pane_t& pane);
+	void emit();
+	size_t encode();
+
+protected:
+	esp_mqtt_client_handle_t client;
+	const char* topic;
+
+	/* Send one complete payload, returns the MQTT msg_id or -1 */
+	virtual int publish(const char* payload, size_t len);
+
+public:
+	/* percentiles is a comma separated list of percentiles such as "50,90,99" */
+	WIoTP_Aggregator(esp_mqtt_client_handle_t client, const char* topic, const char* field="temp",
+			uint32_t window_ms=60000, uint32_t hop_ms=60000,
+			uint32_t stats=WIOTP_AGG_COUNT|WIOTP_AGG_MIN|WIOTP_AGG_MAX|WIOTP_AGG_MEAN|WIOTP_AGG_STDDEV,
+			const char* percentiles="", int decimals=2);
+	virtual ~WIoTP_Aggregator();
+
+	/* Add a reading taken at ts_us, emitting the summaries of the windows it closes */
+	void add(int64_t ts_us, float value);
+
+	/* Emit the summaries of the windows closed at now_us when no reading arrives */
+	void poll(int64_t now_us);
+
+	/* Only publish the summaries whose mean is reported by the deadband, NULL for all summaries */
+	void set_deadband(const WIoTP_Deadband* deadband);
+
+	uint32_t suppressed() const { return stat_suppressed; }
+};
+
+#endif /* MAIN_WIOTPAGGREGATOR_H_ */
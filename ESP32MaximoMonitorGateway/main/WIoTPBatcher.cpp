@@ -0,0 +1,219 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPBatcher.cpp
+#
+# Batching publisher for WIoTP device events
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPBatcher.h"
+#include "WIoTPEncoder.h"
+#include "WIoTPMetrics.h"
+#include "WIoTPBudget.h"
+#include "ESP32Log.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+static const char *LOG_TAG="BATCH";
+
+// Opening {"d":{"<field>":[ and closing ]}} of the JSON array payload
+static const char JSON_HEADER[]="{\"d\":{\"";
+static const char JSON_FIELD_END[]="\":[";
+static const char JSON_TRAILER[]="]}}";
+// Largest CBOR head of the readings byte string, for payloads under 64KB
+#define CBOR_BYTES_HEAD_LEN 3
+
+size_t wiotp_batch_envelope_len(wiotp_format_t format, size_t field_len) {
+	if(format!=WIOTP_FMT_JSON) {
+		uint8_t head[8];
+		// map(1) "d" map(1) text(field) bytes(...)
+		return 1+2+1+(cbor_head(head,CBOR_TEXT,field_len)-head)+field_len+CBOR_BYTES_HEAD_LEN;
+	}
+	return sizeof(JSON_HEADER)-1+field_len+sizeof(JSON_FIELD_END)-1+sizeof(JSON_TRAILER)-1;
+}
+
+size_t wiotp_batch_sample_len(wiotp_format_t format, const int32_t* values, size_t n, int32_t value) {
+	if(format==WIOTP_FMT_CBOR) {
+		return wiotp_delta_len(n>0?values[n-1]:0,value);
+	}
+	if(format==WIOTP_FMT_GORILLA) {
+		return n==0?WIOTP_GORILLA_HEADER_LEN:(WIOTP_GORILLA_MAX_BITS+7)/8;
+	}
+	char digits[12];
+	return (wiotp_itoa(digits,value)-digits)+(n>0?1:0);
+}
+
+size_t wiotp_batch_encode(char* payload, wiotp_format_t format, const char* field, size_t field_len,
+		const int32_t* values, size_t n, size_t body_len) {
+	if(format==WIOTP_FMT_CBOR) {
+		uint8_t* p=(uint8_t*)payload;
+		p=cbor_head(p,CBOR_MAP,1);
+		p=cbor_text(p,"d",1);
+		p=cbor_head(p,CBOR_MAP,1);
+		p=cbor_text(p,field,field_len);
+		p=cbor_head(p,CBOR_BYTES,body_len);
+		p=wiotp_delta_pack(p,values,n);
+		*p='\0';
+		return p-(uint8_t*)payload;
+	}
+
+	char* p=payload;
+	memcpy(p,JSON_HEADER,sizeof(JSON_HEADER)-1);
+	p+=sizeof(JSON_HEADER)-1;
+	memcpy(p,field,field_len);
+	p+=field_len;
+	memcpy(p,JSON_FIELD_END,sizeof(JSON_FIELD_END)-1);
+	p+=sizeof(JSON_FIELD_END)-1;
+	for(size_t i=0;i<n;i++) {
+		if(i>0) {
+			*p++=',';
+		}
+		p=wiotp_itoa(p,values[i]);
+	}
+	memcpy(p,JSON_TRAILER,sizeof(JSON_TRAILER));
+	return p+sizeof(JSON_TRAILER)-1-payload;
+}
+
+size_t wiotp_batch_encode_block(char* payload, const char* field, size_t field_len, const uint8_t* block, size_t len) {
+	uint8_t* p=(uint8_t*)payload;
+	p=cbor_head(p,CBOR_MAP,1);
+	p=cbor_text(p,"d",1);
+	p=cbor_head(p,CBOR_MAP,1);
+	p=cbor_text(p,field,field_len);
+	p=cbor_head(p,CBOR_BYTES,len);
+	memcpy(p,block,len);
+	p+=len;
+	*p='\0';
+	return p-(uint8_t*)payload;
+}
+
+WIoTP_Batcher::WIoTP_Batcher(esp_mqtt_client_handle_t client, const char* topic, const char* field,
+		wiotp_format_t format, size_t max_bytes, size_t max_samples, uint32_t max_age_ms)
+: format(format), field(field), max_bytes(max_bytes), max_samples(max_samples), max_age_us((int64_t)max_age_ms*1000),
+  body_len(0), n_samples(0), first_sample_us(0), client(client), topic(topic) {
+	field_len=strlen(field);
+
+	// Buffers are allocated once, the payload with room for the terminating zero
+	payload=(char*)WIoTP_Budget::alloc(WIOTP_MEM_BATCH,max_bytes+1);
+	if(format==WIOTP_FMT_GORILLA) {
+		values=NULL;
+		block=(uint8_t*)WIoTP_Budget::alloc(WIOTP_MEM_BATCH,max_bytes);
+	} else {
+		values=(int32_t*)WIoTP_Budget::alloc(WIOTP_MEM_BATCH,max_samples*sizeof(int32_t));
+		block=NULL;
+	}
+	wiotp_gorilla_init(&gorilla);
+	WIoTP_Deadband::reset(channel);
+
+	envelope_len=wiotp_batch_envelope_len(format,field_len);
+	if(envelope_len+wiotp_batch_sample_len(format,NULL,0,INT32_MIN)>max_bytes) {
+		ESP_LOGE(LOG_TAG,"Batch size %d too small for field %s",max_bytes,field);
+		abort();
+	}
+}
+
+WIoTP_Batcher::~WIoTP_Batcher() {
+	WIoTP_Budget::release(WIOTP_MEM_BATCH,block,max_bytes);
+	WIoTP_Budget::release(WIOTP_MEM_BATCH,values,max_samples*sizeof(int32_t));
+	WIoTP_Budget::release(WIOTP_MEM_BATCH,payload,max_bytes+1);
+}
+
+int WIoTP_Batcher::publish(const char* payload, size_t len) {
+	// Publish at QOS 1, no retain
+	return esp_mqtt_client_publish(client, topic, payload, len, 1, 0);
+}
+
+void WIoTP_Batcher::set_deadband(const WIoTP_Deadband* deadband) {
+	this->deadband=deadband;
+	WIoTP_Deadband::reset(channel);
+}
+
+size_t WIoTP_Batcher::sample_len(int32_t value, int64_t ts_us) const {
+	if(format==WIOTP_FMT_GORILLA) {
+		// Bytes the block grows by, its last byte being partly used
+		return (gorilla.bits+wiotp_gorilla_bits(&gorilla,ts_us/1000,value)+7)/8-wiotp_gorilla_len(&gorilla);
+	}
+	return wiotp_batch_sample_len(format,values,n_samples,value);
+}
+
+bool WIoTP_Batcher::add(int64_t ts_us, int32_t value) {
+	if(deadband!=NULL && !deadband->report(channel,value,ts_us)) {
+		stat_suppressed++;
+		WIoTP_Metrics::count(WIOTP_CNT_SUPPRESSED);
+		return false;
+	}
+	bool flushed=false;
+
+	// Flush first if this sample does not fit
+	size_t len=sample_len(value,ts_us);
+	if(envelope_len+body_len+len>max_bytes) {
+		flushed=flush();
+		len=sample_len(value,ts_us);
+	}
+
+	if(n_samples==0) {
+		first_sample_us=ts_us;
+	}
+	if(format==WIOTP_FMT_GORILLA) {
+		wiotp_gorilla_append(&gorilla,block,ts_us/1000,value);
+	} else {
+		values[n_samples]=value;
+	}
+	n_samples++;
+	body_len+=len;
+
+	if(n_samples>=max_samples || esp_timer_get_time()-first_sample_us>=max_age_us) {
+		flushed|=flush();
+	}
+	return flushed;
+}
+
+bool WIoTP_Batcher::poll() {
+	if(n_samples>0 && esp_timer_get_time()-first_sample_us>=max_age_us) {
+		return flush();
+	}
+	return false;
+}
+
+bool WIoTP_Batcher::flush() {
+	if(n_samples==0) {
+		return false;
+	}
+
+	size_t len=format==WIOTP_FMT_GORILLA?wiotp_batch_encode_block(payload,field,field_len,block,body_len)
+			:wiotp_batch_encode(payload,format,field,field_len,values,n_samples,body_len);
+	WIoTP_Metrics::record(WIOTP_STAGE_BATCH,esp_timer_get_time()-first_sample_us);
+	int msg_id=publish(payload,len);
+
+	if(msg_id>=0) {
+		stat_messages++;
+		stat_samples+=n_samples;
+		stat_bytes+=len;
+		GW_LOGD(LOG_TAG,"Published %d samples in %d bytes as %s, msg_id=%d",n_samples,len,wiotp_format_name(format),msg_id);
+		GW_LOGD(LOG_TAG,"Totals: %u messages, %u samples, %llu bytes/sample",
+				stat_messages,stat_samples,stat_bytes/stat_samples);
+	} else {
+		GW_LOGW(LOG_TAG,"Failed to publish %d samples in %d bytes, dropped",n_samples,len);
+	}
+
+	body_len=0;
+	n_samples=0;
+	wiotp_gorilla_init(&gorilla);
+	return msg_id>=0;
+}
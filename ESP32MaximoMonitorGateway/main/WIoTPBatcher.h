@@ -0,0 +1,117 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPBatcher.h
+#
+# Batching publisher for WIoTP device events
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPBATCHER_H_
+#define MAIN_WIOTPBATCHER_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "mqtt_client.h"
+}
+
+#include "WIoTPBinary.h"
+#include "WIoTPGorilla.h"
+#include "WIoTPDeadband.h"
+
+/* Encoded size of a batch of field holding no reading */
+size_t wiotp_batch_envelope_len(wiotp_format_t format, size_t field_len);
+
+/* Encoded size of value when appended to a batch holding the n readings of values.
+ * For WIOTP_FMT_GORILLA, whose readings are sized by wiotp_gorilla_bits(), the largest size */
+size_t wiotp_batch_sample_len(wiotp_format_t format, const int32_t* values, size_t n, int32_t value);
+
+/* Render a batch of n readings into payload, body_len being the sum of their sample lengths.
+ * Returns the payload length, the payload being zero terminated */
+size_t wiotp_batch_encode(char* payload, wiotp_format_t format, const char* field, size_t field_len,
+		const int32_t* values, size_t n, size_t body_len);
+
+/* Render a batch held as a compressed block of len bytes into a WIOTP_FMT_GORILLA payload */
+size_t wiotp_batch_encode_block(char* payload, const char* field, size_t field_len, const uint8_t* block, size_t len);
+
+/**
+ * Collects readings of one event type and publishes them as a single QoS 1 message,
+ * either as JSON {"d":{"<field>":[v1,v2,...]}} or as CBOR {"d":{"<field>":h'...'}}
+ * where the byte string holds the readings as zigzag varint deltas (see wiotp_delta_pack()),
+ * or, for WIOTP_FMT_GORILLA, the timestamped readings as a compressed block written as they are added.
+ * The batch is flushed when the next sample would not fit in max_bytes,
+ * when max_samples readings are held, or when the oldest reading, aged from the time
+ * it was taken, is older than max_age_ms, whichever comes first.
+ * Messages and samples are counted once published, or spooled by the publish() of a subclass.
+ * With a deadband, only the readings it reports are batched.
+ */
+class WIoTP_Batcher {
+private:
+	const wiotp_format_t format;
+	const char* field;
+	size_t field_len;
+	char* payload;
+	int32_t* values;			// readings of the current batch
+	uint8_t* block;				// compressed block of the current batch, for WIOTP_FMT_GORILLA
+	wiotp_gorilla_t gorilla;
+	const WIoTP_Deadband* deadband = NULL;
+	wiotp_rbe_t channel;
+	const size_t max_bytes;
+	const size_t max_samples;
+	const int64_t max_age_us;
+	size_t envelope_len;		// encoded size of an empty batch
+	size_t body_len;			// encoded size of the readings
+	size_t n_samples;
+	int64_t first_sample_us;	// time the oldest reading of the batch was taken
+
+	// Statistics since creation
+	uint32_t stat_messages = 0;
+	uint32_t stat_samples = 0;
+	uint64_t stat_bytes = 0;
+	uint32_t stat_suppressed = 0;
+
+	size_t sample_len(int32_t value, int64_t ts_us) const;
+
+protected:
+	esp_mqtt_client_handle_t client;
+	const char* topic;
+
+	/* Send one complete payload, returns the MQTT msg_id or -1 */
+	virtual int publish(const char* payload, size_t len);
+
+public:
+	WIoTP_Batcher(esp_mqtt_client_handle_t client, const char* topic, const char* field="temp",
+			wiotp_format_t format=WIOTP_FMT_JSON,
+			size_t max_bytes=CONFIG_GW_BATCH_MAX_BYTES, size_t max_samples=CONFIG_GW_BATCH_MAX_SAMPLES,
+			uint32_t max_age_ms=CONFIG_GW_BATCH_MAX_AGE_MS);
+	virtual ~WIoTP_Batcher();
+
+	/* Only batch the readings reported by the deadband, NULL for all readings */
+	void set_deadband(const WIoTP_Deadband* deadband);
+
+	/* Add a reading taken at ts_us to the batch, flushing as needed. Returns true if a batch was published */
+	bool add(int64_t ts_us, int32_t value);
+
+	/* Flush the batch if its deadline has expired. Returns true if a batch was published */
+	bool poll();
+
+	/* Publish the current batch if it holds any reading */
+	bool flush();
+
+	size_t pending() const { return n_samples; }
+	uint32_t messages() const { return stat_messages; }
+	uint32_t samples() const { return stat_samples; }
+	uint64_t bytes() const { return stat_bytes; }
+	uint32_t suppressed() const { return stat_suppressed; }
+};
+
+#endif /* MAIN_WIOTPBATCHER_H_ */
@@ -0,0 +1,121 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPBinary.h
+#
+# Compact binary payload primitives: CBOR items and delta/varint series
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPBINARY_H_
+#define MAIN_WIOTPBINARY_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+}
+
+/* Payload formats, named as in the fmt/ segment of WIoTP event topics */
+typedef enum {
+	WIOTP_FMT_JSON,
+	WIOTP_FMT_CBOR,
+	WIOTP_FMT_GORILLA,		// CBOR envelope holding a timestamped compressed block (see WIoTPGorilla.h)
+} wiotp_format_t;
+
+static inline const char* wiotp_format_name(wiotp_format_t fmt) {
+	return fmt==WIOTP_FMT_CBOR?"cbor":fmt==WIOTP_FMT_GORILLA?"gorilla":"json";
+}
+
+/* CBOR major types (RFC 7049) */
+#define CBOR_UINT  0
+#define CBOR_NINT  1
+#define CBOR_BYTES 2
+#define CBOR_TEXT  3
+#define CBOR_ARRAY 4
+#define CBOR_MAP   5
+
+/* Write a CBOR item head with its argument, returns the end pointer */
+static inline uint8_t* cbor_head(uint8_t* p, uint8_t major, uint32_t val) {
+	major<<=5;
+	if(val<24) {
+		*p++=major|val;
+	} else if(val<0x100) {
+		*p++=major|24;
+		*p++=val;
+	} else if(val<0x10000) {
+		*p++=major|25;
+		*p++=val>>8;
+		*p++=val;
+	} else {
+		*p++=major|26;
+		*p++=val>>24;
+		*p++=val>>16;
+		*p++=val>>8;
+		*p++=val;
+	}
+	return p;
+}
+
+static inline uint8_t* cbor_int(uint8_t* p, int32_t v) {
+	return v<0?cbor_head(p,CBOR_NINT,(uint32_t)(-1-v)):cbor_head(p,CBOR_UINT,(uint32_t)v);
+}
+
+static inline uint8_t* cbor_text(uint8_t* p, const char* s, size_t len) {
+	p=cbor_head(p,CBOR_TEXT,len);
+	memcpy(p,s,len);
+	return p+len;
+}
+
+/* Map signed deltas to unsigned so that small magnitudes give small values */
+static inline uint32_t wiotp_zigzag(int32_t v) {
+	return ((uint32_t)v<<1)^(uint32_t)(v>>31);
+}
+
+static inline int32_t wiotp_unzigzag(uint32_t u) {
+	return (int32_t)(u>>1)^-(int32_t)(u&1);
+}
+
+/* Number of bytes of the LEB128 varint of u */
+static inline size_t wiotp_varint_len(uint32_t u) {
+	return u<(1u<<7)?1:u<(1u<<14)?2:u<(1u<<21)?3:u<(1u<<28)?4:5;
+}
+
+/* Write u as a LEB128 varint, returns the end pointer */
+static inline uint8_t* wiotp_varint(uint8_t* p, uint32_t u) {
+	while(u>=0x80) {
+		*p++=(uint8_t)(u|0x80);
+		u>>=7;
+	}
+	*p++=(uint8_t)u;
+	return p;
+}
+
+/* Bytes needed to append value after prev to a delta series */
+static inline size_t wiotp_delta_len(int32_t prev, int32_t value) {
+	return wiotp_varint_len(wiotp_zigzag((int32_t)((uint32_t)value-(uint32_t)prev)));
+}
+
+/**
+ * Pack a series as zigzag varints, the first value relative to 0 and each next one relative to
+ * the previous value. Returns the end pointer.
+ * Slowly varying readings pack in one byte each.
+ */
+static inline uint8_t* wiotp_delta_pack(uint8_t* p, const int32_t* values, size_t n) {
+	int32_t prev=0;
+	for(size_t i=0;i<n;i++) {
+		p=wiotp_varint(p,wiotp_zigzag((int32_t)((uint32_t)values[i]-(uint32_t)prev)));
+		prev=values[i];
+	}
+	return p;
+}
+
+#endif /* MAIN_WIOTPBINARY_H_ */
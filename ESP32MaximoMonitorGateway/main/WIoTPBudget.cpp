@@ -0,0 +1,127 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPBudget.cpp
+#
+# Compile-time memory budget of the gateway, with a static arena and high-water marks
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPBudget.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+}
+
+static const char *LOG_TAG="BUDGET";
+
+static_assert(WIOTP_MEM_TOTAL_SIZE<=CONFIG_GW_MEM_BUDGET_KB*1024,"GW_MEM_* regions exceed GW_MEM_BUDGET_KB");
+
+// Allocations are rounded up to keep buffers aligned
+#define BUDGET_ALIGN 8
+#define BUDGET_ROUND(size) (((size)+BUDGET_ALIGN-1)&~(size_t)(BUDGET_ALIGN-1))
+
+const size_t WIoTP_Budget::sizes[WIOTP_MEM_REGIONS]={ CONFIG_GW_MEM_CONFIG_SIZE, CONFIG_GW_MEM_SCRATCH_SIZE,
+		CONFIG_GW_MEM_BATCH_SIZE, WIOTP_MEM_DEVICES_SIZE, CONFIG_GW_MEM_BUFFERS_SIZE, WIOTP_MEM_FEATURES_SIZE,
+		CONFIG_GW_MEM_OUTBOX_SIZE };
+std::atomic<size_t> WIoTP_Budget::used[WIOTP_MEM_REGIONS];
+std::atomic<size_t> WIoTP_Budget::peak[WIOTP_MEM_REGIONS];
+
+#ifdef CONFIG_GW_MEM_STATIC
+static uint8_t arena[WIOTP_MEM_ARENA_SIZE] __attribute__((aligned(BUDGET_ALIGN)));
+
+/* Start of each region in the arena, the outbox having none */
+static uint8_t* region_base(wiotp_mem_t region) {
+	size_t off=0;
+	for(int i=0;i<region;i++) {
+		off+=WIoTP_Budget::budget((wiotp_mem_t)i);
+	}
+	return arena+off;
+}
+#endif
+
+const char* WIoTP_Budget::region_name(wiotp_mem_t region) {
+	static const char* names[WIOTP_MEM_REGIONS]={ "config", "scratch", "batch", "devices", "buffers", "features", "outbox" };
+	return names[region];
+}
+
+void WIoTP_Budget::account(wiotp_mem_t region, size_t total) {
+	size_t p=peak[region].load(std::memory_order_relaxed);
+	while(total>p && !peak[region].compare_exchange_weak(p,total,std::memory_order_relaxed));
+}
+
+void* WIoTP_Budget::alloc(wiotp_mem_t region, size_t size) {
+	size=BUDGET_ROUND(size);
+	size_t off=used[region].fetch_add(size,std::memory_order_relaxed);
+	if(off+size>sizes[region]) {
+		ESP_LOGE(LOG_TAG,"Region %s exceeded: %u bytes requested, %u of %u used, raise its GW_MEM_*_SIZE",
+				region_name(region),size,off,sizes[region]);
+		abort();
+	}
+	account(region,off+size);
+#ifdef CONFIG_GW_MEM_STATIC
+	void* p=region_base(region)+off;
+	// Scratch buffers may have been used before
+	memset(p,0,size);
+#else
+	void* p=calloc(1,size);
+	if(p==NULL) {
+		abort();
+	}
+#endif
+	return p;
+}
+
+void WIoTP_Budget::release(wiotp_mem_t region, void* p, size_t size) {
+	if(p==NULL) {
+		return;
+	}
+	size=BUDGET_ROUND(size);
+#ifdef CONFIG_GW_MEM_STATIC
+	// Only the top of the region can be given back
+	size_t top=(uint8_t*)p-region_base(region)+size;
+	used[region].compare_exchange_strong(top,top-size,std::memory_order_relaxed);
+#else
+	free(p);
+	used[region].fetch_sub(size,std::memory_order_relaxed);
+#endif
+}
+
+bool WIoTP_Budget::reserve(wiotp_mem_t region, size_t size) {
+	size_t u=used[region].load(std::memory_order_relaxed);
+	do {
+		if(u+size>sizes[region]) {
+			return false;
+		}
+	} while(!used[region].compare_exchange_weak(u,u+size,std::memory_order_relaxed));
+	account(region,u+size);
+	return true;
+}
+
+void WIoTP_Budget::unreserve(wiotp_mem_t region, size_t size) {
+	used[region].fetch_sub(size,std::memory_order_relaxed);
+}
+
+void WIoTP_Budget::log() {
+	size_t total=0;
+	for(int i=0;i<WIOTP_MEM_REGIONS;i++) {
+		wiotp_mem_t region=(wiotp_mem_t)i;
+		ESP_LOGI(LOG_TAG,"%-8s %6u used, %6u high water of %6u",region_name(region),in_use(region),high_water(region),sizes[region]);
+		total+=high_water(region);
+	}
+#ifdef CONFIG_GW_MEM_STATIC
+	ESP_LOGI(LOG_TAG,"High water %u of %u bytes, arena of %u bytes",total,WIOTP_MEM_TOTAL_SIZE,WIOTP_MEM_ARENA_SIZE);
+#else
+	ESP_LOGI(LOG_TAG,"High water %u of %u bytes, from the heap",total,WIOTP_MEM_TOTAL_SIZE);
+#endif
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPBudget.h
+#
+# Compile-time memory budget of the gateway, with a static arena and high-water marks
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPBUDGET_H_
+#define MAIN_WIOTPBUDGET_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+}
+
+#include <atomic>
+
+/* Regions of the memory budget */
+typedef enum {
+	WIOTP_MEM_CONFIG,		// configuration arena and boot-time strings
+	WIOTP_MEM_SCRATCH,		// temporary buffers, released in reverse order of allocation
+	WIOTP_MEM_BATCH,		// batch payloads and readings, or aggregation panes
+	WIOTP_MEM_DEVICES,		// registry and batches of the downstream devices
+	WIOTP_MEM_BUFFERS,		// offline queue record, command buffers, in-flight table
+	WIOTP_MEM_FEATURES,		// blocks and tables of the edge analytics
+	WIOTP_MEM_OUTBOX,		// QoS 1 messages held by the MQTT client outbox, accounted only
+	WIOTP_MEM_REGIONS
+} wiotp_mem_t;
+
+#ifdef CONFIG_GW_FANIN_ENABLE
+#define WIOTP_MEM_DEVICES_SIZE CONFIG_GW_MEM_DEVICES_SIZE
+#else
+#define WIOTP_MEM_DEVICES_SIZE 0
+#endif
+
+#ifdef CONFIG_GW_FEAT_ENABLE
+#define WIOTP_MEM_FEATURES_SIZE CONFIG_GW_MEM_FEATURES_SIZE
+#else
+#define WIOTP_MEM_FEATURES_SIZE 0
+#endif
+
+/* Regions allocated from the arena, then the whole budget, the outbox included */
+#define WIOTP_MEM_ARENA_SIZE (CONFIG_GW_MEM_CONFIG_SIZE+CONFIG_GW_MEM_SCRATCH_SIZE+CONFIG_GW_MEM_BATCH_SIZE \
+		+WIOTP_MEM_DEVICES_SIZE+CONFIG_GW_MEM_BUFFERS_SIZE+WIOTP_MEM_FEATURES_SIZE)
+#define WIOTP_MEM_TOTAL_SIZE (WIOTP_MEM_ARENA_SIZE+CONFIG_GW_MEM_OUTBOX_SIZE)
+
+/**
+ * Memory budget of the gateway, a table of regions whose sizes are fixed at compile time and whose
+ * total is checked against GW_MEM_BUDGET_KB by the compiler.
+ * Components allocate their buffers once, when created, from the region they belong to. With
+ * GW_MEM_STATIC, regions are carved out of one static arena and allocation is a bump of the region,
+ * so the footprint of the gateway is known from the link map and does not depend on the heap.
+ * Otherwise allocations come from the heap and are only accounted.
+ * Either way, an allocation beyond the budget of its region is logged and aborts at once, rather
+ * than failing later under load. Arena memory is not reused, but for the last allocation of a
+ * region: objects are expected to live as long as the gateway, temporary buffers are taken
+ * from WIOTP_MEM_SCRATCH.
+ * The outbox region is only accounted, by reserve() and unreserve(), its messages being allocated by
+ * the MQTT client.
+ * Usage and high-water marks of each region are reported by log() and in the metrics event.
+ */
+class WIoTP_Budget {
+private:
+	static const size_t sizes[WIOTP_MEM_REGIONS];
+	static std::atomic<size_t> used[WIOTP_MEM_REGIONS];
+	static std::atomic<size_t> peak[WIOTP_MEM_REGIONS];
+
+	static void account(wiotp_mem_t region, size_t total);
+
+public:
+	/* Zeroed buffer of size bytes from the region. Aborts if the region is exceeded */
+	static void* alloc(wiotp_mem_t region, size_t size);
+
+	/* Give back a buffer of the region. With GW_MEM_STATIC, only the last allocation of a region is reused */
+	static void release(wiotp_mem_t region, void* p, size_t size);
+
+	/* Account size bytes allocated elsewhere, returns false if the region would be exceeded */
+	static bool reserve(wiotp_mem_t region, size_t size);
+	static void unreserve(wiotp_mem_t region, size_t size);
+
+	/* Log the usage and high-water mark of each region */
+	static void log();
+
+	static size_t budget(wiotp_mem_t region) { return sizes[region]; }
+	static size_t in_use(wiotp_mem_t region) { return used[region].load(std::memory_order_relaxed); }
+	static size_t high_water(wiotp_mem_t region) { return peak[region].load(std::memory_order_relaxed); }
+	static const char* region_name(wiotp_mem_t region);
+};
+
+#endif /* MAIN_WIOTPBUDGET_H_ */
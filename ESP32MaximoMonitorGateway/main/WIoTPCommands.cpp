@@ -0,0 +1,244 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPCommands.cpp
+#
+# Routing of WIoTP device commands to their handlers
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPCommands.h"
+#include "WIoTPBudget.h"
+#include "ESP32Log.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+}
+
+static const char *LOG_TAG="COMMANDS";
+
+bool wiotp_command_parse(const char* topic, size_t topic_len, wiotp_command_t* cmd) {
+	// Segments 2, 4, 6 and 8 of iot-2/type/<type>/id/<id>/cmd/<command>/fmt/<format>
+	static const char* const fixed[]={ "iot-2", "type", NULL, "id", NULL, "cmd", NULL, "fmt", NULL };
+	const char* values[4];
+	size_t lens[4];
+	const char* p=topic;
+	const char* end=topic+topic_len;
+	for(size_t i=0;i<sizeof(fixed)/sizeof(fixed[0]);i++) {
+		if(p>end) {
+			return false;
+		}
+		const char* seg_end=(const char*)memchr(p,'/',end-p);
+		if(seg_end==NULL) {
+			seg_end=end;
+		}
+		size_t len=seg_end-p;
+		if(fixed[i]!=NULL) {
+			if(len!=strlen(fixed[i]) || memcmp(p,fixed[i],len)!=0) {
+				return false;
+			}
+		} else {
+			if(len==0 || len>UINT8_MAX) {
+				return false;
+			}
+			values[i/2-1]=p;
+			lens[i/2-1]=len;
+		}
+		p=seg_end+1;
+	}
+	if(p<=end) {
+		// More segments
+		return false;
+	}
+	cmd->type=values[0];
+	cmd->type_len=lens[0];
+	cmd->id=values[1];
+	cmd->id_len=lens[1];
+	cmd->command=values[2];
+	cmd->command_len=lens[2];
+	cmd->format=values[3];
+	cmd->format_len=lens[3];
+	return true;
+}
+
+WIoTP_CommandBuffer::WIoTP_CommandBuffer(size_t max_len) : max_len(max_len) {
+	buf=(char*)WIoTP_Budget::alloc(WIOTP_MEM_BUFFERS,max_len+1);
+}
+
+WIoTP_CommandBuffer::~WIoTP_CommandBuffer() {
+	WIoTP_Budget::release(WIOTP_MEM_BUFFERS,buf,max_len+1);
+}
+
+bool WIoTP_CommandBuffer::begin(const wiotp_command_t& cmd, size_t total_len) {
+	if(total_len>max_len) {
+		GW_LOGW(LOG_TAG,"Command %.*s of %d bytes exceeds %d bytes",cmd.command_len,cmd.command,total_len,max_len);
+		return false;
+	}
+	len=0;
+	return true;
+}
+
+void WIoTP_CommandBuffer::data(const char* data, size_t len, size_t offset) {
+	memcpy(buf+offset,data,len);
+	this->len=offset+len;
+}
+
+void WIoTP_CommandBuffer::end() {
+	buf[len]='\0';
+	command(buf,len);
+}
+
+WIoTP_CommandRouter::WIoTP_CommandRouter() : n_nodes(1) {
+	// Root of the trie, before the first segment
+	memset(nodes,0,sizeof(nodes));
+	nodes[0].child=-1;
+	nodes[0].sibling=-1;
+}
+
+bool WIoTP_CommandRouter::route(const char* filter, WIoTP_CommandHandler* handler) {
+	int node=0;
+	const char* seg=filter;
+	while(true) {
+		const char* seg_end=strchr(seg,'/');
+		if(seg_end==NULL) {
+			seg_end=seg+strlen(seg);
+		}
+		size_t seg_len=seg_end-seg;
+		char wildcard=0;
+		if(seg_len==1 && (*seg=='+' || *seg=='#')) {
+			wildcard=*seg;
+		}
+		if((wildcard=='#' && *seg_end!='\0') || seg_len>UINT8_MAX) {
+			ESP_LOGE(LOG_TAG,"Invalid command filter %s",filter);
+			return false;
+		}
+
+		// Children are kept in matching order: literal segments, then '+', then '#'
+		int8_t* link=&nodes[node].child;
+		int child=-1;
+		for(int c=nodes[node].child;c>=0;c=nodes[c].sibling) {
+			if(nodes[c].wildcard==wildcard && (wildcard!=0 || (nodes[c].seg_len==seg_len && memcmp(nodes[c].seg,seg,seg_len)==0))) {
+				child=c;
+				break;
+			}
+		}
+		if(child<0) {
+			if(n_nodes>=WIOTP_ROUTER_MAX_NODES) {
+				ESP_LOGE(LOG_TAG,"No room left for command filter %s",filter);
+				return false;
+			}
+			child=n_nodes++;
+			route_node_t& n=nodes[child];
+			n.seg=seg;
+			n.seg_len=seg_len;
+			n.wildcard=wildcard;
+			n.child=-1;
+			n.handler=NULL;
+			// Insert before the first sibling matched after this one
+			int rank=wildcard==0?0:wildcard=='+'?1:2;
+			for(int c=*link;c>=0;c=nodes[c].sibling) {
+				int c_rank=nodes[c].wildcard==0?0:nodes[c].wildcard=='+'?1:2;
+				if(c_rank>rank) {
+					break;
+				}
+				link=&nodes[c].sibling;
+			}
+			n.sibling=*link;
+			*link=child;
+		}
+		node=child;
+
+		if(*seg_end=='\0') {
+			break;
+		}
+		seg=seg_end+1;
+	}
+	nodes[node].handler=handler;
+	return true;
+}
+
+WIoTP_CommandHandler* WIoTP_CommandRouter::match(int node, const char* seg, const char* end) const {
+	const char* seg_end=(const char*)memchr(seg,'/',end-seg);
+	if(seg_end==NULL) {
+		seg_end=end;
+	}
+	for(int c=nodes[node].child;c>=0;c=nodes[c].sibling) {
+		const route_node_t& n=nodes[c];
+		if(n.wildcard=='#') {
+			return n.handler;
+		}
+		if(n.wildcard==0 && (n.seg_len!=seg_end-seg || memcmp(n.seg,seg,n.seg_len)!=0)) {
+			continue;
+		}
+		if(seg_end==end) {
+			if(n.handler!=NULL) {
+				return n.handler;
+			}
+			continue;
+		}
+		// Backtrack to the next sibling if the rest of the topic does not match below this one
+		WIoTP_CommandHandler* handler=match(c,seg_end+1,end);
+		if(handler!=NULL) {
+			return handler;
+		}
+	}
+	return NULL;
+}
+
+WIoTP_CommandHandler* WIoTP_CommandRouter::find(const char* topic, size_t topic_len) const {
+	return match(0,topic,topic+topic_len);
+}
+
+bool WIoTP_CommandRouter::dispatch(esp_mqtt_event_handle_t event) {
+	size_t offset=event->current_data_offset;
+	if(offset==0) {
+		// First fragment, the only one with the topic
+		if(current!=NULL) {
+			GW_LOGW(LOG_TAG,"Command interrupted at %d/%d bytes",next_offset,total_len);
+			current->cancel();
+			current=NULL;
+		}
+		wiotp_command_t cmd;
+		WIoTP_CommandHandler* handler=find(event->topic,event->topic_len);
+		if(handler==NULL || !wiotp_command_parse(event->topic,event->topic_len,&cmd)) {
+			stat_unrouted++;
+			GW_LOGW(LOG_TAG,"No handler for %.*s",event->topic_len,event->topic);
+			return false;
+		}
+		stat_commands++;
+		if(!handler->begin(cmd,event->total_data_len)) {
+			return true;
+		}
+		current=handler;
+		next_offset=0;
+		total_len=event->total_data_len;
+	} else if(current==NULL) {
+		// Rest of an ignored command
+		return false;
+	}
+
+	if(offset!=next_offset) {
+		GW_LOGW(LOG_TAG,"Command fragment at %d lost, expected %d",offset,next_offset);
+		current->cancel();
+		current=NULL;
+		return false;
+	}
+	current->data(event->data,event->data_len,offset);
+	next_offset+=event->data_len;
+	if(next_offset>=total_len) {
+		current->end();
+		current=NULL;
+	}
+	return true;
+}
@@ -0,0 +1,141 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPCommands.h
+#
+# Routing of WIoTP device commands to their handlers
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPCOMMANDS_H_
+#define MAIN_WIOTPCOMMANDS_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "mqtt_client.h"
+}
+
+/* Commands of all the devices of the gateway, and of the gateway itself */
+#define WIOTP_COMMAND_FILTER "iot-2/type/+/id/+/cmd/+/fmt/+"
+
+#define WIOTP_ROUTER_MAX_NODES 32
+
+/* Segments of a command topic iot-2/type/<type>/id/<id>/cmd/<command>/fmt/<format>,
+ * pointing into the topic of the MQTT event, not zero terminated */
+typedef struct {
+	const char* type;
+	const char* id;
+	const char* command;
+	const char* format;
+	uint8_t type_len;
+	uint8_t id_len;
+	uint8_t command_len;
+	uint8_t format_len;
+} wiotp_command_t;
+
+/**
+ * Receives the payload of a command, which may come in several fragments when it is larger than the
+ * MQTT client buffer. Handlers run in the MQTT client task.
+ */
+class WIoTP_CommandHandler {
+public:
+	virtual ~WIoTP_CommandHandler() {}
+
+	/* A command of total_len bytes starts. cmd is only valid during this call.
+	 * Returns false to ignore the command */
+	virtual bool begin(const wiotp_command_t& cmd, size_t total_len) { return true; }
+
+	/* Next fragment of the payload, at offset */
+	virtual void data(const char* data, size_t len, size_t offset) = 0;
+
+	/* The whole payload was received */
+	virtual void end() {}
+
+	/* A fragment was lost, or another command started before the end of this one */
+	virtual void cancel() {}
+};
+
+/**
+ * Handler of short commands, whose payload is gathered into a buffer of max_len bytes.
+ * Longer commands are ignored.
+ */
+class WIoTP_CommandBuffer : public WIoTP_CommandHandler {
+private:
+	char* buf;
+	const size_t max_len;
+	size_t len = 0;
+
+protected:
+	/* Handle the complete, zero terminated, payload */
+	virtual void command(const char* payload, size_t len) = 0;
+
+public:
+	WIoTP_CommandBuffer(size_t max_len=256);
+	virtual ~WIoTP_CommandBuffer();
+
+	virtual bool begin(const wiotp_command_t& cmd, size_t total_len);
+	virtual void data(const char* data, size_t len, size_t offset);
+	virtual void end();
+};
+
+/**
+ * Dispatches MQTT_EVENT_DATA events of command topics to handlers, through a trie of topic segments
+ * built from the topic filters of the routes, such as "iot-2/type/+/id/+/cmd/rate/fmt/+".
+ * The event topic is matched in place, literal segments being preferred to '+' and '#' wildcards.
+ * The fragments following the first one of a payload, which carry no topic, go to the same handler.
+ * Routes are all added before the MQTT client is started.
+ */
+class WIoTP_CommandRouter {
+private:
+	typedef struct {
+		const char* seg;			// literal segment, in the topic filter of the route
+		uint8_t seg_len;
+		char wildcard;				// '+', '#' or 0 for a literal segment
+		int8_t child;				// first child node, -1 if none
+		int8_t sibling;				// next sibling node, -1 if none
+		WIoTP_CommandHandler* handler;	// set on the last segment of a route
+	} route_node_t;
+
+	route_node_t nodes[WIOTP_ROUTER_MAX_NODES];
+	size_t n_nodes;
+
+	// Command whose payload is being received
+	WIoTP_CommandHandler* current = NULL;
+	size_t next_offset = 0;
+	size_t total_len = 0;
+
+	uint32_t stat_commands = 0;
+	uint32_t stat_unrouted = 0;
+
+	WIoTP_CommandHandler* match(int node, const char* seg, const char* end) const;
+
+public:
+	WIoTP_CommandRouter();
+
+	/* Route the commands matching a topic filter to handler. filter must stay valid.
+	 * Returns false if it does not fit in the trie */
+	bool route(const char* filter, WIoTP_CommandHandler* handler);
+
+	/* Handler of a topic, NULL if none */
+	WIoTP_CommandHandler* find(const char* topic, size_t topic_len) const;
+
+	/* Dispatch a MQTT_EVENT_DATA event, returns false if it was not routed */
+	bool dispatch(esp_mqtt_event_handle_t event);
+
+	uint32_t commands() const { return stat_commands; }
+	uint32_t unrouted() const { return stat_unrouted; }
+};
+
+/* Split a command topic into its segments, returns false if it is not a command topic */
+bool wiotp_command_parse(const char* topic, size_t topic_len, wiotp_command_t* cmd);
+
+#endif /* MAIN_WIOTPCOMMANDS_H_ */
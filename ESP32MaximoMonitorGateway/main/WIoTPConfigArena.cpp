@@ -0,0 +1,159 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPConfigArena.cpp
+#
+# Parsing of key=value configuration into a single lookup arena
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPConfigArena.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+}
+
+#define CONFIG_ARENA_MAGIC 0x47574346
+
+/* Arena header, followed by n_slots slots and the zero-terminated keys and values */
+typedef struct {
+	uint32_t magic;
+	uint16_t n_slots;
+	uint16_t size;
+} config_arena_hdr_t;
+
+/* Hash table slot, hash 0 marking an empty slot. Offsets are relative to the arena */
+typedef struct {
+	uint32_t hash;
+	uint16_t key_off;
+	uint16_t val_off;
+} config_slot_t;
+
+uint32_t wiotp_fnv1a(uint32_t h, const void* data, size_t len) {
+	const uint8_t* p=(const uint8_t*)data;
+	for(size_t i=0;i<len;i++) {
+		h=(h^p[i])*16777619u;
+	}
+	return h;
+}
+
+static uint32_t key_hash(const char* key) {
+	uint32_t h=wiotp_fnv1a(WIOTP_FNV_OFFSET,key,strlen(key));
+	return h!=0?h:1;
+}
+
+/* Trim blanks around [*start,*end) */
+static void trim(const char** start, const char** end) {
+	while(*start<*end && (**start==' ' || **start=='\t')) (*start)++;
+	while(*end>*start && ((*end)[-1]==' ' || (*end)[-1]=='\t' || (*end)[-1]=='\r')) (*end)--;
+}
+
+/* Call f(key,key_len,value,value_len) for each key=value line of blob */
+template<typename F> static void for_each_entry(const char* blob, size_t len, F f) {
+	const char* end=blob+len;
+	for(const char* line=blob;line<end;) {
+		const char* eol=(const char*)memchr(line,'\n',end-line);
+		if(eol==NULL) eol=end;
+		const char* eq=(const char*)memchr(line,'=',eol-line);
+		if(eq!=NULL && *line!='#') {
+			const char *k=line, *k_end=eq, *v=eq+1, *v_end=eol;
+			trim(&k,&k_end);
+			trim(&v,&v_end);
+			if(k<k_end) {
+				f(k,k_end-k,v,v_end-v);
+			}
+		}
+		line=eol+1;
+	}
+}
+
+/* Slots of the table for n_entries, a power of two at most half full */
+static uint16_t slots_for(size_t n_entries) {
+	uint16_t n_slots=8;
+	while(n_slots<2*n_entries) n_slots<<=1;
+	return n_slots;
+}
+
+size_t wiotp_config_size(const char* blob, size_t len) {
+	size_t n_entries=0, strings_len=0;
+	for_each_entry(blob,len,[&](const char*, size_t key_len, const char*, size_t val_len) {
+		n_entries++;
+		strings_len+=key_len+1+val_len+1;
+	});
+	return sizeof(config_arena_hdr_t)+slots_for(n_entries)*sizeof(config_slot_t)+strings_len;
+}
+
+void wiotp_config_build(const char* blob, size_t len, uint8_t* arena, size_t size) {
+	size_t n_entries=0;
+	for_each_entry(blob,len,[&](const char*, size_t, const char*, size_t) {
+		n_entries++;
+	});
+	uint16_t n_slots=slots_for(n_entries);
+	config_arena_hdr_t* hdr=(config_arena_hdr_t*)arena;
+	hdr->magic=CONFIG_ARENA_MAGIC;
+	hdr->n_slots=n_slots;
+	hdr->size=size;
+
+	// Copy the strings and fill the table, a repeated key overriding the previous value
+	config_slot_t* slots=(config_slot_t*)(hdr+1);
+	size_t off=sizeof(config_arena_hdr_t)+n_slots*sizeof(config_slot_t);
+	for_each_entry(blob,len,[&](const char* key, size_t key_len, const char* val, size_t val_len) {
+		char* k=(char*)arena+off;
+		memcpy(k,key,key_len);
+		k[key_len]='\0';
+		char* v=k+key_len+1;
+		memcpy(v,val,val_len);
+		v[val_len]='\0';
+
+		uint32_t h=key_hash(k);
+		uint16_t i=h&(n_slots-1);
+		while(slots[i].hash!=0 && !(slots[i].hash==h && strcmp((char*)arena+slots[i].key_off,k)==0)) {
+			i=(i+1)&(n_slots-1);
+		}
+		slots[i].hash=h;
+		slots[i].key_off=off;
+		slots[i].val_off=off+key_len+1;
+		off+=key_len+1+val_len+1;
+	});
+}
+
+uint8_t* wiotp_config_parse(const char* blob, size_t len, size_t* size) {
+	*size=wiotp_config_size(blob,len);
+	if(*size>UINT16_MAX) {
+		return NULL;
+	}
+	uint8_t* arena=(uint8_t*)calloc(1,*size);
+	if(arena==NULL) {
+		return NULL;
+	}
+	wiotp_config_build(blob,len,arena,*size);
+	return arena;
+}
+
+bool wiotp_config_check(const uint8_t* arena, size_t size) {
+	const config_arena_hdr_t* hdr=(const config_arena_hdr_t*)arena;
+	return size>=sizeof(config_arena_hdr_t) && hdr->magic==CONFIG_ARENA_MAGIC && hdr->size==size
+			&& hdr->n_slots>0 && (hdr->n_slots&(hdr->n_slots-1))==0
+			&& sizeof(config_arena_hdr_t)+hdr->n_slots*sizeof(config_slot_t)<=size;
+}
+
+const char* wiotp_config_get(const uint8_t* arena, const char* key) {
+	const config_arena_hdr_t* hdr=(const config_arena_hdr_t*)arena;
+	const config_slot_t* slots=(const config_slot_t*)(hdr+1);
+	uint32_t h=key_hash(key);
+	for(uint16_t i=h&(hdr->n_slots-1);slots[i].hash!=0;i=(i+1)&(hdr->n_slots-1)) {
+		if(slots[i].hash==h && strcmp((const char*)arena+slots[i].key_off,key)==0) {
+			return (const char*)arena+slots[i].val_off;
+		}
+	}
+	return NULL;
+}
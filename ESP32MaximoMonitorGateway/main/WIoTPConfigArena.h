@@ -0,0 +1,49 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPConfigArena.h
+#
+# Parsing of key=value configuration into a single lookup arena
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPCONFIGARENA_H_
+#define MAIN_WIOTPCONFIGARENA_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+}
+
+#define WIOTP_FNV_OFFSET 2166136261u
+
+/* FNV-1a hash of a buffer, continuing from h (WIOTP_FNV_OFFSET to start) */
+uint32_t wiotp_fnv1a(uint32_t h, const void* data, size_t len);
+
+/* Size of the arena holding the key=value lines of blob, 64 KB at most to be usable */
+size_t wiotp_config_size(const char* blob, size_t len);
+
+/* Fill a zeroed arena of the size returned by wiotp_config_size() with the entries of blob */
+void wiotp_config_build(const char* blob, size_t len, uint8_t* arena, size_t size);
+
+/* Parse the key=value lines of blob into a malloc'ed arena holding an open-addressing hash table
+ * and the strings. '#' starts a comment line, blanks around keys and values are ignored, and a repeated
+ * key overrides the previous value.
+ * Returns the arena and its size, or NULL if it cannot be allocated or exceeds 64 KB */
+uint8_t* wiotp_config_parse(const char* blob, size_t len, size_t* size);
+
+/* Check that a stored arena of size bytes is well formed */
+bool wiotp_config_check(const uint8_t* arena, size_t size);
+
+/* Value of key in the arena, or NULL */
+const char* wiotp_config_get(const uint8_t* arena, const char* key);
+
+#endif /* MAIN_WIOTPCONFIGARENA_H_ */
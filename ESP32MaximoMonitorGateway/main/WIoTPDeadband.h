@@ -0,0 +1,78 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPDeadband.h
+#
+# Report-by-exception filtering of readings, with a deadband and a heartbeat
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPDEADBAND_H_
+#define MAIN_WIOTPDEADBAND_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+}
+
+/* Last reported reading of one channel */
+typedef struct {
+	int32_t value;
+	int64_t ts_us;			// INT64_MIN until the first reading
+} wiotp_rbe_t;
+
+/**
+ * Report-by-exception filter. A reading of a channel is reported when it differs from the last reported
+ * reading of that channel by more than the deadband, or when the channel was silent for max_silent_ms,
+ * as a heartbeat telling the channel is alive and unchanged. Other readings are suppressed.
+ * The filter holds the thresholds of a channel, or of channels of the same unit, and each channel
+ * its own wiotp_rbe_t.
+ */
+class WIoTP_Deadband {
+private:
+	const uint32_t deadband;
+	const int64_t max_silent_us;
+
+public:
+	WIoTP_Deadband(uint32_t deadband, uint32_t max_silent_ms)
+	: deadband(deadband), max_silent_us((int64_t)max_silent_ms*1000) {}
+
+	/* Deadband of channel i in a comma separated list such as "50,5", the last one applying to the following channels */
+	static uint32_t nth(const char* list, size_t i) {
+		uint32_t deadband=0;
+		for(size_t n=0;n<=i && *list!='\0';n++) {
+			char* end;
+			deadband=strtoul(list,&end,10);
+			list=*end==','?end+1:end;
+		}
+		return deadband;
+	}
+
+	/* Reset a channel, so that its next reading is reported */
+	static void reset(wiotp_rbe_t& channel) {
+		channel.value=0;
+		channel.ts_us=INT64_MIN;
+	}
+
+	/* Whether the reading is reported, in which case it becomes the last reported reading of the channel */
+	bool report(wiotp_rbe_t& channel, int32_t value, int64_t ts_us) const {
+		uint32_t change=value>channel.value?(uint32_t)value-(uint32_t)channel.value:(uint32_t)channel.value-(uint32_t)value;
+		if(change<=deadband && channel.ts_us!=INT64_MIN && ts_us-channel.ts_us<max_silent_us) {
+			return false;
+		}
+		channel.value=value;
+		channel.ts_us=ts_us;
+		return true;
+	}
+};
+
+#endif /* MAIN_WIOTPDEADBAND_H_ */
@@ -0,0 +1,257 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPDevices.cpp
+#
+# Registry of the downstream devices of the gateway, with per-device batching
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPDevices.h"
+#include "WIoTPBatcher.h"
+#include "WIoTPBudget.h"
+#include "WIoTPConfigArena.h"
+#include "WIoTPMetrics.h"
+#include "WIoTPTopic.h"
+#include "ESP32Log.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+static const char *LOG_TAG="DEVICES";
+
+// Offset of the type segment in a device topic, the id segment follows "/id/"
+#define TOPIC_TYPE_OFFSET (sizeof("iot-2/type/")-1)
+#define TOPIC_ID_SEP (sizeof("/id/")-1)
+
+/* Device types and ids are made of alphanumerics, '-', '_' and '.' */
+static bool valid_name(const char* name, size_t len) {
+	if(len==0 || len>WIOTP_DEVICE_MAX_NAME) {
+		return false;
+	}
+	for(size_t i=0;i<len;i++) {
+		char c=name[i];
+		if(!isalnum((unsigned char)c) && c!='-' && c!='_' && c!='.') {
+			return false;
+		}
+	}
+	return true;
+}
+
+static uint32_t device_hash(const char* type, size_t type_len, const char* id, size_t id_len) {
+	uint32_t h=wiotp_fnv1a(WIOTP_FNV_OFFSET,type,type_len);
+	h=wiotp_fnv1a(h,"/",1);
+	return wiotp_fnv1a(h,id,id_len);
+}
+
+WIoTP_Devices::WIoTP_Devices(esp_mqtt_client_handle_t client, wiotp_format_t format, const char* event, const char* field,
+		size_t max_devices, size_t max_samples, size_t max_bytes, uint32_t max_age_ms)
+: format(format), event(event), field(field), max_devices(max_devices), max_samples(max_samples), max_bytes(max_bytes),
+  max_age_us((int64_t)max_age_ms*1000), n_devices(0), next_deadline_us(INT64_MAX), stat_rejected(0), client(client) {
+	field_len=strlen(field);
+	envelope_len=wiotp_batch_envelope_len(format,field_len);
+
+	// Table at most half full, so probe sequences stay short
+	uint32_t n_slots=2;
+	while(n_slots<2*max_devices) {
+		n_slots<<=1;
+	}
+	slot_mask=n_slots-1;
+
+	size_t topic_len=wiotp_event_topic(NULL,0,"","",event,wiotp_format_name(format));
+	pool_size=max_devices*(topic_len+WIOTP_DEVICE_AVG_NAMES+1);
+
+	// A compressed block takes the room of the readings, but at least that of its first two readings
+	stride=max_samples;
+	if(format==WIOTP_FMT_GORILLA) {
+		size_t min_stride=(WIOTP_GORILLA_HEADER_LEN+(WIOTP_GORILLA_MAX_BITS+7)/8+sizeof(int32_t)-1)/sizeof(int32_t);
+		if(stride<min_stride) {
+			stride=min_stride;
+		}
+	}
+
+	// Everything is allocated once
+	devices=(wiotp_device_t*)WIoTP_Budget::alloc(WIOTP_MEM_DEVICES,max_devices*sizeof(wiotp_device_t));
+	slots=(uint16_t*)WIoTP_Budget::alloc(WIOTP_MEM_DEVICES,n_slots*sizeof(uint16_t));
+	values=(int32_t*)WIoTP_Budget::alloc(WIOTP_MEM_DEVICES,max_devices*stride*sizeof(int32_t));
+	pool=(char*)WIoTP_Budget::alloc(WIOTP_MEM_DEVICES,pool_size);
+	payload=(char*)WIoTP_Budget::alloc(WIOTP_MEM_DEVICES,max_bytes+1);
+	if(envelope_len+wiotp_batch_sample_len(format,NULL,0,INT32_MIN)>max_bytes) {
+		ESP_LOGE(LOG_TAG,"Batch size %d too small for field %s",max_bytes,field);
+		abort();
+	}
+
+	ESP_LOGI(LOG_TAG,"Registry of %d devices, %u slots, %d bytes",max_devices,n_slots,
+			max_devices*(sizeof(wiotp_device_t)+stride*sizeof(int32_t))+n_slots*sizeof(uint16_t)+pool_size+max_bytes+1);
+}
+
+WIoTP_Devices::~WIoTP_Devices() {
+	WIoTP_Budget::release(WIOTP_MEM_DEVICES,payload,max_bytes+1);
+	WIoTP_Budget::release(WIOTP_MEM_DEVICES,pool,pool_size);
+	WIoTP_Budget::release(WIOTP_MEM_DEVICES,values,max_devices*stride*sizeof(int32_t));
+	WIoTP_Budget::release(WIOTP_MEM_DEVICES,slots,(slot_mask+1)*sizeof(uint16_t));
+	WIoTP_Budget::release(WIOTP_MEM_DEVICES,devices,max_devices*sizeof(wiotp_device_t));
+}
+
+int WIoTP_Devices::publish(const char* topic, const char* payload, size_t len) {
+	// Publish at QOS 1, no retain
+	return esp_mqtt_client_publish(client, topic, payload, len, 1, 0);
+}
+
+int WIoTP_Devices::lookup(const char* type, size_t type_len, const char* id, size_t id_len, bool create) {
+	uint32_t h=device_hash(type,type_len,id,id_len);
+	uint32_t i=h&slot_mask;
+	while(slots[i]!=0) {
+		const wiotp_device_t& d=devices[slots[i]-1];
+		if(d.hash==h && d.type_len==type_len && d.id_len==id_len
+				&& memcmp(d.topic+TOPIC_TYPE_OFFSET,type,type_len)==0
+				&& memcmp(d.topic+TOPIC_TYPE_OFFSET+type_len+TOPIC_ID_SEP,id,id_len)==0) {
+			return slots[i]-1;
+		}
+		i=(i+1)&slot_mask;
+	}
+	if(!create) {
+		return -1;
+	}
+
+	// Register the device in the free slot ending the probe sequence
+	uint32_t index=n_devices.load(std::memory_order_relaxed);
+	if(!valid_name(type,type_len) || !valid_name(id,id_len) || index>=max_devices) {
+		stat_rejected.fetch_add(1,std::memory_order_relaxed);
+		return -1;
+	}
+	char type_name[WIOTP_DEVICE_MAX_NAME+1], id_name[WIOTP_DEVICE_MAX_NAME+1];
+	memcpy(type_name,type,type_len);
+	type_name[type_len]='\0';
+	memcpy(id_name,id,id_len);
+	id_name[id_len]='\0';
+	size_t len=wiotp_event_topic(pool+pool_used,pool_size-pool_used,type_name,id_name,event,wiotp_format_name(format));
+	if(pool_used+len>=pool_size) {
+		ESP_LOGW(LOG_TAG,"No room left for the topic of %s/%s",type_name,id_name);
+		stat_rejected.fetch_add(1,std::memory_order_relaxed);
+		return -1;
+	}
+
+	wiotp_device_t& d=devices[index];
+	d.hash=h;
+	d.topic=pool+pool_used;
+	d.type_len=type_len;
+	d.id_len=id_len;
+	d.n_values=0;
+	d.body_len=0;
+	d.readings=0;
+	WIoTP_Deadband::reset(d.rbe);
+	wiotp_gorilla_init(&d.gorilla);
+	pool_used+=len+1;
+	slots[i]=index+1;
+	n_devices.store(index+1,std::memory_order_release);
+
+	ESP_LOGI(LOG_TAG,"Device %s/%s registered (%u/%d)",type_name,id_name,index+1,max_devices);
+	return index;
+}
+
+size_t WIoTP_Devices::sample_len(const wiotp_device_t& d, const int32_t* v, int32_t value, int64_t ts_us) const {
+	if(format==WIOTP_FMT_GORILLA) {
+		// Bytes the block grows by, its last byte being partly used
+		return (d.gorilla.bits+wiotp_gorilla_bits(&d.gorilla,ts_us/1000,value)+7)/8-wiotp_gorilla_len(&d.gorilla);
+	}
+	return wiotp_batch_sample_len(format,v,d.n_values,value);
+}
+
+bool WIoTP_Devices::add(uint32_t index, int64_t ts_us, int32_t value) {
+	wiotp_device_t& d=devices[index];
+	int32_t* v=values+index*stride;
+	d.readings++;
+	if(deadband!=NULL && !deadband->report(d.rbe,value,ts_us)) {
+		stat_suppressed++;
+		WIoTP_Metrics::count(WIOTP_CNT_SUPPRESSED);
+		return false;
+	}
+	bool flushed=false;
+
+	// Flush first if this sample does not fit, in the payload or in the slice of the device
+	size_t len=sample_len(d,v,value,ts_us);
+	if(envelope_len+d.body_len+len>max_bytes || (format==WIOTP_FMT_GORILLA && d.body_len+len>stride*sizeof(int32_t))) {
+		flushed=flush(index);
+		len=sample_len(d,v,value,ts_us);
+	}
+
+	if(d.n_values==0) {
+		d.first_us=ts_us;
+		if(ts_us+max_age_us<next_deadline_us) {
+			next_deadline_us=ts_us+max_age_us;
+		}
+	}
+	if(format==WIOTP_FMT_GORILLA) {
+		wiotp_gorilla_append(&d.gorilla,(uint8_t*)v,ts_us/1000,value);
+	} else {
+		v[d.n_values]=value;
+	}
+	d.n_values++;
+	d.body_len+=len;
+
+	if(d.n_values>=max_samples) {
+		flushed|=flush(index);
+	}
+	return flushed;
+}
+
+size_t WIoTP_Devices::poll(int64_t now) {
+	if(now<next_deadline_us) {
+		return 0;
+	}
+
+	// Flush the expired batches and find the next deadline among the others
+	size_t n=0;
+	next_deadline_us=INT64_MAX;
+	uint32_t count=n_devices.load(std::memory_order_acquire);
+	for(uint32_t i=0;i<count;i++) {
+		const wiotp_device_t& d=devices[i];
+		if(d.n_values==0) {
+			continue;
+		}
+		if(now-d.first_us>=max_age_us) {
+			n+=flush(i)?1:0;
+		} else if(d.first_us+max_age_us<next_deadline_us) {
+			next_deadline_us=d.first_us+max_age_us;
+		}
+	}
+	return n;
+}
+
+bool WIoTP_Devices::flush(uint32_t index) {
+	wiotp_device_t& d=devices[index];
+	if(d.n_values==0) {
+		return false;
+	}
+
+	size_t len=format==WIOTP_FMT_GORILLA?wiotp_batch_encode_block(payload,field,field_len,(const uint8_t*)(values+index*stride),d.body_len)
+			:wiotp_batch_encode(payload,format,field,field_len,values+index*stride,d.n_values,d.body_len);
+	WIoTP_Metrics::record(WIOTP_STAGE_BATCH,esp_timer_get_time()-d.first_us);
+	int msg_id=publish(d.topic,payload,len);
+	if(msg_id>=0) {
+		stat_messages++;
+	}
+	GW_LOGD(LOG_TAG,"Published %d samples of %.*s/%.*s in %d bytes, msg_id=%d",d.n_values,
+			d.type_len,d.topic+TOPIC_TYPE_OFFSET,d.id_len,d.topic+TOPIC_TYPE_OFFSET+d.type_len+TOPIC_ID_SEP,len,msg_id);
+
+	d.body_len=0;
+	d.n_values=0;
+	wiotp_gorilla_init(&d.gorilla);
+	return msg_id>=0;
+}
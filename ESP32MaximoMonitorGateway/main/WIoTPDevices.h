@@ -0,0 +1,133 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPDevices.h
+#
+# Registry of the downstream devices of the gateway, with per-device batching
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPDEVICES_H_
+#define MAIN_WIOTPDEVICES_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "mqtt_client.h"
+}
+
+#include <atomic>
+
+#include "WIoTPBinary.h"
+#include "WIoTPGorilla.h"
+#include "WIoTPDeadband.h"
+
+/* Longest device type or id, as accepted by WIoTP */
+#define WIOTP_DEVICE_MAX_NAME 36
+/* Room kept per device for its type and id in the topic pool */
+#define WIOTP_DEVICE_AVG_NAMES 32
+
+/* A downstream device, and its current batch */
+typedef struct {
+	uint32_t hash;				// FNV-1a of <type>/<id>
+	const char* topic;			// iot-2/type/<type>/id/<id>/evt/<event>/fmt/<format>
+	uint8_t type_len;
+	uint8_t id_len;
+	uint16_t n_values;
+	uint16_t body_len;			// encoded size of the readings
+	int64_t first_us;			// time of the oldest reading of the batch
+	uint32_t readings;
+	wiotp_rbe_t rbe;			// last reported reading
+	wiotp_gorilla_t gorilla;	// compressed block of the batch, for WIOTP_FMT_GORILLA
+} wiotp_device_t;
+
+/**
+ * Devices publishing through the gateway, each batched like WIoTP_Batcher under its own event topic.
+ * Devices are found by <type>/<id> in an open-addressing table with linear probing, holding indexes
+ * into the device array. Each device holds its pre-rendered topic, whose type and id segments serve
+ * as the key, and a fixed slice of a shared array of readings. Devices are never removed: once
+ * max_devices are registered, or the topic pool is exhausted, readings of new devices are rejected.
+ * For WIOTP_FMT_GORILLA, the slice holds the compressed block of the batch, which is also flushed
+ * when the slice is full. With a deadband, each device is a channel of its own.
+ *
+ * lookup() registers devices and may run in another task than the batching side (add(), poll(), flush()):
+ * a device is fully written before the device count is released, and its index is handed over
+ * to the batching side through a SPSC ring.
+ */
+class WIoTP_Devices {
+private:
+	const wiotp_format_t format;
+	const char* event;
+	const char* field;
+	size_t field_len;
+	const size_t max_devices;
+	const size_t max_samples;
+	const size_t max_bytes;
+	const int64_t max_age_us;
+	size_t envelope_len;
+
+	wiotp_device_t* devices;
+	std::atomic<uint32_t> n_devices;
+	uint16_t* slots;			// device index+1, 0 when free
+	uint32_t slot_mask;
+	int32_t* values;			// max_samples readings per device
+	size_t stride;				// readings, or 4 bytes of compressed block, per device
+	const WIoTP_Deadband* deadband = NULL;
+	char* pool;					// topics
+	size_t pool_size;
+	size_t pool_used = 0;
+	char* payload;
+	int64_t next_deadline_us;	// earliest batch deadline, INT64_MAX when no batch is pending
+
+	std::atomic<uint32_t> stat_rejected;
+	uint32_t stat_messages = 0;
+	uint32_t stat_suppressed = 0;
+
+	size_t sample_len(const wiotp_device_t& d, const int32_t* v, int32_t value, int64_t ts_us) const;
+
+protected:
+	esp_mqtt_client_handle_t client;
+
+	/* Send one complete payload, returns the MQTT msg_id or -1 */
+	virtual int publish(const char* topic, const char* payload, size_t len);
+
+public:
+	WIoTP_Devices(esp_mqtt_client_handle_t client, wiotp_format_t format=WIOTP_FMT_JSON,
+			const char* event="data", const char* field="temp",
+			size_t max_devices=CONFIG_GW_FANIN_MAX_DEVICES, size_t max_samples=CONFIG_GW_FANIN_BATCH_SAMPLES,
+			size_t max_bytes=CONFIG_GW_BATCH_MAX_BYTES, uint32_t max_age_ms=CONFIG_GW_BATCH_MAX_AGE_MS);
+	virtual ~WIoTP_Devices();
+
+	/* Index of device <type>/<id>, registered if unknown and create is set.
+	 * Returns -1 if unknown, invalid or if the registry is full */
+	int lookup(const char* type, size_t type_len, const char* id, size_t id_len, bool create=true);
+
+	/* Only batch the readings reported by the deadband, NULL for all readings */
+	void set_deadband(const WIoTP_Deadband* deadband) { this->deadband=deadband; }
+
+	/* Add a reading to the batch of a device, flushing as needed. Returns true if a batch was published */
+	bool add(uint32_t index, int64_t ts_us, int32_t value);
+
+	/* Flush the batches whose deadline has expired, returns the number published */
+	size_t poll(int64_t now);
+
+	/* Publish the current batch of a device if it holds any reading */
+	bool flush(uint32_t index);
+
+	const wiotp_device_t& device(uint32_t index) const { return devices[index]; }
+	uint32_t count() const { return n_devices.load(std::memory_order_acquire); }
+	size_t capacity() const { return max_devices; }
+	uint32_t rejected() const { return stat_rejected.load(std::memory_order_relaxed); }
+	uint32_t messages() const { return stat_messages; }
+	uint32_t suppressed() const { return stat_suppressed; }
+};
+
+#endif /* MAIN_WIOTPDEVICES_H_ */
@@ -0,0 +1,120 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPDsp.h
+#
+# Signal processing kernels of the edge analytics, portable and vectorizable
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPDSP_H_
+#define MAIN_WIOTPDSP_H_
+
+extern "C" {
+#include <stddef.h>
+#include <math.h>
+}
+
+/*
+ * Portable kernels of the edge analytics, on float arrays. Complex arrays are interleaved re,im as the
+ * ESP-DSP kernels take them, so that either can be used on the same buffers. Loops have no data-dependent
+ * branches and their arrays do not alias, so that the compiler vectorizes them where the target allows.
+ */
+
+/* Hann window of n points, symmetric as dsps_wind_hann_f32 */
+static inline void wiotp_dsp_hann(float* w, size_t n) {
+	for(size_t i=0;i<n;i++) {
+		w[i]=0.5f-0.5f*cosf(2*(float)M_PI*i/(n-1));
+	}
+}
+
+/* out[i]=a[i]*b[i] */
+static inline void wiotp_dsp_mul(const float* __restrict a, const float* __restrict b, float* __restrict out, size_t n) {
+	for(size_t i=0;i<n;i++) {
+		out[i]=a[i]*b[i];
+	}
+}
+
+/* Sum of a[i]*b[i] */
+static inline float wiotp_dsp_dotprod(const float* __restrict a, const float* __restrict b, size_t n) {
+	float sum=0;
+	for(size_t i=0;i<n;i++) {
+		sum+=a[i]*b[i];
+	}
+	return sum;
+}
+
+/* Twiddles of an n-point real FFT, e^-2pi.i.k/n for k<n/2, n floats */
+static inline void wiotp_dsp_rfft_init(float* tw, size_t n) {
+	for(size_t k=0;k<n/2;k++) {
+		tw[2*k]=cosf(2*(float)M_PI*k/n);
+		tw[2*k+1]=-sinf(2*(float)M_PI*k/n);
+	}
+}
+
+/* In-place bit reversal permutation of m complex values, m a power of two */
+static inline void wiotp_dsp_bit_rev(float* z, size_t m) {
+	for(size_t i=1, j=0;i<m;i++) {
+		size_t bit=m>>1;
+		for(;j&bit;bit>>=1) {
+			j^=bit;
+		}
+		j|=bit;
+		if(i<j) {
+			float re=z[2*i], im=z[2*i+1];
+			z[2*i]=z[2*j]; z[2*i+1]=z[2*j+1];
+			z[2*j]=re; z[2*j+1]=im;
+		}
+	}
+}
+
+/*
+ * In-place radix-2 decimation in time FFT of m complex values in bit reversed order, m a power of two.
+ * tw holds the twiddles of wiotp_dsp_rfft_init for 2*m points, the m-point ones being every other one.
+ */
+static inline void wiotp_dsp_fft(float* __restrict z, size_t m, const float* __restrict tw) {
+	for(size_t half=1, step=m;half<m;half*=2) {
+		step/=2;
+		for(size_t start=0;start<m;start+=2*half) {
+			float* __restrict a=z+2*start;
+			float* __restrict b=a+2*half;
+			for(size_t k=0;k<half;k++) {
+				float wr=tw[4*k*step], wi=tw[4*k*step+1];
+				float tr=b[2*k]*wr-b[2*k+1]*wi;
+				float ti=b[2*k]*wi+b[2*k+1]*wr;
+				b[2*k]=a[2*k]-tr;
+				b[2*k+1]=a[2*k+1]-ti;
+				a[2*k]+=tr;
+				a[2*k+1]+=ti;
+			}
+		}
+	}
+}
+
+/*
+ * Power spectrum of n real values from the FFT z of the n/2 complex values x[2i]+j.x[2i+1], in natural order:
+ * p[k]=|X[k]|^2 for k=0..n/2, n/2+1 floats. tw holds the twiddles of wiotp_dsp_rfft_init for n points.
+ */
+static inline void wiotp_dsp_rfft_power(const float* __restrict z, size_t n, const float* __restrict tw, float* __restrict p) {
+	size_t m=n/2;
+	p[0]=(z[0]+z[1])*(z[0]+z[1]);
+	p[m]=(z[0]-z[1])*(z[0]-z[1]);
+	for(size_t k=1;k<m;k++) {
+		// Even and odd halves from Z[k] and conj(Z[m-k]), then X[k]=E+W^k.O
+		float er=(z[2*k]+z[2*(m-k)])/2, ei=(z[2*k+1]-z[2*(m-k)+1])/2;
+		float or_=(z[2*k+1]+z[2*(m-k)+1])/2, oi=(z[2*(m-k)]-z[2*k])/2;
+		float xr=er+tw[2*k]*or_-tw[2*k+1]*oi;
+		float xi=ei+tw[2*k]*oi+tw[2*k+1]*or_;
+		p[k]=xr*xr+xi*xi;
+	}
+}
+
+#endif /* MAIN_WIOTPDSP_H_ */
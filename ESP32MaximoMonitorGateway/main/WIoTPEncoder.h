@@ -0,0 +1,182 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPEncoder.h
+#
+# Compile-time specialized WIoTP JSON payload encoder
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPENCODER_H_
+#define MAIN_WIOTPENCODER_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+}
+
+/* Pairs of decimal digits "00".."99" */
+static const char wiotp_digits2[201]=
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/* Write an unsigned value in decimal at p, returns the end pointer. No terminating zero is written */
+static inline char* wiotp_utoa(char* p, uint32_t v) {
+	char tmp[10];
+	char* t=tmp+sizeof(tmp);
+	while(v>=100) {
+		uint32_t r=(v%100)*2;
+		v/=100;
+		*--t=wiotp_digits2[r+1];
+		*--t=wiotp_digits2[r];
+	}
+	if(v>=10) {
+		*--t=wiotp_digits2[v*2+1];
+		*--t=wiotp_digits2[v*2];
+	} else {
+		*--t=(char)('0'+v);
+	}
+	size_t n=tmp+sizeof(tmp)-t;
+	memcpy(p,t,n);
+	return p+n;
+}
+
+/* Write a signed value in decimal at p, returns the end pointer */
+static inline char* wiotp_itoa(char* p, int32_t v) {
+	if(v<0) {
+		*p++='-';
+		return wiotp_utoa(p,0u-(uint32_t)v);
+	}
+	return wiotp_utoa(p,(uint32_t)v);
+}
+
+/* Write a float with a fixed number of decimals (at most 6) at p, returns the end pointer.
+ * Non-finite values and values out of the int32 range are written as null */
+static inline char* wiotp_ftoa(char* p, float v, int decimals) {
+	static const uint32_t scale[]={ 1, 10, 100, 1000, 10000, 100000, 1000000 };
+	if(!(v>-2147483648.0f && v<2147483648.0f)) {
+		memcpy(p,"null",4);
+		return p+4;
+	}
+	bool negative=v<0;
+	if(negative) {
+		v=-v;
+	}
+	uint32_t ipart=(uint32_t)v;
+	uint32_t fpart=(uint32_t)((v-(float)ipart)*scale[decimals]+0.5f);
+	if(fpart>=scale[decimals]) {
+		// Rounding carried into the integer part
+		ipart++;
+		fpart-=scale[decimals];
+	}
+	if(negative && (ipart|fpart)) {
+		*p++='-';
+	}
+	p=wiotp_utoa(p,ipart);
+	if(decimals>0) {
+		*p++='.';
+		// Left-pad the fraction with zeros
+		char* end=p+decimals;
+		for(char* q=end;q>p;fpart/=10) {
+			*--q=(char)('0'+fpart%10);
+		}
+		p=end;
+	}
+	return p;
+}
+
+/**
+ * Declare a payload field: an identifier for the schema, the value type and the JSON key.
+ * Each field knows the largest text it can produce, so that payload buffers are sized at compile time.
+ */
+#define WIOTP_INT_FIELD(ident, key) \
+	struct ident { \
+		typedef int32_t type; \
+		static const char* key_str() { return ",\"" key "\":"; } \
+		enum { key_len=sizeof(",\"" key "\":")-1, max_len=sizeof(",\"" key "\":")-1+11 }; \
+		static char* write(char* p, type v) { return wiotp_itoa(p,v); } \
+	}
+
+#define WIOTP_FLOAT_FIELD(ident, key, decimals) \
+	struct ident { \
+		typedef float type; \
+		static const char* key_str() { return ",\"" key "\":"; } \
+		enum { key_len=sizeof(",\"" key "\":")-1, max_len=sizeof(",\"" key "\":")-1+12+(decimals) }; \
+		static char* write(char* p, type v) { return wiotp_ftoa(p,v,decimals); } \
+	}
+
+template<typename... Fields> struct wiotp_fields_writer;
+template<> struct wiotp_fields_writer<> {
+	static char* write(char* p) { return p; }
+};
+template<typename F, typename... Fields> struct wiotp_fields_writer<F, Fields...> {
+	static char* write(char* p, typename F::type v, typename Fields::type... rest) {
+		memcpy(p,F::key_str(),F::key_len);
+		p=F::write(p+F::key_len,v);
+		return wiotp_fields_writer<Fields...>::write(p,rest...);
+	}
+};
+
+template<typename... Fields> struct wiotp_fields_len;
+template<> struct wiotp_fields_len<> {
+	enum { value=0 };
+};
+template<typename F, typename... Fields> struct wiotp_fields_len<F, Fields...> {
+	enum { value=F::max_len+wiotp_fields_len<Fields...>::value };
+};
+
+/**
+ * Encoder for a {"d":{...}} payload with a schema fixed at compile time.
+ * Usage:
+ *   WIOTP_INT_FIELD(Temp,"temp");
+ *   WIOTP_FLOAT_FIELD(Hum,"hum",1);
+ *   char payload[WIoTP_Encoder<Temp,Hum>::max_len+1];
+ *   size_t len=WIoTP_Encoder<Temp,Hum>::encode(payload,21,48.5f);
+ * No heap, no format parsing: keys are copied as constants and numbers converted in place.
+ */
+template<typename... Fields> class WIoTP_Encoder {
+	static_assert(sizeof...(Fields)>0,"schema needs at least one field");
+
+public:
+	/* Largest payload length, without the terminating zero */
+	enum { max_len=sizeof("{\"d\":{}}")-1+wiotp_fields_len<Fields...>::value };
+
+	/* Encode into a buffer known to be large enough. Returns the payload length */
+	template<size_t N>
+	static size_t encode(char (&buf)[N], typename Fields::type... values) {
+		static_assert(N>max_len,"payload buffer too small for schema");
+		return encode_unchecked(buf,values...);
+	}
+
+	/* Encode into a buffer of buflen bytes. Returns the payload length, or 0 if it may not fit */
+	static size_t encode(char* buf, size_t buflen, typename Fields::type... values) {
+		if(buflen<=max_len) {
+			return 0;
+		}
+		return encode_unchecked(buf,values...);
+	}
+
+	/* Encode into a buffer of at least max_len+1 bytes */
+	static size_t encode_unchecked(char* buf, typename Fields::type... values) {
+		memcpy(buf,"{\"d\":{",6);
+		char* p=wiotp_fields_writer<Fields...>::write(buf+5,values...);
+		// The first key overwrote the opening brace of "d" with its comma, restore it
+		buf[5]='{';
+		*p++='}';
+		*p++='}';
+		*p='\0';
+		return p-buf;
+	}
+};
+
+#endif /* MAIN_WIOTPENCODER_H_ */
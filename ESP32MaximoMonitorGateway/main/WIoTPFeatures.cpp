@@ -0,0 +1,227 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPFeatures.cpp
+#
+# Edge analytics of readings: block features, band energies and anomaly scores
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPFeatures.h"
+#include "WIoTPDsp.h"
+#include "WIoTPEncoder.h"
+#include "WIoTPBudget.h"
+#include "WIoTPMetrics.h"
+#include "ESP32Log.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#ifdef CONFIG_GW_FEAT_ESP_DSP
+#include "esp_dsp.h"
+#endif
+}
+
+static const char *LOG_TAG="FEATURES";
+
+// Largest rendering of a key suffix such as "_score", and of a value
+#define FEAT_MAX_SUFFIX_LEN 7
+#define FEAT_MAX_VALUE_LEN 12
+
+float* WIoTP_Features::window=NULL;
+float* WIoTP_Features::twiddles=NULL;
+size_t WIoTP_Features::table_size=0;
+float WIoTP_Features::window_power=0;
+
+void WIoTP_Features::init_tables(size_t n) {
+	if(table_size==n) {
+		return;
+	}
+	if(table_size!=0) {
+		ESP_LOGE(LOG_TAG,"Blocks of %u readings, where other channels have %u",n,table_size);
+		abort();
+	}
+	window=(float*)WIoTP_Budget::alloc(WIOTP_MEM_FEATURES,n*sizeof(float));
+	twiddles=(float*)WIoTP_Budget::alloc(WIOTP_MEM_FEATURES,n*sizeof(float));
+#ifdef CONFIG_GW_FEAT_ESP_DSP
+	// The FFT tables of ESP-DSP are its own, sized by CONFIG_DSP_MAX_FFT_SIZE
+	if(n/2>CONFIG_DSP_MAX_FFT_SIZE || dsps_fft2r_init_fc32(NULL,CONFIG_DSP_MAX_FFT_SIZE)!=ESP_OK) {
+		ESP_LOGE(LOG_TAG,"Failed to initialise ESP-DSP for blocks of %u readings",n);
+		abort();
+	}
+	dsps_wind_hann_f32(window,n);
+#else
+	wiotp_dsp_hann(window,n);
+#endif
+	// Twiddles of the real FFT split, also those of the portable FFT
+	wiotp_dsp_rfft_init(twiddles,n);
+	window_power=wiotp_dsp_dotprod(window,window,n);
+	table_size=n;
+}
+
+WIoTP_Features::WIoTP_Features(esp_mqtt_client_handle_t client, const char* topic, const char* field,
+		size_t block_size, size_t n_bands, uint32_t alpha_permille, uint32_t warmup, int decimals)
+: field(field), block_size(block_size), n_bands(n_bands), alpha(alpha_permille/1000.0f), warmup(warmup),
+  decimals(decimals), count(0), first_us(0), blocks(0), client(client), topic(topic) {
+	if(block_size<8 || (block_size&(block_size-1))!=0 || n_bands<1 || n_bands>WIOTP_FEAT_MAX_BANDS
+			|| (block_size/2)%n_bands!=0) {
+		ESP_LOGE(LOG_TAG,"%u bands do not split the spectrum of blocks of %u readings",n_bands,block_size);
+		abort();
+	}
+	size_t n_values=5+3*n_bands;
+	if(sizeof("{\"d\":{}}")+n_values*(sizeof(",\"\":")-1+strlen(field)+FEAT_MAX_SUFFIX_LEN+FEAT_MAX_VALUE_LEN+decimals)>sizeof(payload)) {
+		ESP_LOGE(LOG_TAG,"Features of field %s do not fit in %d bytes",field,sizeof(payload));
+		abort();
+	}
+
+	memset(band_mean,0,sizeof(band_mean));
+	memset(band_var,0,sizeof(band_var));
+	init_tables(block_size);
+	block=(float*)WIoTP_Budget::alloc(WIOTP_MEM_FEATURES,block_size*sizeof(float));
+	work=(float*)WIoTP_Budget::alloc(WIOTP_MEM_FEATURES,block_size*sizeof(float));
+	ESP_LOGI(LOG_TAG,"Features of %s over blocks of %u readings in %u bands",field,block_size,n_bands);
+}
+
+WIoTP_Features::~WIoTP_Features() {
+	WIoTP_Budget::release(WIOTP_MEM_FEATURES,work,block_size*sizeof(float));
+	WIoTP_Budget::release(WIOTP_MEM_FEATURES,block,block_size*sizeof(float));
+}
+
+int WIoTP_Features::publish(const char* payload, size_t len) {
+	// Publish at QOS 1, no retain
+	return esp_mqtt_client_publish(client, topic, payload, len, 1, 0);
+}
+
+void WIoTP_Features::add(int64_t ts_us, float value) {
+	if(count==0) {
+		first_us=ts_us;
+	}
+	block[count++]=value;
+	if(count==block_size) {
+		process(ts_us);
+		count=0;
+	}
+}
+
+void WIoTP_Features::process(int64_t last_us) {
+	int64_t start=esp_timer_get_time();
+	const size_t n=block_size, m=block_size/2;
+
+	// Time domain features of the block less its mean
+	float sum=0;
+	for(size_t i=0;i<n;i++) {
+		sum+=block[i];
+	}
+	float mean=sum/n, peak=0;
+	for(size_t i=0;i<n;i++) {
+		block[i]-=mean;
+		peak=fmaxf(peak,fabsf(block[i]));
+	}
+#ifdef CONFIG_GW_FEAT_ESP_DSP
+	float sum_sq;
+	dsps_dotprod_f32(block,block,&sum_sq,n);
+	dsps_mul_f32(block,window,work,n,1,1,1);
+	// The n readings as n/2 complex values: ESP-DSP transforms in natural order, then reorders
+	dsps_fft2r_fc32(work,m);
+	dsps_bit_rev_fc32(work,m);
+#else
+	float sum_sq=wiotp_dsp_dotprod(block,block,n);
+	wiotp_dsp_mul(block,window,work,n);
+	// The n readings as n/2 complex values, reordered then transformed
+	wiotp_dsp_bit_rev(work,m);
+	wiotp_dsp_fft(work,m,twiddles);
+#endif
+	wiotp_dsp_rfft_power(work,n,twiddles,block);
+	float rms=sqrtf(sum_sq/n);
+
+	// One-sided mean square per band, from bin 1 as the mean was removed
+	float bands[WIOTP_FEAT_MAX_BANDS];
+	const float scale=2/(n*window_power);
+	const size_t bins=m/n_bands;
+	for(size_t b=0;b<n_bands;b++) {
+		float energy=0;
+		for(size_t k=b*bins+1;k<=(b+1)*bins;k++) {
+			energy+=block[k];
+		}
+		// The Nyquist bin is not doubled
+		if(b==n_bands-1) {
+			energy-=block[m]/2;
+		}
+		bands[b]=energy*scale;
+	}
+
+	// z-scores against the EWMA of the log energies, then the EWMA is updated. The first blocks weigh
+	// 1/blocks, which keeps the exact mean and variance until the EWMA weight is larger
+	bool scored=blocks>=warmup;
+	float weight=fmaxf(alpha,1.0f/(blocks+1));
+	float z[WIOTP_FEAT_MAX_BANDS], score=0;
+	for(size_t b=0;b<n_bands;b++) {
+		float level=logf(bands[b]+1e-12f);
+		float diff=level-band_mean[b];
+		z[b]=band_var[b]>0?diff/sqrtf(band_var[b]):0;
+		score=fmaxf(score,fabsf(z[b]));
+		band_mean[b]+=weight*diff;
+		band_var[b]=(1-weight)*(band_var[b]+weight*diff*diff);
+	}
+	blocks++;
+	WIoTP_Metrics::record(WIOTP_STAGE_FEATURES,esp_timer_get_time()-start);
+
+	size_t field_len=strlen(field);
+	char* p=payload;
+	memcpy(p,"{\"d\":{",6);
+	p+=6;
+	// Write ,"<field><suffix>": skipping the comma for the first key
+	auto key=[&](const char* suffix, int index) {
+		if(p[-1]!='{') *p++=',';
+		*p++='"';
+		memcpy(p,field,field_len);
+		p+=field_len;
+		size_t len=strlen(suffix);
+		memcpy(p,suffix,len);
+		p+=len;
+		if(index>=0) p=wiotp_utoa(p,index);
+		*p++='"';
+		*p++=':';
+	};
+	key("_mean",-1);
+	p=wiotp_ftoa(p,mean,decimals);
+	key("_rms",-1);
+	p=wiotp_ftoa(p,rms,decimals);
+	key("_peak",-1);
+	p=wiotp_ftoa(p,peak,decimals);
+	key("_crest",-1);
+	p=wiotp_ftoa(p,rms>0?peak/rms:0,decimals);
+	// Band width from the sampling rate measured over the block
+	key("_hz",-1);
+	p=wiotp_ftoa(p,last_us>first_us?(n-1)*1e6f/(last_us-first_us)/2/n_bands:0,decimals);
+	for(size_t b=0;b<n_bands;b++) {
+		key("_b",b);
+		p=wiotp_ftoa(p,bands[b],decimals);
+	}
+	if(scored) {
+		for(size_t b=0;b<n_bands;b++) {
+			key("_z",b);
+			p=wiotp_ftoa(p,z[b],decimals);
+		}
+		key("_score",-1);
+		p=wiotp_ftoa(p,score,decimals);
+	}
+	*p++='}';
+	*p++='}';
+	*p='\0';
+	size_t len=p-payload;
+	int msg_id=publish(payload,len);
+	GW_LOGD(LOG_TAG,"Published features %.*s, msg_id=%d",len,payload,msg_id);
+}
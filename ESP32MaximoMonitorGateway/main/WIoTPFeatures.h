@@ -0,0 +1,86 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPFeatures.h
+#
+# Edge analytics of readings: block features, band energies and anomaly scores
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPFEATURES_H_
+#define MAIN_WIOTPFEATURES_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "mqtt_client.h"
+}
+
+#define WIOTP_FEAT_MAX_BANDS 16
+/* Size of the buffer of a features payload */
+#define WIOTP_FEAT_MAX_LEN 1280
+
+/**
+ * Edge analytics of one channel. Readings are buffered into blocks of block_size, a power of two, and
+ * each full block is published as one features event:
+ * {"d":{"<field>_mean":..,"<field>_rms":..,"<field>_peak":..,"<field>_crest":..,"<field>_hz":..,"<field>_b0":..,"<field>_z0":..,"<field>_score":..}}
+ * rms, peak and crest factor are those of the block less its mean. The spectrum of the Hann windowed block
+ * is split into n_bands bands of _hz each, from 0 to half the sampling rate measured over the block, and
+ * _b<i> is the mean square of the block in band i, so that the bands add up to about rms^2.
+ * Anomalies are scored against an EWMA of the mean and variance of the logarithm of each band energy,
+ * with a weight of alpha_permille per mille for a new block, or 1/n for the n-th block while larger:
+ * _z<i> is the z-score of band i, _score the largest absolute z-score. Scores are published once warmup
+ * blocks have been seen.
+ * Kernels are those of WIoTPDsp.h, or of ESP-DSP with GW_FEAT_ESP_DSP. The window and twiddles are shared
+ * by all channels, which must have the same block size.
+ */
+class WIoTP_Features {
+private:
+	const char* field;
+	const size_t block_size;
+	const size_t n_bands;
+	const float alpha;
+	const uint32_t warmup;
+	const int decimals;
+	float* block;			// readings of the current block, then its power spectrum
+	float* work;			// windowed block, then its FFT
+	size_t count;
+	int64_t first_us;		// time of the first reading of the block
+	uint32_t blocks;		// blocks seen
+	float band_mean[WIOTP_FEAT_MAX_BANDS];	// EWMA of the log band energies
+	float band_var[WIOTP_FEAT_MAX_BANDS];
+	char payload[WIOTP_FEAT_MAX_LEN];
+
+	static float* window;
+	static float* twiddles;
+	static size_t table_size;
+	static float window_power;	// sum of the squared window
+
+	static void init_tables(size_t n);
+	void process(int64_t last_us);
+
+protected:
+	esp_mqtt_client_handle_t client;
+	const char* topic;
+
+	/* Send one complete payload, returns the MQTT msg_id or -1 */
+	virtual int publish(const char* payload, size_t len);
+
+public:
+	WIoTP_Features(esp_mqtt_client_handle_t client, const char* topic, const char* field="temp",
+			size_t block_size=256, size_t n_bands=8, uint32_t alpha_permille=50, uint32_t warmup=20, int decimals=3);
+	virtual ~WIoTP_Features();
+
+	/* Add a reading taken at ts_us, publishing the features of the block it completes */
+	void add(int64_t ts_us, float value);
+};
+
+#endif /* MAIN_WIOTPFEATURES_H_ */
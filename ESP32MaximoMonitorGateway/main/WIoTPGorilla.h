@@ -0,0 +1,299 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPGorilla.h
+#
+# Gorilla-style compressed time series blocks of timestamped readings
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPGORILLA_H_
+#define MAIN_WIOTPGORILLA_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+}
+
+/**
+ * Gorilla-style compressed time series block (Pelkonen et al., "Gorilla: A Fast, Scalable,
+ * In-Memory Time Series Database"), for timestamped int32 readings.
+ * The block is a big-endian bit stream:
+ *   16 bits   number of readings
+ *   64 bits   timestamp of the first reading, in ms
+ *   32 bits   first value
+ * then, for each next reading, its timestamp as the delta of its delta to the previous one
+ * (the delta before the first one being 0):
+ *   '0'                  same delta
+ *   '10'   +  7 bits     delta of delta in [-64,63]
+ *   '110'  +  9 bits     in [-256,255]
+ *   '1110' + 12 bits     in [-2048,2047]
+ *   '1111' + 32 bits     otherwise
+ * and its value XORed with the previous value:
+ *   '0'                  same value
+ *   '10'  + bits         the meaningful bits of the XOR fall in the window of the previous one
+ *   '11'  + 5 bits leading zeros + 5 bits meaningful length-1 + bits
+ * A channel sampled at a steady rate whose value does not change costs 2 bits per reading.
+ */
+
+#define WIOTP_GORILLA_HEADER_BITS (16+64+32)
+#define WIOTP_GORILLA_HEADER_LEN (WIOTP_GORILLA_HEADER_BITS/8)
+/* Largest number of bits of one reading after the first */
+#define WIOTP_GORILLA_MAX_BITS (4+32+2+5+5+32)
+#define WIOTP_GORILLA_MAX_COUNT 0xffff
+
+/* State of a block being written */
+typedef struct {
+	int64_t ts;				// timestamp of the last reading
+	int32_t delta;			// last timestamp delta
+	uint32_t value;			// last value
+	uint16_t count;
+	uint8_t leading;		// window of the last XOR written with its leading zeros, 0xff if none yet
+	uint8_t trailing;
+	uint32_t bits;			// bits written
+} wiotp_gorilla_t;
+
+/* Write the n low bits of v at bit pos of p. Bits are written in sequence: each byte is cleared as it is entered */
+static inline void wiotp_bits_put(uint8_t* p, uint32_t pos, uint32_t v, unsigned n) {
+	while(n>0) {
+		unsigned used=pos&7;
+		unsigned k=n<8-used?n:8-used;
+		uint8_t chunk=(uint8_t)((v>>(n-k))&((1u<<k)-1));
+		uint8_t* b=p+(pos>>3);
+		if(used==0) {
+			*b=0;
+		}
+		*b|=chunk<<(8-used-k);
+		pos+=k;
+		n-=k;
+	}
+}
+
+/* Read n bits at bit pos of p */
+static inline uint32_t wiotp_bits_get(const uint8_t* p, uint32_t pos, unsigned n) {
+	uint32_t v=0;
+	while(n>0) {
+		unsigned used=pos&7;
+		unsigned k=n<8-used?n:8-used;
+		v=(v<<k)|((p[pos>>3]>>(8-used-k))&((1u<<k)-1));
+		pos+=k;
+		n-=k;
+	}
+	return v;
+}
+
+static inline void wiotp_gorilla_init(wiotp_gorilla_t* g) {
+	g->count=0;
+	g->bits=0;
+}
+
+/* Size in bytes of the block */
+static inline size_t wiotp_gorilla_len(const wiotp_gorilla_t* g) {
+	return (g->bits+7)/8;
+}
+
+/* Bits taken by a timestamp delta of delta, by the XOR x of a value */
+static inline unsigned wiotp_gorilla_dod_bits(int64_t dod) {
+	return dod==0?1:(dod>=-64 && dod<=63)?2+7:(dod>=-256 && dod<=255)?3+9:(dod>=-2048 && dod<=2047)?4+12:4+32;
+}
+
+static inline unsigned wiotp_gorilla_xor_bits(const wiotp_gorilla_t* g, uint32_t x) {
+	if(x==0) {
+		return 1;
+	}
+	unsigned leading=__builtin_clz(x), trailing=__builtin_ctz(x);
+	if(g->leading!=0xff && leading>=g->leading && trailing>=g->trailing) {
+		return 2+32-g->leading-g->trailing;
+	}
+	return 2+5+5+32-leading-trailing;
+}
+
+/* Bits added to the block by a reading, 0 if the block cannot take more readings */
+static inline unsigned wiotp_gorilla_bits(const wiotp_gorilla_t* g, int64_t ts, int32_t value) {
+	if(g->count==0) {
+		return WIOTP_GORILLA_HEADER_BITS;
+	}
+	if(g->count==WIOTP_GORILLA_MAX_COUNT) {
+		return 0;
+	}
+	int64_t delta=ts-g->ts;
+	return wiotp_gorilla_dod_bits(delta-g->delta)+wiotp_gorilla_xor_bits(g,(uint32_t)value^g->value);
+}
+
+/* Append a reading, block having room for wiotp_gorilla_bits() more bits.
+ * Timestamps are expected in order, at most 2^31 ms apart */
+static inline void wiotp_gorilla_append(wiotp_gorilla_t* g, uint8_t* block, int64_t ts, int32_t value) {
+	uint32_t pos=g->bits;
+	if(g->count==0) {
+		pos=16;
+		wiotp_bits_put(block,pos,(uint32_t)((uint64_t)ts>>32),32);
+		wiotp_bits_put(block,pos+32,(uint32_t)ts,32);
+		wiotp_bits_put(block,pos+64,(uint32_t)value,32);
+		pos+=96;
+		g->delta=0;
+		g->leading=0xff;
+		g->trailing=0;
+	} else {
+		int32_t delta=(int32_t)(ts-g->ts);
+		int64_t dod=(int64_t)delta-g->delta;
+		if(dod==0) {
+			wiotp_bits_put(block,pos,0,1);
+			pos+=1;
+		} else if(dod>=-64 && dod<=63) {
+			wiotp_bits_put(block,pos,(0x2u<<7)|((uint32_t)dod&0x7f),2+7);
+			pos+=2+7;
+		} else if(dod>=-256 && dod<=255) {
+			wiotp_bits_put(block,pos,(0x6u<<9)|((uint32_t)dod&0x1ff),3+9);
+			pos+=3+9;
+		} else if(dod>=-2048 && dod<=2047) {
+			wiotp_bits_put(block,pos,(0xeu<<12)|((uint32_t)dod&0xfff),4+12);
+			pos+=4+12;
+		} else {
+			wiotp_bits_put(block,pos,0xf,4);
+			wiotp_bits_put(block,pos+4,(uint32_t)dod,32);
+			pos+=4+32;
+		}
+		g->delta=delta;
+
+		uint32_t x=(uint32_t)value^g->value;
+		if(x==0) {
+			wiotp_bits_put(block,pos,0,1);
+			pos+=1;
+		} else {
+			unsigned leading=__builtin_clz(x), trailing=__builtin_ctz(x);
+			if(g->leading!=0xff && leading>=g->leading && trailing>=g->trailing) {
+				// Same window as the previous XOR
+				unsigned len=32-g->leading-g->trailing;
+				wiotp_bits_put(block,pos,0x2,2);
+				wiotp_bits_put(block,pos+2,x>>g->trailing,len);
+				pos+=2+len;
+			} else {
+				unsigned len=32-leading-trailing;
+				wiotp_bits_put(block,pos,(0x3u<<10)|(leading<<5)|(len-1),2+5+5);
+				wiotp_bits_put(block,pos+12,x>>trailing,len);
+				pos+=2+5+5+len;
+				g->leading=leading;
+				g->trailing=trailing;
+			}
+		}
+	}
+	g->ts=ts;
+	g->value=(uint32_t)value;
+	g->count++;
+	g->bits=pos;
+	// The count leads the block, so that it can be read without decoding it
+	block[0]=g->count>>8;
+	block[1]=g->count;
+}
+
+/* State of a block being read */
+typedef struct {
+	const uint8_t* block;
+	uint32_t size_bits;
+	uint32_t pos;
+	uint16_t count;			// readings left
+	uint16_t index;
+	int64_t ts;
+	int32_t delta;
+	uint32_t value;
+	uint8_t leading;
+	uint8_t trailing;
+} wiotp_gorilla_reader_t;
+
+/* Sign-extend the n low bits of v */
+static inline int32_t wiotp_bits_signed(uint32_t v, unsigned n) {
+	return (int32_t)(v<<(32-n))>>(32-n);
+}
+
+/* Read the next n bits of the block, returns false past its end */
+static inline bool wiotp_gorilla_take(wiotp_gorilla_reader_t* r, unsigned n, uint32_t* v) {
+	if(r->pos+n>r->size_bits) {
+		return false;
+	}
+	*v=wiotp_bits_get(r->block,r->pos,n);
+	r->pos+=n;
+	return true;
+}
+
+/* Start reading a block of len bytes, returns its number of readings */
+static inline size_t wiotp_gorilla_open(wiotp_gorilla_reader_t* r, const uint8_t* block, size_t len) {
+	r->block=block;
+	r->size_bits=len*8;
+	r->pos=0;
+	r->index=0;
+	r->count=len<WIOTP_GORILLA_HEADER_LEN?0:(block[0]<<8)|block[1];
+	return r->count;
+}
+
+/* Read the next reading, returns false at the end of the block or if it is truncated */
+static inline bool wiotp_gorilla_next(wiotp_gorilla_reader_t* r, int64_t* ts, int32_t* value) {
+	if(r->index>=r->count) {
+		return false;
+	}
+	uint32_t v, hi, lo;
+	if(r->index==0) {
+		r->pos=16;
+		if(!wiotp_gorilla_take(r,32,&hi) || !wiotp_gorilla_take(r,32,&lo) || !wiotp_gorilla_take(r,32,&r->value)) {
+			return false;
+		}
+		r->ts=(int64_t)(((uint64_t)hi<<32)|lo);
+		r->delta=0;
+		r->leading=0;
+		r->trailing=0;
+	} else {
+		// Delta of delta, its length given by the number of leading ones of its prefix
+		static const unsigned dod_bits[]={ 0, 7, 9, 12, 32 };
+		unsigned prefix=0;
+		while(prefix<4) {
+			if(!wiotp_gorilla_take(r,1,&v)) {
+				return false;
+			}
+			if(v==0) {
+				break;
+			}
+			prefix++;
+		}
+		if(prefix>0) {
+			if(!wiotp_gorilla_take(r,dod_bits[prefix],&v)) {
+				return false;
+			}
+			r->delta+=wiotp_bits_signed(v,dod_bits[prefix]);
+		}
+		r->ts+=r->delta;
+
+		if(!wiotp_gorilla_take(r,1,&v)) {
+			return false;
+		}
+		if(v) {
+			if(!wiotp_gorilla_take(r,1,&v)) {
+				return false;
+			}
+			if(v) {
+				if(!wiotp_gorilla_take(r,10,&v)) {
+					return false;
+				}
+				r->leading=v>>5;
+				r->trailing=32-r->leading-((v&0x1f)+1);
+			}
+			unsigned len=32-r->leading-r->trailing;
+			if(!wiotp_gorilla_take(r,len,&v)) {
+				return false;
+			}
+			r->value^=v<<r->trailing;
+		}
+	}
+	r->index++;
+	*ts=r->ts;
+	*value=(int32_t)r->value;
+	return true;
+}
+
+#endif /* MAIN_WIOTPGORILLA_H_ */
@@ -0,0 +1,114 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPHistory.h
+#
+# Ring of the most recent elements, written by one task and read by any task
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPHISTORY_H_
+#define MAIN_WIOTPHISTORY_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+}
+
+#include <atomic>
+
+/**
+ * Fixed-capacity ring keeping the last N-1 elements written by a single writer task, read by any
+ * number of reader tasks without locks and without ever blocking the writer.
+ * The writer overwrites the oldest element; a reader checks after copying that the writer did not
+ * overtake it, and drops the elements which may have been overwritten meanwhile.
+ * Elements are numbered from 0 as written, indexes run freely and are masked on access, so N
+ * must be a power of two.
+ */
+template<typename T, size_t N> class WIoTP_History {
+	static_assert(N>=2 && (N&(N-1))==0,"history size must be a power of two");
+
+private:
+	T buf[N];
+	std::atomic<uint32_t> head;		// number of elements written
+
+public:
+	WIoTP_History() : head(0) {}
+
+	/* Writer side: append an element, overwriting the oldest one */
+	void push(const T& v) {
+		uint32_t h=head.load(std::memory_order_relaxed);
+		buf[h&(N-1)]=v;
+		head.store(h+1,std::memory_order_release);
+		// The next element must not be seen written before this head
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	/* Index of the next element to be written */
+	uint32_t end() const { return head.load(std::memory_order_acquire); }
+
+	/* Index of the oldest element held */
+	uint32_t begin() const {
+		uint32_t h=end();
+		return h>N-1?h-(N-1):0;
+	}
+
+	/**
+	 * Reader side: copy up to max elements into out, from index *from or from the oldest one held if
+	 * it was overwritten, and advance *from past the elements read.
+	 * Returns the number of elements copied, 0 once *from reaches end()
+	 */
+	size_t read(uint32_t* from, T* out, size_t max) const {
+		for(;;) {
+			uint32_t h=head.load(std::memory_order_acquire);
+			uint32_t i=*from;
+			if(h-i>N-1) {
+				i=h-(N-1);
+			}
+			uint32_t n=h-i;
+			if(n>max) {
+				n=max;
+			}
+			for(uint32_t k=0;k<n;k++) {
+				out[k]=buf[(i+k)&(N-1)];
+			}
+			// While element h2 is being written, the elements from h2-(N-1) are intact
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint32_t h2=head.load(std::memory_order_relaxed);
+			uint32_t lost=h2-i>N-1?h2-(N-1)-i:0;
+			if(lost>=n && n>0) {
+				// Overtaken while copying, start again from the oldest element
+				*from=h2-(N-1);
+				continue;
+			}
+			if(lost>0) {
+				memmove(out,out+lost,(n-lost)*sizeof(T));
+			}
+			*from=i+n;
+			return n-lost;
+		}
+	}
+
+	/* Reader side: copy the last element written into v, returns false if none was */
+	bool latest(T* v) const {
+		uint32_t h=end();
+		if(h==0) {
+			return false;
+		}
+		uint32_t from=h-1;
+		return read(&from,v,1)==1;
+	}
+
+	static constexpr size_t capacity() { return N-1; }
+};
+
+#endif /* MAIN_WIOTPHISTORY_H_ */
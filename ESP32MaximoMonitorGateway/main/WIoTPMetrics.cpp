@@ -0,0 +1,243 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPMetrics.cpp
+#
+# Pipeline counters and latency histograms, reported as a metrics event
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPMetrics.h"
+#include "WIoTPEncoder.h"
+#include "WIoTPBudget.h"
+
+extern "C" {
+#include <string.h>
+#include "esp_system.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "freertos/semphr.h"
+}
+
+static const char *LOG_TAG="METRICS";
+
+// CPU usage needs the run time statistics of FreeRTOS
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+#define METRICS_CPU_USAGE
+#endif
+
+#ifdef METRICS_CPU_USAGE
+// Status of all the tasks, taken on each encode
+#define METRICS_MAX_SYSTEM_TASKS 32
+static TaskStatus_t system_tasks[METRICS_MAX_SYSTEM_TASKS];
+// Run time counters at the last reset: watched tasks, idle task of each core, and total
+static uint32_t last_run_time[WIOTP_METRICS_MAX_TASKS];
+static uint32_t last_idle_time[portNUM_PROCESSORS];
+static uint32_t last_total_time;
+
+/* Held while the snapshot is taken and read and the baselines advanced: encode() is called by the publishing
+ * task, which resets the baselines, and by the HTTP server, which does not */
+static SemaphoreHandle_t cpu_lock() {
+	static SemaphoreHandle_t lock=xSemaphoreCreateMutex();
+	return lock;
+}
+#endif
+
+WIoTP_Histogram WIoTP_Metrics::stages[WIOTP_STAGES];
+std::atomic<uint32_t> WIoTP_Metrics::counters[WIOTP_COUNTERS];
+TaskHandle_t WIoTP_Metrics::tasks[WIOTP_METRICS_MAX_TASKS];
+size_t WIoTP_Metrics::n_tasks=0;
+
+void WIoTP_Histogram::record(int64_t us) {
+	if(us<0) {
+		us=0;
+	}
+	// Index of the highest bit above the first bucket
+	uint32_t v=(uint32_t)((us>>WIOTP_HIST_SHIFT)>0xffffffff?0xffffffff:us>>WIOTP_HIST_SHIFT);
+	size_t i=v==0?0:32-__builtin_clz(v);
+	if(i>=WIOTP_HIST_BUCKETS) {
+		i=WIOTP_HIST_BUCKETS-1;
+	}
+	buckets[i].fetch_add(1,std::memory_order_relaxed);
+
+	uint32_t m=max_us.load(std::memory_order_relaxed);
+	uint32_t v_us=us>0xffffffff?0xffffffff:(uint32_t)us;
+	while(v_us>m && !max_us.compare_exchange_weak(m,v_us,std::memory_order_relaxed));
+}
+
+void WIoTP_Histogram::reset() {
+	for(size_t i=0;i<WIOTP_HIST_BUCKETS;i++) {
+		buckets[i].store(0,std::memory_order_relaxed);
+	}
+	max_us.store(0,std::memory_order_relaxed);
+}
+
+uint32_t WIoTP_Histogram::count() const {
+	uint32_t n=0;
+	for(size_t i=0;i<WIOTP_HIST_BUCKETS;i++) {
+		n+=buckets[i].load(std::memory_order_relaxed);
+	}
+	return n;
+}
+
+uint32_t WIoTP_Histogram::percentile(float p) const {
+	uint32_t n=count();
+	if(n==0) {
+		return 0;
+	}
+	uint32_t rank=(uint32_t)(p*n+0.5f), seen=0;
+	for(size_t i=0;i<WIOTP_HIST_BUCKETS-1;i++) {
+		seen+=buckets[i].load(std::memory_order_relaxed);
+		if(seen>=rank) {
+			uint32_t bound=1u<<(i+WIOTP_HIST_SHIFT);
+			return bound<max()?bound:max();
+		}
+	}
+	return max();
+}
+
+void WIoTP_Metrics::watch_task(TaskHandle_t task) {
+	if(n_tasks<WIOTP_METRICS_MAX_TASKS && task!=NULL) {
+		tasks[n_tasks++]=task;
+	}
+#ifdef METRICS_CPU_USAGE
+	// Start counting from now
+	xSemaphoreTake(cpu_lock(),portMAX_DELAY);
+	UBaseType_t n=uxTaskGetSystemState(system_tasks,METRICS_MAX_SYSTEM_TASKS,&last_total_time);
+	for(UBaseType_t j=0;j<n;j++) {
+		if(system_tasks[j].xHandle==task) {
+			last_run_time[n_tasks-1]=system_tasks[j].ulRunTimeCounter;
+		}
+		for(int core=0;core<portNUM_PROCESSORS;core++) {
+			if(system_tasks[j].xHandle==xTaskGetIdleTaskHandleForCPU(core)) {
+				last_idle_time[core]=system_tasks[j].ulRunTimeCounter;
+			}
+		}
+	}
+	xSemaphoreGive(cpu_lock());
+#endif
+}
+
+const char* WIoTP_Metrics::stage_name(wiotp_stage_t stage) {
+	static const char* names[WIOTP_STAGES]={ "jitter", "dequeue", "batch", "publish", "ack", "connect", "features" };
+	return names[stage];
+}
+
+const char* WIoTP_Metrics::counter_name(wiotp_counter_t counter) {
+	static const char* names[WIOTP_COUNTERS]={ "samples", "overruns", "published", "acked", "spilled", "dropped", "replayed", "device_samples", "suppressed", "connects",
+			"log_dropped", "log_limited" };
+	return names[counter];
+}
+
+size_t WIoTP_Metrics::encode(char* buf, size_t size, bool reset) {
+	if(WIOTP_METRICS_LEN(n_tasks)>size) {
+		ESP_LOGE(LOG_TAG,"Metrics do not fit in %u bytes",size);
+		return 0;
+	}
+
+	char* p=buf;
+	memcpy(p,"{\"d\":{",6);
+	p+=6;
+	// Write ,"<prefix><suffix>": skipping the comma for the first key
+	auto key=[&](const char* prefix, const char* suffix) {
+		if(p[-1]!='{') *p++=',';
+		*p++='"';
+		size_t len=strlen(prefix);
+		memcpy(p,prefix,len);
+		p+=len;
+		len=strlen(suffix);
+		memcpy(p,suffix,len);
+		p+=len;
+		*p++='"';
+		*p++=':';
+	};
+	for(int i=0;i<WIOTP_COUNTERS;i++) {
+		key(counter_name((wiotp_counter_t)i),"");
+		p=wiotp_utoa(p,counter((wiotp_counter_t)i));
+	}
+	for(int i=0;i<WIOTP_STAGES;i++) {
+		WIoTP_Histogram& h=stages[i];
+		const char* name=stage_name((wiotp_stage_t)i);
+		key(name,"_n");
+		p=wiotp_utoa(p,h.count());
+		key(name,"_p50");
+		p=wiotp_utoa(p,h.percentile(0.50f));
+		key(name,"_p90");
+		p=wiotp_utoa(p,h.percentile(0.90f));
+		key(name,"_p99");
+		p=wiotp_utoa(p,h.percentile(0.99f));
+		key(name,"_max");
+		p=wiotp_utoa(p,h.max());
+		if(reset) {
+			h.reset();
+		}
+	}
+	key("heap_free","");
+	p=wiotp_utoa(p,esp_get_free_heap_size());
+	key("heap_min","");
+	p=wiotp_utoa(p,esp_get_minimum_free_heap_size());
+	for(int i=0;i<WIOTP_MEM_REGIONS;i++) {
+		key("mem_",WIoTP_Budget::region_name((wiotp_mem_t)i));
+		p=wiotp_utoa(p,WIoTP_Budget::high_water((wiotp_mem_t)i));
+	}
+	for(size_t i=0;i<n_tasks;i++) {
+		// Unused stack in bytes
+		key("stack_",pcTaskGetTaskName(tasks[i]));
+		p=wiotp_utoa(p,uxTaskGetStackHighWaterMark(tasks[i]));
+	}
+#ifdef METRICS_CPU_USAGE
+	uint32_t total;
+	xSemaphoreTake(cpu_lock(),portMAX_DELAY);
+	UBaseType_t n=uxTaskGetSystemState(system_tasks,METRICS_MAX_SYSTEM_TASKS,&total);
+	// Counters are 32 bits, differences are right across one wrap
+	uint32_t elapsed=total-last_total_time;
+	if(n>0 && elapsed>0) {
+		auto permille=[elapsed](uint32_t run_time, uint32_t last) {
+			uint64_t v=(uint64_t)(uint32_t)(run_time-last)*1000/elapsed;
+			return (uint32_t)(v>1000?1000:v);
+		};
+		for(size_t i=0;i<n_tasks;i++) {
+			for(UBaseType_t j=0;j<n;j++) {
+				if(system_tasks[j].xHandle==tasks[i]) {
+					key("cpu_",pcTaskGetTaskName(tasks[i]));
+					p=wiotp_utoa(p,permille(system_tasks[j].ulRunTimeCounter,last_run_time[i]));
+					if(reset) {
+						last_run_time[i]=system_tasks[j].ulRunTimeCounter;
+					}
+				}
+			}
+		}
+		for(int core=0;core<portNUM_PROCESSORS;core++) {
+			TaskHandle_t idle=xTaskGetIdleTaskHandleForCPU(core);
+			for(UBaseType_t j=0;idle!=NULL && j<n;j++) {
+				if(system_tasks[j].xHandle==idle) {
+					const char name[2]={ (char)('0'+core), '\0' };
+					key("load_",name);
+					p=wiotp_utoa(p,1000-permille(system_tasks[j].ulRunTimeCounter,last_idle_time[core]));
+					if(reset) {
+						last_idle_time[core]=system_tasks[j].ulRunTimeCounter;
+					}
+				}
+			}
+		}
+		if(reset) {
+			last_total_time=total;
+		}
+	} else if(n==0) {
+		ESP_LOGW(LOG_TAG,"More than %d tasks, CPU usage not reported",METRICS_MAX_SYSTEM_TASKS);
+	}
+	xSemaphoreGive(cpu_lock());
+#endif
+	*p++='}';
+	*p++='}';
+	*p='\0';
+	return p-buf;
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPMetrics.h
+#
+# Pipeline counters and latency histograms, reported as a metrics event
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPMETRICS_H_
+#define MAIN_WIOTPMETRICS_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+#include "WIoTPBudget.h"
+
+#include <atomic>
+
+/* Bucket i counts latencies below 2^(i+WIOTP_HIST_SHIFT) us, the last bucket all longer ones */
+#define WIOTP_HIST_BUCKETS 16
+#define WIOTP_HIST_SHIFT 7
+
+#define WIOTP_METRICS_MAX_TASKS 6
+
+// Longest keys, such as "published" and "stack_" followed by a task name, and longest value
+#define WIOTP_METRICS_MAX_KEY_LEN 16
+#define WIOTP_METRICS_MAX_TASK_KEY_LEN (6+configMAX_TASK_NAME_LEN)
+#define WIOTP_METRICS_MAX_VALUE_LEN 10
+#define WIOTP_METRICS_VALUE_LEN(key_len) (sizeof(",\"\":")-1+(key_len)+WIOTP_METRICS_MAX_VALUE_LEN)
+/* Size of a payload of n_tasks watched tasks, at most: the counters, 5 values per stage, the heap levels,
+ * the memory regions, stack and CPU usage of each task, and the load of each core */
+#define WIOTP_METRICS_LEN(n_tasks) (sizeof("{\"d\":{}}") \
+		+(WIOTP_COUNTERS+WIOTP_STAGES*5+2+WIOTP_MEM_REGIONS+portNUM_PROCESSORS)*WIOTP_METRICS_VALUE_LEN(WIOTP_METRICS_MAX_KEY_LEN) \
+		+(n_tasks)*2*WIOTP_METRICS_VALUE_LEN(WIOTP_METRICS_MAX_TASK_KEY_LEN))
+/* Size of a buffer which holds any metrics payload */
+#define WIOTP_METRICS_MAX_LEN WIOTP_METRICS_LEN(WIOTP_METRICS_MAX_TASKS)
+
+/* Stages of the pipeline, each timed by a histogram */
+typedef enum {
+	WIOTP_STAGE_JITTER,		// deviation of a sampling interval from the sampling period
+	WIOTP_STAGE_DEQUEUE,	// sample taken to sample read from the ring
+	WIOTP_STAGE_BATCH,		// first sample of a batch to the batch being published
+	WIOTP_STAGE_PUBLISH,	// time spent in the publish call, including backpressure
+	WIOTP_STAGE_ACK,		// publish to PUBACK
+	WIOTP_STAGE_CONNECT,	// start of a connection attempt to the broker session being open, TLS handshake included
+	WIOTP_STAGE_FEATURES,	// edge analytics of one block of readings
+	WIOTP_STAGES
+} wiotp_stage_t;
+
+/* Monotonic counters */
+typedef enum {
+	WIOTP_CNT_SAMPLES,		// samples read from the ring
+	WIOTP_CNT_OVERRUNS,		// samples lost on a full ring
+	WIOTP_CNT_PUBLISHED,	// messages handed to the MQTT client
+	WIOTP_CNT_ACKED,		// PUBACKs received
+	WIOTP_CNT_SPILLED,		// messages appended to the offline queue
+	WIOTP_CNT_DROPPED,		// messages dropped by backpressure
+	WIOTP_CNT_REPLAYED,		// messages published from the offline queue
+	WIOTP_CNT_DEVICE_SAMPLES,	// readings of downstream devices read from their ring
+	WIOTP_CNT_SUPPRESSED,	// readings within the deadband of the last reported one, not published
+	WIOTP_CNT_CONNECTS,		// connections to the broker, the first one included
+	WIOTP_CNT_LOG_DROPPED,	// deferred log records lost on a full ring
+	WIOTP_CNT_LOG_LIMITED,	// deferred log records beyond the rate of their tag
+	WIOTP_COUNTERS
+} wiotp_counter_t;
+
+/**
+ * Fixed-bucket latency histogram, power of two buckets from 128 us to 4 s.
+ * record() is lock-free and may be called from any task.
+ */
+class WIoTP_Histogram {
+private:
+	std::atomic<uint32_t> buckets[WIOTP_HIST_BUCKETS];
+	std::atomic<uint32_t> max_us;
+
+public:
+	WIoTP_Histogram() { reset(); }
+
+	void record(int64_t us);
+	void reset();
+
+	uint32_t count() const;
+	uint32_t max() const { return max_us.load(std::memory_order_relaxed); }
+	/* Upper bound of the bucket holding the p quantile, at most the maximum, 0 if empty */
+	uint32_t percentile(float p) const;
+};
+
+/**
+ * Counters and stage histograms of the acquisition/publish pipeline, updated from the hot paths
+ * without locks, and encoded with the heap and task stack levels as a JSON metrics event:
+ * {"d":{"samples":..,"published":..,..,"ack_n":..,"ack_p50":..,"ack_p99":..,"ack_max":..,"heap_free":..,"mem_config":..,"stack_Sampler":..}}
+ * mem_ keys are the high-water marks of the regions of the memory budget (see WIoTP_Budget). Latencies are in microseconds.
+ * With FreeRTOS run time statistics, cpu_<task> is the CPU time of each watched task and load_<core> the busy time
+ * of each core, in per mille of the time since the last reset. Histograms cover the time since they were last reset by encode(), counters are cumulative.
+ */
+class WIoTP_Metrics {
+private:
+	static WIoTP_Histogram stages[WIOTP_STAGES];
+	static std::atomic<uint32_t> counters[WIOTP_COUNTERS];
+	static TaskHandle_t tasks[WIOTP_METRICS_MAX_TASKS];
+	static size_t n_tasks;
+
+public:
+	static void record(wiotp_stage_t stage, int64_t us) { stages[stage].record(us); }
+	static void count(wiotp_counter_t counter, uint32_t n=1) { counters[counter].fetch_add(n,std::memory_order_relaxed); }
+	static uint32_t counter(wiotp_counter_t counter) { return counters[counter].load(std::memory_order_relaxed); }
+	static const WIoTP_Histogram& stage(wiotp_stage_t stage) { return stages[stage]; }
+
+	/* Report the stack high-water mark and CPU usage of the task */
+	static void watch_task(TaskHandle_t task);
+
+	/* Write the metrics payload into buf and reset the histograms and CPU usage baselines unless told not to,
+	 * returns its length or 0 if it does not fit. May be called from several tasks */
+	static size_t encode(char* buf, size_t size, bool reset=true);
+
+	static const char* stage_name(wiotp_stage_t stage);
+	static const char* counter_name(wiotp_counter_t counter);
+};
+
+#endif /* MAIN_WIOTPMETRICS_H_ */
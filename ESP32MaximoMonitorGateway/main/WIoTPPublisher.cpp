@@ -0,0 +1,206 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPPublisher.cpp
+#
+# QoS 1 publishing with a bounded in-flight window
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#include "WIoTPPublisher.h"
+#include "WIoTPMetrics.h"
+#include "WIoTPBudget.h"
+#include "ESP32Log.h"
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+}
+
+static const char *LOG_TAG="PUBLISHER";
+
+WIoTP_Publisher::WIoTP_Publisher(esp_mqtt_client_handle_t client, size_t window, size_t reserve, uint32_t timeout_ms,
+		size_t outbox_bytes)
+: client(client), window(window), reserve(reserve<window?reserve:window-1), timeout_us((int64_t)timeout_ms*1000),
+  outbox_bytes(outbox_bytes) {
+	table=(inflight_t*)WIoTP_Budget::alloc(WIOTP_MEM_BUFFERS,window*sizeof(inflight_t));
+	for(size_t i=0;i<window;i++) {
+		table[i].msg_id=-1;
+	}
+	lock=xSemaphoreCreateMutex();
+	freed=xSemaphoreCreateBinary();
+	if(lock==NULL || freed==NULL) {
+		abort();
+	}
+	esp_mqtt_client_register_event(client, MQTT_EVENT_PUBLISHED, &_event_handler, this);
+	ESP_LOGI(LOG_TAG,"In-flight window of %u messages, %u reserved, %u bytes",window,this->reserve,outbox_bytes);
+}
+
+WIoTP_Publisher::~WIoTP_Publisher() {
+	vSemaphoreDelete(freed);
+	vSemaphoreDelete(lock);
+	WIoTP_Budget::release(WIOTP_MEM_BUFFERS,table,window*sizeof(inflight_t));
+}
+
+/* Slots of the window open to the priority */
+static size_t share(wiotp_priority_t priority, size_t window, size_t reserve) {
+	switch(priority) {
+	case WIOTP_PRIO_LOW:
+		return (window-reserve+1)/2;
+	case WIOTP_PRIO_NORMAL:
+		return window-reserve;
+	default:
+		return window;
+	}
+}
+
+size_t WIoTP_Publisher::max_message(wiotp_priority_t priority) const {
+	size_t bytes=outbox_bytes*share(priority,window,reserve)/window;
+	return bytes>WIOTP_PUB_OUTBOX_OVERHEAD?bytes-WIOTP_PUB_OUTBOX_OVERHEAD:0;
+}
+
+void WIoTP_Publisher::_event_handler(void* that, esp_event_base_t base, int32_t event_id, void* event_data) {
+	((WIoTP_Publisher*)that)->on_published(((esp_mqtt_event_handle_t)event_data)->msg_id);
+}
+
+/* Called with the lock held */
+bool WIoTP_Publisher::admit(wiotp_priority_t priority, size_t bytes) const {
+	size_t slots=share(priority,window,reserve);
+	return n_inflight<slots && n_bytes+bytes<=outbox_bytes*slots/window;
+}
+
+/* Called with the lock held. Slots do not move, so that publish() finds back the one it reserved */
+void WIoTP_Publisher::release(size_t i) {
+	n_bytes-=table[i].bytes;
+	WIoTP_Budget::unreserve(WIOTP_MEM_OUTBOX,table[i].bytes);
+	table[i].msg_id=-1;
+	n_inflight--;
+	xSemaphoreGive(freed);
+}
+
+/* The PUBACK of slot i was received at acked_us. Called with the lock held */
+void WIoTP_Publisher::acked(size_t i, int64_t acked_us) {
+	int64_t latency=acked_us-table[i].sent_us;
+	latency_total_us+=latency;
+	if(latency>latency_max_us) {
+		latency_max_us=latency;
+	}
+	stat_acked++;
+	WIoTP_Metrics::count(WIOTP_CNT_ACKED);
+	WIoTP_Metrics::record(WIOTP_STAGE_ACK,latency);
+	release(i);
+}
+
+/* Release the slots of messages the client outbox has given up on. Called with the lock held */
+void WIoTP_Publisher::expire(int64_t now) {
+	for(size_t i=0;i<window;i++) {
+		if(table[i].msg_id>0 && now-table[i].sent_us>timeout_us) {
+			GW_LOGW(LOG_TAG,"No PUBACK for msg_id=%d after %lld ms",table[i].msg_id,(now-table[i].sent_us)/1000);
+			stat_expired++;
+			release(i);
+		}
+	}
+}
+
+/* Returns the index of the slot reserved, or window if none was admitted */
+size_t WIoTP_Publisher::reserve_slot(wiotp_priority_t priority, size_t bytes) {
+	size_t i=window;
+	xSemaphoreTake(lock,portMAX_DELAY);
+	int64_t now=esp_timer_get_time();
+	expire(now);
+	// The region is shared with nothing else, but accounts the outbox in the memory budget
+	if(admit(priority,bytes) && WIoTP_Budget::reserve(WIOTP_MEM_OUTBOX,bytes)) {
+		// admit() leaves a free slot
+		for(i=0;table[i].msg_id>=0;i++);
+		inflight_t* slot=&table[i];
+		n_inflight++;
+		slot->msg_id=0;
+		slot->sent_us=now;
+		slot->bytes=bytes;
+		n_bytes+=bytes;
+		if(n_inflight>stat_max_inflight) {
+			stat_max_inflight=n_inflight;
+		}
+		if(n_bytes>stat_max_bytes) {
+			stat_max_bytes=n_bytes;
+		}
+	}
+	xSemaphoreGive(lock);
+	return i;
+}
+
+int WIoTP_Publisher::publish(const char* topic, const char* payload, size_t len, int qos, wiotp_priority_t priority, TickType_t wait) {
+	if(qos==0) {
+		// Nothing to track, the client does not keep QoS 0 messages
+		stat_published++;
+		WIoTP_Metrics::count(WIOTP_CNT_PUBLISHED);
+		return esp_mqtt_client_publish(client, topic, payload, len, 0, 0);
+	}
+
+	if(len==0) {
+		len=strlen(payload);
+	}
+	size_t bytes=strlen(topic)+len+WIOTP_PUB_OUTBOX_OVERHEAD;
+	TickType_t start=xTaskGetTickCount();
+	size_t i;
+	while((i=reserve_slot(priority,bytes))==window) {
+		TickType_t waited=xTaskGetTickCount()-start;
+		if(waited>=wait || xSemaphoreTake(freed,wait-waited)!=pdTRUE) {
+			stat_refused++;
+			return WIOTP_PUB_REFUSED;
+		}
+	}
+
+	// The lock is not held while publishing: the client may be dispatching a PUBACK under its own lock
+	int msg_id=esp_mqtt_client_publish(client, topic, payload, len, qos, 0);
+
+	xSemaphoreTake(lock,portMAX_DELAY);
+	if(msg_id<=0) {
+		release(i);
+	} else {
+		stat_published++;
+		WIoTP_Metrics::count(WIOTP_CNT_PUBLISHED);
+		table[i].msg_id=msg_id;
+		// The PUBACK may already have been handled
+		for(size_t j=0;j<WIOTP_PUB_EARLY_ACKS;j++) {
+			if(early_acks[j].msg_id==msg_id) {
+				early_acks[j].msg_id=0;
+				acked(i,early_acks[j].acked_us);
+				break;
+			}
+		}
+	}
+	xSemaphoreGive(lock);
+	return msg_id;
+}
+
+void WIoTP_Publisher::on_published(int msg_id) {
+	if(msg_id<=0) {
+		// Would match a free slot or one being published
+		return;
+	}
+	xSemaphoreTake(lock,portMAX_DELAY);
+	int64_t now=esp_timer_get_time();
+	size_t i;
+	for(i=0;i<window && table[i].msg_id!=msg_id;i++);
+	if(i<window) {
+		acked(i,now);
+	} else {
+		// Not recorded yet by publish(), or expired
+		early_acks[next_early_ack].msg_id=msg_id;
+		early_acks[next_early_ack].acked_us=now;
+		next_early_ack=(next_early_ack+1)%WIOTP_PUB_EARLY_ACKS;
+	}
+	xSemaphoreGive(lock);
+}
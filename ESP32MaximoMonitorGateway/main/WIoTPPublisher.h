@@ -0,0 +1,133 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPPublisher.h
+#
+# QoS 1 publishing with a bounded in-flight window
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPPUBLISHER_H_
+#define MAIN_WIOTPPUBLISHER_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mqtt_client.h"
+}
+
+/* Returned by publish() when the in-flight window is full */
+#define WIOTP_PUB_REFUSED -2
+
+/* Bytes held by the client outbox for a message besides its topic and payload: packet header and outbox item */
+#define WIOTP_PUB_OUTBOX_OVERHEAD 48
+
+/* Number of PUBACKs which may arrive before their msg_id is recorded */
+#define WIOTP_PUB_EARLY_ACKS 4
+
+/* Priority of a message, lower priorities get a smaller share of the window */
+typedef enum {
+	WIOTP_PRIO_LOW,		// replay of the offline backlog, at most half of the window
+	WIOTP_PRIO_NORMAL,	// data events
+	WIOTP_PRIO_HIGH,	// summaries and replies, may also use the reserved slots
+} wiotp_priority_t;
+
+/**
+ * Publishes through the MQTT client while bounding the number of QoS 1 messages awaiting their PUBACK.
+ * Each outstanding msg_id is kept in a fixed table of window entries, an entry keeping its place from the
+ * reservation of the slot to its release, which is made by MQTT_EVENT_PUBLISHED
+ * or after timeout_ms, the time after which the client outbox drops the message itself.
+ * The bytes the outbox holds for these messages are bounded as well, by the WIOTP_MEM_OUTBOX region of
+ * the memory budget, each priority getting the same share of the bytes as of the slots.
+ * When the window or the share is full, publish() can wait for a slot, else it returns WIOTP_PUB_REFUSED and the
+ * producer drops or spills the message: the client outbox, and the heap, no longer grow without bound
+ * when the broker slows down.
+ */
+class WIoTP_Publisher {
+private:
+	typedef struct {
+		int msg_id;			// -1 when free, 0 while being published
+		int64_t sent_us;
+		uint32_t bytes;		// held by the client outbox
+	} inflight_t;
+
+	typedef struct {
+		int msg_id;			// 0 when unused
+		int64_t acked_us;
+	} early_ack_t;
+
+	esp_mqtt_client_handle_t client;
+	const size_t window;
+	const size_t reserve;
+	const int64_t timeout_us;
+	const size_t outbox_bytes;
+	inflight_t* table;
+	size_t n_inflight = 0;
+	size_t n_bytes = 0;
+	early_ack_t early_acks[WIOTP_PUB_EARLY_ACKS] = {};
+	size_t next_early_ack = 0;
+	SemaphoreHandle_t lock;
+	SemaphoreHandle_t freed;		// given on each released slot
+
+	// Statistics
+	uint32_t stat_published = 0;
+	uint32_t stat_acked = 0;
+	uint32_t stat_expired = 0;
+	uint32_t stat_refused = 0;
+	uint32_t stat_max_inflight = 0;
+	size_t stat_max_bytes = 0;
+	int64_t latency_max_us = 0;
+	int64_t latency_total_us = 0;
+
+	bool admit(wiotp_priority_t priority, size_t bytes) const;
+	void expire(int64_t now);
+	void release(size_t i);
+	void acked(size_t i, int64_t acked_us);
+	size_t reserve_slot(wiotp_priority_t priority, size_t bytes);
+
+	static void _event_handler(void* that, esp_event_base_t base, int32_t event_id, void* event_data);
+
+protected:
+	/* Called by the client on MQTT_EVENT_PUBLISHED */
+	virtual void on_published(int msg_id);
+
+public:
+	/* window is the number of QoS 1 messages in flight, reserve of them being kept for WIOTP_PRIO_HIGH,
+	 * holding at most outbox_bytes in the client outbox */
+	WIoTP_Publisher(esp_mqtt_client_handle_t client, size_t window=CONFIG_GW_INFLIGHT_WINDOW,
+			size_t reserve=CONFIG_GW_INFLIGHT_RESERVE, uint32_t timeout_ms=CONFIG_GW_INFLIGHT_TIMEOUT_MS,
+			size_t outbox_bytes=CONFIG_GW_MEM_OUTBOX_SIZE);
+	virtual ~WIoTP_Publisher();
+
+	/* Publish without retain, waiting up to wait ticks for a slot of the window.
+	 * Returns the msg_id, -1 on error or WIOTP_PUB_REFUSED if the window stays full */
+	int publish(const char* topic, const char* payload, size_t len, int qos=1,
+			wiotp_priority_t priority=WIOTP_PRIO_NORMAL, TickType_t wait=0);
+
+	size_t in_flight() const { return n_inflight; }
+	size_t capacity() const { return window; }
+	/* Largest message of the priority which may be admitted, topic and payload */
+	size_t max_message(wiotp_priority_t priority) const;
+	size_t outbox_in_use() const { return n_bytes; }
+	size_t max_outbox() const { return stat_max_bytes; }
+	uint32_t published() const { return stat_published; }
+	uint32_t acked() const { return stat_acked; }
+	uint32_t expired() const { return stat_expired; }
+	uint32_t refused() const { return stat_refused; }
+	uint32_t max_in_flight() const { return stat_max_inflight; }
+	/* Time from publish to PUBACK */
+	uint32_t mean_ack_latency_ms() const { return stat_acked>0?latency_total_us/stat_acked/1000:0; }
+	uint32_t max_ack_latency_ms() const { return latency_max_us/1000; }
+};
+
+#endif /* MAIN_WIOTPPUBLISHER_H_ */
@@ -0,0 +1,60 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPTokenBucket.h
+#
+# Token bucket rate limiter
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPTOKENBUCKET_H_
+#define MAIN_WIOTPTOKENBUCKET_H_
+
+extern "C" {
+#include <stdint.h>
+}
+
+/**
+ * Allows rate operations per second on average, and bursts of up to burst operations.
+ * Time is given by the caller, in microseconds.
+ */
+class WIoTP_TokenBucket {
+private:
+	const uint32_t rate;
+	const uint32_t burst;
+	uint32_t tokens;
+	int64_t refill_us = 0;
+
+public:
+	WIoTP_TokenBucket(uint32_t rate, uint32_t burst) : rate(rate), burst(burst), tokens(burst) {}
+
+	/* Add the tokens earned up to now_us, keeping the remainder of a partial token */
+	void refill(int64_t now_us) {
+		uint32_t earned=(uint32_t)((now_us-refill_us)*rate/1000000);
+		if(earned>0) {
+			tokens=(tokens+earned>burst)?burst:tokens+earned;
+			refill_us=(tokens==burst)?now_us:refill_us+(int64_t)earned*1000000/rate;
+		}
+	}
+
+	/* Use one token, returns false if none is left */
+	bool take() {
+		if(tokens==0) {
+			return false;
+		}
+		tokens--;
+		return true;
+	}
+
+	uint32_t available() const { return tokens; }
+};
+
+#endif /* MAIN_WIOTPTOKENBUCKET_H_ */
@@ -0,0 +1,39 @@
+/******************************************************************************
+#  Copyright IBM Corp. 2021.  All Rights Reserved.
+#
+# This program and the accompanying materials
+# are made available under the terms of the Apache V2.0
+# which accompanies this distribution, and is available at
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# *****************************************************************************
+# WIoTPTopic.h
+#
+# Watson IoT Platform topic and client id names
+#
+# Created on: 17 oct. 2026
+#
+# Author: Philippe Gregoire - IBM France, Hybrid CLoud Build Team Europe
+# *****************************************************************************/
+#ifndef MAIN_WIOTPTOPIC_H_
+#define MAIN_WIOTPTOPIC_H_
+
+extern "C" {
+#include <stddef.h>
+#include <stdio.h>
+}
+
+/* See https://www.ibm.com/support/knowledgecenter/SSQP8H/iot/platform/gateways/mqtt.html
+ * Both return the length of the name, which was truncated if not less than size */
+
+/* Event topic of a device, or of the gateway itself: iot-2/type/<type>/id/<id>/evt/<event>/fmt/<format> */
+static inline int wiotp_event_topic(char* buf, size_t size, const char* type, const char* id, const char* event, const char* format) {
+	return snprintf(buf,size,"iot-2/type/%s/id/%s/evt/%s/fmt/%s",type,id,event,format);
+}
+
+/* Client id of a gateway: g:<orgid>:<type>:<id> */
+static inline int wiotp_gateway_client_id(char* buf, size_t size, const char* orgid, const char* type, const char* id) {
+	return snprintf(buf,size,"g:%s:%s:%s",orgid,type,id);
+}
+
+#endif /* MAIN_WIOTPTOPIC_H_ */
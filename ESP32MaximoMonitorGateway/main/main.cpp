@@ -23,23 +23,98 @@ extern "C" {
 
 #include "esp_log.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 
 #include "esp_system.h"
-extern uint8_t temprature_sens_read();
+#include "esp_timer.h"
 
 #include "mqtt_client.h"
+#include "esp_ota_ops.h"
+#if defined(CONFIG_GW_MQTT_TLS) && defined(CONFIG_MBEDTLS_CERTIFICATE_BUNDLE)
+#include "esp_crt_bundle.h"
+#endif
 }
 
 #include "ESP32SPIFFS.h"
+#include "ESP32Config.h"
+#include "ESP32Boot.h"
 #include "ESP32Wifi.h"
+#include "WIoTPBatcher.h"
+#include "ESP32SPIFFSQueue.h"
+#include "ESP32Sampler.h"
+#ifdef CONFIG_GW_ADC_ENABLE
+#include "ESP32Adc.h"
+#endif
+#include "WIoTPAggregator.h"
+#include "WIoTPFeatures.h"
+#include "WIoTPPublisher.h"
+#include "WIoTPBudget.h"
+#include "WIoTPMetrics.h"
+#include "WIoTPTopic.h"
+#include "WIoTPDevices.h"
+#include "ESP32FanIn.h"
+#include "WIoTPCommands.h"
+#include "ESP32OTA.h"
+#include "ESP32WebServer.h"
+#include "ESP32Resolver.h"
+#include "ESP32Tasks.h"
+#include "ESP32Log.h"
+
+#include <new>
 
 static const char *LOG_TAG="WIOTP";
 static const char *LOG_TAG_MQTT = "MQTT";
 
+// Sensors read by the sampling task, channel 0 being the internal temperature
+#ifdef CONFIG_GW_ADC_ENABLE
+typedef ESP32_SensorSampler<ESP32_Sensors<ESP32_TempSensor,
+		ESP32_AdcSensor<CONFIG_GW_ADC_CHANNEL_MASK,CONFIG_GW_ADC_SAMPLE_FREQ_HZ,CONFIG_GW_ADC_DECIMATION,
+		CONFIG_GW_ADC_FRAME_SIZE,CONFIG_GW_ADC_BUFFER_SIZE> > > gw_sampler_t;
+#else
+typedef ESP32_SensorSampler<ESP32_Sensors<ESP32_TempSensor> > gw_sampler_t;
+#endif
+
+// Set while the gateway client is connected to the broker
+static volatile bool wiotp_connected = false;
+
+// Commands received for the gateway and its devices, routed from MQTT_EVENT_DATA
+static WIoTP_CommandRouter wiotp_commands;
+
+// Broker host, whose address is resolved in the background and cached in NVS
+static ESP32_Resolver wiotp_resolver;
+static char wiotp_host[GW_RESOLVER_MAX_HOST_LEN];
+
+// Start of the current connection attempt, for the connect latency
+static int64_t wiotp_connect_start_us = 0;
+
+#ifdef CONFIG_GW_MQTT_TLS
+// Largest CA certificate file, in PEM
+#define WIOTP_CA_MAX_LEN 4096
+#endif
+
+/* Broker URI, to its last known address, else to its name, then resolved by the MQTT client.
+ * Over TLS, the certificate is checked against the name given as common_name, also sent as SNI */
+static void wiotp_broker_uri(char* uri, size_t len) {
+#ifdef CONFIG_GW_MQTT_TLS
+    const char* scheme="mqtts://";
+    char port[8];
+    snprintf(port,sizeof(port),":%d",CONFIG_GW_MQTT_TLS_PORT);
+#else
+    const char* scheme="mqtt://";
+    const char* port="";
+#endif
+    esp_ip4_addr_t addr;
+    if(wiotp_resolver.lookup(wiotp_host,&addr)) {
+        snprintf(uri,len,"%s" IPSTR "%s",scheme,IP2STR(&addr),port);
+    } else {
+        snprintf(uri,len,"%s%s%s",scheme,wiotp_host,port);
+    }
+}
+
 esp_err_t event_handler(void *ctx, system_event_t *event)
 {
     return ESP_OK;
@@ -50,67 +125,95 @@ static esp_err_t mqtt_event_handler_cb(esp_mqtt_event_handle_t event)
 {
     esp_mqtt_client_handle_t client = event->client;
     int msg_id;
+    int64_t connect_us;
+    char uri[32+GW_RESOLVER_MAX_HOST_LEN];
     // your_context_t *context = event->context;
     switch (event->event_id) {
         case MQTT_EVENT_CONNECTED:
-            ESP_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_CONNECTED");
-            msg_id = esp_mqtt_client_publish(client, "/topic/qos1", "data_3", 0, 1, 0);
-            ESP_LOGI(LOG_TAG_MQTT, "sent publish successful, msg_id=%d", msg_id);
-
-            msg_id = esp_mqtt_client_subscribe(client, "/topic/qos0", 0);
-            ESP_LOGI(LOG_TAG_MQTT, "sent subscribe successful, msg_id=%d", msg_id);
-
-            msg_id = esp_mqtt_client_subscribe(client, "/topic/qos1", 1);
-            ESP_LOGI(LOG_TAG_MQTT, "sent subscribe successful, msg_id=%d", msg_id);
-
-            msg_id = esp_mqtt_client_unsubscribe(client, "/topic/qos1");
-            ESP_LOGI(LOG_TAG_MQTT, "sent unsubscribe successful, msg_id=%d", msg_id);
+            // From the start of the attempt: TCP, TLS handshake when over mqtts, then MQTT CONNECT
+            connect_us = esp_timer_get_time()-wiotp_connect_start_us;
+            GW_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_CONNECTED in %lld ms%s", connect_us/1000,
+                    WIoTP_Metrics::counter(WIOTP_CNT_CONNECTS)>0?" (reconnection)":"");
+            WIoTP_Metrics::record(WIOTP_STAGE_CONNECT, connect_us);
+            WIoTP_Metrics::count(WIOTP_CNT_CONNECTS);
+            wiotp_connected = true;
+            ESP32_Boot::mark(GW_BOOT_MQTT_CONNECTED);
+            // Commands of the gateway and of all its devices
+            msg_id = esp_mqtt_client_subscribe(client, WIOTP_COMMAND_FILTER, 1);
+            GW_LOGI(LOG_TAG_MQTT, "sent subscribe to %s, msg_id=%d", WIOTP_COMMAND_FILTER, msg_id);
             break;
         case MQTT_EVENT_DISCONNECTED:
-            ESP_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_DISCONNECTED");
+            GW_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_DISCONNECTED");
+            wiotp_connected = false;
+            // In case the broker moved, the next attempts take the new address once resolved
+            wiotp_resolver.refresh(wiotp_host);
+            break;
+        case MQTT_EVENT_BEFORE_CONNECT:
+            wiotp_connect_start_us = esp_timer_get_time();
+            // Never waits on name resolution, the cache answers at once
+            wiotp_broker_uri(uri, sizeof(uri));
+            esp_mqtt_client_set_uri(client, uri);
+            GW_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_BEFORE_CONNECT, connecting to %s", uri);
             break;
 
         case MQTT_EVENT_SUBSCRIBED:
-            ESP_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
-            msg_id = esp_mqtt_client_publish(client, "/topic/qos0", "data", 0, 0, 0);
-            ESP_LOGI(LOG_TAG_MQTT, "sent publish successful, msg_id=%d", msg_id);
+            GW_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
             break;
         case MQTT_EVENT_UNSUBSCRIBED:
-            ESP_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
+            GW_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
             break;
         case MQTT_EVENT_PUBLISHED:
-            ESP_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+            GW_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+            if(ESP32_Boot::mark(GW_BOOT_FIRST_PUBLISH)) {
+                ESP32_Boot::log();
+                // This firmware reached the broker, an update is no longer rolled back
+                esp_ota_mark_app_valid_cancel_rollback();
+            }
             break;
         case MQTT_EVENT_DATA:
-            ESP_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_DATA");
-            printf("TOPIC=%.*s\r\n", event->topic_len, event->topic);
-            printf("DATA=%.*s\r\n", event->data_len, event->data);
+            // Handled in this task, without waiting for the publishing loop
+            wiotp_commands.dispatch(event);
             break;
         case MQTT_EVENT_ERROR:
-            ESP_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_ERROR");
+            GW_LOGI(LOG_TAG_MQTT, "MQTT_EVENT_ERROR");
             break;
         default:
-            ESP_LOGI(LOG_TAG_MQTT, "Other event id:%d", event->event_id);
+            GW_LOGI(LOG_TAG_MQTT, "Other event id:%d", event->event_id);
             break;
     }
     return ESP_OK;
 }
 
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
-    ESP_LOGD(LOG_TAG_MQTT, "Event dispatched from event loop base=%s, event_id=%d", base, event_id);
+    GW_LOGD(LOG_TAG_MQTT, "Event dispatched from event loop base=%s, event_id=%d", base, event_id);
     mqtt_event_handler_cb((esp_mqtt_event_handle_t)event_data);
 }
 
 
 
-static esp_mqtt_client_handle_t wiotp_start(const char* wiotp_orgid, const char* wiotp_gw_type, const char* wiotp_gw_id, const char* wiotp_gw_token)
-{
-    char wiotp_uri[256];
-    //snprintf(wiotp_uri,sizeof(wiotp_uri),"mqtt://%s.messaging.internetofthings.ibmcloud.com",wiotp_orgid);
+/* Start the MQTT client once an IP address is obtained, it then reconnects by itself */
+static void wiotp_got_ip_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
+    static bool started = false;
+    if(!started) {
+        started = true;
+        esp_mqtt_client_start((esp_mqtt_client_handle_t)handler_args);
+    }
+}
 
-    snprintf(wiotp_uri,sizeof(wiotp_uri),"mqtt://169.62.202.130");
+/* Create the MQTT client, started by wiotp_got_ip_handler. The broker is wiotp_host when given,
+ * else that of the organization. With GW_MQTT_TLS, it is authenticated by the CA certificate of wiotp_ca_file */
+static esp_mqtt_client_handle_t wiotp_init(const char* wiotp_orgid, const char* wiotp_gw_type, const char* wiotp_gw_id, const char* wiotp_gw_token,
+		const char* wiotp_broker_host, const char* wiotp_ca_file)
+{
+    if(wiotp_broker_host!=NULL) {
+        snprintf(wiotp_host,sizeof(wiotp_host),"%s",wiotp_broker_host);
+    } else {
+        snprintf(wiotp_host,sizeof(wiotp_host),"%s.messaging.internetofthings.ibmcloud.com",wiotp_orgid);
+    }
+    char wiotp_uri[32+GW_RESOLVER_MAX_HOST_LEN];
+    wiotp_broker_uri(wiotp_uri,sizeof(wiotp_uri));
     char wiotp_gw_client_id[256];
-    snprintf(wiotp_gw_client_id,sizeof(wiotp_gw_client_id),"g:%s:%s:%s",wiotp_orgid,wiotp_gw_type,wiotp_gw_id);
+    wiotp_gateway_client_id(wiotp_gw_client_id,sizeof(wiotp_gw_client_id),wiotp_orgid,wiotp_gw_type,wiotp_gw_id);
 
 	// Setting up gateway connection
 	// See https://www.ibm.com/support/knowledgecenter/SSQP8H/iot/platform/gateways/mqtt.html
@@ -120,56 +223,421 @@ static esp_mqtt_client_handle_t wiotp_start(const char* wiotp_orgid, const char*
     mqtt_cfg.client_id = wiotp_gw_client_id;
 	mqtt_cfg.username = "use-token-auth";
 	mqtt_cfg.password = wiotp_gw_token;
+#ifdef CONFIG_GW_MQTT_TLS
+    // The URI may hold the cached address, the certificate is checked against the name.
+    // Each connection makes a full handshake: esp-mqtt gives no access to its TLS session to resume it
+    mqtt_cfg.common_name = wiotp_host;
+    // Kept for the lifetime of the client, which reads it on each connection
+    mqtt_cfg.cert_pem = ESP32_SPIFFS::read_string(wiotp_ca_file,WIOTP_CA_MAX_LEN);
+    if(mqtt_cfg.cert_pem == NULL) {
+#ifdef CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+        ESP_LOGW(LOG_TAG_MQTT,"No CA certificate %s, checking the broker against the certificate bundle",wiotp_ca_file);
+        mqtt_cfg.crt_bundle_attach = esp_crt_bundle_attach;
+#else
+        ESP_LOGE(LOG_TAG_MQTT,"No CA certificate %s, the broker cannot be authenticated",wiotp_ca_file);
+#endif
+    }
+#endif
 
     ESP_LOGI(LOG_TAG_MQTT,"Connecting to %s with clientid=%s",mqtt_cfg.uri,mqtt_cfg.client_id);
     esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
     esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, mqtt_event_handler, client);
-    esp_mqtt_client_start(client);
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wiotp_got_ip_handler, client, NULL));
 
     return client;
 }
 
-extern "C" void app_main(void)
+/* cmd/rate command, {"hz":<rate>} or <rate>, applied to the sampler at once */
+class WIoTP_RateCommand : public WIoTP_CommandBuffer {
+private:
+	ESP32_Sampler& sampler;
+
+protected:
+	/* {"hz":<rate>}, or a bare <rate>, an integer within the range of GW_SAMPLE_RATE_HZ */
+	virtual void command(const char* payload, size_t len) {
+		const char* p=strstr(payload,"\"hz\"");
+		if(p!=NULL) {
+			p=strchr(p+4,':');
+		}
+		p=p!=NULL?p+1:payload;
+		char* end;
+		errno=0;
+		long hz=strtol(p,&end,10);
+		if(end==p || errno==ERANGE || (*end!='\0' && strchr(" \t\r\n,}",*end)==NULL)
+				|| hz<GW_SAMPLE_RATE_MIN_HZ || hz>GW_SAMPLE_RATE_MAX_HZ || !sampler.set_rate(hz)) {
+			GW_LOGW(LOG_TAG,"Invalid rate command %s, expecting {\"hz\":%d..%d}",payload,GW_SAMPLE_RATE_MIN_HZ,GW_SAMPLE_RATE_MAX_HZ);
+		}
+	}
+
+public:
+	WIoTP_RateCommand(ESP32_Sampler& sampler) : WIoTP_CommandBuffer(64), sampler(sampler) {}
+};
+
+/* Sends payloads through the in-flight window, and spools them to the offline queue while the broker
+ * cannot be reached or the window is full */
+class WIoTP_Spool {
+private:
+	ESP32_SPIFFS_Queue& queue;
+	WIoTP_Publisher& publisher;
+	const wiotp_priority_t priority;
+	uint32_t dropped = 0;
+
+public:
+	WIoTP_Spool(ESP32_SPIFFS_Queue& queue, WIoTP_Publisher& publisher, wiotp_priority_t priority)
+	: queue(queue), publisher(publisher), priority(priority) {}
+
+	int send(const char* topic, const char* payload, size_t len) {
+		int msg_id=-1;
+		if(wiotp_connected) {
+			int64_t start=esp_timer_get_time();
+#ifdef CONFIG_GW_BACKPRESSURE_BLOCK
+			msg_id=publisher.publish(topic,payload,len,1,priority,pdMS_TO_TICKS(CONFIG_GW_BACKPRESSURE_BLOCK_MS));
+#else
+			msg_id=publisher.publish(topic,payload,len,1,priority);
+#endif
+			WIoTP_Metrics::record(WIOTP_STAGE_PUBLISH,esp_timer_get_time()-start);
+#ifdef CONFIG_GW_BACKPRESSURE_DROP
+			if(msg_id==WIOTP_PUB_REFUSED) {
+				dropped++;
+				WIoTP_Metrics::count(WIOTP_CNT_DROPPED);
+				return msg_id;
+			}
+#endif
+		}
+		if(msg_id<0 && queue.push(topic,payload,len)) {
+			WIoTP_Metrics::count(WIOTP_CNT_SPILLED);
+			msg_id=0;
+		}
+		return msg_id;
+	}
+
+	uint32_t drop_count() const { return dropped; }
+};
+
+/* Publisher (batcher or aggregator) which sends through the in-flight window, spooling as needed */
+template<class Publisher> class WIoTP_Spooling : public Publisher {
+private:
+	WIoTP_Spool spool;
+
+protected:
+	virtual int publish(const char* payload, size_t len) {
+		return spool.send(this->topic,payload,len);
+	}
+
+public:
+	template<typename... Args>
+	WIoTP_Spooling(ESP32_SPIFFS_Queue& queue, WIoTP_Publisher& publisher, wiotp_priority_t priority, Args... args)
+	: Publisher(args...), spool(queue,publisher,priority) {}
+
+	uint32_t drop_count() const { return spool.drop_count(); }
+};
+
+/* Downstream devices, whose batches are sent through the in-flight window, spooling as needed */
+class WIoTP_SpoolingDevices : public WIoTP_Devices {
+private:
+	WIoTP_Spool spool;
+
+protected:
+	virtual int publish(const char* topic, const char* payload, size_t len) {
+		return spool.send(topic,payload,len);
+	}
+
+public:
+	template<typename... Args>
+	WIoTP_SpoolingDevices(ESP32_SPIFFS_Queue& queue, WIoTP_Publisher& publisher, wiotp_priority_t priority, Args... args)
+	: WIoTP_Devices(args...), spool(queue,publisher,priority) {}
+
+	uint32_t drop_count() const { return spool.drop_count(); }
+};
+
+/* Publishing task: sets the gateway up, then drains the sample rings and publishes */
+static void publish_task(void* arg)
 {
 	// Init SPIFFS
 	ESP32_SPIFFS spiffs=ESP32_SPIFFS();
 
+#ifdef CONFIG_GW_LOG_DEFERRED
+    // Hot paths log through a ring drained by the log task, which may write to SPIFFS
+    ESP32_Log::start();
+#endif
+
     nvs_flash_init();
 
-    // Init Wifi Station (client)
-	ESP32_Wifi wifi=ESP32_Wifi(spiffs.read_string("/secret/wifi_ssid.txt"),
-								spiffs.read_string("/secret/wifi_pass.txt"),ESP32_Wifi::generate_hostname("WIOTP"));
-    // Wait 5 sec for TCPIP to come up
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
+    // Configuration is parsed once from SPIFFS, then loaded from its NVS cache
+    ESP32_Config config;
+    ESP32_Boot::mark(GW_BOOT_CONFIG);
+
+    // Init Wifi Station (client), connection is made in the background
+	ESP32_Wifi wifi(config.get("wifi_ssid",""),config.get("wifi_pass",""),ESP32_Wifi::generate_hostname("WIOTP"));
+	// Fallback APs, wifi_ssid2/wifi_pass2 and so on
+	for(int i=2;i<=CONFIG_GW_WIFI_MAX_APS;i++) {
+		char ssid_key[16], pass_key[16];
+		snprintf(ssid_key,sizeof(ssid_key),"wifi_ssid%d",i);
+		snprintf(pass_key,sizeof(pass_key),"wifi_pass%d",i);
+		if(config.get(ssid_key)!=NULL) {
+			wifi.add_ap(config.get(ssid_key),config.get(pass_key,""));
+		}
+	}
 
-    // Init wiotp MQTT Broker
-    const char* wiotp_orgid=ESP32_SPIFFS::read_string("/secret/wiotp_orgid.txt",16);
-	const char* wiotp_gw_type=ESP32_SPIFFS::read_string("/secret/wiotp_gw_type.txt");
-	const char* wiotp_gw_id=ESP32_SPIFFS::read_string("/secret/wiotp_gw_id.txt");
-	const char* wiotp_gw_token=ESP32_SPIFFS::read_string("/secret/wiotp_gw_token.txt");
-    esp_mqtt_client_handle_t mqttCl=wiotp_start(wiotp_orgid,wiotp_gw_type,wiotp_gw_id,wiotp_gw_token);
+    // Resolves the broker address in the background, from its address cached in NVS.
+    // After the Wifi, which creates the default event loop
+    wiotp_resolver.start();
 
-    const char* wiotp_dev_type=ESP32_SPIFFS::read_string("/secret/wiotp_dev_type.txt");
-	const char* wiotp_dev_id=ESP32_SPIFFS::read_string("/secret/wiotp_dev_id.txt");
+    // Sampling runs in its own task, started below, whose rate can be changed by command.
+    // Static as the ring would not fit on the task stack
+    static gw_sampler_t sampler;
+    const char* wiotp_dev_type=config.get("wiotp_dev_type","");
+	const char* wiotp_dev_id=config.get("wiotp_dev_id","");
+
+	// Routes are in place before the client is started
+    static char wiotp_rate_filter[256];
+    static WIoTP_RateCommand rate_command(sampler);
+    snprintf(wiotp_rate_filter,sizeof(wiotp_rate_filter),"iot-2/type/%s/id/%s/cmd/rate/fmt/+",wiotp_dev_type,wiotp_dev_id);
+    wiotp_commands.route(wiotp_rate_filter,&rate_command);
+
+    // Init wiotp MQTT Broker, connected as soon as Wifi gets an IP address
+    const char* wiotp_orgid=config.get("wiotp_orgid","");
+	const char* wiotp_gw_type=config.get("wiotp_gw_type","");
+	const char* wiotp_gw_id=config.get("wiotp_gw_id","");
+	const char* wiotp_gw_token=config.get("wiotp_gw_token","");
+    esp_mqtt_client_handle_t mqttCl=wiotp_init(wiotp_orgid,wiotp_gw_type,wiotp_gw_id,wiotp_gw_token,config.get("wiotp_host"),
+    		config.get("wiotp_ca_file","/secret/ca.pem"));
+
+    // Bounds the QoS 1 messages awaiting their PUBACK
+    WIoTP_Publisher publisher(mqttCl);
+
+#ifdef CONFIG_GW_OTA_ENABLE
+    // Firmware updates, streamed to flash as cmd/ota commands of the gateway arrive
+    static char wiotp_ota_filter[256];
+    static char wiotp_ota_topic[256];
+    snprintf(wiotp_ota_filter,sizeof(wiotp_ota_filter),"iot-2/type/%s/id/%s/cmd/ota/fmt/+",wiotp_gw_type,wiotp_gw_id);
+    wiotp_event_topic(wiotp_ota_topic,sizeof(wiotp_ota_topic),wiotp_gw_type,wiotp_gw_id,"ota","json");
+    static ESP32_OTA ota(publisher,wiotp_ota_topic);
+    wiotp_commands.route(wiotp_ota_filter,&ota);
+#endif
+    wifi.start();
 
 	char wiotp_topic[256];
     // iot-2/type/typeId/id/deviceId/evt/eventId/fmt/formatString
-    snprintf(wiotp_topic,sizeof(wiotp_topic),"iot-2/type/%s/id/%s/evt/%s/fmt/json",wiotp_dev_type,wiotp_dev_id,"data");
+#if defined(CONFIG_GW_DATA_FORMAT_CBOR)
+    const wiotp_format_t wiotp_data_format=WIOTP_FMT_CBOR;
+#elif defined(CONFIG_GW_DATA_FORMAT_GORILLA)
+    const wiotp_format_t wiotp_data_format=WIOTP_FMT_GORILLA;
+#else
+    const wiotp_format_t wiotp_data_format=WIOTP_FMT_JSON;
+#endif
+    wiotp_event_topic(wiotp_topic,sizeof(wiotp_topic),wiotp_dev_type,wiotp_dev_id,"data",wiotp_format_name(wiotp_data_format));
 
-    char wiotp_payload[512];
+    // Batches which cannot be published are kept on SPIFFS and replayed once reconnected
+    ESP32_SPIFFS_Queue queue;
+    // Replay gets the smallest share of the outbox, which must still hold any record of the queue
+    if(publisher.max_message(WIOTP_PRIO_LOW)<CONFIG_GW_QUEUE_MAX_RECORD) {
+    	ESP_LOGE(LOG_TAG,"Outbox share of %u bytes for replay below GW_QUEUE_MAX_RECORD, raise GW_MEM_OUTBOX_SIZE",
+    			publisher.max_message(WIOTP_PRIO_LOW));
+    	abort();
+    }
+
+#ifdef CONFIG_GW_AGG_ENABLE
+    // Only window summaries are published, as summary events
+    char wiotp_summary_topic[256];
+    wiotp_event_topic(wiotp_summary_topic,sizeof(wiotp_summary_topic),wiotp_dev_type,wiotp_dev_id,"summary","json");
+    const uint32_t wiotp_agg_stats=0
+#ifdef CONFIG_GW_AGG_COUNT
+    		|WIOTP_AGG_COUNT
+#endif
+#ifdef CONFIG_GW_AGG_MIN
+    		|WIOTP_AGG_MIN
+#endif
+#ifdef CONFIG_GW_AGG_MAX
+    		|WIOTP_AGG_MAX
+#endif
+#ifdef CONFIG_GW_AGG_MEAN
+    		|WIOTP_AGG_MEAN
+#endif
+#ifdef CONFIG_GW_AGG_STDDEV
+    		|WIOTP_AGG_STDDEV
+#endif
+    		;
+    // One aggregator per sensor channel, summarizing it under the channel name
+    typedef WIoTP_Spooling<WIoTP_Aggregator> wiotp_channel_t;
+    wiotp_channel_t* channels[gw_sampler_t::channels];
+    for(size_t i=0;i<gw_sampler_t::channels;i++) {
+    	channels[i]=new(WIoTP_Budget::alloc(WIOTP_MEM_BATCH,sizeof(wiotp_channel_t))) wiotp_channel_t(queue,publisher,WIOTP_PRIO_HIGH,
+    			mqttCl,(const char*)wiotp_summary_topic,gw_sampler_t::channel_name(i),
+    			CONFIG_GW_AGG_WINDOW_MS,CONFIG_GW_AGG_HOP_MS,wiotp_agg_stats,CONFIG_GW_AGG_PERCENTILES,CONFIG_GW_AGG_DECIMALS);
+    }
+#else
+    // Readings are batched into array payloads, flushed on size, count or age, one batcher per sensor
+    // channel, publishing it under the channel name
+    typedef WIoTP_Spooling<WIoTP_Batcher> wiotp_channel_t;
+    wiotp_channel_t* channels[gw_sampler_t::channels];
+    for(size_t i=0;i<gw_sampler_t::channels;i++) {
+    	channels[i]=new(WIoTP_Budget::alloc(WIOTP_MEM_BATCH,sizeof(wiotp_channel_t))) wiotp_channel_t(queue,publisher,WIOTP_PRIO_NORMAL,
+    			mqttCl,(const char*)wiotp_topic,gw_sampler_t::channel_name(i),wiotp_data_format);
+    }
+#endif
+#ifdef CONFIG_GW_FEAT_ENABLE
+    // Features of blocks of readings of each channel, published as features events beside its readings or summaries
+    char wiotp_features_topic[256];
+    wiotp_event_topic(wiotp_features_topic,sizeof(wiotp_features_topic),wiotp_dev_type,wiotp_dev_id,"features","json");
+    typedef WIoTP_Spooling<WIoTP_Features> wiotp_features_t;
+    wiotp_features_t* features[gw_sampler_t::channels];
+    for(size_t i=0;i<gw_sampler_t::channels;i++) {
+    	features[i]=new(WIoTP_Budget::alloc(WIOTP_MEM_FEATURES,sizeof(wiotp_features_t))) wiotp_features_t(queue,publisher,WIOTP_PRIO_HIGH,
+    			mqttCl,(const char*)wiotp_features_topic,gw_sampler_t::channel_name(i),CONFIG_GW_FEAT_BLOCK_SIZE,CONFIG_GW_FEAT_BANDS,
+    			CONFIG_GW_FEAT_EWMA_ALPHA,CONFIG_GW_FEAT_WARMUP,CONFIG_GW_FEAT_DECIMALS);
+    }
+#endif
+#ifdef CONFIG_GW_RBE_ENABLE
+    // Only changes beyond the deadband of each channel are published, and a heartbeat of unchanged channels.
+    // Summaries are filtered on their mean
+    for(size_t i=0;i<gw_sampler_t::channels;i++) {
+    	WIoTP_Deadband* deadband=new(WIoTP_Budget::alloc(WIOTP_MEM_BATCH,sizeof(WIoTP_Deadband)))
+    			WIoTP_Deadband(WIoTP_Deadband::nth(CONFIG_GW_RBE_DEADBAND,i),CONFIG_GW_RBE_MAX_SILENT_MS);
+    	channels[i]->set_deadband(deadband);
+    }
+#endif
+
+    // This task consumes the sample ring and publishes
+    sampler.start();
+
+#ifdef CONFIG_GW_HTTP_ENABLE
+    // Readings and metrics served over HTTP, from a history ring fed by this task.
+    // Static as the ring would not fit on the task stack
+    static ESP32_WebServer web(sampler);
+    web.start();
+#endif
+
+#ifdef CONFIG_GW_FANIN_ENABLE
+    // Readings of downstream devices, received over UDP, are batched per device under the device topics.
+    // Static as the ring would not fit on the task stack
+    static WIoTP_SpoolingDevices devices(queue,publisher,WIOTP_PRIO_NORMAL,mqttCl,wiotp_data_format);
+    static ESP32_FanIn fanin(devices);
+#ifdef CONFIG_GW_RBE_ENABLE
+    // Each device is filtered against its own last reported reading
+    static WIoTP_Deadband device_deadband(CONFIG_GW_RBE_DEVICE_DEADBAND,CONFIG_GW_RBE_MAX_SILENT_MS);
+    devices.set_deadband(&device_deadband);
+#endif
+    fanin.start();
+    gw_device_sample_t device_samples[16];
+    uint32_t device_overruns = 0;
+#endif
+
+#if CONFIG_GW_METRICS_PERIOD_MS>0
+    // Gateway health, published as metrics events of the gateway itself
+    char wiotp_metrics_topic[256];
+    wiotp_event_topic(wiotp_metrics_topic,sizeof(wiotp_metrics_topic),wiotp_gw_type,wiotp_gw_id,"metrics","json");
+    static char metrics_payload[WIOTP_METRICS_MAX_LEN];
+    int64_t next_metrics_us = esp_timer_get_time()+(int64_t)CONFIG_GW_METRICS_PERIOD_MS*1000;
+    WIoTP_Metrics::watch_task(xTaskGetCurrentTaskHandle());
+    WIoTP_Metrics::watch_task(sampler.task_handle());
+    WIoTP_Metrics::watch_task(wiotp_resolver.task_handle());
+#ifdef CONFIG_GW_LOG_DEFERRED
+    WIoTP_Metrics::watch_task(ESP32_Log::task_handle());
+#endif
+#ifdef CONFIG_GW_FANIN_ENABLE
+    WIoTP_Metrics::watch_task(fanin.task_handle());
+#endif
+#endif
+
+    // Buffers are all allocated by now
+    WIoTP_Budget::log();
 
     gpio_set_direction(GPIO_NUM_4, GPIO_MODE_OUTPUT);
     int level = 0;
+    int32_t temp = 0;
+    uint32_t overruns = 0;
+    int64_t next_heartbeat_us = 0;
+    gw_sample_t samples[16];
     while (true) {
-    	uint8_t temp=temprature_sens_read()*rand();
-    	ESP_LOGI(LOG_TAG,"HeartBeat %d %d",level,temp);
+    	size_t n;
+    	while((n=sampler.ring.pop_bulk(samples,sizeof(samples)/sizeof(samples[0])))>0) {
+    		int64_t dequeued=esp_timer_get_time();
+    		WIoTP_Metrics::count(WIOTP_CNT_SAMPLES,n);
+    		for(size_t i=0;i<n;i++) {
+    			WIoTP_Metrics::record(WIOTP_STAGE_DEQUEUE,dequeued-samples[i].ts_us);
+    			if(samples[i].channel==0) {
+#ifdef CONFIG_GW_HTTP_ENABLE
+    				web.history.push(samples[i]);
+#endif
+    				temp=samples[i].value;
+    			}
+    			channels[samples[i].channel]->add(samples[i].ts_us,samples[i].value);
+#ifdef CONFIG_GW_FEAT_ENABLE
+    			features[samples[i].channel]->add(samples[i].ts_us,samples[i].value);
+#endif
+    		}
+    	}
+    	for(size_t i=0;i<gw_sampler_t::channels;i++) {
+#ifdef CONFIG_GW_AGG_ENABLE
+    		channels[i]->poll(esp_timer_get_time());
+#else
+    		channels[i]->poll();
+#endif
+    	}
+
+#ifdef CONFIG_GW_FANIN_ENABLE
+    	while((n=fanin.ring.pop_bulk(device_samples,sizeof(device_samples)/sizeof(device_samples[0])))>0) {
+    		int64_t dequeued=esp_timer_get_time();
+    		WIoTP_Metrics::count(WIOTP_CNT_DEVICE_SAMPLES,n);
+    		for(size_t i=0;i<n;i++) {
+    			WIoTP_Metrics::record(WIOTP_STAGE_DEQUEUE,dequeued-device_samples[i].ts_us);
+    			devices.add(device_samples[i].device,device_samples[i].ts_us,device_samples[i].value);
+    		}
+    	}
+    	devices.poll(esp_timer_get_time());
+#endif
+
+    	// Replay the offline backlog in rate-limited bursts
+    	if(wiotp_connected) {
+    		queue.drain(publisher);
+    	}
+
+    	int64_t now=esp_timer_get_time();
+    	if(now>=next_heartbeat_us) {
+    		next_heartbeat_us=now+1000000;
+    		GW_LOGI(LOG_TAG,"HeartBeat %d %d",level,temp);
+    		if(sampler.ring.overrun_count()!=overruns) {
+    			WIoTP_Metrics::count(WIOTP_CNT_OVERRUNS,sampler.ring.overrun_count()-overruns);
+    			overruns=sampler.ring.overrun_count();
+    			GW_LOGW(LOG_TAG,"Sample ring overruns: %u, high water %u/%d",overruns,sampler.ring.high_water_mark(),sampler.ring.capacity());
+    		}
+#ifdef CONFIG_GW_FANIN_ENABLE
+    		if(fanin.ring.overrun_count()!=device_overruns) {
+    			WIoTP_Metrics::count(WIOTP_CNT_OVERRUNS,fanin.ring.overrun_count()-device_overruns);
+    			device_overruns=fanin.ring.overrun_count();
+    			GW_LOGW(LOG_TAG,"Device ring overruns: %u, high water %u/%d",device_overruns,fanin.ring.high_water_mark(),fanin.ring.capacity());
+    		}
+    		GW_LOGD(LOG_TAG,"Devices %u/%d, rejected %u, datagrams %u, malformed %u, messages %u",devices.count(),devices.capacity(),
+    				devices.rejected(),fanin.datagrams(),fanin.malformed(),devices.messages());
+#endif
+#ifdef CONFIG_GW_HTTP_ENABLE
+    		GW_LOGD(LOG_TAG,"HTTP requests %u, throttled %u",web.requests(),web.throttled());
+#endif
+    		GW_LOGD(LOG_TAG,"In flight %u/%u (max %u), %u bytes (max %u), acked %u, expired %u, refused %u, PUBACK latency mean %u ms max %u ms",
+    				publisher.in_flight(),publisher.capacity(),publisher.max_in_flight(),publisher.outbox_in_use(),publisher.max_outbox(),
+    				publisher.acked(),publisher.expired(),publisher.refused(),publisher.mean_ack_latency_ms(),publisher.max_ack_latency_ms());
+    		gpio_set_level(GPIO_NUM_4, level);
+    		level = !level;
+    	}
 
-    	// Publish at QOS 1, no retain
-    	snprintf(wiotp_payload,sizeof(wiotp_payload),"{\"d\":{\"temp\":%d}}",temp);
-    	esp_mqtt_client_publish(mqttCl, wiotp_topic, wiotp_payload, 0, 1, 0);
+#if CONFIG_GW_METRICS_PERIOD_MS>0
+    	if(wiotp_connected && now>=next_metrics_us) {
+    		next_metrics_us=now+(int64_t)CONFIG_GW_METRICS_PERIOD_MS*1000;
+    		size_t len=WIoTP_Metrics::encode(metrics_payload,sizeof(metrics_payload));
+    		if(len>0 && publisher.publish(wiotp_metrics_topic,metrics_payload,len,1,WIOTP_PRIO_HIGH)<0) {
+    			GW_LOGW(LOG_TAG,"Metrics not published, %u bytes",(unsigned)len);
+    		}
+    	}
+#endif
 
-        gpio_set_level(GPIO_NUM_4, level);
-        level = !level;
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        vTaskDelay(CONFIG_GW_PUBLISH_PERIOD_MS / portTICK_PERIOD_MS);
     }
 }
+
+extern "C" void app_main(void)
+{
+	// The gateway runs in a task of its own, pinned with the network tasks, and the main task ends here
+	xTaskCreatePinnedToCore(&publish_task,"Publish",CONFIG_GW_PUBLISH_TASK_STACK,NULL,CONFIG_GW_PUBLISH_TASK_PRIORITY,NULL,
+			gw_task_core(CONFIG_GW_NET_TASK_CORE));
+}
\ No newline at end of file